@@ -0,0 +1,285 @@
+/**
+ * Synthetic Stack Generator
+ *
+ * Writes a deterministic synthetic frame set (SyntheticStack.h) as FITS files,
+ * optionally with its exact reference planes: the double-precision mean, the
+ * expected classification and the ground-truth feature flags. The same seed
+ * and settings reproduce the same files on any machine.
+ *
+ * --kernel-fixture writes the frames and what the native kernels (StackKernels.h)
+ * make of them to one file, so the Julia tests can run the same stack through
+ * cpu_accumulate!/cpu_finalize! and compare. Little-endian layout:
+ *
+ * Offset  Type                     Field
+ * 0       char[4]                  "BAKF"
+ * 4       uint32                   version (1)
+ * 8       int64[3]                 height (NAXIS1), width, frames
+ * 32      float32[frames][pixels]  frames, column-major
+ * ...     uint16[pixels]           accumulator n
+ * ...     float32[pixels] × 6      mean, m2, m3, m4, min, max
+ * ...     float32[pixels] × 2      fused (MLE), confidence
+ * ...     uint8[pixels]            DistributionCode
+ *
+ * Usage:
+ *     BayesianAstroSynth --output DIR [--size HEIGHTxWIDTH] [--frames N] [--seed S]
+ *                        [--bitpix 16|-32] [--reference] [--threads N] [model options]
+ *     BayesianAstroSynth --kernel-fixture FILE [--size HEIGHTxWIDTH] [--frames N] [model options]
+ */
+
+#include "FitsWriter.h"
+#include "StackKernels.h"
+#include "SyntheticStack.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace pcl;
+
+namespace
+{
+
+double NowSeconds()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Usage()
+{
+    fprintf(stderr,
+            "Usage: BayesianAstroSynth --output DIR [options]\n"
+            "       BayesianAstroSynth --kernel-fixture FILE [options]\n"
+            "  --size HxW           Frame size, NAXIS1 x NAXIS2 (default 4096x6144)\n"
+            "  --frames N           Number of frames (default 300)\n"
+            "  --seed S             Generator seed (default 1)\n"
+            "  --bitpix 16|-32      Integer ADU or Float32 frames (default 16)\n"
+            "  --prefix NAME        File name prefix (default synth)\n"
+            "  --threads N          Frames written in parallel (default: hardware concurrency)\n"
+            "  --reference          Also write reference/<prefix>_reference_mean.fits, _reference_classes.fits\n"
+            "                       and _truth.fits (exact double-precision statistics)\n"
+            "  --kernel-fixture FILE  Instead of FITS files, write the frames and the native kernels'\n"
+            "                       accumulator and finalized planes to FILE (read by the Julia tests)\n"
+            "Model:\n"
+            "  --sky E --gradient E --read-noise E --bias ADU\n"
+            "  --stars N --star-fwhm PX --hot-pixels FRACTION\n"
+            "  --cosmic-rays PER_MPX --trails PROBABILITY --dither PX\n");
+}
+
+bool ParseSize(const char* text, int64_t& height, int64_t& width)
+{
+    char* end = nullptr;
+    height = strtoll(text, &end, 10);
+    if (end == text || (*end != 'x' && *end != 'X'))
+        return false;
+    const char* rest = end + 1;
+    width = strtoll(rest, &end, 10);
+    return end != rest && *end == '\0' && height > 0 && width > 0;
+}
+
+bool ParseDouble(const char* text, double& value)
+{
+    char* end = nullptr;
+    value = strtod(text, &end);
+    return end != text && *end == '\0' && value >= 0.0;
+}
+
+// Stream the stack through the native kernels and write frames and results (layout above)
+bool WriteKernelFixture(const SyntheticStack& stack, const std::string& path, std::string& error)
+{
+    const SyntheticStackConfig& config = stack.Config();
+    const size_t pixels = stack.Pixels();
+
+    std::vector<float> frames(config.frames * pixels);
+    std::vector<uint16_t> n(pixels);
+    std::vector<float> planes(8 * pixels);
+    std::vector<uint8_t> classes(pixels);
+
+    AccumulatorPlanes acc;
+    acc.n = n.data();
+    float** moments[] = { &acc.mean, &acc.m2, &acc.m3, &acc.m4, &acc.min, &acc.max };
+    for (size_t i = 0; i < 6; ++i)
+        *moments[i] = planes.data() + i * pixels;
+    acc.pixels = pixels;
+    float* fused = planes.data() + 6 * pixels;
+    float* confidence = planes.data() + 7 * pixels;
+
+    ResetAccumulator(acc);
+    for (size_t f = 0; f < config.frames; ++f)
+    {
+        stack.GenerateFrame(f, frames.data() + f * pixels);
+        AccumulateFrame(acc, frames.data() + f * pixels);
+    }
+    FinalizeAccumulator(acc, fused, confidence, classes.data());
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        error = "Cannot create " + path;
+        return false;
+    }
+    const uint32_t version = 1;
+    const int64_t shape[3] = { config.height, config.width, int64_t(config.frames) };
+    bool ok = fwrite("BAKF", 1, 4, file) == 4 && fwrite(&version, sizeof(version), 1, file) == 1
+        && fwrite(shape, sizeof(shape), 1, file) == 1
+        && fwrite(frames.data(), sizeof(float), frames.size(), file) == frames.size()
+        && fwrite(n.data(), sizeof(uint16_t), pixels, file) == pixels
+        && fwrite(planes.data(), sizeof(float), planes.size(), file) == planes.size()
+        && fwrite(classes.data(), 1, pixels, file) == pixels;
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        error = "Cannot write " + path;
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    SyntheticStackConfig config;
+    std::string output;
+    std::string fixture;
+    std::string prefix = "synth";
+    int threads = 0;
+    bool reference = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+        {
+            Usage();
+            return 0;
+        }
+        if (arg == "--reference")
+        {
+            reference = true;
+            continue;
+        }
+
+        const char* value = i + 1 < argc ? argv[++i] : nullptr;
+        auto number = [value](double& target) { return ParseDouble(value, target); };
+        double count = 0.0;
+        bool ok = true;
+        if (value == nullptr)
+            ok = false;
+        else if (arg == "--output")
+            output = value;
+        else if (arg == "--kernel-fixture")
+            fixture = value;
+        else if (arg == "--prefix")
+            prefix = value;
+        else if (arg == "--size")
+            ok = ParseSize(value, config.height, config.width);
+        else if (arg == "--frames")
+            ok = (config.frames = size_t(atoll(value))) > 0 && config.frames <= 65535;
+        else if (arg == "--seed")
+            config.seed = strtoull(value, nullptr, 10);
+        else if (arg == "--bitpix")
+            ok = (config.bitpix = atoi(value)) == 16 || config.bitpix == -32;
+        else if (arg == "--threads")
+            ok = (threads = atoi(value)) > 0;
+        else if (arg == "--sky")
+            ok = number(config.skyLevel);
+        else if (arg == "--gradient")
+            ok = number(config.gradient);
+        else if (arg == "--read-noise")
+            ok = number(config.readNoise);
+        else if (arg == "--bias")
+            ok = number(config.bias);
+        else if (arg == "--stars")
+            ok = number(count) && (config.stars = size_t(count), true);
+        else if (arg == "--star-fwhm")
+            ok = number(config.starFwhm) && config.starFwhm > 0.0;
+        else if (arg == "--hot-pixels")
+            ok = number(config.hotPixelFraction);
+        else if (arg == "--cosmic-rays")
+            ok = number(config.cosmicRaysPerMegapixel);
+        else if (arg == "--trails")
+            ok = number(config.trailProbability);
+        else if (arg == "--dither")
+            ok = number(config.ditherPixels);
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            fprintf(stderr, "Invalid argument: %s\n", arg.c_str());
+            Usage();
+            return 2;
+        }
+    }
+
+    if (output.empty() == fixture.empty())
+    {
+        Usage();
+        return 2;
+    }
+
+    SyntheticStack stack(config);
+    if (!fixture.empty())
+    {
+        std::string error;
+        if (!WriteKernelFixture(stack, fixture, error))
+        {
+            fprintf(stderr, "** %s\n", error.c_str());
+            return 1;
+        }
+        fprintf(stderr, "Kernel fixture of %zu frames of %lld×%lld written to %s\n", config.frames,
+                (long long)config.height, (long long)config.width, fixture.c_str());
+        return 0;
+    }
+
+    fprintf(stderr, "Generating %zu frames of %lld×%lld (BITPIX %d, seed %llu) into %s\n",
+            config.frames, (long long)config.height, (long long)config.width, config.bitpix,
+            (unsigned long long)config.seed, output.c_str());
+
+    double start = NowSeconds();
+    std::string error;
+    if (!stack.WriteFrames(output, prefix, threads, nullptr, error))
+    {
+        fprintf(stderr, "** %s\n", error.c_str());
+        return 1;
+    }
+    const double seconds = NowSeconds() - start;
+    fprintf(stderr, "Frames written in %.2f s (%.1f Mpx/s)\n", seconds,
+            double(stack.Pixels()) * double(config.frames) / seconds / 1e6);
+
+    if (reference)
+    {
+        start = NowSeconds();
+        const SyntheticReference ref = SyntheticReference::Compute(stack, threads);
+        std::vector<float> mean(ref.mean.begin(), ref.mean.end());
+
+        const std::vector<FitsKeyword> keywords = {
+            FitsKeyword::Integer("SYNSEED", int64_t(config.seed), "synthetic stack seed"),
+            FitsKeyword::Integer("SYNNFRM", int64_t(config.frames), "frames in the stack")
+        };
+        PlaneWriteOptions floatOptions;
+        PlaneWriteOptions codeOptions;
+        codeOptions.encoding = PlaneEncoding::UInt8;
+
+        // Kept out of the frame directory so a directory scan does not take them for frames
+        const std::filesystem::path dir = std::filesystem::path(output) / "reference";
+        std::filesystem::create_directories(dir);
+        const bool ok =
+            WriteFitsPlane((dir / (prefix + "_reference_mean.fits")).string(), mean.data(),
+                           config.height, config.width, floatOptions, keywords, nullptr, error) &&
+            WriteFitsPlane((dir / (prefix + "_reference_classes.fits")).string(), ref.classes.data(),
+                           config.height, config.width, codeOptions, keywords, nullptr, error) &&
+            WriteFitsPlane((dir / (prefix + "_truth.fits")).string(), ref.truth.data(),
+                           config.height, config.width, codeOptions, keywords, nullptr, error);
+        if (!ok)
+        {
+            fprintf(stderr, "** %s\n", error.c_str());
+            return 1;
+        }
+        fprintf(stderr, "Reference planes written in %.2f s\n", NowSeconds() - start);
+    }
+
+    return 0;
+}
@@ -0,0 +1,1663 @@
+/**
+ * Stacking Kernel Benchmark
+ *
+ * Times the native stacking kernels (StackKernels.h) and FITS decode over a
+ * grid of image sizes and frame counts, single- and multi-threaded, on planes
+ * from the same workspace arena the module uses. Builds without PCL, Qt or
+ * Julia. Frames come from the seeded synthetic stack generator, so every
+ * machine measures the same data; --check also verifies the kernels against
+ * the generator's exact reference statistics. Results are written as JSON
+ * (stdout or --output) with a host description, so runs on different
+ * machines and builds can be compared; a readable table goes to stderr.
+ * --trace writes a Chrome trace timeline of every timed run and worker slice;
+ * --counters adds one untimed run per measurement under perf_event hardware
+ * counters (IPC, cache and branch misses, estimated DRAM traffic), summed over
+ * the worker threads. --pipeline adds a fixed end-to-end run: a synthetic FITS
+ * stack read through native ingest, accumulated, finalized and written.
+ *
+ * --baseline compares the run with an earlier results file (the perf-gate target
+ * uses the checked-in benchmark/baseline.json): a record regresses when its
+ * fastest run is slower than the baseline's by more than the tolerance, or by
+ * more than the noise both runs showed, whichever is larger. Slower records are
+ * confirmed by rerunning the suite (--retries) and keeping each record's fastest
+ * time; what is still slower is listed and the exit status is 3.
+ *
+ * Usage:
+ *     BayesianAstroBenchmark [--sizes 1,4,16] [--frames 8,32] [--threads N]
+ *                            [--repeat N] [--output results.json] [--seed S] [--check] [--quick]
+ *                            [--trace trace.json] [--counters] [--pipeline]
+ *                            [--baseline baseline.json] [--tolerance PERCENT]
+ */
+
+#include "FitsFormat.h"
+#include "FitsWriter.h"
+#include "FrameIngest.h"
+#include "HardwareCounters.h"
+#include "LivePreview.h"
+#include "MemoryPlanner.h"
+#include "PlaneHistogram.h"
+#include "PreviewTiles.h"
+#include "StackKernels.h"
+#include "SyntheticStack.h"
+#include "TraceTimeline.h"
+#include "WorkspaceArena.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace pcl;
+
+namespace
+{
+
+// Frames are cycled from a pool so large stacks do not need frames × size of memory
+constexpr size_t FRAME_POOL = 8;
+
+// Image height, as in the Julia benchmarks; width follows from the megapixel count
+constexpr int64_t IMAGE_HEIGHT = 4096;
+
+// Accumulator slots of the second accumulator merged in, after the arena's own planes
+constexpr uint32_t MERGE_SLOT_BASE = uint32_t(WorkspaceSlot::DecodedFrame) + 1;
+
+// The fixed end-to-end stack: 4 Mpx, 16 frames of 16-bit integer ADU
+constexpr int64_t PIPELINE_HEIGHT = 2048;
+constexpr int64_t PIPELINE_WIDTH = 2048;
+constexpr size_t PIPELINE_FRAMES = 16;
+
+// Baseline comparison: a record regresses past max(tolerance, NOISE_FACTOR × relative
+// spread (median vs fastest run) of either file), and by more than the timer floor
+constexpr double DEFAULT_TOLERANCE = 0.10;
+constexpr int DEFAULT_RETRIES = 2;
+constexpr double NOISE_FACTOR = 3.0;
+constexpr double ABSOLUTE_NOISE_SECONDS = 20e-6;
+
+struct Options
+{
+    std::vector<double> megapixels = { 1.0, 4.0, 16.0 };
+    std::vector<size_t> frames = { 8, 32 };
+    int threads = 0;                // 0 = hardware concurrency
+    int repeat = 5;
+    uint64_t seed = 1;              // Synthetic stack seed
+    bool check = false;             // Compare against the exact synthetic reference
+    std::string output;             // Empty = stdout
+    std::string trace;              // Chrome trace JSON path; empty = no tracing
+    bool counters = false;          // Hardware counters of an extra untimed run per measurement
+    bool pipeline = false;          // Fixed end-to-end ingest, accumulate, finalize and write
+    std::string baseline;           // Results file to compare with; empty = no comparison
+    double tolerance = DEFAULT_TOLERANCE;
+    int retries = DEFAULT_RETRIES;  // Reruns that must confirm a regression
+};
+
+struct Result
+{
+    std::string kernel;
+    std::string variant;
+    std::string traceName;          // "kernel/variant", named by the trace events of its runs
+    int64_t height = 0;
+    int64_t width = 0;
+    size_t frames = 0;
+    int threads = 1;
+    double medianSeconds = 0.0;
+    double minSeconds = 0.0;
+    double pixelUpdates = 0.0;      // Pixels processed per timed run (pixels × frames)
+    double bytes = 0.0;             // Estimated memory traffic per timed run
+    CounterValues counters;         // --counters: one run, all threads
+    int counterGroups = 0;           // Groups read: the calling thread plus one per worker slice
+};
+
+// Streamed synthetic stack against its exact double-precision reference
+struct SyntheticCheck
+{
+    int64_t height = 0;
+    int64_t width = 0;
+    size_t frames = 0;
+    double meanMaxRelativeError = 0.0;
+    double m2MaxRelativeError = 0.0;
+    double classAgreement = 0.0;    // Fraction of pixels classified as their ground truth expects
+};
+
+// Streamed means beyond this relative error from the exact mean fail the run
+constexpr double MEAN_TOLERANCE = 1e-4;
+
+// Counters of the measurement run in progress; every thread that works on it adds its own
+struct CounterRun
+{
+    std::mutex mutex;
+    CounterValues total;
+    int threads = 0;
+
+    void Add(const CounterGroup& group)
+    {
+        CounterValues values;
+        if (!group.Read(values))
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        total.Add(values);
+        ++threads;
+    }
+};
+
+bool g_counters = false;
+CounterRun* g_counterRun = nullptr;
+
+double NowSeconds()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Split [0, pixels) into 'threads' cache-line-aligned slices and run them concurrently
+template <typename F>
+void ForSlices(size_t pixels, int threads, F&& fn)
+{
+    if (threads <= 1)
+    {
+        fn(size_t(0), pixels);
+        return;
+    }
+
+    const size_t chunk = (pixels / size_t(threads) + 15) / 16 * 16;
+    std::vector<std::thread> pool;
+    for (size_t first = 0; first < pixels; first += chunk)
+        pool.emplace_back([&fn, first, count = std::min(chunk, pixels - first)]()
+        {
+            SetTraceThreadName("kernel worker");
+            TraceScope trace(TraceCategory::Compute, "slice", "pixels", int64_t(count));
+            CounterGroup group;
+            std::string note;
+            if (g_counterRun != nullptr)
+                group.Open(0, note);
+            fn(first, count);
+            if (group.IsOpen())
+                g_counterRun->Add(group);
+        });
+    for (std::thread& t : pool)
+        t.join();
+}
+
+// Median and minimum over 'repeat' timed runs; 'setup' runs untimed before each
+template <typename Setup, typename Body>
+void Measure(Result& result, int repeat, Setup&& setup, Body&& body)
+{
+    std::vector<double> times;
+    for (int r = 0; r < repeat; ++r)
+    {
+        setup();
+        TraceScope trace(TraceCategory::Compute, result.traceName.c_str(), "run", r);
+        const double start = NowSeconds();
+        body();
+        times.push_back(NowSeconds() - start);
+    }
+    std::sort(times.begin(), times.end());
+    result.minSeconds = times.front();
+    result.medianSeconds = times[times.size() / 2];
+
+    // Counted separately so opening the groups stays out of the timings
+    if (g_counters)
+    {
+        setup();
+        CounterRun run;
+        CounterGroup group;
+        std::string note;
+        if (group.Open(0, note))
+        {
+            g_counterRun = &run;
+            body();
+            g_counterRun = nullptr;
+            run.Add(group);
+            result.counters = run.total;
+            result.counterGroups = run.threads;
+        }
+    }
+}
+
+AccumulatorPlanes AcquirePlanes(WorkspaceArena& arena, uint32_t baseSlot, size_t pixels)
+{
+    AccumulatorPlanes acc;
+    acc.n = arena.Acquire<uint16_t>(WorkspaceSlot(baseSlot), pixels);
+    float** planes[] = { &acc.mean, &acc.m2, &acc.m3, &acc.m4, &acc.min, &acc.max };
+    for (uint32_t i = 0; i < 6; ++i)
+        *planes[i] = arena.Acquire<float>(WorkspaceSlot(baseSlot + 1 + i), pixels);
+    acc.pixels = pixels;
+    return acc;
+}
+
+void CopyPlanes(const AccumulatorPlanes& to, const AccumulatorPlanes& from)
+{
+    const size_t bytes = from.pixels * sizeof(float);
+    memcpy(to.n, from.n, from.pixels * sizeof(uint16_t));
+    memcpy(to.mean, from.mean, bytes);
+    memcpy(to.m2, from.m2, bytes);
+    memcpy(to.m3, from.m3, bytes);
+    memcpy(to.m4, from.m4, bytes);
+    memcpy(to.min, from.min, bytes);
+    memcpy(to.max, from.max, bytes);
+}
+
+bool PlanesEqual(const AccumulatorPlanes& a, const AccumulatorPlanes& b)
+{
+    const size_t bytes = a.pixels * sizeof(float);
+    return memcmp(a.n, b.n, a.pixels * sizeof(uint16_t)) == 0 && memcmp(a.mean, b.mean, bytes) == 0 &&
+           memcmp(a.m2, b.m2, bytes) == 0 && memcmp(a.m3, b.m3, bytes) == 0 &&
+           memcmp(a.m4, b.m4, bytes) == 0 && memcmp(a.min, b.min, bytes) == 0 &&
+           memcmp(a.max, b.max, bytes) == 0;
+}
+
+// One pixel's accumulator as its own heap object: the layout of Matrix{PixelDistribution}
+// in the Julia engine before DistributionAccumulator, timed against the same update over planes
+struct PixelObject
+{
+    uint16_t n = 0;
+    float mean = 0.0f;
+    float m2 = 0.0f;
+    float m3 = 0.0f;
+    float m4 = 0.0f;
+    float min = std::numeric_limits<float>::infinity();
+    float max = -std::numeric_limits<float>::infinity();
+};
+
+// StackKernels' Welford step and NaN-propagating min/max, so both layouts run the same code
+inline void UpdatePixel(uint16_t& n, float& mean, float& m2, float& m3, float& m4, float& lo, float& hi,
+                        float value)
+{
+    const float n1f = float(n);
+    const uint16_t n2 = uint16_t(n + 1);
+    const float nf = float(n2);
+
+    const float delta = value - mean;
+    const float deltaN = delta / nf;
+    const float deltaN2 = deltaN * deltaN;
+    const float term1 = delta * deltaN * n1f;
+
+    m4 += term1 * deltaN2 * (nf * nf - 3.0f * nf + 3.0f) + 6.0f * deltaN2 * m2 - 4.0f * deltaN * m3;
+    m3 += term1 * deltaN * (nf - 2.0f) - 3.0f * deltaN * m2;
+    m2 += term1;
+    mean += deltaN;
+    n = n2;
+    lo = (lo != lo || value < lo) ? (lo != lo ? lo : value) : (value != value ? value : lo);
+    hi = (hi != hi || value > hi) ? (hi != hi ? hi : value) : (value != value ? value : hi);
+}
+
+// Return freed heap pages to the system (glibc keeps small freed blocks for reuse)
+void ReleaseFreedHeap()
+{
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+// UpdatePixel over unaliased planes, written as the kernels' loop so it vectorizes
+void UpdatePlanes(uint16_t* __restrict__ n, float* __restrict__ mean, float* __restrict__ m2,
+                  float* __restrict__ m3, float* __restrict__ m4, float* __restrict__ lo,
+                  float* __restrict__ hi, const float* __restrict__ frame, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint16_t ni = n[i];
+        float meani = mean[i], m2i = m2[i], m3i = m3[i], m4i = m4[i], loi = lo[i], hii = hi[i];
+        UpdatePixel(ni, meani, m2i, m3i, m4i, loi, hii, frame[i]);
+        n[i] = ni;
+        mean[i] = meani;
+        m2[i] = m2i;
+        m3[i] = m3i;
+        m4[i] = m4i;
+        lo[i] = loi;
+        hi[i] = hii;
+    }
+}
+
+// Resident set size of the process, in bytes (0 where /proc is unavailable)
+uint64_t ResidentBytes()
+{
+    unsigned long long size = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f == nullptr)
+        return 0;
+    const bool read = fscanf(f, "%llu %llu", &size, &resident) == 2;
+    fclose(f);
+    return read ? uint64_t(resident) * uint64_t(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+// Big-endian FITS samples of the given BITPIX holding 'values'
+std::vector<uint8_t> EncodeSamples(const std::vector<float>& values, int bitpix)
+{
+    const size_t width = size_t(std::abs(bitpix)) / 8;
+    std::vector<uint8_t> raw(values.size() * width);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        uint64_t bits = 0;
+        switch (bitpix)
+        {
+        case 8: bits = uint8_t(std::clamp(values[i] / 256.0f, 0.0f, 255.0f)); break;
+        case 16: bits = uint16_t(int16_t(std::clamp(values[i] - 32768.0f, -32768.0f, 32767.0f))); break;
+        case 32: bits = uint32_t(int32_t(values[i])); break;
+        case -32: { float f = values[i]; uint32_t u; memcpy(&u, &f, 4); bits = u; break; }
+        case -64: { double d = values[i]; memcpy(&bits, &d, 8); break; }
+        }
+        for (size_t b = 0; b < width; ++b)
+            raw[i * width + b] = uint8_t(bits >> (8 * (width - 1 - b)));
+    }
+    return raw;
+}
+
+std::string CpuModel()
+{
+    FILE* f = fopen("/proc/cpuinfo", "r");
+    if (f == nullptr)
+        return "unknown";
+    char line[512];
+    std::string model = "unknown";
+    while (fgets(line, sizeof(line), f) != nullptr)
+    {
+        if (strncmp(line, "model name", 10) == 0)
+        {
+            const char* colon = strchr(line, ':');
+            if (colon != nullptr)
+            {
+                model = colon + 2;
+                model.erase(model.find_last_not_of(" \n") + 1);
+            }
+            break;
+        }
+    }
+    fclose(f);
+    return model;
+}
+
+const char* SimdLevel()
+{
+#if defined(__AVX512F__)
+    return "avx512f";
+#elif defined(__AVX2__)
+    return "avx2";
+#elif defined(__AVX__)
+    return "avx";
+#elif defined(__SSE2__)
+    return "sse2";
+#elif defined(__ARM_NEON)
+    return "neon";
+#else
+    return "none";
+#endif
+}
+
+std::string JsonEscape(const std::string& text)
+{
+    std::string out;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20)
+            out += c;
+    }
+    return out;
+}
+
+/**
+ * Baseline files are this program's own output, read back field by field: the
+ * objects of the "results" array, with flat string and number fields (nested
+ * objects such as "counters" are skipped over).
+ */
+struct BaselineRecord
+{
+    std::string kernel;
+    std::string variant;
+    long long height = 0;
+    long long width = 0;
+    long long frames = 0;
+    long long threads = 0;
+    double medianSeconds = 0.0;
+    double minSeconds = 0.0;
+};
+
+// End of the object or string starting at 'begin', or npos
+size_t SkipJsonValue(const std::string& json, size_t begin)
+{
+    int depth = 0;
+    bool quoted = false;
+    for (size_t i = begin; i < json.size(); ++i)
+    {
+        const char c = json[i];
+        if (quoted)
+        {
+            if (c == '\\')
+                ++i;
+            else if (c == '"')
+            {
+                quoted = false;
+                if (depth == 0)
+                    return i + 1;
+            }
+        }
+        else if (c == '"')
+            quoted = true;
+        else if (c == '{' || c == '[')
+            ++depth;
+        else if ((c == '}' || c == ']') && --depth == 0)
+            return i + 1;
+    }
+    return std::string::npos;
+}
+
+// Top-level field 'key' of 'object' as raw text (strings without their quotes)
+bool JsonField(const std::string& object, const char* key, std::string& value)
+{
+    const std::string pattern = std::string("\"") + key + "\":";
+    for (size_t i = 1; i < object.size();)
+    {
+        if (object[i] == '{' || object[i] == '[')
+        {
+            i = SkipJsonValue(object, i);
+            continue;
+        }
+        if (object[i] != '"')
+        {
+            ++i;
+            continue;
+        }
+        if (object.compare(i, pattern.size(), pattern) != 0)
+        {
+            i = SkipJsonValue(object, i);   // A key or string value
+            continue;
+        }
+
+        size_t begin = object.find_first_not_of(" \t\r\n", i + pattern.size());
+        if (begin == std::string::npos)
+            return false;
+        if (object[begin] == '"')
+        {
+            const size_t end = SkipJsonValue(object, begin);
+            if (end == std::string::npos)
+                return false;
+            value = object.substr(begin + 1, end - begin - 2);
+            return true;
+        }
+        const size_t end = object.find_first_of(",}", begin);
+        value = object.substr(begin, end - begin);
+        return true;
+    }
+    return false;
+}
+
+bool ReadBaseline(const std::string& json, std::vector<BaselineRecord>& records, std::string& error)
+{
+    size_t i = json.find("\"results\"");
+    i = i == std::string::npos ? i : json.find('[', i);
+    if (i == std::string::npos)
+    {
+        error = "no \"results\" array";
+        return false;
+    }
+
+    while ((i = json.find_first_of("{]", i + 1)) != std::string::npos && json[i] == '{')
+    {
+        const size_t end = SkipJsonValue(json, i);
+        if (end == std::string::npos)
+            break;
+        const std::string object = json.substr(i, end - i);
+        i = end - 1;
+
+        BaselineRecord r;
+        std::string height, width, frames, threads, median, fastest;
+        if (!JsonField(object, "kernel", r.kernel) || !JsonField(object, "variant", r.variant)
+            || !JsonField(object, "height", height) || !JsonField(object, "width", width)
+            || !JsonField(object, "frames", frames) || !JsonField(object, "threads", threads)
+            || !JsonField(object, "median_seconds", median) || !JsonField(object, "min_seconds", fastest))
+        {
+            error = "incomplete result record " + object;
+            return false;
+        }
+        r.height = atoll(height.c_str());
+        r.width = atoll(width.c_str());
+        r.frames = atoll(frames.c_str());
+        r.threads = atoll(threads.c_str());
+        r.medianSeconds = atof(median.c_str());
+        r.minSeconds = atof(fastest.c_str());
+        records.push_back(r);
+    }
+    return true;
+}
+
+bool LoadBaseline(const std::string& path, std::vector<BaselineRecord>& records, std::string& cpu,
+                  std::string& error)
+{
+    std::string json;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == nullptr)
+    {
+        error = "cannot read " + path;
+        return false;
+    }
+    char buffer[65536];
+    for (size_t n; (n = fread(buffer, 1, sizeof(buffer), f)) > 0;)
+        json.append(buffer, n);
+    fclose(f);
+
+    const size_t host = json.find("\"host\"");
+    if (host != std::string::npos && json.find('{', host) != std::string::npos)
+        JsonField(json.substr(json.find('{', host)), "cpu", cpu);
+    if (!ReadBaseline(json, records, error))
+    {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+// Relative spread of a record's timed runs: how far the median sits above the fastest run
+double Noise(double medianSeconds, double minSeconds)
+{
+    return minSeconds > 0.0 ? (medianSeconds - minSeconds) / minSeconds : 0.0;
+}
+
+class Benchmark
+{
+public:
+    explicit Benchmark(const Options& options)
+        : m_options(options)
+    {
+    }
+
+    bool Run();
+    std::string ToJson() const;
+
+    // Keep each record's fastest times from a rerun of the same configuration
+    void KeepFastest(const Benchmark& rerun);
+
+    // Regressed records against the baseline; with 'report', listed with a summary on stderr
+    int CompareBaseline(const std::vector<BaselineRecord>& baseline, bool report) const;
+
+private:
+    void RunSize(double megapixels);
+    void RunLayout(const std::vector<std::vector<float>>& pool, const std::vector<int>& threadCounts);
+    void RunPageSizes(const std::vector<std::vector<float>>& pool, const std::vector<int>& threadCounts);
+    void RunPipeline();
+    Result& Add(const char* kernel, const char* variant, size_t frames, int threads);
+    void Report(const Result& r) const;
+    void CheckSynthetic(const SyntheticStack& generator, size_t frames, const AccumulatorPlanes& acc,
+                        float* fused, float* confidence, uint8_t* classes);
+
+    Options m_options;
+    WorkspaceArena m_arena;
+    std::deque<Result> m_results;      // Stable references while results are added
+    std::vector<std::string> m_mismatches;
+    std::vector<SyntheticCheck> m_checks;
+
+    int64_t m_height = 0;
+    int64_t m_width = 0;
+};
+
+Result& Benchmark::Add(const char* kernel, const char* variant, size_t frames, int threads)
+{
+    Result r;
+    r.kernel = kernel;
+    r.variant = variant;
+    r.traceName = r.kernel + "/" + r.variant;
+    r.height = m_height;
+    r.width = m_width;
+    r.frames = frames;
+    r.threads = threads;
+    m_results.push_back(r);
+    return m_results.back();
+}
+
+void Benchmark::Report(const Result& r) const
+{
+    fprintf(stderr, "  %-11s %-10s %3zu frames %2d thr  %9.3f ms  %8.1f Mpx/s  %6.2f GB/s\n",
+            r.kernel.c_str(), r.variant.c_str(), r.frames, r.threads, r.medianSeconds * 1e3,
+            r.pixelUpdates / r.medianSeconds / 1e6, r.bytes / r.medianSeconds / 1e9);
+    if (r.counterGroups > 0)
+    {
+        // Per pixel update, so sizes and frame counts compare directly; unavailable events are left out
+        const CounterValues& c = r.counters;
+        char text[96];
+        std::string line = "  " + std::string(24, ' ');
+        auto add = [&](double value, const char* format)
+        {
+            if (std::isnan(value))
+                return;
+            snprintf(text, sizeof(text), format, value);
+            line += text;
+        };
+        add(c.Has(CounterEvent::TaskClock) ? double(c[CounterEvent::TaskClock]) * 1e-6 : NAN, " CPU %.3f ms,");
+        add(c.Has(CounterEvent::PageFaults) ? double(c[CounterEvent::PageFaults]) : NAN, " %.0f page faults,");
+        add(c.InstructionsPerCycle(), " IPC %.2f,");
+        add(100.0 * c.CacheMissRate(), " cache miss %.1f%%,");
+        add(100.0 * c.BranchMissRate(), " branch miss %.2f%%,");
+        add(c.Has(CounterEvent::Instructions) ? double(c[CounterEvent::Instructions]) / r.pixelUpdates : NAN,
+            " %.1f instr/px,");
+        add(c.MemoryBytes() / r.pixelUpdates, " %.2f B/px from DRAM (est.),");
+        line.pop_back();
+        fprintf(stderr, "%s\n", line.c_str());
+    }
+}
+
+void Benchmark::RunSize(double megapixels)
+{
+    m_height = IMAGE_HEIGHT;
+    m_width = std::max<int64_t>(1, int64_t(std::llround(megapixels * 1e6 / double(IMAGE_HEIGHT))));
+    const size_t pixels = size_t(m_height * m_width);
+    fprintf(stderr, "%lld×%lld (%.1f Mpx)\n", (long long)m_height, (long long)m_width, pixels / 1e6);
+
+    m_arena.BeginRun();
+    AccumulatorPlanes acc = AcquirePlanes(m_arena, uint32_t(WorkspaceSlot::AccumulatorCount), pixels);
+    AccumulatorPlanes other = AcquirePlanes(m_arena, MERGE_SLOT_BASE, pixels);
+    float* fused = m_arena.Acquire<float>(WorkspaceSlot::Fused, pixels);
+    float* confidence = m_arena.Acquire<float>(WorkspaceSlot::Confidence, pixels);
+    uint8_t* classes = m_arena.Acquire<uint8_t>(WorkspaceSlot::Classification, pixels);
+    float* decoded = m_arena.Acquire<float>(WorkspaceSlot::DecodedFrame, pixels);
+
+    // Synthetic sky frames (stars, noise, hot pixels, cosmic rays, trails), identical on every machine
+    SyntheticStackConfig synthetic;
+    synthetic.height = m_height;
+    synthetic.width = m_width;
+    synthetic.frames = *std::max_element(m_options.frames.begin(), m_options.frames.end());
+    synthetic.seed = m_options.seed;
+    const SyntheticStack generator(synthetic);
+
+    std::vector<std::vector<float>> pool(FRAME_POOL, std::vector<float>(pixels));
+    Result& generate = Add("generate", "synthetic", 1, 1);
+    generate.pixelUpdates = double(pixels);
+    generate.bytes = double(pixels) * 4.0;
+    size_t generated = 0;
+    Measure(generate, std::min<int>(m_options.repeat, int(FRAME_POOL)), []() {},
+            [&]()
+            {
+                const size_t f = generated++ % FRAME_POOL;
+                generator.GenerateFrame(f, pool[f].data());
+            });
+    Report(generate);
+    for (size_t f = std::min(generated, FRAME_POOL); f < FRAME_POOL; ++f)
+        generator.GenerateFrame(f, pool[f].data());
+
+    if (m_options.check)
+        CheckSynthetic(generator, m_options.frames.front(), acc, fused, confidence, classes);
+
+    const int hardware = m_options.threads > 0 ? m_options.threads
+                                               : std::max(1, int(std::thread::hardware_concurrency()));
+    std::vector<int> threadCounts = { 1 };
+    if (hardware > 1)
+        threadCounts.push_back(hardware);
+
+    for (size_t frames : m_options.frames)
+    {
+        std::vector<const float*> stack(frames);
+        for (size_t f = 0; f < frames; ++f)
+            stack[f] = pool[f % FRAME_POOL].data();
+
+        auto reset = [&]() { ResetAccumulator(acc); };
+
+        for (int threads : threadCounts)
+        {
+            // Per frame: read the frame, read and write 26 bytes of accumulator
+            const double perFrameBytes = double(pixels) * (4.0 + 2.0 * ACCUMULATOR_BYTES_PER_PIXEL);
+
+            Result& scalar = Add("accumulate", "scalar", frames, threads);
+            scalar.pixelUpdates = double(pixels) * frames;
+            scalar.bytes = perFrameBytes * frames;
+            Measure(scalar, m_options.repeat, reset, [&]()
+            {
+                for (const float* frame : stack)
+                    ForSlices(pixels, threads, [&](size_t first, size_t count)
+                              { AccumulateFrameScalar(acc.Slice(first, count), frame + first); });
+            });
+            Report(scalar);
+
+            // Reference state for the variant comparison
+            ResetAccumulator(other);
+            for (const float* frame : stack)
+                AccumulateFrameScalar(other, frame);
+
+            Result& simd = Add("accumulate", "simd", frames, threads);
+            simd.pixelUpdates = scalar.pixelUpdates;
+            simd.bytes = scalar.bytes;
+            Measure(simd, m_options.repeat, reset, [&]()
+            {
+                for (const float* frame : stack)
+                    ForSlices(pixels, threads, [&](size_t first, size_t count)
+                              { AccumulateFrame(acc.Slice(first, count), frame + first); });
+            });
+            Report(simd);
+            if (!PlanesEqual(acc, other))
+                m_mismatches.push_back("accumulate simd differs from scalar");
+
+            // The accumulator is read and written once per batch; each frame is read once
+            Result& batched = Add("accumulate", "batched", frames, threads);
+            batched.pixelUpdates = scalar.pixelUpdates;
+            batched.bytes = double(pixels) * (4.0 * frames + 2.0 * ACCUMULATOR_BYTES_PER_PIXEL);
+            Measure(batched, m_options.repeat, reset, [&]()
+            {
+                ForSlices(pixels, threads, [&](size_t first, size_t count)
+                {
+                    std::vector<const float*> slice(frames);
+                    for (size_t f = 0; f < frames; ++f)
+                        slice[f] = stack[f] + first;
+                    AccumulateFrames(acc.Slice(first, count), slice.data(), frames);
+                });
+            });
+            Report(batched);
+            if (!PlanesEqual(acc, other))
+                m_mismatches.push_back("accumulate batched differs from scalar");
+
+            // acc holds the full stack here: finalize it, then merge the reference stack into a copy
+            Result& finalize = Add("finalize", "native", frames, threads);
+            finalize.pixelUpdates = double(pixels);
+            finalize.bytes = double(pixels) * (ACCUMULATOR_BYTES_PER_PIXEL + OUTPUT_BYTES_PER_PIXEL);
+            Measure(finalize, m_options.repeat, []() {}, [&]()
+            {
+                ForSlices(pixels, threads, [&](size_t first, size_t count)
+                          { FinalizeAccumulator(acc.Slice(first, count), fused + first,
+                                                confidence + first, classes + first); });
+            });
+            Report(finalize);
+
+            Result& merge = Add("merge", "native", frames, threads);
+            merge.pixelUpdates = double(pixels);
+            merge.bytes = double(pixels) * 3.0 * ACCUMULATOR_BYTES_PER_PIXEL;
+            Measure(merge, m_options.repeat, [&]() { CopyPlanes(acc, other); }, [&]()
+            {
+                ForSlices(pixels, threads, [&](size_t first, size_t count)
+                          { MergeAccumulators(acc.Slice(first, count), other.Slice(first, count)); });
+            });
+            Report(merge);
+        }
+    }
+
+    RunPageSizes(pool, threadCounts);
+    RunLayout(pool, threadCounts);
+
+    // Summary reductions of the finalized confidence plane, as the run summary takes them
+    std::vector<double> freeSums, treeSums;
+
+    // Frame-count independent kernels, measured on the finalized fused plane
+    for (int threads : threadCounts)
+    {
+        // Free-running: the same leaf kernel over one slice per thread, combined in slice
+        // order, so the tree shape (and possibly the bits) follows the thread count
+        double freeSum = 0.0;
+        Result& freeSummary = Add("summary", "free", 1, threads);
+        freeSummary.pixelUpdates = double(pixels);
+        freeSummary.bytes = double(pixels) * 4.0;
+        Measure(freeSummary, m_options.repeat, []() {}, [&]()
+        {
+            std::vector<std::pair<size_t, double>> slices;
+            std::mutex mutex;
+            ForSlices(pixels, threads, [&](size_t first, size_t count)
+            {
+                const double sum = SumPlane(confidence + first, count);
+                std::lock_guard<std::mutex> lock(mutex);
+                slices.emplace_back(first, sum);
+            });
+            std::sort(slices.begin(), slices.end());
+            freeSum = 0.0;
+            for (const auto& slice : slices)
+                freeSum += slice.second;
+        });
+        Report(freeSummary);
+        freeSums.push_back(freeSum);
+
+        // Deterministic: fixed leaves and a fixed pairwise tree, whatever takes the leaves
+        double treeSum = 0.0;
+        const size_t leaves = (pixels + REDUCTION_LEAF_PIXELS - 1) / REDUCTION_LEAF_PIXELS;
+        std::vector<double> partials(leaves);
+        Result& treeSummary = Add("summary", "fixed_tree", 1, threads);
+        treeSummary.pixelUpdates = double(pixels);
+        treeSummary.bytes = double(pixels) * 4.0;
+        Measure(treeSummary, m_options.repeat, []() {}, [&]()
+        {
+            ForSlices(leaves, threads, [&](size_t first, size_t count)
+            {
+                for (size_t leaf = first; leaf < first + count; ++leaf)
+                {
+                    const size_t offset = leaf * REDUCTION_LEAF_PIXELS;
+                    partials[leaf] = SumPlane(confidence + offset, std::min(REDUCTION_LEAF_PIXELS, pixels - offset));
+                }
+            });
+            treeSum = PairwiseSum(partials.data(), leaves);
+        });
+        Report(treeSummary);
+        treeSums.push_back(treeSum);
+        fprintf(stderr, "  %-22s %2d thr  fixed tree at %.2f× the free-running time\n", "", threads,
+                treeSummary.medianSeconds / freeSummary.medianSeconds);
+
+        float lo = 0.0f, hi = 0.0f;
+        Result& minmax = Add("minmax", "native", 1, threads);
+        minmax.pixelUpdates = double(pixels);
+        minmax.bytes = double(pixels) * 4.0;
+        Measure(minmax, m_options.repeat, []() {}, [&]()
+        {
+            lo = std::numeric_limits<float>::infinity();
+            hi = -std::numeric_limits<float>::infinity();
+            std::mutex mutex;
+            ForSlices(pixels, threads, [&](size_t first, size_t count)
+            {
+                float sliceMin, sliceMax;
+                PlaneMinMax(pool[0].data() + first, count, sliceMin, sliceMax);
+                std::lock_guard<std::mutex> lock(mutex);
+                lo = std::min(lo, sliceMin);
+                hi = std::max(hi, sliceMax);
+            });
+        });
+        Report(minmax);
+
+        Result& stretch = Add("stretch", "native", 1, threads);
+        stretch.pixelUpdates = double(pixels);
+        stretch.bytes = double(pixels) * 8.0;
+        Measure(stretch, m_options.repeat, []() {}, [&]()
+        {
+            ForSlices(pixels, threads, [&](size_t first, size_t count)
+                      { StretchPlane(decoded + first, pool[0].data() + first, count, lo, hi); });
+        });
+        Report(stretch);
+
+        for (int bitpix : { 8, 16, 32, -32, -64 })
+        {
+            const std::vector<uint8_t> raw = EncodeSamples(pool[0], bitpix);
+            const size_t width = size_t(std::abs(bitpix)) / 8;
+            const std::string variant = "bitpix" + std::to_string(bitpix);
+            const double bzero = bitpix == 16 ? 32768.0 : 0.0;
+
+            Result& decode = Add("fits_decode", variant.c_str(), 1, threads);
+            decode.pixelUpdates = double(pixels);
+            decode.bytes = double(pixels) * (width + 4.0);
+            Measure(decode, m_options.repeat, []() {}, [&]()
+            {
+                ForSlices(pixels, threads, [&](size_t first, size_t count)
+                          { DecodeFitsSamples(raw.data() + first * width, decoded + first, count,
+                                              bitpix, bzero, 1.0); });
+            });
+            Report(decode);
+        }
+    }
+
+    for (size_t i = 1; i < treeSums.size(); ++i)
+    {
+        if (std::memcmp(&treeSums[i], &treeSums[0], sizeof(double)) != 0)
+            m_mismatches.push_back("deterministic summary differs between thread counts");
+        if (std::memcmp(&freeSums[i], &freeSums[0], sizeof(double)) != 0)
+            fprintf(stderr, "  summary free-running sum differs between %d and %d threads (%.17g vs %.17g)\n",
+                    threadCounts[0], threadCounts[i], freeSums[0], freeSums[i]);
+    }
+
+    // The zoom pyramid of every output plane, as built after finalizing
+    PreviewSource source;
+    source.fused = fused;
+    source.confidence = confidence;
+    source.classification = classes;
+    source.naxis1 = m_height;
+    source.naxis2 = m_width;
+    source.generation = 1;
+    PreviewPyramid pyramid;
+    const int pyramidThreads = threadCounts.back();
+    pyramid.Build(source, pyramidThreads);
+    Result& build = Add("preview", "pyramid", 1, pyramidThreads);
+    build.pixelUpdates = double(pixels);
+    build.bytes = double(pixels) * (2.0 * sizeof(float) + sizeof(uint8_t));
+    Measure(build, m_options.repeat, []() {}, [&]() { pyramid.Build(source, pyramidThreads); });
+    Report(build);
+    source.pyramid = &pyramid;
+
+    // Preview tiles of the finalized fused plane, as the UI requests them: a full-resolution
+    // tile from the middle of the image and the one-tile overview, copied from the pyramid
+    PreviewTiler tiler;
+    tiler.SetSource(source);
+    for (int level : { 0, tiler.Levels() - 1 })
+    {
+        const int64_t tileX = tiler.TilesAcross(level) / 2;
+        const int64_t tileY = tiler.TilesDown(level) / 2;
+        const int64_t tileWidth = std::min<int64_t>(PREVIEW_TILE_SIZE, tiler.LevelWidth(level) - tileX * PREVIEW_TILE_SIZE);
+        const int64_t tileHeight = std::min<int64_t>(PREVIEW_TILE_SIZE, tiler.LevelHeight(level) - tileY * PREVIEW_TILE_SIZE);
+        const int64_t taps = std::min<int64_t>(int64_t(1) << level, PREVIEW_MAX_TAPS);
+        std::string png, error;
+        tiler.RenderTile(PreviewPlane::Fused, level, tileX, tileY, png, error);
+
+        Result& tile = Add("preview", level == 0 ? "full_res" : "overview", 1, 1);
+        tile.pixelUpdates = double(tileWidth * tileHeight);
+        tile.bytes = level == 0 ? double(tileWidth * tileHeight * taps * taps) * 4.0 : double(tileWidth * tileHeight);
+        bool rendered = true;
+        Measure(tile, m_options.repeat, []() {}, [&]()
+                { rendered = tiler.RenderTile(PreviewPlane::Fused, level, tileX, tileY, png, error) && rendered; });
+        Report(tile);
+        if (!rendered)
+            m_mismatches.push_back("preview tile failed to render: " + error);
+        if (level == 0 && tiler.Levels() == 1)
+            break;
+    }
+
+    // Histogram of the fused plane as binned after finalizing, and one tile binned again,
+    // as when only that tile of the plane changes
+    HistogramSource histogramSource;
+    histogramSource.values = fused;
+    histogramSource.naxis1 = m_height;
+    histogramSource.naxis2 = m_width;
+    PlaneHistogram histogram;
+    const int histogramThreads = threadCounts.back();
+    Result& binned = Add("histogram", "build", 1, histogramThreads);
+    binned.pixelUpdates = double(pixels);
+    binned.bytes = double(pixels) * sizeof(float);
+    Measure(binned, m_options.repeat, []() {}, [&]() { histogram.Build(histogramSource, histogramThreads); });
+    Report(binned);
+
+    const int64_t tileFirst1 = (m_height / 2 / HISTOGRAM_TILE_SIZE) * HISTOGRAM_TILE_SIZE;
+    const int64_t tileFirst2 = (m_width / 2 / HISTOGRAM_TILE_SIZE) * HISTOGRAM_TILE_SIZE;
+    const int64_t tileRows = std::min<int64_t>(HISTOGRAM_TILE_SIZE, m_height - tileFirst1);
+    const int64_t tileColumns = std::min<int64_t>(HISTOGRAM_TILE_SIZE, m_width - tileFirst2);
+    Result& updated = Add("histogram", "tile_update", 1, 1);
+    updated.pixelUpdates = double(tileRows * tileColumns);
+    updated.bytes = double(tileRows * tileColumns) * sizeof(float);
+    Measure(updated, m_options.repeat, []() {}, [&]()
+            { histogram.Update(histogramSource, tileFirst1, tileRows, tileFirst2, tileColumns); });
+    Report(updated);
+
+    // Merged per-thread totals and updated tiles must add up to a single-threaded build
+    PlaneHistogram reference;
+    reference.Build(histogramSource, histogram.Low(), histogram.High(), 1);
+    if (reference.Below() != histogram.Below() || reference.Above() != histogram.Above() ||
+        !std::equal(reference.Counts(), reference.Counts() + reference.Bins(), histogram.Counts()))
+        m_mismatches.push_back("histogram differs from a single-threaded build");
+
+    // One live snapshot of the whole accumulator, handed to the gathering thread and
+    // waited for, as at the end of each band of a run
+    LivePreview live;
+    live.BeginRun(m_height, m_width);
+    live.BeginBand(acc, 0, m_width, 1, 1);
+    live.EndBand();
+    const std::shared_ptr<const LiveSnapshot> snapshot = live.Latest();
+    if (snapshot != nullptr)
+    {
+        const int64_t taps = std::min<int64_t>(snapshot->step, LIVE_PREVIEW_TAPS);
+        const double samples = double(snapshot->source.naxis1 * snapshot->source.naxis2 * taps * taps);
+        Result& gather = Add("preview", "live_snapshot", 1, 1);
+        gather.pixelUpdates = double(snapshot->source.naxis1 * snapshot->source.naxis2);
+        gather.bytes = samples * double(sizeof(uint16_t) + sizeof(float));
+        Measure(gather, m_options.repeat, []() {}, [&]() { live.EndBand(); });
+        Report(gather);
+    }
+    else
+    {
+        m_mismatches.push_back("live preview produced no snapshot");
+    }
+    live.EndRun();
+}
+
+void Benchmark::RunPageSizes(const std::vector<std::vector<float>>& pool, const std::vector<int>& threadCounts)
+{
+    const size_t pixels = size_t(m_height * m_width);
+
+    // The same planes from an arena on regular pages and one on transparent huge pages
+    // (the module's default), each freshly mapped so the backing is the one asked for
+    for (HugePageMode mode : { HugePageMode::Off, HugePageMode::Transparent })
+    {
+        const bool huge = mode != HugePageMode::Off;
+
+        // Mapping and first touch of the accumulator planes: the page faults of a new run
+        std::unique_ptr<WorkspaceArena> fresh;
+        Result& touch = Add("hugepages", huge ? "first_touch_transparent" : "first_touch_regular", 1, 1);
+        touch.pixelUpdates = double(pixels);
+        touch.bytes = double(pixels) * ACCUMULATOR_BYTES_PER_PIXEL;
+        Measure(touch, m_options.repeat, [&]() { fresh.reset(); }, [&]()
+        {
+            fresh.reset(new WorkspaceArena(mode));
+            fresh->BeginRun();
+            ResetAccumulator(AcquirePlanes(*fresh, uint32_t(WorkspaceSlot::AccumulatorCount), pixels));
+        });
+        Report(touch);
+        fresh.reset();
+
+        WorkspaceArena arena(mode);
+        arena.BeginRun();
+        AccumulatorPlanes acc = AcquirePlanes(arena, uint32_t(WorkspaceSlot::AccumulatorCount), pixels);
+        float* fused = arena.Acquire<float>(WorkspaceSlot::Fused, pixels);
+        float* confidence = arena.Acquire<float>(WorkspaceSlot::Confidence, pixels);
+        uint8_t* classes = arena.Acquire<uint8_t>(WorkspaceSlot::Classification, pixels);
+        ResetAccumulator(acc);
+
+        for (size_t frames : m_options.frames)
+        {
+            std::vector<const float*> stack(frames);
+            for (size_t f = 0; f < frames; ++f)
+                stack[f] = pool[f % FRAME_POOL].data();
+
+            for (int threads : threadCounts)
+            {
+                Result& accumulate = Add("hugepages", huge ? "accumulate_transparent" : "accumulate_regular",
+                                         frames, threads);
+                accumulate.pixelUpdates = double(pixels) * frames;
+                accumulate.bytes = double(pixels) * (4.0 + 2.0 * ACCUMULATOR_BYTES_PER_PIXEL) * frames;
+                Measure(accumulate, m_options.repeat, [&]() { ResetAccumulator(acc); }, [&]()
+                {
+                    for (const float* frame : stack)
+                        ForSlices(pixels, threads, [&](size_t first, size_t count)
+                                  { AccumulateFrame(acc.Slice(first, count), frame + first); });
+                });
+                Report(accumulate);
+
+                Result& finalize = Add("hugepages", huge ? "finalize_transparent" : "finalize_regular",
+                                       frames, threads);
+                finalize.pixelUpdates = double(pixels);
+                finalize.bytes = double(pixels) * (ACCUMULATOR_BYTES_PER_PIXEL + OUTPUT_BYTES_PER_PIXEL);
+                Measure(finalize, m_options.repeat, []() {}, [&]()
+                {
+                    ForSlices(pixels, threads, [&](size_t first, size_t count)
+                              { FinalizeAccumulator(acc.Slice(first, count), fused + first,
+                                                    confidence + first, classes + first); });
+                });
+                Report(finalize);
+            }
+        }
+
+        const WorkspaceStats stats = arena.Stats();
+        fprintf(stderr, "  %-22s %s pages: %.1f MiB advised, %.1f MiB backed by huge pages%s%s\n", "hugepages",
+                huge ? "transparent huge" : "regular", stats.transparentAdvisedBytes / 1048576.0,
+                stats.transparentBackedBytes / 1048576.0, stats.hugePageNote.empty() ? "" : "; ",
+                stats.hugePageNote.c_str());
+    }
+}
+
+void Benchmark::RunLayout(const std::vector<std::vector<float>>& pool, const std::vector<int>& threadCounts)
+{
+    const size_t pixels = size_t(m_height * m_width);
+    using Objects = std::vector<std::unique_ptr<PixelObject>>;
+
+    // Planes of the same seven moments, owned here so both layouts are allocated and
+    // measured the same way
+    struct Planes
+    {
+        std::vector<uint16_t> n;
+        std::vector<float> mean, m2, m3, m4, min, max;
+
+        explicit Planes(size_t pixels)
+            : n(pixels), mean(pixels), m2(pixels), m3(pixels), m4(pixels),
+              min(pixels, std::numeric_limits<float>::infinity()), max(pixels, -std::numeric_limits<float>::infinity())
+        {
+        }
+
+        void Reset()
+        {
+            std::fill(n.begin(), n.end(), uint16_t(0));
+            for (std::vector<float>* plane : { &mean, &m2, &m3, &m4 })
+                std::fill(plane->begin(), plane->end(), 0.0f);
+            std::fill(min.begin(), min.end(), std::numeric_limits<float>::infinity());
+            std::fill(max.begin(), max.end(), -std::numeric_limits<float>::infinity());
+        }
+    };
+
+    // Resident growth of one allocation of each layout: its real memory cost, allocator
+    // overhead included. Heap freed by earlier sizes is returned first, so it is not reused
+    ReleaseFreedHeap();
+    const uint64_t empty = ResidentBytes();
+    Objects objects;
+    objects.reserve(pixels);
+    for (size_t i = 0; i < pixels; ++i)
+        objects.push_back(std::make_unique<PixelObject>());
+    const uint64_t withObjects = ResidentBytes();
+    std::unique_ptr<Planes> planes(new Planes(pixels));
+    const uint64_t withPlanes = ResidentBytes();
+    fprintf(stderr, "  %-22s resident: objects %.1f B/px, planes %.1f B/px\n", "layout",
+            double(withObjects - std::min(empty, withObjects)) / double(pixels),
+            double(withPlanes - std::min(withObjects, withPlanes)) / double(pixels));
+
+    // Allocation and initialization, single-threaded as the comprehension was
+    Result& objectsAlloc = Add("layout", "objects_alloc", 1, 1);
+    objectsAlloc.pixelUpdates = double(pixels);
+    objectsAlloc.bytes = double(pixels) * (sizeof(PixelObject) + sizeof(void*));
+    Measure(objectsAlloc, m_options.repeat, [&]() { Objects().swap(objects); }, [&]()
+    {
+        objects.reserve(pixels);
+        for (size_t i = 0; i < pixels; ++i)
+            objects.push_back(std::make_unique<PixelObject>());
+    });
+    Report(objectsAlloc);
+
+    Result& planesAlloc = Add("layout", "planes_alloc", 1, 1);
+    planesAlloc.pixelUpdates = double(pixels);
+    planesAlloc.bytes = double(pixels) * ACCUMULATOR_BYTES_PER_PIXEL;
+    Measure(planesAlloc, m_options.repeat, [&]() { planes.reset(); }, [&]() { planes.reset(new Planes(pixels)); });
+    Report(planesAlloc);
+
+    for (size_t frames : m_options.frames)
+    {
+        std::vector<const float*> stack(frames);
+        for (size_t f = 0; f < frames; ++f)
+            stack[f] = pool[f % FRAME_POOL].data();
+
+        for (int threads : threadCounts)
+        {
+            const double perFrameBytes = double(pixels) * (4.0 + 2.0 * ACCUMULATOR_BYTES_PER_PIXEL);
+
+            Result& perObject = Add("layout", "objects", frames, threads);
+            perObject.pixelUpdates = double(pixels) * frames;
+            perObject.bytes = perFrameBytes * frames;
+            Measure(perObject, m_options.repeat, [&]()
+            {
+                for (const auto& p : objects)
+                    *p = PixelObject();
+            }, [&]()
+            {
+                for (const float* frame : stack)
+                    ForSlices(pixels, threads, [&](size_t first, size_t count)
+                    {
+                        for (size_t i = first; i < first + count; ++i)
+                        {
+                            PixelObject& p = *objects[i];
+                            UpdatePixel(p.n, p.mean, p.m2, p.m3, p.m4, p.min, p.max, frame[i]);
+                        }
+                    });
+            });
+            Report(perObject);
+
+            Result& perPlane = Add("layout", "planes", frames, threads);
+            perPlane.pixelUpdates = perObject.pixelUpdates;
+            perPlane.bytes = perObject.bytes;
+            Measure(perPlane, m_options.repeat, [&]() { planes->Reset(); }, [&]()
+            {
+                Planes& q = *planes;
+                for (const float* frame : stack)
+                    ForSlices(pixels, threads, [&](size_t first, size_t count)
+                    {
+                        UpdatePlanes(q.n.data() + first, q.mean.data() + first, q.m2.data() + first,
+                                     q.m3.data() + first, q.m4.data() + first, q.min.data() + first,
+                                     q.max.data() + first, frame + first, count);
+                    });
+            });
+            Report(perPlane);
+
+            for (size_t i = 0; i < pixels; ++i)
+                if (objects[i]->n != planes->n[i] || std::memcmp(&objects[i]->mean, &planes->mean[i], sizeof(float)) != 0
+                    || std::memcmp(&objects[i]->m4, &planes->m4[i], sizeof(float)) != 0)
+                {
+                    m_mismatches.push_back("layout objects and planes differ");
+                    break;
+                }
+            fprintf(stderr, "  %-22s %2d thr  planes at %.2f× the per-object speed\n", "", threads,
+                    perObject.medianSeconds / perPlane.medianSeconds);
+        }
+    }
+}
+
+void Benchmark::CheckSynthetic(const SyntheticStack& generator, size_t frames, const AccumulatorPlanes& acc,
+                               float* fused, float* confidence, uint8_t* classes)
+{
+    SyntheticStackConfig config = generator.Config();
+    config.frames = frames;
+    const SyntheticStack stack(config);
+    const size_t pixels = stack.Pixels();
+
+    std::vector<float> frame(pixels);
+    ResetAccumulator(acc);
+    for (size_t f = 0; f < frames; ++f)
+    {
+        stack.GenerateFrame(f, frame.data());
+        AccumulateFrame(acc, frame.data());
+    }
+    FinalizeAccumulator(acc, fused, confidence, classes);
+
+    const SyntheticReference ref = SyntheticReference::Compute(stack, m_options.threads);
+    SyntheticCheck check;
+    check.height = m_height;
+    check.width = m_width;
+    check.frames = frames;
+    size_t agree = 0;
+    size_t expected[8] = {}, matched[8] = {};
+    for (size_t p = 0; p < pixels; ++p)
+    {
+        ++expected[ref.classes[p] & 7];
+        matched[ref.classes[p] & 7] += classes[p] == ref.classes[p];
+        check.meanMaxRelativeError = std::max(check.meanMaxRelativeError,
+                                              std::fabs(fused[p] - ref.mean[p]) / std::max(1.0, std::fabs(ref.mean[p])));
+        check.m2MaxRelativeError = std::max(check.m2MaxRelativeError,
+                                            std::fabs(acc.m2[p] - ref.m2[p]) / std::max(1.0, ref.m2[p]));
+        agree += classes[p] == ref.classes[p];
+    }
+    check.classAgreement = double(agree) / double(pixels);
+    m_checks.push_back(check);
+
+    fprintf(stderr, "  check       %zu frames: mean error %.2e, M2 error %.2e, classes %.4f%% as the ground truth expects\n",
+            frames, check.meanMaxRelativeError, check.m2MaxRelativeError, 100.0 * check.classAgreement);
+    // Per expected class, so a classifier blind to one feature shows which
+    static const char* const names[8] = { "", "gaussian", "poisson", "bimodal", "skewed right",
+                                          "skewed left", "uniform", "unknown" };
+    std::string byClass;
+    char text[64];
+    for (int code = 1; code < 8; ++code)
+        if (expected[code] > 0)
+        {
+            snprintf(text, sizeof(text), ", %s %.1f%% of %zu", names[code],
+                     100.0 * double(matched[code]) / double(expected[code]), expected[code]);
+            byClass += text;
+        }
+    fprintf(stderr, "  %-22s by expected class:%s\n", "", byClass.c_str() + 1);
+    if (!(check.meanMaxRelativeError <= MEAN_TOLERANCE))
+        m_mismatches.push_back("accumulated mean deviates from the exact synthetic reference");
+}
+
+void Benchmark::RunPipeline()
+{
+    m_height = PIPELINE_HEIGHT;
+    m_width = PIPELINE_WIDTH;
+    const size_t pixels = size_t(m_height * m_width);
+    const int threads = m_options.threads > 0 ? m_options.threads
+                                              : std::max(1, int(std::thread::hardware_concurrency()));
+    fprintf(stderr, "pipeline %lld×%lld, %zu frames\n", (long long)m_height, (long long)m_width, PIPELINE_FRAMES);
+
+    // Written once, untimed; the frames are then in the page cache, so the runs measure
+    // ingest, decode, kernels and output rather than the disk
+    SyntheticStackConfig synthetic;
+    synthetic.height = m_height;
+    synthetic.width = m_width;
+    synthetic.frames = PIPELINE_FRAMES;
+    synthetic.seed = m_options.seed;
+    const std::filesystem::path directory = std::filesystem::temp_directory_path()
+        / ("bayesianastro-pipeline-" + std::to_string(uint64_t(NowSeconds() * 1e6)));
+    std::vector<std::string> paths;
+    std::string error;
+    std::error_code ignored;
+    if (!SyntheticStack(synthetic).WriteFrames(directory.string(), "pipeline", threads, &paths, error))
+    {
+        m_mismatches.push_back("pipeline stack not written: " + error);
+        std::filesystem::remove_all(directory, ignored);
+        return;
+    }
+
+    m_arena.BeginRun();
+    AccumulatorPlanes acc = AcquirePlanes(m_arena, uint32_t(WorkspaceSlot::AccumulatorCount), pixels);
+    float* fused = m_arena.Acquire<float>(WorkspaceSlot::Fused, pixels);
+    float* confidence = m_arena.Acquire<float>(WorkspaceSlot::Confidence, pixels);
+    uint8_t* classes = m_arena.Acquire<uint8_t>(WorkspaceSlot::Classification, pixels);
+    const std::string output = (directory / "pipeline_fused.fits").string();
+
+    IngestOptions ingestOptions;
+    ingestOptions.cacheMode = IngestCacheMode::Buffered;
+    ingestOptions.workerThreads = threads;
+    PlaneWriteOptions writeOptions;
+    writeOptions.threads = threads;
+
+    // Per frame: 16-bit samples read and decoded, the accumulator read and written; then
+    // finalize and one float32 plane written
+    Result& pipeline = Add("pipeline", "end_to_end", PIPELINE_FRAMES, threads);
+    pipeline.pixelUpdates = double(pixels) * PIPELINE_FRAMES;
+    pipeline.bytes = double(pixels) * (PIPELINE_FRAMES * (2.0 + 4.0 + 2.0 * ACCUMULATOR_BYTES_PER_PIXEL)
+                                       + ACCUMULATOR_BYTES_PER_PIXEL + OUTPUT_BYTES_PER_PIXEL + 4.0);
+    Measure(pipeline, m_options.repeat, [&]() { ResetAccumulator(acc); }, [&]()
+    {
+        FrameIngest ingest(paths, ingestOptions, nullptr, &m_arena);
+        IngestFrame frame;
+        if (!ingest.Open(error))
+            return;
+        while (ingest.Next(frame, error))
+            ForSlices(pixels, threads, [&](size_t first, size_t count)
+                      { AccumulateFrame(acc.Slice(first, count), frame.pixels + first); });
+        ForSlices(pixels, threads, [&](size_t first, size_t count)
+                  { FinalizeAccumulator(acc.Slice(first, count), fused + first, confidence + first, classes + first); });
+        if (error.empty())
+            WriteFitsPlane(output, fused, m_height, m_width, writeOptions, {}, nullptr, error);
+    });
+    Report(pipeline);
+
+    if (!error.empty())
+        m_mismatches.push_back("pipeline failed: " + error);
+    std::filesystem::remove_all(directory, ignored);
+}
+
+bool Benchmark::Run()
+{
+    for (double megapixels : m_options.megapixels)
+        RunSize(megapixels);
+    if (m_options.pipeline)
+        RunPipeline();
+
+    for (const std::string& mismatch : m_mismatches)
+        fprintf(stderr, "** %s\n", mismatch.c_str());
+    return m_mismatches.empty();
+}
+
+std::string Benchmark::ToJson() const
+{
+    char line[1024];
+    std::string json = "{\n";
+
+    char timestamp[32];
+    time_t now = time(nullptr);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    snprintf(line, sizeof(line),
+             "  \"host\": {\"cpu\": \"%s\", \"hardware_threads\": %u, \"compiler\": \"%s\", "
+             "\"simd\": \"%s\", \"assertions\": %s},\n",
+             JsonEscape(CpuModel()).c_str(), std::thread::hardware_concurrency(), JsonEscape(__VERSION__).c_str(),
+             SimdLevel(),
+#ifdef NDEBUG
+             "false"
+#else
+             "true"
+#endif
+    );
+    json += line;
+    snprintf(line, sizeof(line), "  \"timestamp\": \"%s\",\n  \"repeat\": %d,\n  \"variants_identical\": %s,\n",
+             timestamp, m_options.repeat, m_mismatches.empty() ? "true" : "false");
+    json += line;
+
+    json += "  \"checks\": [\n";
+    for (size_t i = 0; i < m_checks.size(); ++i)
+    {
+        const SyntheticCheck& c = m_checks[i];
+        snprintf(line, sizeof(line),
+                 "    {\"height\": %lld, \"width\": %lld, \"frames\": %zu, \"seed\": %llu, "
+                 "\"mean_max_relative_error\": %.3e, \"m2_max_relative_error\": %.3e, "
+                 "\"class_agreement\": %.6f}%s\n",
+                 (long long)c.height, (long long)c.width, c.frames, (unsigned long long)m_options.seed,
+                 c.meanMaxRelativeError, c.m2MaxRelativeError, c.classAgreement,
+                 i + 1 == m_checks.size() ? "" : ",");
+        json += line;
+    }
+    json += "  ],\n";
+
+    json += "  \"results\": [\n";
+    for (size_t i = 0; i < m_results.size(); ++i)
+    {
+        const Result& r = m_results[i];
+        snprintf(line, sizeof(line),
+                 "    {\"kernel\": \"%s\", \"variant\": \"%s\", \"height\": %lld, \"width\": %lld, "
+                 "\"frames\": %zu, \"threads\": %d, \"median_seconds\": %.6e, \"min_seconds\": %.6e, "
+                 "\"mpix_per_second\": %.2f, \"gb_per_second\": %.3f",
+                 r.kernel.c_str(), r.variant.c_str(), (long long)r.height, (long long)r.width, r.frames,
+                 r.threads, r.medianSeconds, r.minSeconds, r.pixelUpdates / r.medianSeconds / 1e6,
+                 r.bytes / r.medianSeconds / 1e9);
+        json += line;
+        if (r.counterGroups > 0)
+        {
+            snprintf(line, sizeof(line), ", \"counter_groups\": %d, \"counters\": ", r.counterGroups);
+            json += line + r.counters.ToJson();
+        }
+        json += i + 1 == m_results.size() ? "}\n" : "},\n";
+    }
+    json += "  ]\n}\n";
+    return json;
+}
+
+void Benchmark::KeepFastest(const Benchmark& rerun)
+{
+    for (size_t i = 0; i < m_results.size() && i < rerun.m_results.size(); ++i)
+    {
+        Result& r = m_results[i];
+        const Result& other = rerun.m_results[i];
+        r.minSeconds = std::min(r.minSeconds, other.minSeconds);
+        r.medianSeconds = std::min(r.medianSeconds, other.medianSeconds);
+    }
+}
+
+int Benchmark::CompareBaseline(const std::vector<BaselineRecord>& baseline, bool report) const
+{
+    int regressed = 0, improved = 0, compared = 0;
+    std::vector<bool> matched(baseline.size(), false);
+    std::string missing;
+    for (const Result& r : m_results)
+    {
+        auto b = std::find_if(baseline.begin(), baseline.end(), [&](const BaselineRecord& record)
+        {
+            return record.kernel == r.kernel && record.variant == r.variant && record.height == r.height
+                && record.width == r.width && record.frames == (long long)r.frames && record.threads == r.threads;
+        });
+        if (b == baseline.end())
+        {
+            char name[160];
+            snprintf(name, sizeof(name), " %s/%s (%lld×%lld, %zu frames, %d thr)", r.kernel.c_str(), r.variant.c_str(),
+                     (long long)r.height, (long long)r.width, r.frames, r.threads);
+            missing += name;
+            continue;
+        }
+        matched[size_t(b - baseline.begin())] = true;
+        ++compared;
+
+        const double threshold = std::max(m_options.tolerance,
+                                          NOISE_FACTOR * std::max(Noise(b->medianSeconds, b->minSeconds),
+                                                                  Noise(r.medianSeconds, r.minSeconds)));
+        const double change = r.minSeconds / b->minSeconds - 1.0;
+        const bool measurable = std::fabs(r.minSeconds - b->minSeconds) > ABSOLUTE_NOISE_SECONDS;
+        if (measurable && change > threshold)
+        {
+            if (!report)
+            {
+                ++regressed;
+                continue;
+            }
+            if (regressed++ == 0)
+                fprintf(stderr, "Regressions against %s (fastest run, threshold = max(tolerance, %.0f× noise)):\n",
+                        m_options.baseline.c_str(), NOISE_FACTOR);
+            fprintf(stderr, "  %-11s %-10s %5lld×%-5lld %3zu frames %2d thr  %9.3f ms -> %9.3f ms  %+6.1f%%  (threshold %.1f%%)\n",
+                    r.kernel.c_str(), r.variant.c_str(), (long long)r.height, (long long)r.width, r.frames, r.threads,
+                    b->minSeconds * 1e3, r.minSeconds * 1e3, 100.0 * change, 100.0 * threshold);
+        }
+        else if (measurable && change < -threshold)
+            ++improved;
+    }
+    if (!report)
+        return regressed;
+
+    size_t dropped = 0;
+    for (bool m : matched)
+        dropped += !m;
+    fprintf(stderr, "Baseline: %d records compared, %d regressed, %d improved", compared, regressed, improved);
+    if (dropped > 0)
+        fprintf(stderr, ", %zu not run", dropped);
+    fprintf(stderr, "\n");
+    if (!missing.empty())
+        fprintf(stderr, "  Not in the baseline:%s\n", missing.c_str());
+    return regressed;
+}
+
+template <typename T>
+bool ParseList(const char* text, std::vector<T>& values)
+{
+    values.clear();
+    for (const char* p = text; *p != '\0';)
+    {
+        char* end = nullptr;
+        const double v = strtod(p, &end);
+        if (end == p || !(v > 0))
+            return false;
+        values.push_back(T(v));
+        p = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0')
+            return false;
+    }
+    return !values.empty();
+}
+
+void Usage()
+{
+    fprintf(stderr,
+            "Usage: BayesianAstroBenchmark [options]\n"
+            "  --sizes LIST     Image sizes in megapixels (default 1,4,16)\n"
+            "  --frames LIST    Frame counts for the accumulation kernels (default 8,32)\n"
+            "  --threads N      Threads for the parallel runs (default: hardware concurrency)\n"
+            "  --repeat N       Timed runs per measurement; the median is reported (default 5)\n"
+            "  --output FILE    Write JSON results to FILE instead of stdout\n"
+            "  --seed S         Synthetic stack seed (default 1)\n"
+            "  --check          Stream the first frame count of each size through the kernels and\n"
+            "                   compare with the exact synthetic reference\n"
+            "  --quick          Small smoke run (0.25 Mpx, 4 frames, 2 repeats)\n"
+            "  --trace FILE     Write a Chrome trace timeline of the timed runs to FILE\n"
+            "  --counters       Add perf_event hardware counters from one extra run per measurement\n"
+            "  --pipeline       Add the fixed end-to-end run (synthetic FITS stack through ingest,\n"
+            "                   accumulation, finalization and output)\n"
+            "  --baseline FILE  Compare with an earlier results file; exit status 3 on regressions\n"
+            "  --tolerance PCT  Slowdown always accepted by --baseline (default 10)\n"
+            "  --retries N      Reruns that must confirm a regression, keeping each record's\n"
+            "                   fastest time (default 2)\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool ok = true;
+        if (arg == "--quick")
+        {
+            options.megapixels = { 0.25 };
+            options.frames = { 4 };
+            options.repeat = 2;
+            continue;
+        }
+        if (arg == "--check")
+        {
+            options.check = true;
+            continue;
+        }
+        if (arg == "--counters")
+        {
+            options.counters = true;
+            continue;
+        }
+        if (arg == "--pipeline")
+        {
+            options.pipeline = true;
+            continue;
+        }
+        if (arg == "--help" || arg == "-h")
+        {
+            Usage();
+            return 0;
+        }
+        if (value == nullptr)
+            ok = false;
+        else if (arg == "--sizes")
+            ok = ParseList(value, options.megapixels);
+        else if (arg == "--frames")
+            ok = ParseList(value, options.frames);
+        else if (arg == "--threads")
+            ok = (options.threads = atoi(value)) > 0;
+        else if (arg == "--repeat")
+            ok = (options.repeat = atoi(value)) > 0;
+        else if (arg == "--output")
+            options.output = value;
+        else if (arg == "--seed")
+            options.seed = strtoull(value, nullptr, 10);
+        else if (arg == "--trace")
+            options.trace = value;
+        else if (arg == "--baseline")
+            options.baseline = value;
+        else if (arg == "--tolerance")
+            ok = (options.tolerance = atof(value) / 100.0) > 0.0;
+        else if (arg == "--retries")
+            ok = (options.retries = atoi(value)) >= 0;
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            fprintf(stderr, "Invalid argument: %s\n", arg.c_str());
+            Usage();
+            return 2;
+        }
+        ++i;
+    }
+
+    if (!options.trace.empty())
+    {
+        SetTraceThreadName("benchmark");
+        StartTrace();
+    }
+
+    if (options.counters)
+    {
+        // Probe once: the reason is reported, and runs go on without counters if none open
+        CounterGroup probe;
+        std::string note;
+        g_counters = probe.Open(0, note);
+        if (!note.empty())
+            fprintf(stderr, "Hardware counters: %s\n", note.c_str());
+    }
+
+    std::vector<BaselineRecord> baseline;
+    if (!options.baseline.empty())
+    {
+        std::string cpu, error;
+        if (!LoadBaseline(options.baseline, baseline, cpu, error))
+        {
+            fprintf(stderr, "** Cannot load baseline: %s\n", error.c_str());
+            return 1;
+        }
+        if (!cpu.empty() && cpu != JsonEscape(CpuModel()))
+            fprintf(stderr, "** Baseline was recorded on a different CPU (%s)\n", cpu.c_str());
+    }
+
+    Benchmark benchmark(options);
+    bool consistent = benchmark.Run();
+
+    if (!options.trace.empty())
+    {
+        StopTrace();
+        std::string error;
+        if (!WriteChromeTrace(options.trace, error))
+        {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        fprintf(stderr, "Trace: %s\n", options.trace.c_str());
+    }
+
+    // A slowdown has to show in every rerun: each record keeps its fastest time over the
+    // runs, so a record regresses only if no run matched the baseline
+    int regressed = 0;
+    if (!baseline.empty())
+    {
+        regressed = benchmark.CompareBaseline(baseline, false);
+        for (int retry = 1; retry <= options.retries && regressed > 0; ++retry)
+        {
+            fprintf(stderr, "%d records slower than the baseline; rerun %d of %d to confirm\n",
+                    regressed, retry, options.retries);
+            Options rerunOptions = options;
+            rerunOptions.check = false;
+            Benchmark rerun(rerunOptions);
+            consistent = rerun.Run() && consistent;
+            benchmark.KeepFastest(rerun);
+            regressed = benchmark.CompareBaseline(baseline, false);
+        }
+        regressed = benchmark.CompareBaseline(baseline, true);
+    }
+
+    const std::string json = benchmark.ToJson();
+
+    if (options.output.empty())
+    {
+        fputs(json.c_str(), stdout);
+    }
+    else
+    {
+        FILE* f = fopen(options.output.c_str(), "wb");
+        if (f == nullptr || fwrite(json.data(), 1, json.size(), f) != json.size() || fclose(f) != 0)
+        {
+            fprintf(stderr, "Cannot write %s\n", options.output.c_str());
+            return 1;
+        }
+        fprintf(stderr, "Results: %s\n", options.output.c_str());
+    }
+
+    if (!consistent)
+        return 1;
+    return regressed > 0 ? 3 : 0;
+}
@@ -0,0 +1,445 @@
+/**
+ * Headless Stacking Command Line
+ *
+ * Runs a stack through the same engine as the PixInsight module (native ingest,
+ * memory planner, Julia accumulation and finalization, output encodings) without
+ * PCL or Qt, for render nodes and unattended batch runs. Inputs are files, shell
+ * style globs (expanded here, so quoted patterns work from job schedulers that
+ * run without a shell) and list files with one path per line. Every
+ * ProcessingConfig option has a flag. The report goes to stdout, progress to
+ * stderr; the metrics JSON (and trace) are written next to the outputs as in the
+ * module. Exit status: 0 on success, 1 if the run failed, 2 on a usage error.
+ *
+ * Usage:
+ *     BayesianAstroCLI --output DIR [options] FILE|GLOB ... [--list FILE]
+ */
+
+#include "JuliaRuntime.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <glob.h>
+#endif
+
+using namespace pcl;
+
+namespace
+{
+
+struct Options
+{
+    std::vector<std::string> inputs;
+    std::string outputDirectory;
+    std::string prefix = "bayesian";
+    std::string juliaHome;
+    std::string juliaModule;        // Directory holding BayesianAstro.jl; empty = ./julia
+    int juliaThreads = 0;           // 0 = JULIA_NUM_THREADS or Julia's default
+    bool quiet = false;
+    ProcessingConfig config;
+};
+
+void Usage()
+{
+    fprintf(stderr,
+            "Usage: BayesianAstroCLI --output DIR [options] FILE|GLOB ... [--list FILE]\n"
+            "Inputs:\n"
+            "  FILE|GLOB              Input frames; globs (*, ?, [..]) are expanded and sorted\n"
+            "  --list FILE            One input path or glob per line ('#' comments, '-' = stdin)\n"
+            "  --output DIR           Output directory (created if missing)\n"
+            "  --prefix NAME          Output file prefix (default bayesian)\n"
+            "Stacking:\n"
+            "  --fusion NAME          mle | confidence | lucky | multiscale (default confidence)\n"
+            "  --confidence-threshold X   (default 0.1)\n"
+            "  --outlier-sigma X      (default 3.0)\n"
+            "  --tile WxH             Julia tile size (default 1024x1024)\n"
+            "  --gpu | --no-gpu       CUDA when available (default --gpu)\n"
+            "Resources:\n"
+            "  --threads N            Native workers: header scan, reads, output (default: all cores)\n"
+            "  --julia-threads N      Julia threads for accumulation and finalization\n"
+            "  --memory MB            RAM budget for the memory planner (default: from system RAM)\n"
+            "  --huge-pages MODE      off | transparent | hugetlb (default transparent)\n"
+            "Ingest:\n"
+            "  --ingest NAME          auto | io_uring | pread (default auto)\n"
+            "  --page-cache MODE      auto | buffered | direct | drop-behind (default auto)\n"
+            "  --packed-cache MODE    off | float32 | float16 (default off)\n"
+            "Outputs:\n"
+            "  --fused-encoding E     float32 | float16 | uint16 (default float32)\n"
+            "  --confidence-encoding E    float32 | float16 | uint16 (default float32)\n"
+            "  --no-confidence        Do not write the confidence map\n"
+            "  --classification E     none | uint8 | packed4 (default none)\n"
+            "  --compress             Tile-compress output planes\n"
+            "Profiling:\n"
+            "  --trace                Write <prefix>_trace.json (Chrome trace timeline)\n"
+            "  --counters             Sample hardware counters per phase and thread\n"
+            "Reproducibility:\n"
+            "  --deterministic        Summary statistics bit-identical on any core count\n"
+            "Runtime:\n"
+            "  --julia-home DIR       Julia installation (sets JULIA_HOME)\n"
+            "  --julia-module DIR     Directory containing BayesianAstro.jl (default ./julia,\n"
+            "                         or $BAYESIANASTRO_JULIA)\n"
+            "  --quiet                No progress lines\n");
+}
+
+// Index of 'value' in 'names', or -1
+int ParseChoice(const char* value, std::initializer_list<const char*> names)
+{
+    int index = 0;
+    for (const char* name : names)
+    {
+        if (strcmp(value, name) == 0)
+            return index;
+        ++index;
+    }
+    return -1;
+}
+
+bool ParseFloat(const char* text, float& value)
+{
+    char* end = nullptr;
+    value = strtof(text, &end);
+    return end != text && *end == '\0';
+}
+
+bool ParseTile(const char* text, int& x, int& y)
+{
+    char* end = nullptr;
+    x = int(strtol(text, &end, 10));
+    if (end == text || (*end != 'x' && *end != 'X'))
+        return false;
+    const char* rest = end + 1;
+    y = int(strtol(rest, &end, 10));
+    return end != rest && *end == '\0' && x > 0 && y > 0;
+}
+
+bool ParseEncoding(const char* text, PlaneEncoding& encoding)
+{
+    const int choice = ParseChoice(text, { "float32", "float16", "uint16" });
+    if (choice < 0)
+        return false;
+    encoding = PlaneEncoding(choice);       // Same order as the enum
+    return true;
+}
+
+bool IsPattern(const std::string& path)
+{
+    return path.find_first_of("*?[") != std::string::npos;
+}
+
+// Append the files 'pattern' names: itself, or its sorted glob matches
+bool ExpandInput(const std::string& pattern, std::vector<std::string>& files, std::string& error)
+{
+#ifndef _WIN32
+    if (IsPattern(pattern))
+    {
+        glob_t matches;
+        const int status = glob(pattern.c_str(), 0, nullptr, &matches);
+        if (status == 0)
+            files.insert(files.end(), matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+        globfree(&matches);
+        if (status != 0)
+        {
+            error = status == GLOB_NOMATCH ? "no files match " + pattern : "cannot expand " + pattern;
+            return false;
+        }
+        return true;
+    }
+#endif
+    files.push_back(pattern);
+    return true;
+}
+
+bool ReadList(const std::string& path, std::vector<std::string>& patterns, std::string& error)
+{
+    std::ifstream file;
+    if (path != "-")
+    {
+        file.open(path);
+        if (!file)
+        {
+            error = "cannot read " + path;
+            return false;
+        }
+    }
+    std::istream& in = path == "-" ? std::cin : file;
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+            continue;
+        const size_t last = line.find_last_not_of(" \t\r");
+        patterns.push_back(line.substr(first, last - first + 1));
+    }
+    return true;
+}
+
+void PrintReport(const ProcessingResult& result, const ProcessingConfig& config)
+{
+    printf("Fused image: %s\n", result.fusedImagePath.c_str());
+    if (config.output.writeConfidence)
+        printf("Confidence map: %s\n", result.confidenceMapPath.c_str());
+    if (!result.classificationMapPath.empty())
+        printf("Classification map: %s\n", result.classificationMapPath.c_str());
+    if (result.output.fileBytes > 0)
+        printf("Outputs: %.2f MB written (%.1f%% of float32) in %.3f s\n",
+               result.output.fileBytes / 1048576.0,
+               100.0 * result.output.fileBytes / result.output.float32Bytes, result.output.seconds);
+    printf("Mean confidence: %.3f\n", result.meanConfidence);
+    if (config.deterministic)
+        printf("Deterministic summary: fixed reduction tree in %.3f ms\n", result.reductionSeconds * 1e3);
+    printf("Pixels: %d gaussian, %d poisson, %d bimodal, %d artifact of %d\n",
+           result.gaussianPixels, result.poissonPixels, result.bimodalPixels, result.artifactPixels,
+           result.totalPixels);
+    printf("Memory plan: %s\n", result.memoryPlan.Describe().c_str());
+
+    printf("Frame catalog: %u cached, %u scanned in %.3f s\n",
+           unsigned(result.catalog.cached), unsigned(result.catalog.scanned), result.catalog.seconds);
+    const IngestStats& ingest = result.ingest;
+    printf("Ingest backend: %s, page cache: %s\n", ingest.backend.c_str(), ingest.cacheMode.c_str());
+    if (!ingest.note.empty())
+        fprintf(stderr, "** %s\n", ingest.note.c_str());
+    printf("Ingest: %.1f MB/s, queue depth %.1f avg / %d peak, %llu reads\n",
+           ingest.MegabytesPerSecond(), ingest.averageQueueDepth, ingest.peakQueueDepth,
+           (unsigned long long)ingest.reads);
+    if (config.ingest.packedCache != PackedCacheMode::Off)
+        printf("Packed cache: %llu frames mapped, %llu entries written\n",
+               (unsigned long long)ingest.packedHits, (unsigned long long)ingest.packedWrites);
+    if (!result.workspace.hugePageNote.empty())
+        fprintf(stderr, "** %s\n", result.workspace.hugePageNote.c_str());
+
+    const RunMetrics& metrics = result.metrics;
+    printf("Phase        time (s)  peak RSS (MB)  arena HWM (MB)  Julia alloc (MB)  GC (s)\n");
+    for (int i = 0; i < int(RunPhase::Count); ++i)
+    {
+        const PhaseMetrics& phase = metrics.phases[i];
+        if (phase.intervals == 0)
+            continue;
+        printf("%-10s %10.3f %14.1f %15.1f %17.1f %7.3f\n",
+               RunPhaseName(RunPhase(i)), phase.seconds, phase.peakRssBytes / 1048576.0,
+               phase.arenaHighWaterBytes / 1048576.0, phase.juliaAllocatedBytes / 1048576.0,
+               phase.juliaGcSeconds);
+    }
+    printf("Peak RSS: %.1f MB\n", metrics.peakRssBytes / 1048576.0);
+    if (config.hardwareCounters)
+    {
+        if (metrics.countersEnabled)
+        {
+            printf("Phase        IPC  cache miss  branch miss  est. DRAM (GB/s)  CPU (s)  threads\n");
+            for (int i = 0; i < int(RunPhase::Count); ++i)
+            {
+                const PhaseMetrics& phase = metrics.phases[i];
+                if (phase.intervals == 0)
+                    continue;
+                const CounterValues& c = phase.counters;
+                printf("%-10s %5.2f %10.1f%% %11.2f%% %17.2f %8.3f %8u\n",
+                       RunPhaseName(RunPhase(i)), c.InstructionsPerCycle(),
+                       100.0 * c.CacheMissRate(), 100.0 * c.BranchMissRate(),
+                       c.MemoryBytes() / phase.seconds / 1e9,
+                       c[CounterEvent::TaskClock] * 1e-9, unsigned(phase.threads.size()));
+            }
+        }
+        if (!metrics.countersNote.empty())
+            fprintf(stderr, "** Hardware counters: %s\n", metrics.countersNote.c_str());
+    }
+    if (!result.metricsPath.empty())
+        printf("Metrics: %s\n", result.metricsPath.c_str());
+    if (!result.tracePath.empty())
+        printf("Trace: %s\n", result.tracePath.c_str());
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    ProcessingConfig& config = options.config;
+    config.previewPyramid = false;  // Nothing views the result here
+    config.previewHistograms = false;
+    std::vector<std::string> patterns;
+    std::vector<std::string> lists;
+
+    if (const char* modulePath = getenv("BAYESIANASTRO_JULIA"))
+        options.juliaModule = modulePath;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+        {
+            Usage();
+            return 0;
+        }
+        if (arg.compare(0, 2, "--") != 0)
+        {
+            patterns.push_back(arg);
+            continue;
+        }
+
+        // Switches
+        bool known = true;
+        if (arg == "--gpu")
+            config.useGPU = true;
+        else if (arg == "--no-gpu")
+            config.useGPU = false;
+        else if (arg == "--no-confidence")
+            config.output.writeConfidence = false;
+        else if (arg == "--compress")
+            config.output.compress = true;
+        else if (arg == "--trace")
+            config.trace = true;
+        else if (arg == "--counters")
+            config.hardwareCounters = true;
+        else if (arg == "--deterministic")
+            config.deterministic = true;
+        else if (arg == "--quiet")
+            options.quiet = true;
+        else
+            known = false;
+        if (known)
+            continue;
+
+        const char* value = i + 1 < argc ? argv[++i] : nullptr;
+        int choice = 0;
+        double megabytes = 0.0;
+        bool ok = true;
+        if (value == nullptr)
+            ok = false;
+        else if (arg == "--list")
+            lists.push_back(value);
+        else if (arg == "--output")
+            options.outputDirectory = value;
+        else if (arg == "--prefix")
+            ok = *(options.prefix = value).c_str() != '\0';
+        else if (arg == "--fusion")
+            ok = (choice = ParseChoice(value, { "mle", "confidence", "lucky", "multiscale" })) >= 0
+              && (config.fusionStrategy = FusionStrategy(choice + 1), true);        // Julia is 1-indexed
+        else if (arg == "--confidence-threshold")
+            ok = ParseFloat(value, config.confidenceThreshold);
+        else if (arg == "--outlier-sigma")
+            ok = ParseFloat(value, config.outlierSigma) && config.outlierSigma > 0.0f;
+        else if (arg == "--tile")
+            ok = ParseTile(value, config.tileSizeX, config.tileSizeY);
+        else if (arg == "--threads")
+            ok = (config.threads = atoi(value)) > 0;
+        else if (arg == "--julia-threads")
+            ok = (options.juliaThreads = atoi(value)) > 0;
+        else if (arg == "--memory")
+            ok = (megabytes = atof(value)) > 0.0 && (config.memoryBudget = uint64_t(megabytes * 1048576.0), true);
+        else if (arg == "--huge-pages")
+            ok = (choice = ParseChoice(value, { "off", "transparent", "hugetlb" })) >= 0
+              && (config.hugePages = HugePageMode(choice), true);
+        else if (arg == "--ingest")
+            ok = (choice = ParseChoice(value, { "auto", "io_uring", "pread" })) >= 0
+              && (config.ingest.backend = IngestBackendType(choice), true);
+        else if (arg == "--page-cache")
+            ok = (choice = ParseChoice(value, { "auto", "buffered", "direct", "drop-behind" })) >= 0
+              && (config.ingest.cacheMode = IngestCacheMode(choice), true);
+        else if (arg == "--packed-cache")
+            ok = (choice = ParseChoice(value, { "off", "float32", "float16" })) >= 0
+              && (config.ingest.packedCache = PackedCacheMode(choice), true);
+        else if (arg == "--fused-encoding")
+            ok = ParseEncoding(value, config.output.fusedEncoding);
+        else if (arg == "--confidence-encoding")
+            ok = ParseEncoding(value, config.output.confidenceEncoding);
+        else if (arg == "--classification")
+        {
+            ok = (choice = ParseChoice(value, { "none", "uint8", "packed4" })) >= 0;
+            config.output.writeClassification = choice > 0;
+            config.output.classificationEncoding = choice == 1 ? PlaneEncoding::UInt8 : PlaneEncoding::Packed4;
+        }
+        else if (arg == "--julia-home")
+            options.juliaHome = value;
+        else if (arg == "--julia-module")
+            options.juliaModule = value;
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            fprintf(stderr, "Invalid argument: %s\n", arg.c_str());
+            Usage();
+            return 2;
+        }
+    }
+
+    std::string error;
+    for (const std::string& list : lists)
+        if (!ReadList(list, patterns, error))
+        {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+    for (const std::string& pattern : patterns)
+        if (!ExpandInput(pattern, options.inputs, error))
+        {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+
+    if (options.inputs.empty() || options.outputDirectory.empty())
+    {
+        fprintf(stderr, options.inputs.empty() ? "No input files specified.\n" : "No output directory specified.\n");
+        Usage();
+        return 2;
+    }
+
+    std::error_code directoryError;
+    std::filesystem::create_directories(options.outputDirectory, directoryError);
+    if (directoryError)
+    {
+        fprintf(stderr, "Cannot create %s: %s\n", options.outputDirectory.c_str(), directoryError.message().c_str());
+        return 1;
+    }
+
+    // Julia reads its thread count once, when the runtime starts
+    if (options.juliaThreads > 0)
+    {
+        static std::string envVar;
+        envVar = "JULIA_NUM_THREADS=" + std::to_string(options.juliaThreads);
+        putenv(const_cast<char*>(envVar.c_str()));
+    }
+
+    JuliaRuntime& runtime = JuliaRuntime::Instance();
+    if (!runtime.Initialize(options.juliaHome, options.juliaModule))
+    {
+        fprintf(stderr, "Julia runtime could not be initialized (module path: %s)\n",
+                options.juliaModule.empty() ? "./julia" : options.juliaModule.c_str());
+        return 1;
+    }
+
+    printf("BayesianAstro: %zu frames -> %s/%s_*\n", options.inputs.size(),
+           options.outputDirectory.c_str(), options.prefix.c_str());
+    if (config.useGPU)
+        printf("GPU: %s\n", runtime.GetGPUInfo().c_str());
+    fflush(stdout);
+
+    ProgressCallback progress;
+    if (!options.quiet)
+        progress = [](int percent, const std::string& status)
+        {
+            fprintf(stderr, "[%3d%%] %s\n", percent, status.c_str());
+        };
+
+    const ProcessingResult result = runtime.ProcessStack(options.inputs, options.outputDirectory,
+                                                         options.prefix, config, progress);
+    if (!result.success)
+    {
+        fprintf(stderr, "** Processing failed: %s\n", result.errorMessage.c_str());
+        runtime.Shutdown();
+        return 1;
+    }
+
+    PrintReport(result, config);
+    runtime.Shutdown();
+    return 0;
+}
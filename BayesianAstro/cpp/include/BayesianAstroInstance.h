@@ -11,10 +11,18 @@
 #include <pcl/StringList.h>
 
 #include "BayesianAstroParameters.h"
+#include "StageGraph.h"
+
+#include <string>
+#include <vector>
 
 namespace pcl
 {
 
+class LivePreview;
+class ProgressAggregator;
+struct ProcessingConfig;
+
 class BayesianAstroInstance : public ProcessImplementation
 {
 public:
@@ -58,6 +66,57 @@ public:
     const String& OutputPrefix() const { return p_outputPrefix; }
     void SetOutputPrefix(const String& v) { p_outputPrefix = v; }
 
+    pcl_enum IngestBackendMode() const { return p_ingestBackend; }
+    void SetIngestBackendMode(pcl_enum v) { p_ingestBackend = v; }
+
+    pcl_enum IngestCachePolicy() const { return p_ingestCacheMode; }
+    void SetIngestCachePolicy(pcl_enum v) { p_ingestCacheMode = v; }
+
+    pcl_enum IngestPackedCacheMode() const { return p_ingestPackedCache; }
+    void SetIngestPackedCacheMode(pcl_enum v) { p_ingestPackedCache = v; }
+
+    pcl_enum FusedPlaneEncoding() const { return p_fusedEncoding; }
+    void SetFusedPlaneEncoding(pcl_enum v) { p_fusedEncoding = v; }
+
+    pcl_enum ConfidencePlaneEncoding() const { return p_confidenceEncoding; }
+    void SetConfidencePlaneEncoding(pcl_enum v) { p_confidenceEncoding = v; }
+
+    pcl_enum ClassificationPlaneEncoding() const { return p_classificationEncoding; }
+    void SetClassificationPlaneEncoding(pcl_enum v) { p_classificationEncoding = v; }
+
+    bool CompressOutput() const { return p_compressOutput; }
+    void SetCompressOutput(bool v) { p_compressOutput = v; }
+
+    // RAM budget in MiB; 0 = DEFAULT_MEMORY_BUDGET_FRACTION of physical memory
+    double MemoryBudgetMiB() const { return p_memoryBudget; }
+    void SetMemoryBudgetMiB(double v) { p_memoryBudget = float(v); }
+
+    pcl_enum HugePagePolicy() const { return p_hugePages; }
+    void SetHugePagePolicy(pcl_enum v) { p_hugePages = v; }
+
+    bool TraceTimeline() const { return p_traceTimeline; }
+    void SetTraceTimeline(bool v) { p_traceTimeline = v; }
+
+    bool HardwareCounters() const { return p_hardwareCounters; }
+    void SetHardwareCounters(bool v) { p_hardwareCounters = v; }
+
+    bool DeterministicReduction() const { return p_deterministicReduction; }
+    void SetDeterministicReduction(bool v) { p_deterministicReduction = v; }
+
+    // Run progress counters for the UI bridge; not a parameter, never copied
+    void SetProgressAggregator(ProgressAggregator* progress) { m_progress = progress; }
+
+    // Progressive snapshots of a running stack for the UI; not a parameter, never copied
+    void SetLivePreview(LivePreview* live) { m_livePreview = live; }
+
+    // Stages Execute would compute with the current inputs and parameters
+    StagePlan PlannedStages() const;
+
+    // Re-finalize the accumulators the last run left in the session with the current
+    // parameters, for the preview only (nothing is written). False when there is nothing
+    // to do, or the frames would have to be read again; 'seconds' is the time it took
+    bool RefinalizePreview(double& seconds);
+
 private:
     // Parameters
     pcl_enum   p_fusionStrategy;
@@ -68,10 +127,27 @@ private:
     pcl_bool   p_generateConfidenceMap;
     String     p_outputDirectory;
     String     p_outputPrefix;
+    pcl_enum   p_ingestBackend;
+    pcl_enum   p_ingestCacheMode;
+    pcl_enum   p_ingestPackedCache;
+    pcl_enum   p_fusedEncoding;
+    pcl_enum   p_confidenceEncoding;
+    pcl_enum   p_classificationEncoding;
+    pcl_bool   p_compressOutput;
+    float      p_memoryBudget;
+    pcl_enum   p_hugePages;
+    pcl_bool   p_traceTimeline;
+    pcl_bool   p_hardwareCounters;
+    pcl_bool   p_deterministicReduction;
+
+    ProgressAggregator* m_progress = nullptr;
+    LivePreview* m_livePreview = nullptr;
 
     // Internal methods
     bool ValidateInputFiles() const;
     void ProcessStack();
+    std::vector<std::string> InputPaths() const;
+    void BuildConfig(ProcessingConfig& config) const;
 
     friend class BayesianAstroProcess;
     friend class BayesianAstroInterface;
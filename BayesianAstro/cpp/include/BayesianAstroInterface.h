@@ -11,14 +11,59 @@
 #include <pcl/Sizer.h>
 
 #include <QtWebEngineWidgets/QWebEngineView>
+#include <QtWebEngineCore/QWebEngineUrlSchemeHandler>
 #include <QtWebChannel/QWebChannel>
+#include <QTimer>
+#include <QVariantList>
+#include <QVariantMap>
 #include <QWidget>
 
 #include "BayesianAstroInstance.h"
+#include "FrameCatalog.h"
+#include "LivePreview.h"
+#include "PreviewTiles.h"
+#include "ProgressAggregator.h"
 
 namespace pcl
 {
 
+// Interval between coalesced status updates pushed to JavaScript during a run
+constexpr int PROGRESS_REFRESH_MS = 100;
+
+// Quiet time after the last fusion strategy change before the preview is refinalized,
+// so changing it repeatedly refinalizes once rather than per step
+constexpr int REFINALIZE_DELAY_MS = 250;
+
+// Preview tiles: bayesianastro://preview/<generation>/<plane>/<level>/<x>/<y>.png, and
+// the same path under 'live' for snapshots of a running stack. Result plane histograms:
+// bayesianastro://histogram/<generation>/<plane>.bin (PlaneHistogram::Serialize)
+constexpr const char* PREVIEW_SCHEME = "bayesianastro";
+constexpr const char* PREVIEW_HOST = "preview";
+constexpr const char* PREVIEW_LIVE_HOST = "live";
+constexpr const char* PREVIEW_HISTOGRAM_HOST = "histogram";
+
+// Register the preview scheme with Qt WebEngine; must run at module installation,
+// before any web engine profile exists
+void RegisterPreviewScheme();
+
+// Serves preview tiles of the last run straight from the engine's output planes, and
+// of the latest live snapshot while a run accumulates; and the last run's histograms
+class BayesianAstroTileHandler : public QWebEngineUrlSchemeHandler
+{
+public:
+    explicit BayesianAstroTileHandler(const LivePreview* live, QObject* parent = nullptr);
+
+    void requestStarted(QWebEngineUrlRequestJob* job) override;
+
+private:
+    void ServeHistogram(QWebEngineUrlRequestJob* job, const QStringList& parts);
+
+    const LivePreview* m_live;
+    PreviewTiler m_tiler;
+    PreviewTiler m_liveTiler;
+    std::shared_ptr<const LiveSnapshot> m_liveSnapshot;    // Keeps m_liveTiler's planes alive
+};
+
 // Bridge object exposed to JavaScript via QWebChannel
 class BayesianAstroBridge : public QObject
 {
@@ -51,17 +96,26 @@ public:
     // Link to instance
     void SetInstance(BayesianAstroInstance* instance) { m_instance = instance; }
 
+    // Reload per-frame stats for the instance's input files from the frame catalog
+    void RefreshFrameStats();
+
+    // Snapshots of the running stack, for the tile handler
+    const LivePreview* Live() const { return &m_live; }
+
 public slots:
     // Called from JavaScript
     void addFiles(const QStringList& paths);
     void removeFile(int index);
     void clearFiles();
     QStringList getFiles() const;
+    QVariantList getFrameStats() const;
+    QVariantMap getPreviewInfo() const;
+    QVariantList getStagePlan() const;
     void execute();
     void setOutputDirectory(const QString& path);
     void setOutputPrefix(const QString& prefix);
 
-    // Progress reporting
+    // Progress reporting; coalesced into the next statusUpdated
     void reportProgress(int percent, const QString& status);
 
 signals:
@@ -71,11 +125,28 @@ signals:
     void useGPUChanged();
     void generateConfidenceMapChanged();
     void filesChanged();
-    void progressUpdated(int percent, const QString& status);
+    void previewChanged();
+    // One status object per refresh tick: phase, percent, status, frames, fps, MB/s, ETA, memory
+    void statusUpdated(const QVariantMap& status);
     void executionComplete(bool success, const QString& message);
 
 private:
+    // Sample the engine's progress counters and emit at most one statusUpdated
+    void PublishProgress();
+
+    // Emit previewChanged when a new live snapshot has been gathered
+    void PublishLivePreview();
+
+    // Refinalize the last run's accumulators with the current parameters, for the preview
+    void RefinalizePreview();
+
     BayesianAstroInstance* m_instance = nullptr;
+    FrameHeaderTable m_frameStats;
+    ProgressAggregator m_progress;
+    QTimer m_progressTimer;
+    QTimer m_refinalizeTimer;
+    LivePreview m_live;
+    uint64_t m_liveGeneration = 0;     // Last snapshot announced to JavaScript
 };
 
 class BayesianAstroInterface : public ProcessInterface
@@ -114,6 +114,192 @@ public:
     String DefaultValue() const override;
 };
 
+// Native ingest backend
+class BAIngestBackend : public MetaEnumeration
+{
+public:
+    enum { Auto = 0,
+           IoUring = 1,
+           ThreadPool = 2,
+           NumberOfItems,
+           Default = Auto };
+
+    BAIngestBackend(MetaProcess*);
+
+    IsoString Id() const override;
+    size_type NumberOfElements() const override;
+    IsoString ElementId(size_type) const override;
+    int ElementValue(size_type) const override;
+    size_type DefaultValueIndex() const override;
+};
+
+// Page cache policy for frame ingest
+class BAIngestCacheMode : public MetaEnumeration
+{
+public:
+    enum { Auto = 0,
+           Buffered = 1,
+           DirectIO = 2,
+           DropBehind = 3,
+           NumberOfItems,
+           Default = Auto };
+
+    BAIngestCacheMode(MetaProcess*);
+
+    IsoString Id() const override;
+    size_type NumberOfElements() const override;
+    IsoString ElementId(size_type) const override;
+    int ElementValue(size_type) const override;
+    size_type DefaultValueIndex() const override;
+};
+
+// Decoded-frame cache for repeated runs over the same data
+class BAIngestPackedCache : public MetaEnumeration
+{
+public:
+    enum { Off = 0,
+           Float32 = 1,
+           Float16 = 2,
+           NumberOfItems,
+           Default = Off };
+
+    BAIngestPackedCache(MetaProcess*);
+
+    IsoString Id() const override;
+    size_type NumberOfElements() const override;
+    IsoString ElementId(size_type) const override;
+    int ElementValue(size_type) const override;
+    size_type DefaultValueIndex() const override;
+};
+
+// Storage encoding of the fused image and confidence map planes
+class BAFusedEncoding : public MetaEnumeration
+{
+public:
+    enum { Float32 = 0,
+           Float16 = 1,
+           UInt16 = 2,
+           NumberOfItems,
+           Default = Float32 };
+
+    BAFusedEncoding(MetaProcess*);
+
+    IsoString Id() const override;
+    size_type NumberOfElements() const override;
+    IsoString ElementId(size_type) const override;
+    int ElementValue(size_type) const override;
+    size_type DefaultValueIndex() const override;
+};
+
+class BAConfidenceEncoding : public MetaEnumeration
+{
+public:
+    enum { Float32 = 0,
+           Float16 = 1,
+           UInt16 = 2,
+           NumberOfItems,
+           Default = Float32 };
+
+    BAConfidenceEncoding(MetaProcess*);
+
+    IsoString Id() const override;
+    size_type NumberOfElements() const override;
+    IsoString ElementId(size_type) const override;
+    int ElementValue(size_type) const override;
+    size_type DefaultValueIndex() const override;
+};
+
+// Classification map output (None disables it)
+class BAClassificationEncoding : public MetaEnumeration
+{
+public:
+    enum { None = 0,
+           UInt8 = 1,
+           Packed4 = 2,
+           NumberOfItems,
+           Default = None };
+
+    BAClassificationEncoding(MetaProcess*);
+
+    IsoString Id() const override;
+    size_type NumberOfElements() const override;
+    IsoString ElementId(size_type) const override;
+    int ElementValue(size_type) const override;
+    size_type DefaultValueIndex() const override;
+};
+
+// Lossless tile compression of all output planes
+class BACompressOutput : public MetaBoolean
+{
+public:
+    BACompressOutput(MetaProcess*);
+
+    IsoString Id() const override;
+    bool DefaultValue() const override;
+};
+
+// Huge page backing of accumulator planes and frame buffers
+class BAHugePages : public MetaEnumeration
+{
+public:
+    enum { Off = 0,
+           Transparent = 1,
+           HugeTLB = 2,
+           NumberOfItems,
+           Default = Transparent };
+
+    BAHugePages(MetaProcess*);
+
+    IsoString Id() const override;
+    size_type NumberOfElements() const override;
+    IsoString ElementId(size_type) const override;
+    int ElementValue(size_type) const override;
+    size_type DefaultValueIndex() const override;
+};
+
+// RAM budget for the memory planner, in MiB (0 = a fraction of physical memory)
+class BAMemoryBudget : public MetaFloat
+{
+public:
+    BAMemoryBudget(MetaProcess*);
+
+    IsoString Id() const override;
+    int Precision() const override;
+    double DefaultValue() const override;
+    double MinimumValue() const override;
+    double MaximumValue() const override;
+};
+
+// Chrome trace timeline of the run, written next to the outputs
+class BATraceTimeline : public MetaBoolean
+{
+public:
+    BATraceTimeline(MetaProcess*);
+
+    IsoString Id() const override;
+    bool DefaultValue() const override;
+};
+
+// perf_event hardware counters per phase and thread, in the run report
+class BAHardwareCounters : public MetaBoolean
+{
+public:
+    BAHardwareCounters(MetaProcess*);
+
+    IsoString Id() const override;
+    bool DefaultValue() const override;
+};
+
+// Summary statistics with a fixed reduction tree: bit-identical on any core count
+class BADeterministicReduction : public MetaBoolean
+{
+public:
+    BADeterministicReduction(MetaProcess*);
+
+    IsoString Id() const override;
+    bool DefaultValue() const override;
+};
+
 // Extern declarations
 extern BAFusionStrategy* TheBAFusionStrategyParameter;
 extern BAInputFiles* TheBAInputFilesParameter;
@@ -124,6 +310,18 @@ extern BAUseGPU* TheBAUseGPUParameter;
 extern BAGenerateConfidenceMap* TheBAGenerateConfidenceMapParameter;
 extern BAOutputDirectory* TheBAOutputDirectoryParameter;
 extern BAOutputPrefix* TheBAOutputPrefixParameter;
+extern BAIngestBackend* TheBAIngestBackendParameter;
+extern BAIngestCacheMode* TheBAIngestCacheModeParameter;
+extern BAIngestPackedCache* TheBAIngestPackedCacheParameter;
+extern BAFusedEncoding* TheBAFusedEncodingParameter;
+extern BAConfidenceEncoding* TheBAConfidenceEncodingParameter;
+extern BAClassificationEncoding* TheBAClassificationEncodingParameter;
+extern BACompressOutput* TheBACompressOutputParameter;
+extern BAMemoryBudget* TheBAMemoryBudgetParameter;
+extern BAHugePages* TheBAHugePagesParameter;
+extern BATraceTimeline* TheBATraceTimelineParameter;
+extern BAHardwareCounters* TheBAHardwareCountersParameter;
+extern BADeterministicReduction* TheBADeterministicReductionParameter;
 
 } // namespace pcl
 
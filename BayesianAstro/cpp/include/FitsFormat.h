@@ -0,0 +1,102 @@
+/**
+ * FITS Format
+ *
+ * Minimal native parsing of primary-HDU image headers and decoding of raw
+ * big-endian FITS data into Float32, used by the native ingest path.
+ */
+
+#ifndef __FitsFormat_h
+#define __FitsFormat_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pcl
+{
+
+// FITS logical record size
+constexpr size_t FITS_BLOCK_SIZE = 2880;
+
+// Structural description of a primary image HDU
+struct FitsImageInfo
+{
+    int bitpix = 0;
+    int naxis = 0;
+    int64_t naxes[3] = {0, 0, 0};
+    double bzero = 0.0;
+    double bscale = 1.0;
+    uint64_t dataOffset = 0;   // Byte offset of the data unit (multiple of 2880)
+
+    // FITS NAXIS1 is the fastest-varying axis, matching Julia's first dimension
+    int64_t Height() const { return naxes[0]; }
+    int64_t Width() const { return naxes[1]; }
+
+    int64_t PlanePixels() const { return naxes[0] * naxes[1]; }
+    size_t BytesPerPixel() const { return size_t(bitpix < 0 ? -bitpix : bitpix) / 8; }
+    uint64_t PlaneBytes() const { return uint64_t(PlanePixels()) * BytesPerPixel(); }
+};
+
+/**
+ * Non-owning view of one 80-byte header card. All accessors parse in place
+ * without allocating, so headers of thousands of files can be scanned cheaply.
+ */
+struct FitsCard
+{
+    const char* data = nullptr;
+
+    // Keyword comparison against the blank-padded 8-character key field
+    bool KeyIs(const char* key) const;
+
+    // True if the card has a "= " value indicator
+    bool HasValue() const { return data[8] == '=' && data[9] == ' '; }
+
+    // Integer, fixed or exponential (E or D) numeric value
+    bool NumericValue(double& value) const;
+
+    // Quoted string value, with '' unescaped and trailing blanks removed, copied into
+    // a caller buffer (always NUL-terminated, truncated to capacity - 1)
+    bool StringValue(char* out, size_t capacity) const;
+};
+
+// Parse a FITS numeric literal in [begin, end) without allocating
+bool ParseFitsNumber(const char* begin, const char* end, double& value);
+
+/**
+ * Parse a FITS date string to a Unix timestamp. Supports YYYY-MM-DDTHH:MM:SS[.sss],
+ * YYYY-MM-DD and the pre-2000 DD/MM/YY form (mirrors FitsIO.parse_fits_date).
+ */
+bool ParseFitsDate(const char* text, double& unixSeconds);
+
+// Receives every card of a header as it is parsed (before END)
+class FitsCardVisitor
+{
+public:
+    virtual ~FitsCardVisitor() = default;
+    virtual void Visit(const FitsCard& card) = 0;
+};
+
+/**
+ * Parse the primary header of an open FITS file, filling the structural image
+ * description and passing each card to 'visitor' if one is given.
+ * Returns false with a message in 'error' if the file is not a 2D/3D image.
+ */
+bool ParseFitsHeader(int fd, FitsImageInfo& info, FitsCardVisitor* visitor, std::string& error);
+
+/**
+ * Read and parse the primary header of an open FITS file.
+ * Only the structural keywords (BITPIX, NAXISn, BZERO, BSCALE) are extracted.
+ * Returns false with a message in 'error' if the file is not a 2D/3D image.
+ */
+bool ReadFitsImageInfo(int fd, FitsImageInfo& info, std::string& error);
+
+/**
+ * Decode 'count' big-endian samples of the given BITPIX into physical Float32
+ * values (bzero + bscale * raw), matching FITSIO's equivalent-type read.
+ */
+void DecodeFitsSamples(const void* raw, float* out, size_t count,
+                       int bitpix, double bzero, double bscale);
+
+} // namespace pcl
+
+#endif // __FitsFormat_h
@@ -0,0 +1,96 @@
+/**
+ * FITS Header Scanner
+ *
+ * Reads only the header blocks of many FITS files in parallel and extracts the
+ * structural keywords plus the per-frame quality metadata used by BayesianAstro
+ * (FWHM, background, noise, timestamp, filter, exposure, gain) into a columnar
+ * table. Keyword priorities mirror FitsIO.get_fits_metadata.
+ */
+
+#ifndef __FitsHeaderScanner_h
+#define __FitsHeaderScanner_h
+
+#include "FitsFormat.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace pcl
+{
+
+// FILTER values longer than this are truncated
+constexpr size_t FITS_FILTER_NAME_SIZE = 24;
+
+struct FitsFilterName
+{
+    char name[FITS_FILTER_NAME_SIZE] = {};
+};
+
+/**
+ * Columnar per-frame header table, one row per input path (in input order).
+ * Optional metadata is NaN (or an empty filter name) when the keyword is absent.
+ */
+struct FrameHeaderTable
+{
+    // Structural columns
+    std::vector<uint8_t> ok;                // Header parsed and describes a supported image
+    std::vector<int32_t> bitpix;
+    std::vector<int32_t> naxis;
+    std::vector<int64_t> naxis1;
+    std::vector<int64_t> naxis2;
+    std::vector<int64_t> naxis3;
+    std::vector<uint64_t> dataOffset;
+    std::vector<double> bzero;
+    std::vector<double> bscale;
+
+    // Metadata columns
+    std::vector<float> fwhm;
+    std::vector<float> background;
+    std::vector<float> noise;
+    std::vector<float> exposure;
+    std::vector<float> gain;
+    std::vector<double> timestamp;          // Unix seconds
+    std::vector<FitsFilterName> filter;
+
+    // File identity (catalog key together with the path)
+    std::vector<uint64_t> fileSize;
+    std::vector<int64_t> modified;          // mtime, nanoseconds since the epoch
+
+    // Quality metrics measured from the pixels; NaN until a run has seen the frame
+    std::vector<float> mean;
+    std::vector<float> sigma;
+
+    // Error message for rows with ok == 0
+    std::vector<std::string> errors;
+
+    double seconds = 0.0;                   // Wall time of the scan
+
+    size_t Size() const { return ok.size(); }
+
+    void Resize(size_t rows);
+
+    // Rebuild the structural description of one row
+    FitsImageInfo ImageInfo(size_t row) const;
+
+    // Index of the first failed row, or Size() if every row is valid
+    size_t FirstFailure() const;
+
+    // Copy every column of row 'from' of 'other' into row 'to'
+    void CopyRow(size_t to, const FrameHeaderTable& other, size_t from);
+};
+
+/**
+ * Scan the headers of 'paths' with 'threads' workers (0 = hardware concurrency).
+ * Never throws on bad input: unreadable or unsupported files are reported per row.
+ */
+FrameHeaderTable ScanFitsHeaders(const std::vector<std::string>& paths, int threads = 0);
+
+// Modification time of a stat result in ns since the epoch (st_mtim, st_mtimespec on macOS)
+int64_t StatModifiedNanoseconds(const struct stat& st);
+
+} // namespace pcl
+
+#endif // __FitsHeaderScanner_h
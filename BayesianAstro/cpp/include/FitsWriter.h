@@ -0,0 +1,96 @@
+/**
+ * FITS Writer
+ *
+ * Native writer for result planes with compact per-plane encodings (float32,
+ * float16-precision, scaled 16-bit, 8-bit and 4-bit packed classes) and optional
+ * lossless tile compression (FITS tiled image convention, GZIP_1/GZIP_2),
+ * with tiles encoded and compressed in parallel.
+ */
+
+#ifndef __FitsWriter_h
+#define __FitsWriter_h
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+
+// Plane encoding (mirrors the Julia OutputEncoding enum)
+enum class PlaneEncoding : int
+{
+    Float32 = 0,        // BITPIX -32
+    Float16 = 1,        // Significand rounded to IEEE half precision, stored as -32; always compressed
+    UInt16 = 2,         // BITPIX 16 scaled to [low, high] with BSCALE/BZERO, NaN as BLANK
+    UInt8 = 3,          // BITPIX 8 class codes
+    Packed4 = 4         // Two 4-bit class codes per byte along NAXIS1 (BAENCODE = 'PACKED4')
+};
+
+// One preformatted header card
+struct FitsKeyword
+{
+    std::string name;
+    std::string value;      // Already in FITS syntax (quoted strings, T/F, numbers)
+    std::string comment;
+
+    static FitsKeyword Logical(const std::string& name, bool value, const std::string& comment = std::string());
+    static FitsKeyword Integer(const std::string& name, int64_t value, const std::string& comment = std::string());
+    static FitsKeyword Real(const std::string& name, double value, const std::string& comment = std::string());
+    static FitsKeyword String(const std::string& name, const std::string& value, const std::string& comment = std::string());
+};
+
+struct PlaneWriteOptions
+{
+    PlaneEncoding encoding = PlaneEncoding::Float32;
+    bool compress = false;          // Lossless GZIP tile compression
+    int threads = 0;                // Encode/compress workers (0 = hardware concurrency)
+
+    // UInt16 scaling range; NaN means the finite extrema of the plane
+    double low = std::numeric_limits<double>::quiet_NaN();
+    double high = std::numeric_limits<double>::quiet_NaN();
+};
+
+struct PlaneWriteStats
+{
+    uint64_t float32Bytes = 0;      // Size of the plane as plain float32 (for ratios)
+    uint64_t fileBytes = 0;
+    double seconds = 0.0;
+};
+
+/**
+ * Write a column-major (height x width) Float32 plane. FITS NAXIS1 is the height,
+ * matching Julia's first dimension. Class encodings (UInt8, Packed4) are rejected.
+ */
+bool WriteFitsPlane(const std::string& path, const float* data, int64_t height, int64_t width,
+                    const PlaneWriteOptions& options, const std::vector<FitsKeyword>& keywords,
+                    PlaneWriteStats* stats, std::string& error);
+
+/**
+ * Write a column-major (height x width) plane of small unsigned codes (classification).
+ * Only UInt8 and Packed4 encodings are accepted; Packed4 requires codes < 16 and
+ * fails with an error naming the first pixel that is not.
+ */
+bool WriteFitsPlane(const std::string& path, const uint8_t* data, int64_t height, int64_t width,
+                    const PlaneWriteOptions& options, const std::vector<FitsKeyword>& keywords,
+                    PlaneWriteStats* stats, std::string& error);
+
+// Per-plane output choices for a run
+struct OutputOptions
+{
+    PlaneEncoding fusedEncoding = PlaneEncoding::Float32;
+    PlaneEncoding confidenceEncoding = PlaneEncoding::Float32;
+    PlaneEncoding classificationEncoding = PlaneEncoding::Packed4;
+    bool writeConfidence = true;
+    bool writeClassification = false;
+    bool compress = false;
+    int threads = 0;
+};
+
+// Round a float to IEEE half-precision significand (keeps the float32 exponent range)
+float RoundToHalfPrecision(float x);
+
+} // namespace pcl
+
+#endif // __FitsWriter_h
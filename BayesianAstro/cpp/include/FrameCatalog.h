@@ -0,0 +1,55 @@
+/**
+ * Frame Catalog
+ *
+ * Persistent per-directory cache of frame headers and quality metrics, stored
+ * next to the data and keyed by file name, size and modification time. Frames
+ * that have not changed since a previous run are never re-opened to probe them.
+ */
+
+#ifndef __FrameCatalog_h
+#define __FrameCatalog_h
+
+#include "FitsHeaderScanner.h"
+
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+
+// Catalog file name, one per data directory
+constexpr const char* FRAME_CATALOG_FILE_NAME = ".bayesianastro-catalog";
+
+// Catalog lookup report
+struct CatalogStats
+{
+    size_t cached = 0;          // Rows served from a catalog
+    size_t scanned = 0;         // Rows whose headers had to be read
+    double seconds = 0.0;
+};
+
+/**
+ * Resolve the header table for 'paths', taking unchanged frames from their
+ * directory catalogs and scanning the rest in parallel. Catalogs of directories
+ * with new or modified frames are rewritten; unwritable directories are skipped.
+ * 'threads' caps the header scan workers (0 = hardware concurrency).
+ */
+FrameHeaderTable LoadFrameCatalog(const std::vector<std::string>& paths, CatalogStats* stats = nullptr,
+                                  int threads = 0);
+
+/**
+ * Merge the valid rows of 'table' (aligned with 'paths') into their directory
+ * catalogs, e.g. after a run has measured quality metrics. Returns false if any
+ * catalog could not be written.
+ */
+bool StoreFrameCatalog(const std::vector<std::string>& paths, const FrameHeaderTable& table);
+
+// Size and modification time (ns) of a file, the identity catalog rows are keyed by
+bool StatFile(const std::string& path, uint64_t& size, int64_t& modified);
+
+// Mean and standard deviation of the finite samples of a decoded frame
+void MeasureFrameQuality(const float* pixels, size_t count, float& mean, float& sigma);
+
+} // namespace pcl
+
+#endif // __FrameCatalog_h
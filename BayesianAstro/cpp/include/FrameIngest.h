@@ -0,0 +1,187 @@
+/**
+ * Frame Ingest
+ *
+ * Streams a sequence of FITS frames from disk with deep read queues. Each frame
+ * is split into strips that are submitted in batches to an IngestBackend, into a
+ * small pool of read-ahead frame buffers, and decoded to Float32 on delivery.
+ * With a packed cache enabled, unchanged frames are mapped from their cache
+ * entries instead, and entries are written for frames that had to be decoded.
+ * A band of whole columns can be requested instead of the full frame, for
+ * stacks that are accumulated in several passes to fit a memory budget.
+ */
+
+#ifndef __FrameIngest_h
+#define __FrameIngest_h
+
+#include "FitsFormat.h"
+#include "FitsHeaderScanner.h"
+#include "IngestBackend.h"
+#include "PackedFrameCache.h"
+#include "WorkspaceArena.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pcl
+{
+
+// Page cache policy for frame data (mirrors the ingestCacheMode process parameter)
+enum class IngestCacheMode : int
+{
+    Auto = 0,           // Direct I/O when the dataset exceeds directIORamFraction of RAM
+    Buffered = 1,       // Plain reads through the page cache
+    DirectIO = 2,       // O_DIRECT with aligned pooled buffers (drop-behind if unsupported)
+    DropBehind = 3      // Buffered reads, posix_fadvise(DONTNEED) once a frame is consumed (Linux)
+};
+
+// Ingest tuning
+struct IngestOptions
+{
+    IngestBackendType backend = IngestBackendType::Auto;
+    int queueDepth = 64;            // Maximum strip reads in flight
+    int readAheadFrames = 4;        // Number of pooled frame buffers
+    size_t stripBytes = 1 << 20;    // Read granularity
+    int workerThreads = 0;          // pread pool size (0 = hardware concurrency)
+    IngestCacheMode cacheMode = IngestCacheMode::Auto;
+    double directIORamFraction = 0.5;
+    PackedCacheMode packedCache = PackedCacheMode::Off;
+    int64_t firstColumn = 0;        // Band of whole columns (contiguous FITS rows) to deliver
+    int64_t columnCount = 0;        // 0 = through the last column
+};
+
+// Ingest throughput report
+struct IngestStats
+{
+    std::string backend;
+    std::string cacheMode;          // "buffered", "direct" or "drop-behind"
+    std::string note;               // Fallback reason, if any
+    uint64_t bytesRead = 0;
+    uint64_t reads = 0;
+    double seconds = 0.0;
+    double averageQueueDepth = 0.0;
+    int peakQueueDepth = 0;
+    uint64_t packedHits = 0;        // Frames served from the packed cache
+    uint64_t packedWrites = 0;      // Packed cache entries written
+
+    double MegabytesPerSecond() const
+    {
+        return seconds > 0.0 ? double(bytesRead) / (1024.0 * 1024.0) / seconds : 0.0;
+    }
+};
+
+// A decoded frame handed to the consumer
+struct IngestFrame
+{
+    size_t index = 0;
+    const std::string* path = nullptr;
+    const float* pixels = nullptr;  // Column-major (height x width); valid until the next Next()
+    bool packed = false;            // Served from the packed cache
+    int64_t height = 0;
+    int64_t width = 0;              // Columns in the band
+    int64_t firstColumn = 0;        // Band offset within the frame
+};
+
+class FrameIngest
+{
+public:
+    // If 'headers' is given (scanned or cataloged rows for 'files'), frames are not re-probed.
+    // With a 'workspace', read and decode buffers are taken from (and left in) the arena.
+    FrameIngest(const std::vector<std::string>& files, const IngestOptions& options = IngestOptions(),
+                const FrameHeaderTable* headers = nullptr, WorkspaceArena* workspace = nullptr);
+    ~FrameIngest();
+
+    FrameIngest(const FrameIngest&) = delete;
+    FrameIngest& operator=(const FrameIngest&) = delete;
+
+    // Read through 'backend' instead of one made from the options (e.g. to inject faults). Call before Open.
+    void SetBackend(std::unique_ptr<IngestBackend> backend) { m_backend = std::move(backend); }
+
+    // Probe geometry, allocate the buffer pool and start reading ahead
+    bool Open(std::string& error);
+
+    // Block until the next frame is read and decoded. Returns false at end or on error.
+    bool Next(IngestFrame& frame, std::string& error);
+
+    int64_t Height() const { return m_height; }
+    int64_t Width() const { return m_width; }
+    int64_t FirstColumn() const { return m_firstColumn; }
+    int64_t BandColumns() const { return m_bandColumns; }
+    bool IsBanded() const { return m_bandColumns != m_width; }
+    size_t FrameCount() const { return m_files.size(); }
+
+    const IngestStats& Stats() const { return m_stats; }
+
+private:
+    struct Slot
+    {
+        size_t frame = 0;
+        int fd = -1;
+        bool direct = false;        // fd was opened with O_DIRECT
+        FitsImageInfo info;
+        size_t dataSkip = 0;        // Offset of the data unit within the buffer (aligned reads)
+        uint64_t dataEnd = 0;       // File offset just past the frame's plane
+        uint8_t* buffer = nullptr;
+        size_t capacity = 0;
+        int bufferIndex = -1;       // Registered buffer index, or -1
+        int pendingReads = 0;
+        bool active = false;
+        bool failed = false;
+        std::string error;
+        uint64_t sourceSize = 0;    // Source stamp, for packed cache entries
+        int64_t sourceModified = 0;
+        int packedFd = -1;          // Valid packed cache entry, or -1
+        PackedFrameHeader packed;
+    };
+
+    bool ReadHeader(size_t frameIndex, int fd, FitsImageInfo& info, std::string& error) const;
+    uint64_t BandOffset(const FitsImageInfo& info) const;   // Band's byte range in the file
+    uint64_t BandBytes(const FitsImageInfo& info) const;
+    IngestCacheMode ResolveCacheMode() const;
+    void Fill(Slot& slot, size_t frameIndex);
+    bool Pump(bool wait, std::string& error);
+    void Release(Slot& slot);
+    bool ReadSourceFrame(Slot& slot, std::string& error);
+    void StorePacked(const Slot& slot);
+    uint8_t* AllocateSlotBuffer(const Slot& slot, size_t bytes);
+
+    std::vector<std::string> m_files;
+    IngestOptions m_options;
+    const FrameHeaderTable* m_headers = nullptr;
+    std::unique_ptr<IngestBackend> m_backend;
+
+    std::vector<Slot> m_slots;
+    std::deque<ReadRequest> m_queued;
+    std::unordered_map<uint64_t, ReadRequest> m_inFlight;
+    std::vector<ReadRequest> m_batch;
+    std::vector<ReadCompletion> m_completions;
+    uint64_t m_nextTag = 1;
+
+    WorkspaceArena* m_workspace = nullptr;
+    float* m_pixels = nullptr;      // Decoded frame (arena or m_ownedPixels)
+    size_t m_pixelCount = 0;
+    std::vector<float> m_ownedPixels;
+    PackedFrameMapping m_mapping;   // Cache entry of the frame last delivered in place
+    bool m_packedWritable = true;
+    size_t m_nextFrame = 0;
+    int64_t m_height = 0;
+    int64_t m_width = 0;
+    int64_t m_firstColumn = 0;
+    int64_t m_bandColumns = 0;
+
+    IngestCacheMode m_cacheMode = IngestCacheMode::Buffered;
+    bool m_directUnsupported = false;
+
+    IngestStats m_stats;
+    double m_depthSum = 0.0;
+    uint64_t m_depthSamples = 0;
+    double m_startTime = 0.0;
+};
+
+} // namespace pcl
+
+#endif // __FrameIngest_h
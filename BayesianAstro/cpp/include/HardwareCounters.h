@@ -0,0 +1,133 @@
+/**
+ * Hardware Counters
+ *
+ * perf_event_open counter groups (cycles, instructions, cache references and
+ * misses, branches and branch misses, plus task clock, page faults and context
+ * switches) read from user space around the hot loops, per thread. Events are
+ * user-space only, so they work unprivileged up to perf_event_paranoid = 2.
+ * Each event is optional: where the kernel refuses one (no PMU in a VM, a
+ * stricter paranoid level, a non-Linux host) it is reported as unavailable and
+ * the rest are still counted.
+ */
+
+#ifndef __HardwareCounters_h
+#define __HardwareCounters_h
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+
+enum class CounterEvent : int
+{
+    TaskClock = 0,      // Nanoseconds on CPU
+    Cycles,
+    Instructions,
+    CacheReferences,
+    CacheMisses,        // Last-level cache misses on most CPUs
+    Branches,
+    BranchMisses,
+    PageFaults,
+    ContextSwitches,
+    Count
+};
+
+const char* CounterEventName(CounterEvent event);
+
+// Cache line moved per last-level miss, for the memory bandwidth estimate
+constexpr double CACHE_LINE_BYTES = 64.0;
+
+struct CounterValues
+{
+    uint64_t values[int(CounterEvent::Count)] = {};
+    uint32_t available = 0;         // Bit per event that was counted
+    bool multiplexed = false;       // Some values were scaled from partial running time
+
+    bool Has(CounterEvent e) const { return (available >> int(e)) & 1u; }
+    uint64_t operator[](CounterEvent e) const { return values[int(e)]; }
+
+    void Add(const CounterValues& other);
+    CounterValues Since(const CounterValues& earlier) const;
+    bool IsZero() const;
+
+    // Derived ratios; NaN where an input event is unavailable or zero
+    double InstructionsPerCycle() const;
+    double CacheMissRate() const;
+    double BranchMissRate() const;
+    double MemoryBytes() const;     // Last-level misses × cache line
+
+    std::string ToJson() const;     // {"cycles": ..., "ipc": ...}; unavailable events omitted
+};
+
+// One counter group bound to one thread; values are cumulative from Open()
+class CounterGroup
+{
+public:
+    CounterGroup() = default;
+    ~CounterGroup();
+
+    CounterGroup(const CounterGroup&) = delete;
+    CounterGroup& operator=(const CounterGroup&) = delete;
+
+    // 'tid' 0 = the calling thread. False (with the reason) if no event could be opened
+    bool Open(int tid, std::string& error);
+    void Close();
+    bool IsOpen() const { return m_leader >= 0; }
+
+    bool Read(CounterValues& values) const;
+
+private:
+    int m_leader = -1;
+    std::vector<int> m_fds;
+    std::vector<uint64_t> m_ids;
+    std::vector<CounterEvent> m_events;
+};
+
+struct ThreadCounters
+{
+    int tid = 0;
+    std::string name;               // /proc/self/task/<tid>/comm
+    CounterValues values;
+};
+
+/**
+ * Counter groups on every thread of the process (native pools and the Julia
+ * runtime alike). Refresh() picks up threads started since the last call and
+ * retires those that exited, keeping their final counts. Sample() returns the
+ * cumulative values of every thread seen, in a stable order: entries are only
+ * ever appended, so the i-th entries of two samples are the same thread.
+ * Threads that start and exit between two refreshes (short-lived pools) are
+ * not seen; persistent pools, such as Julia's worker threads, are.
+ */
+class ProcessCounters
+{
+public:
+    bool Open();
+    void Refresh();
+    void Sample(std::vector<ThreadCounters>& threads) const;
+
+    bool IsOpen() const { return !m_groups.empty(); }
+
+    // Why some or all events are missing (empty when everything is counted)
+    const std::string& Note() const { return m_note; }
+
+private:
+    struct Thread
+    {
+        int tid = 0;
+        std::string name;
+        std::unique_ptr<CounterGroup> group;
+        CounterValues final;        // Counts at exit, once the group is closed
+    };
+
+    std::vector<Thread> m_groups;
+    std::string m_note;
+    bool m_failed = false;          // Opening is not retried for every new thread
+};
+
+} // namespace pcl
+
+#endif // __HardwareCounters_h
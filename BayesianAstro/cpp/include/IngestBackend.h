@@ -0,0 +1,82 @@
+/**
+ * Ingest Backend
+ *
+ * Asynchronous batched read submission for frame ingest. The io_uring backend
+ * keeps many strip reads in flight against pooled, registered buffers; the
+ * pread backend emulates the same interface with a worker thread pool where
+ * io_uring is unavailable (non-Linux, old kernels, or disabled by policy).
+ */
+
+#ifndef __IngestBackend_h
+#define __IngestBackend_h
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+
+// Ingest backend selection (mirrors the ingestBackend process parameter)
+enum class IngestBackendType : int
+{
+    Auto = 0,       // io_uring when available, else pread pool
+    IoUring = 1,
+    PreadPool = 2
+};
+
+// A single positioned read into a pooled buffer
+struct ReadRequest
+{
+    int fd = -1;
+    uint64_t offset = 0;
+    size_t length = 0;
+    void* buffer = nullptr;
+    int bufferIndex = -1;    // Index of the registered buffer containing 'buffer', or -1
+    uint64_t tag = 0;        // Caller cookie returned with the completion
+};
+
+struct ReadCompletion
+{
+    uint64_t tag = 0;
+    int64_t result = 0;      // Bytes read, or -errno
+};
+
+class IngestBackend
+{
+public:
+    virtual ~IngestBackend() = default;
+
+    virtual const char* Name() const = 0;
+
+    // Maximum number of reads that may be in flight at once
+    virtual int QueueDepth() const = 0;
+
+    // Register pooled buffers for zero-copy fixed reads. Optional; returns false if unsupported.
+    virtual bool RegisterBuffers(const std::vector<std::pair<void*, size_t>>& buffers)
+    {
+        (void)buffers;
+        return false;
+    }
+
+    // Submit a batch of reads. The caller guarantees InFlight() + batch.size() <= QueueDepth().
+    virtual bool Submit(const std::vector<ReadRequest>& batch, std::string& error) = 0;
+
+    // Block until at least 'minCount' completions are available, then drain all ready ones.
+    virtual size_t Reap(std::vector<ReadCompletion>& out, size_t minCount) = 0;
+
+    virtual int InFlight() const = 0;
+
+    /**
+     * Create a backend of the requested type. Auto and IoUring fall back to the
+     * pread pool if io_uring cannot be set up; 'note' receives the reason.
+     */
+    static std::unique_ptr<IngestBackend> Create(IngestBackendType type, int queueDepth,
+                                                 int workerThreads, std::string& note);
+};
+
+} // namespace pcl
+
+#endif // __IngestBackend_h
@@ -12,6 +12,18 @@
 #include <functional>
 #include <memory>
 
+#include "FrameCatalog.h"
+#include "FitsWriter.h"
+#include "FrameIngest.h"
+#include "LivePreview.h"
+#include "MemoryPlanner.h"
+#include "PlaneHistogram.h"
+#include "PreviewTiles.h"
+#include "ProgressAggregator.h"
+#include "RunMetrics.h"
+#include "StageGraph.h"
+#include "WorkspaceArena.h"
+
 // Forward declare Julia types to avoid including julia.h in header
 typedef struct _jl_value_t jl_value_t;
 
@@ -36,6 +48,45 @@ struct ProcessingConfig
     int tileSizeX = 1024;
     int tileSizeY = 1024;
     bool useGPU = true;
+
+    // Native frame ingest (backend, cache modes; depth and read-ahead come from the memory plan)
+    IngestOptions ingest;
+
+    // Native worker threads: header scan, pread pool and output encoding (0 = hardware
+    // concurrency). Julia's own threads are fixed when the runtime starts
+    int threads = 0;
+
+    // RAM budget in bytes for the memory planner (0 = DefaultMemoryBudget())
+    uint64_t memoryBudget = 0;
+
+    // Backing of large workspace buffers
+    HugePageMode hugePages = HugePageMode::Transparent;
+
+    // Output plane encodings and compression
+    OutputOptions output;
+
+    // Record a Chrome trace timeline of the run next to the outputs
+    bool trace = false;
+
+    // Sample perf_event hardware counters of every thread at each phase boundary
+    bool hardwareCounters = false;
+
+    // Summary statistics over the whole output planes with a fixed reduction tree, so
+    // they are bit-identical for any thread count and band layout
+    bool deterministic = false;
+
+    // Build the preview's zoom pyramid after finalizing; off where nothing views the result
+    bool previewPyramid = true;
+
+    // Bin histograms of the fused, confidence and variance planes after finalizing, for
+    // the same viewers
+    bool previewHistograms = true;
+
+    // Optional lock-free progress counters, sampled by a UI at its own refresh rate
+    ProgressAggregator* progress = nullptr;
+
+    // Optional progressive snapshots of the running mean and confidence, for a UI
+    LivePreview* livePreview = nullptr;
 };
 
 // Processing result
@@ -45,6 +96,9 @@ struct ProcessingResult
     std::string errorMessage;
     std::string fusedImagePath;
     std::string confidenceMapPath;
+    std::string classificationMapPath;
+    std::string metricsPath;
+    std::string tracePath;
 
     // Statistics
     int totalPixels = 0;
@@ -53,6 +107,32 @@ struct ProcessingResult
     int poissonPixels = 0;
     int bimodalPixels = 0;
     int artifactPixels = 0;
+    double reductionSeconds = 0.0;  // Deterministic summary pass, when enabled
+    double pyramidSeconds = 0.0;    // Preview pyramid build, after finalizing
+    uint64_t pyramidBytes = 0;
+    double histogramSeconds = 0.0;  // Result plane histograms, after finalizing
+
+    // Band layout, read-ahead and predicted peak chosen for the memory budget
+    MemoryPlan memoryPlan;
+
+    // Ingest throughput (backend, achieved queue depth, MB/s)
+    IngestStats ingest;
+
+    // Frame catalog hits vs header scans
+    CatalogStats catalog;
+
+    // Output planes: bytes written vs plain float32, write time
+    PlaneWriteStats output;
+
+    // Per-phase time, peak RSS, allocations, GC time and arena high-water marks
+    RunMetrics metrics;
+
+    // Session workspace reuse, and Julia bytes allocated per steady-state frame
+    WorkspaceStats workspace;
+    uint64_t frameAllocationBytes = 0;
+
+    // Stages this run computed; the others' outputs came from the session
+    StagePlan stages;
 };
 
 // Progress callback type
@@ -68,7 +148,8 @@ public:
     static JuliaRuntime& Instance();
 
     // Lifecycle
-    bool Initialize(const std::string& juliaHome = "");
+    // 'modulePath' is the directory holding BayesianAstro.jl (default: ./julia)
+    bool Initialize(const std::string& juliaHome = "", const std::string& modulePath = "");
     void Shutdown();
     bool IsInitialized() const { return m_initialized; }
 
@@ -85,6 +166,29 @@ public:
         ProgressCallback progressCallback = nullptr
     );
 
+    // Stages a run with these inputs and parameters would compute, given the outputs the
+    // session holds; without an output directory the target is the preview (Finalize)
+    StagePlan PlanRun(const std::vector<std::string>& inputFiles, const std::string& outputDirectory,
+                      const std::string& outputPrefix, const ProcessingConfig& config) const;
+
+    // ProcessStack computing only the stages PlanRun names: e.g. a new fusion strategy
+    // refinalizes the kept accumulators, a new encoding only rewrites the outputs
+    ProcessingResult Run(
+        const std::vector<std::string>& inputFiles,
+        const std::string& outputDirectory,
+        const std::string& outputPrefix,
+        const ProcessingConfig& config,
+        ProgressCallback progressCallback = nullptr
+    );
+
+    // Output planes of the last successful run, in the session workspace; empty while a
+    // run is in progress or after a failed one, and replaced (new generation) by the next
+    const PreviewSource& Preview() const { return m_preview; }
+
+    // Histogram of a result plane, valid with Preview(); empty when not built (variance
+    // needs the whole image's accumulators, which a banded run does not keep)
+    const PlaneHistogram& Histogram(HistogramPlane plane) const { return m_histograms[int(plane)]; }
+
     // Utility functions
     bool ValidateFitsFile(const std::string& path) const;
     std::pair<int, int> GetImageDimensions(const std::string& path) const;
@@ -102,6 +206,18 @@ private:
     jl_value_t* CallJuliaFunction(const char* moduleName, const char* funcName,
                                    const std::vector<jl_value_t*>& args);
     void HandleJuliaException();
+    bool AcquireWorkspacePlanes(size_t bandPixels, size_t pixels, void* planes[10]);
+    bool AcquireOutputPlanes(size_t pixels, void* planes[10]);
+    void BuildPreviewPyramid(ProcessingResult& result, void* const planes[10], int64_t height, int64_t width,
+                             const ProcessingConfig& config, int threads);
+    void BuildHistograms(ProcessingResult& result, void* const planes[10], int64_t height, int64_t width,
+                         bool accumulators, const ProcessingConfig& config, int threads);
+    void PublishPreview(void* const planes[10], int64_t height, int64_t width);
+    StageKeys CachedStageKeys() const;
+    void RecordWrittenFiles(const ProcessingResult& result);
+    ProcessingResult RunCachedStages(const StagePlan& plan, const StageKeys& keys,
+                                     const std::string& outputDirectory, const std::string& outputPrefix,
+                                     const ProcessingConfig& config, ProgressCallback progressCallback);
 
     bool m_initialized = false;
     std::string m_juliaModulePath;
@@ -109,6 +225,35 @@ private:
     // Cached Julia function pointers for performance
     jl_value_t* m_processStackFunc = nullptr;
     jl_value_t* m_validateFitsFunc = nullptr;
+    jl_value_t* m_beginStackFunc = nullptr;
+    jl_value_t* m_accumulateFrameFunc = nullptr;
+    jl_value_t* m_finishStackFunc = nullptr;
+    jl_value_t* m_refinalizeStackFunc = nullptr;
+    jl_value_t* m_memoryCountersFunc = nullptr;
+
+    // Accumulator, output and frame buffers kept alive between runs
+    WorkspaceArena m_workspace;
+
+    PreviewSource m_preview;
+    PreviewPyramid m_pyramid;       // Reduced levels of m_preview's planes
+    PlaneHistogram m_histograms[int(HistogramPlane::Count)];
+    uint64_t m_previewGeneration = 0;
+
+    // Keys of the stage outputs the session holds: accumulators (unbanded runs only) and
+    // output planes in the workspace, output files on disk
+    StageKeys m_stageKeys;
+    int64_t m_keptHeight = 0;
+    int64_t m_keptWidth = 0;
+    int64_t m_keptFrames = 0;
+
+    // Output files as written, so a file changed since invalidates the Write stage
+    struct WrittenFile
+    {
+        std::string path;
+        uint64_t size = 0;
+        int64_t modified = 0;
+    };
+    std::vector<WrittenFile> m_writtenFiles;
 };
 
 } // namespace pcl
@@ -0,0 +1,195 @@
+/**
+ * Live Preview
+ *
+ * Progressive snapshots of a run while it accumulates: the running mean and
+ * the confidence the run would have if it stopped now, downsampled to at most
+ * LIVE_PREVIEW_SIZE pixels across, every few frames or seconds. Snapshots are
+ * gathered from the accumulator planes on a low-priority thread, a strip at a
+ * time between the accumulating thread's frames, and published as immutable
+ * PreviewSources the tile handler serves like a finished result.
+ *
+ * Only the current band's columns are gathered; earlier bands keep the state
+ * their last snapshot saw, which is their final state.
+ */
+
+#ifndef __LivePreview_h
+#define __LivePreview_h
+
+#include "PreviewTiles.h"
+#include "StackKernels.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pcl
+{
+
+// Longest edge of a snapshot in pixels; each covers a square block of the image
+constexpr int LIVE_PREVIEW_SIZE = 1024;
+
+// Samples per axis averaged into a snapshot pixel
+constexpr int LIVE_PREVIEW_TAPS = 2;
+
+// Snapshot rows gathered per hold of the accumulator lock: bounds how long the
+// accumulating thread can wait for the gatherer before its next frame
+constexpr int LIVE_PREVIEW_STRIP_ROWS = 16;
+
+// Default cadence: a snapshot every this many frames or seconds, whichever comes first
+constexpr int LIVE_PREVIEW_FRAMES = 8;
+constexpr double LIVE_PREVIEW_SECONDS = 5.0;
+
+// Nice increment of the gathering thread. Lowered rather than idle (SCHED_IDLE), since
+// the accumulating thread may wait on it for one strip
+constexpr int LIVE_PREVIEW_NICE = 10;
+
+struct LiveSnapshot
+{
+    std::vector<float> mean;            // NaN where no frame has contributed yet
+    std::vector<float> confidence;
+    PreviewSource source;               // Over 'mean' and 'confidence'; no classification
+
+    int64_t step = 1;                   // Image pixels per snapshot pixel, per axis
+    uint64_t frames = 0;                // Frames in the current band when gathered
+    int band = 0;                       // 1-based
+    int bands = 1;
+};
+
+/**
+ * One thread drives a run (BeginRun .. EndRun) and brackets every write to the
+ * accumulator planes with LockPlanes/UnlockPlanes; Latest() may be called from
+ * any thread and the snapshot it returns stays valid while held.
+ */
+class LivePreview
+{
+public:
+    explicit LivePreview(int everyFrames = LIVE_PREVIEW_FRAMES, double everySeconds = LIVE_PREVIEW_SECONDS);
+    ~LivePreview();
+
+    LivePreview(const LivePreview&) = delete;
+    LivePreview& operator=(const LivePreview&) = delete;
+
+    // Run side: geometry of the whole image, then each band's planes in turn
+    void BeginRun(int64_t height, int64_t width);
+    void BeginBand(const AccumulatorPlanes& planes, int64_t firstColumn, int64_t columns, int band, int bands);
+    void LockPlanes() { m_planesMutex.lock(); }
+    void UnlockPlanes() { m_planesMutex.unlock(); }
+    void FrameAccumulated();
+
+    // Gather the band's final state and wait for it, before its planes are reused
+    void EndBand();
+    void EndRun();
+
+    // Latest snapshot of the current or last run; null before the first one
+    std::shared_ptr<const LiveSnapshot> Latest() const;
+
+    // Changes with every snapshot (the generation of the latest); 0 before the first
+    uint64_t Generation() const { return m_generation.load(std::memory_order_acquire); }
+
+private:
+    struct Band
+    {
+        AccumulatorPlanes planes;
+        int64_t firstColumn = 0;
+        int64_t columns = 0;
+        int band = 0;
+        int bands = 1;
+    };
+
+    void Request();
+    void WorkerLoop();
+    std::shared_ptr<LiveSnapshot> Gather(const Band& band, uint64_t frames,
+                                         const std::shared_ptr<const LiveSnapshot>& previous);
+
+    const int m_everyFrames;
+    const double m_everySeconds;
+
+    int64_t m_height = 0;
+    int64_t m_width = 0;
+
+    // Accumulating thread's cadence state
+    uint64_t m_requestedFrames = 0;
+    std::chrono::steady_clock::time_point m_requestedAt;
+    bool m_firstFrame = false;
+
+    // Held by the accumulating thread per frame and by the gatherer per strip
+    std::mutex m_planesMutex;
+
+    // Guards everything below
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::thread m_worker;
+    bool m_running = false;
+    bool m_stopping = false;
+    bool m_pending = false;
+    bool m_gathering = false;
+    Band m_band;
+    std::shared_ptr<const LiveSnapshot> m_latest;
+
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_generation{0};
+};
+
+/**
+ * Holds the accumulator planes for one write, so no strip is gathered while
+ * they change. A null preview is ignored.
+ */
+class LivePlanesLock
+{
+public:
+    explicit LivePlanesLock(LivePreview* live)
+        : m_live(live)
+    {
+        if (m_live != nullptr)
+            m_live->LockPlanes();
+    }
+
+    ~LivePlanesLock()
+    {
+        if (m_live != nullptr)
+            m_live->UnlockPlanes();
+    }
+
+    LivePlanesLock(const LivePlanesLock&) = delete;
+    LivePlanesLock& operator=(const LivePlanesLock&) = delete;
+
+private:
+    LivePreview* m_live;
+};
+
+/**
+ * Brackets one run: BeginRun on construction and EndRun on destruction, so
+ * every exit path stops the gatherer. A null preview is ignored.
+ */
+class LiveRun
+{
+public:
+    LiveRun(LivePreview* live, int64_t height, int64_t width)
+        : m_live(live)
+    {
+        if (m_live != nullptr)
+            m_live->BeginRun(height, width);
+    }
+
+    ~LiveRun()
+    {
+        if (m_live != nullptr)
+            m_live->EndRun();
+    }
+
+    LiveRun(const LiveRun&) = delete;
+    LiveRun& operator=(const LiveRun&) = delete;
+
+private:
+    LivePreview* m_live;
+};
+
+} // namespace pcl
+
+#endif // __LivePreview_h
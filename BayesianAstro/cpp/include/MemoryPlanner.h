@@ -0,0 +1,72 @@
+/**
+ * Memory Planner
+ *
+ * Fits a stacking run into a RAM budget. Per-pixel accumulators dominate the
+ * footprint, so when a full frame does not fit the stack is accumulated in
+ * bands of whole columns (contiguous FITS rows), one pass over the frames per
+ * band. Within a band the planner spends what is left on read-ahead depth.
+ */
+
+#ifndef __MemoryPlanner_h
+#define __MemoryPlanner_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pcl
+{
+
+// Default budget when none is set: this fraction of physical RAM
+constexpr double DEFAULT_MEMORY_BUDGET_FRACTION = 0.6;
+
+// Resident bytes per pixel: UInt16 count + six Float32 moments; fused, confidence, class code
+constexpr size_t ACCUMULATOR_BYTES_PER_PIXEL = 2 + 6 * 4;
+constexpr size_t OUTPUT_BYTES_PER_PIXEL = 4 + 4 + 1;
+
+// What the planner needs to know about the run
+struct MemoryPlanInputs
+{
+    uint64_t budgetBytes = 0;       // 0 = DefaultMemoryBudget()
+    int64_t height = 0;             // Frame geometry (Julia dimensions)
+    int64_t width = 0;
+    size_t frameCount = 0;
+    size_t sourceBytesPerPixel = 4; // BITPIX / 8 of the input frames
+    int hardwareThreads = 0;        // 0 = hardware concurrency
+};
+
+// The chosen layout and its predicted footprint
+struct MemoryPlan
+{
+    uint64_t budgetBytes = 0;
+    int64_t bandColumns = 0;        // Columns accumulated per pass
+    int passes = 1;
+    int readAheadFrames = 4;
+    int queueDepth = 64;
+    size_t stripBytes = 1 << 20;
+    int workerThreads = 0;          // pread pool
+    int outputThreads = 0;          // Output encoding/compression
+
+    uint64_t accumulatorBytes = 0;  // Per band
+    uint64_t decodeBytes = 0;       // Decoded band handed to Julia
+    uint64_t readAheadBytes = 0;    // Raw read-ahead buffers
+    uint64_t outputBytes = 0;       // Full-frame result planes
+    uint64_t writerBytes = 0;       // Encoded plane held while writing
+
+    bool fitsBudget = true;
+
+    // Peak of the accumulation phase and the write phase
+    uint64_t PeakBytes() const;
+
+    // Human-readable plan, one line per aspect
+    std::string Describe() const;
+};
+
+uint64_t PhysicalMemoryBytes();
+uint64_t DefaultMemoryBudget();
+
+MemoryPlan PlanMemory(const MemoryPlanInputs& inputs);
+
+} // namespace pcl
+
+#endif // __MemoryPlanner_h
@@ -0,0 +1,95 @@
+/**
+ * Packed Frame Cache
+ *
+ * Opt-in cache of decoded frames for repeated runs over the same data (e.g. while
+ * tuning parameters). Each frame is stored once as a flat, mmappable plane in
+ * Float32 or Float16, with a content hash, under a cache directory next to the
+ * data. Entries are keyed by the source file's size and modification time, so a
+ * changed source simply falls back to a regular read and refreshes the entry.
+ */
+
+#ifndef __PackedFrameCache_h
+#define __PackedFrameCache_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pcl
+{
+
+// Packed cache policy (mirrors the ingestPackedCache process parameter)
+enum class PackedCacheMode : int
+{
+    Off = 0,
+    Float32 = 1,        // Exact decoded samples, mapped and used in place
+    Float16 = 2         // IEEE half with a per-frame power-of-two scale; half the size, lossy
+};
+
+// Cache directory, one per data directory
+constexpr const char* PACKED_CACHE_DIRECTORY_NAME = ".bayesianastro-cache";
+
+// On-disk entry header; the payload follows at PACKED_FRAME_PAYLOAD_OFFSET
+struct PackedFrameHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t encoding;          // PackedCacheMode
+    int64_t height;
+    int64_t width;
+    uint64_t sourceSize;
+    int64_t sourceModified;     // ns since epoch
+    uint64_t hash;              // HashPackedPayload of the payload
+    int32_t scaleExponent;      // Float16: stored = ldexp(sample, scaleExponent)
+    uint32_t reserved;
+
+    size_t SampleBytes() const { return encoding == uint32_t(PackedCacheMode::Float16) ? 2 : 4; }
+    size_t PayloadBytes() const { return size_t(height * width) * SampleBytes(); }
+};
+
+constexpr size_t PACKED_FRAME_PAYLOAD_OFFSET = 64;
+
+// A mapped cache entry; 'payload' is valid until UnmapPackedFrame
+struct PackedFrameMapping
+{
+    void* address = nullptr;
+    size_t length = 0;
+    const void* payload = nullptr;
+    PackedFrameHeader header;
+};
+
+// <dir>/.bayesianastro-cache/<name>.bapack for a source frame path
+std::string PackedFramePath(const std::string& sourcePath);
+
+/**
+ * Open the cache entry of 'sourcePath' if it exists, has the requested encoding
+ * and geometry, and was made from a source of the given size and mtime.
+ * Returns an fd positioned for mapping, or -1 (no usable entry).
+ */
+int OpenPackedFrame(const std::string& sourcePath, PackedCacheMode mode,
+                    uint64_t sourceSize, int64_t sourceModified, int64_t height, int64_t width,
+                    PackedFrameHeader& header);
+
+// Map an entry opened by OpenPackedFrame and verify its hash. Closes 'fd'.
+bool MapPackedFrame(int fd, const PackedFrameHeader& header, PackedFrameMapping& mapping, std::string& error);
+void UnmapPackedFrame(PackedFrameMapping& mapping);
+
+// Decode 'count' samples from 'first' of a mapped Float16 entry into 'pixels'
+// (Float32 entries are used in place)
+void DecodePackedFrame(const PackedFrameMapping& mapping, float* pixels, size_t first, size_t count);
+
+// Write (atomically replace) the cache entry of 'sourcePath'
+bool WritePackedFrame(const std::string& sourcePath, PackedCacheMode mode,
+                      uint64_t sourceSize, int64_t sourceModified,
+                      const float* pixels, int64_t height, int64_t width, std::string& error);
+
+// 64-bit content hash (four interleaved multiply-rotate lanes)
+uint64_t HashPackedPayload(const void* data, size_t length);
+
+// IEEE binary16 conversions (round to nearest even; NaN and infinities preserved)
+uint16_t FloatToHalf(float x);
+float HalfToFloat(uint16_t h);
+
+} // namespace pcl
+
+#endif // __PackedFrameCache_h
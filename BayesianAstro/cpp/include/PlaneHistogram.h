@@ -0,0 +1,159 @@
+/**
+ * Plane Histogram
+ *
+ * Histograms of the result planes (fused, confidence, variance) for the web
+ * UI, binned natively from the engine's buffers. Bins are kept per tile, so
+ * when a tile of a plane changes only that tile is binned again and the
+ * totals are adjusted by the difference; a full build splits the tiles over
+ * threads, each adding into its own totals, merged at the end.
+ *
+ * Percentiles interpolate within bins. Out-of-range samples are counted
+ * below and above the bins and interpolate to the plane's exact extremes.
+ *
+ * Serialize produces the compact binary the UI fetches (little-endian):
+ *
+ * Offset  Type          Field
+ * 0       char[4]       "BAH1"
+ * 4       uint32        bins
+ * 8       float32[2]    low, high: range of the bins
+ * 16      float32[2]    min, max of the finite samples (NaN when there are none)
+ * 24      uint64[4]     finite samples, of which below / above the range; non-finite
+ * 56      float32[9]    percentiles at HISTOGRAM_PERCENTILES
+ * 92      uint32[bins]  counts, saturated at 2^32 - 1
+ */
+
+#ifndef __PlaneHistogram_h
+#define __PlaneHistogram_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+
+// Bins per histogram
+constexpr int HISTOGRAM_BINS = 1024;
+
+// Tile edge in plane samples (as preview tiles): the unit of an incremental update
+constexpr int64_t HISTOGRAM_TILE_SIZE = 256;
+
+// Finite samples used to fit a histogram's range, and the fraction of them left out
+// at each end, so a few hot pixels do not squeeze the sky into one bin
+constexpr size_t HISTOGRAM_RANGE_SAMPLES = size_t(1) << 16;
+constexpr double HISTOGRAM_RANGE_CLIP = 0.0005;
+
+// Percentiles (in percent) included in the serialized form
+constexpr int HISTOGRAM_PERCENTILE_COUNT = 9;
+extern const double HISTOGRAM_PERCENTILES[HISTOGRAM_PERCENTILE_COUNT];
+
+enum class HistogramPlane : int
+{
+    Fused = 0,
+    Confidence,         // Fixed range 0..1
+    Variance,           // m2 / (n - 1) of the accumulators (0 below two frames)
+    Count
+};
+
+const char* HistogramPlaneName(HistogramPlane plane);
+bool ParseHistogramPlane(const std::string& name, HistogramPlane& plane);
+
+// Non-owning view of one plane (column-major, naxis1 × naxis2): either 'values', or
+// the accumulator counts and second moments a variance is computed from
+struct HistogramSource
+{
+    const float* values = nullptr;
+    const uint16_t* n = nullptr;
+    const float* m2 = nullptr;
+    int64_t naxis1 = 0;
+    int64_t naxis2 = 0;
+
+    bool Empty() const
+    {
+        return (values == nullptr && (n == nullptr || m2 == nullptr)) || naxis1 <= 0 || naxis2 <= 0;
+    }
+};
+
+class PlaneHistogram
+{
+public:
+    // Bin every tile of 'source' over [low, high], on 'threads' workers (0 = hardware
+    // concurrency). Buffers are kept for the next build
+    void Build(const HistogramSource& source, float low, float high, int threads);
+
+    // As above, over the range fitted to a sample of the plane
+    void Build(const HistogramSource& source, int threads);
+
+    /**
+     * Bin again the tiles overlapping [first1, first1 + count1) × [first2, first2 +
+     * count2) after their samples changed; the range stays. 'source' must be the
+     * plane the histogram was built from.
+     */
+    void Update(const HistogramSource& source, int64_t first1, int64_t count1, int64_t first2, int64_t count2);
+
+    // Free every bin; Empty() afterwards
+    void Release();
+
+    bool Empty() const { return m_counts.empty(); }
+    int Bins() const { return int(m_counts.size()); }
+    const uint64_t* Counts() const { return m_counts.data(); }
+    float Low() const { return m_low; }
+    float High() const { return m_high; }
+    float Min() const { return m_min; }
+    float Max() const { return m_max; }
+    uint64_t Samples() const { return m_samples; }      // Finite, including out of range
+    uint64_t Below() const { return m_below; }
+    uint64_t Above() const { return m_above; }
+    uint64_t NonFinite() const { return m_nonFinite; }
+
+    // Value below which 'percent' of the finite samples fall; NaN without any
+    double Percentile(double percent) const;
+
+    // The binary layout above
+    void Serialize(std::string& out) const;
+
+    uint64_t Bytes() const;
+
+private:
+    // Counts of one tile, besides its row of m_tileBins
+    struct TileStats
+    {
+        uint32_t below = 0;
+        uint32_t above = 0;
+        uint32_t nonFinite = 0;
+        float min = 0.0f;
+        float max = 0.0f;
+    };
+
+    struct Totals;
+
+    // Bin one tile into its row of m_tileBins and add it to 'totals'
+    void BinTile(const HistogramSource& source, int64_t tile, Totals& totals);
+
+    // Finite samples, min and max from the tiles'
+    void UpdateExtremes();
+
+    int64_t m_naxis1 = 0;
+    int64_t m_naxis2 = 0;
+    int64_t m_tilesDown = 0;        // Tiles along NAXIS1
+    int64_t m_tilesAcross = 0;
+    float m_low = 0.0f;
+    float m_high = 1.0f;
+    float m_scale = 0.0f;           // Bins per unit
+
+    std::vector<uint32_t> m_tileBins;   // HISTOGRAM_BINS per tile
+    std::vector<TileStats> m_tiles;
+
+    std::vector<uint64_t> m_counts;
+    uint64_t m_samples = 0;
+    uint64_t m_below = 0;
+    uint64_t m_above = 0;
+    uint64_t m_nonFinite = 0;
+    float m_min = 0.0f;
+    float m_max = 0.0f;
+};
+
+} // namespace pcl
+
+#endif // __PlaneHistogram_h
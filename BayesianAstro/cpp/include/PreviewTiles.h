@@ -0,0 +1,170 @@
+/**
+ * Preview Tiles
+ *
+ * Display tiles of the result planes (fused, confidence, classification) for
+ * the web UI, rendered straight from the engine's buffers and encoded as PNG,
+ * so the browser decodes them natively and no plane is ever copied whole.
+ * Tiles are addressed by zoom level and tile index: level 0 is full
+ * resolution and each level halves it, down to one tile for the whole image.
+ *
+ * The preview shows the plane as FITS lays it out: NAXIS1 (the fastest axis,
+ * the engine's "height") across and NAXIS2 down, so every tile row is a
+ * contiguous run of one plane column.
+ *
+ * Reduced levels come from a PreviewPyramid built once per result, right after
+ * finalization, so a tile at any level costs a copy and a PNG encode. Without
+ * one (live snapshots, which are small) they are sampled from the planes.
+ */
+
+#ifndef __PreviewTiles_h
+#define __PreviewTiles_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+
+// Tile edge in display pixels; edge tiles are cropped to the image
+constexpr int PREVIEW_TILE_SIZE = 256;
+
+// Samples per axis averaged into a display pixel at reduced levels (an exact box
+// filter up to this factor, an evenly spread subset of the block beyond it)
+constexpr int PREVIEW_MAX_TAPS = 4;
+
+// Finite fused samples used to fit the display stretch
+constexpr size_t PREVIEW_STRETCH_SAMPLES = size_t(1) << 16;
+
+class PreviewPyramid;
+
+enum class PreviewPlane : int
+{
+    Fused = 0,          // Auto-stretched greyscale
+    Confidence,         // Linear greyscale, 0..1
+    Classification,     // Palette, one colour per DistributionCode
+    Count
+};
+
+const char* PreviewPlaneName(PreviewPlane plane);
+bool ParsePreviewPlane(const std::string& name, PreviewPlane& plane);
+
+// Non-owning view of a run's output planes (column-major, naxis1 × naxis2); a null
+// plane is one the preview does not have
+struct PreviewSource
+{
+    const float* fused = nullptr;
+    const float* confidence = nullptr;
+    const uint8_t* classification = nullptr;
+    int64_t naxis1 = 0;
+    int64_t naxis2 = 0;
+    uint64_t generation = 0;    // Changes whenever the planes do; 0 = no preview
+    const PreviewPyramid* pyramid = nullptr;    // Prebuilt reduced levels of these planes, if any
+
+    bool Empty() const { return generation == 0 || naxis1 <= 0 || naxis2 <= 0; }
+};
+
+// Zoom levels of an naxis1 × naxis2 image, from full resolution down to one tile
+int PreviewLevelCount(int64_t naxis1, int64_t naxis2);
+
+/**
+ * Fused display stretch: normalize to [0, 1] over the sampled range, clip the
+ * shadows and apply a midtones transfer function (PixInsight's automatic STF)
+ */
+struct PreviewStretch
+{
+    float low = 0.0f;
+    float scale = 1.0f;
+    float shadows = 0.0f;
+    float midtones = 0.5f;
+
+    // Fit to up to PREVIEW_STRETCH_SAMPLES finite samples spread over the plane
+    void Fit(const float* fused, size_t pixels);
+
+    // Display bytes of 'count' samples; NaN is black
+    void Apply(const float* in, uint8_t* out, int count) const;
+};
+
+/**
+ * 2×-decimated display pyramid of a result's planes: every level from 1 down to
+ * one tile, each made from the level above (mean of the finite samples of each
+ * 2×2 block; most frequent class for classification) and stored as display
+ * bytes, NAXIS1 fastest. About a third of a byte per source pixel per plane.
+ */
+class PreviewPyramid
+{
+public:
+    // Decimate every plane of 'source', each level's rows split over 'threads' workers
+    // (0 = hardware concurrency). Buffers are kept for the next build
+    void Build(const PreviewSource& source, int threads);
+
+    // Free every level
+    void Release();
+
+    int64_t Naxis1() const { return m_naxis1; }
+    int64_t Naxis2() const { return m_naxis2; }
+    const PreviewStretch& Stretch() const { return m_stretch; }
+
+    // Display bytes of 'plane' at 'level' (1 .. PreviewLevelCount - 1); null where not built
+    const uint8_t* Level(PreviewPlane plane, int level) const;
+
+    uint64_t Bytes() const;
+
+private:
+    int64_t m_naxis1 = 0;
+    int64_t m_naxis2 = 0;
+    PreviewStretch m_stretch;
+
+    // Per plane, levels 1.. at index level - 1; empty vectors are planes not built
+    std::vector<std::vector<uint8_t>> m_levels[int(PreviewPlane::Count)];
+
+    // Ping-pong float levels, reused across builds
+    std::vector<float> m_scratch[2];
+};
+
+// 8-bit PNG: greyscale, or indexed when 'palette' holds 'colors' RGB triplets
+bool EncodePng(const uint8_t* pixels, int width, int height, const uint8_t* palette, int colors,
+               std::string& png);
+
+/**
+ * Renders tiles of one PreviewSource. The fused stretch is fitted once per
+ * source, on the first fused tile. Not thread-safe; the planes must stay
+ * valid and unchanged while the source is set.
+ */
+class PreviewTiler
+{
+public:
+    void SetSource(const PreviewSource& source);
+    const PreviewSource& Source() const { return m_source; }
+
+    // Levels down to one tile for the whole image; 0 without a source
+    int Levels() const;
+
+    // Display size and tile grid at 'level'
+    int64_t LevelWidth(int level) const;
+    int64_t LevelHeight(int level) const;
+    int64_t TilesAcross(int level) const;
+    int64_t TilesDown(int level) const;
+
+    bool RenderTile(PreviewPlane plane, int level, int64_t tileX, int64_t tileY, std::string& png,
+                    std::string& error);
+
+private:
+    const PreviewPyramid* Pyramid() const;
+
+    PreviewSource m_source;
+
+    // The pyramid's stretch when there is one, else fitted on the first fused tile
+    bool m_stretchFitted = false;
+    PreviewStretch m_stretch;
+
+    std::vector<uint8_t> m_pixels;
+    std::vector<float> m_row;
+    std::vector<int64_t> m_tapsX;
+    std::vector<int64_t> m_tapsY;
+};
+
+} // namespace pcl
+
+#endif // __PreviewTiles_h
@@ -0,0 +1,131 @@
+/**
+ * Progress Aggregator
+ *
+ * Run progress shared between the engine and a UI. Engine threads publish
+ * into atomic counters (phase, percent, frames and bytes ingested, band) and
+ * never block or allocate; a UI timer samples them at its own refresh rate
+ * into one coalesced snapshot with derived throughput, ETA and memory. However
+ * many frames or tiles report, the UI sees at most one update per tick.
+ */
+
+#ifndef __ProgressAggregator_h
+#define __ProgressAggregator_h
+
+#include "RunMetrics.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pcl
+{
+
+// Status text kept by the aggregator, including the terminator; longer text is truncated
+constexpr size_t PROGRESS_STATUS_SIZE = 128;
+
+// Weight of the newest interval in the smoothed frame and byte rates
+constexpr double PROGRESS_RATE_SMOOTHING = 0.3;
+
+struct ProgressSnapshot
+{
+    bool running = false;
+    RunPhase phase = RunPhase::Scan;
+    int percent = 0;
+    std::string status;
+
+    uint64_t framesDone = 0;            // Frame reads completed, summed over bands
+    uint64_t framesTotal = 0;           // Frames times bands
+    int band = 0;                       // 1-based while stacking, 0 before
+    int bands = 1;
+
+    double elapsedSeconds = 0.0;
+    double framesPerSecond = 0.0;       // Smoothed over recent samples
+    double megabytesPerSecond = 0.0;    // Source frame data ingested
+    double etaSeconds = 0.0;            // NaN until the run has made progress
+    uint64_t rssBytes = 0;
+};
+
+/**
+ * Counters may be updated from any thread. The status text is published with
+ * a sequence lock and must have one writer at a time (the thread driving the
+ * run); Sample() must be called from one thread only.
+ */
+class ProgressAggregator
+{
+public:
+    ProgressAggregator();
+
+    // Engine side: relaxed atomic stores and adds only
+    void BeginRun(uint64_t frameCount);
+    void EndRun();
+    void SetPhase(RunPhase phase);
+    void SetBand(int band, int bands);
+    void SetPercent(int percent);
+    void SetStatus(const char* status);
+    void AddFrames(uint64_t frames, uint64_t bytes);
+
+    // Sampling side: false once a finished run has been sampled and nothing changed since
+    bool Sample(ProgressSnapshot& snapshot);
+
+private:
+    static constexpr size_t STATUS_WORDS = PROGRESS_STATUS_SIZE / sizeof(uint64_t);
+
+    void Touch() { m_version.fetch_add(1, std::memory_order_release); }
+
+    std::atomic<uint64_t> m_version{0};
+    std::atomic<bool> m_running{false};
+    std::atomic<int> m_phase{int(RunPhase::Scan)};
+    std::atomic<int> m_percent{0};
+    std::atomic<int> m_band{0};
+    std::atomic<int> m_bands{1};
+    std::atomic<uint64_t> m_frameCount{0};
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_bytes{0};
+    std::atomic<int64_t> m_startNanoseconds{0};
+    std::atomic<int64_t> m_endNanoseconds{0};
+
+    // Status text as words, so a torn read is detected by the sequence rather than a data race
+    std::atomic<uint32_t> m_statusSequence{0};
+    std::atomic<uint64_t> m_status[STATUS_WORDS];
+
+    // Sampler state
+    uint64_t m_sampledVersion = ~uint64_t(0);
+    int64_t m_sampledStart = 0;
+    double m_sampledSeconds = 0.0;
+    uint64_t m_sampledFrames = 0;
+    uint64_t m_sampledBytes = 0;
+    double m_framesPerSecond = -1.0;   // Negative until the first interval of a run
+    double m_bytesPerSecond = -1.0;
+};
+
+/**
+ * Brackets one run: BeginRun on construction and EndRun on destruction, so
+ * every exit path marks the run finished. A null aggregator is ignored.
+ */
+class ProgressRun
+{
+public:
+    ProgressRun(ProgressAggregator* progress, uint64_t frameCount)
+        : m_progress(progress)
+    {
+        if (m_progress != nullptr)
+            m_progress->BeginRun(frameCount);
+    }
+
+    ~ProgressRun()
+    {
+        if (m_progress != nullptr)
+            m_progress->EndRun();
+    }
+
+    ProgressRun(const ProgressRun&) = delete;
+    ProgressRun& operator=(const ProgressRun&) = delete;
+
+private:
+    ProgressAggregator* m_progress;
+};
+
+} // namespace pcl
+
+#endif // __ProgressAggregator_h
@@ -0,0 +1,110 @@
+/**
+ * Run Metrics
+ *
+ * Per-phase resource accounting for a stacking run: wall time, peak RSS,
+ * native and Julia bytes allocated, Julia GC time and the workspace arena
+ * high-water mark, and optionally hardware counters per thread. Phases that
+ * interleave (ingest and accumulate alternate per frame) are accumulated
+ * across all their intervals.
+ */
+
+#ifndef __RunMetrics_h
+#define __RunMetrics_h
+
+#include "HardwareCounters.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+
+class WorkspaceArena;
+
+enum class RunPhase : int
+{
+    Scan = 0,           // Header scan / frame catalog
+    Ingest,             // Native reads and decode (time blocked in FrameIngest::Next)
+    Accumulate,         // Julia accumulate_frame!
+    Finalize,           // Julia finish_stack! (moments, confidence, classification)
+    Write,              // Encoding, compression and output files
+    Count
+};
+
+const char* RunPhaseName(RunPhase phase);
+
+struct PhaseMetrics
+{
+    uint64_t intervals = 0;
+    double seconds = 0.0;
+    uint64_t peakRssBytes = 0;          // Process RSS high-water mark within the phase
+    uint64_t arenaAllocatedBytes = 0;   // Workspace buffers (re)allocated
+    int64_t heapGrowthBytes = 0;        // Net malloc growth (includes small arena buffers)
+    uint64_t juliaAllocatedBytes = 0;
+    double juliaGcSeconds = 0.0;
+    uint64_t arenaHighWaterBytes = 0;   // Largest workspace footprint seen in the phase
+
+    // Hardware counters, summed over threads and per thread (threads idle in the phase omitted)
+    CounterValues counters;
+    std::vector<ThreadCounters> threads;
+};
+
+struct RunMetrics
+{
+    PhaseMetrics phases[int(RunPhase::Count)];
+    uint64_t peakRssBytes = 0;          // Whole run
+    bool exactPeaks = true;             // False if the RSS high-water mark could not be reset
+    bool countersEnabled = false;       // Hardware counters were sampled
+    std::string countersNote;           // Why counters are missing or incomplete
+
+    const PhaseMetrics& operator[](RunPhase phase) const { return phases[int(phase)]; }
+
+    std::string ToJson() const;
+};
+
+// Current and peak resident set size of this process (0 where unavailable)
+uint64_t CurrentRssBytes();
+uint64_t PeakRssBytes();
+
+// Restart the peak RSS counter (Linux /proc/self/clear_refs); false if unsupported
+bool ResetPeakRss();
+
+/**
+ * Brackets phases of a run and accumulates their metrics. The optional Julia
+ * counter source reports cumulative allocated bytes and GC nanoseconds; with
+ * hardware counters, every thread's counters are read at each boundary.
+ */
+class PhaseRecorder
+{
+public:
+    using JuliaCounters = std::function<void(uint64_t& allocatedBytes, uint64_t& gcNanoseconds)>;
+
+    PhaseRecorder(RunMetrics& metrics, WorkspaceArena* arena, JuliaCounters julia = nullptr,
+                  ProcessCounters* counters = nullptr);
+
+    void Begin(RunPhase phase);
+    void End();
+
+private:
+    uint64_t NativeHeapBytes() const;
+
+    RunMetrics& m_metrics;
+    WorkspaceArena* m_arena;
+    JuliaCounters m_julia;
+    ProcessCounters* m_counters;
+
+    RunPhase m_phase = RunPhase::Count;
+    double m_start = 0.0;
+    uint64_t m_arenaAllocated = 0;
+    uint64_t m_heapBytes = 0;
+    uint64_t m_juliaAllocated = 0;
+    uint64_t m_juliaGc = 0;
+    std::vector<ThreadCounters> m_counterStart;
+    std::vector<ThreadCounters> m_counterSample;
+};
+
+} // namespace pcl
+
+#endif // __RunMetrics_h
@@ -0,0 +1,108 @@
+/**
+ * Stack Kernels
+ *
+ * Native ports of the Julia CPU kernels (Welford accumulation, finalization,
+ * parallel merge, linear stretch, min/max) over the same structure-of-arrays
+ * accumulator planes the workspace arena hands to Julia. Arithmetic follows
+ * the Julia code step for step in Float32, so results can be compared directly.
+ *
+ * Kernels are single-threaded over a contiguous pixel range; callers split a
+ * plane into slices (AccumulatorPlanes::Slice) to run them in parallel.
+ */
+
+#ifndef __StackKernels_h
+#define __StackKernels_h
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pcl
+{
+
+// DistributionType codes (types.jl)
+enum class DistributionCode : uint8_t
+{
+    Gaussian = 1,
+    Poisson = 2,
+    Bimodal = 3,
+    SkewedRight = 4,
+    SkewedLeft = 5,
+    Uniform = 6,
+    Unknown = 7
+};
+
+// Non-owning view of the seven accumulator planes (column-major, 'pixels' long)
+struct AccumulatorPlanes
+{
+    uint16_t* n = nullptr;
+    float* mean = nullptr;
+    float* m2 = nullptr;
+    float* m3 = nullptr;
+    float* m4 = nullptr;
+    float* min = nullptr;
+    float* max = nullptr;
+    size_t pixels = 0;
+
+    AccumulatorPlanes Slice(size_t first, size_t count) const;
+};
+
+// Empty state: zero counts and moments, min = +Inf, max = -Inf
+void ResetAccumulator(const AccumulatorPlanes& acc);
+
+/**
+ * Add one frame to the accumulator. The scalar variant is the reference loop
+ * with vectorization disabled; AccumulateFrame is written so the compiler
+ * vectorizes it. Both produce identical results.
+ */
+void AccumulateFrameScalar(const AccumulatorPlanes& acc, const float* frame);
+void AccumulateFrame(const AccumulatorPlanes& acc, const float* frame);
+
+/**
+ * Add 'frameCount' frames, a cache-sized tile of pixels at a time, so the
+ * accumulator planes are read and written once per batch instead of once per
+ * frame. Identical results to calling AccumulateFrame for each frame in order.
+ */
+void AccumulateFrames(const AccumulatorPlanes& acc, const float* const* frames, size_t frameCount);
+
+/**
+ * Fused value (MLE = mean), confidence and distribution class of every pixel,
+ * as cpu_finalize! computes them.
+ */
+void FinalizeAccumulator(const AccumulatorPlanes& acc, float* fused, float* confidence, uint8_t* classes);
+
+// Classification.classify_distribution of one pixel's moments
+DistributionCode ClassifyMoments(uint16_t n, float mean, float m2, float m3, float m4, float min, float max);
+
+// Confidence.compute_confidence of one pixel's moments, as FinalizeAccumulator scores it
+float ConfidenceMoments(uint16_t n, float mean, float m2, float m3, float m4, float min, float max);
+
+// Combine 'from' into 'into' (parallel Welford, as Base.merge for PixelDistribution)
+void MergeAccumulators(const AccumulatorPlanes& into, const AccumulatorPlanes& from);
+
+// Linear stretch of [black, white] to [0, 1], clamped; all zero for an empty range
+void StretchPlane(float* out, const float* in, size_t count, float blackPoint, float whitePoint);
+
+// Minimum and maximum of a plane (+Inf / -Inf when empty; NaN samples are ignored)
+void PlaneMinMax(const float* in, size_t count, float& minValue, float& maxValue);
+
+/**
+ * Deterministic reductions. A plane is cut into leaves of REDUCTION_LEAF_PIXELS at
+ * fixed offsets; each leaf is summed in a fixed lane order and the leaf sums are
+ * combined by a pairwise tree whose shape depends only on their number. Threads
+ * may take the leaves in any order, so the result is bit-identical for any thread
+ * count, scheduling or band layout.
+ */
+constexpr size_t REDUCTION_LEAF_PIXELS = size_t(1) << 14;
+
+// Sum of one leaf (or any range) in double, in fixed lane order
+double SumPlane(const float* in, size_t count);
+
+// Pairwise sum of leaf partials; 'partials' is overwritten
+double PairwiseSum(double* partials, size_t count);
+
+// Add the number of pixels with each class code (DistributionCode, 0..7) to 'counts'
+void CountClasses(const uint8_t* classes, size_t count, uint64_t counts[8]);
+
+} // namespace pcl
+
+#endif // __StackKernels_h
@@ -0,0 +1,98 @@
+/**
+ * Stage Graph
+ *
+ * A run as a graph of stages, each keyed by a content hash of its own
+ * parameters and its parents' keys. A stage's cached output is reusable while
+ * the key it was made with matches; a run computes only the stale stages its
+ * target needs, as make does. Keys are cheap to compute (a stat per input), so
+ * a UI can show what Execute would redo before it is pressed.
+ *
+ * Stage        Parameters                          Cached
+ * Accumulate   input paths, sizes, mtimes          accumulator planes (memory)
+ * Finalize     fusion strategy, GPU                output planes (memory)
+ * Write        directory, prefix, encodings        output files (disk)
+ */
+
+#ifndef __StageGraph_h
+#define __StageGraph_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace pcl
+{
+
+enum class PipelineStage : int
+{
+    Accumulate = 0,     // Scan, ingest and accumulate every frame
+    Finalize,           // Classification, confidence and fusion
+    Write,              // Output planes, metrics and trace
+    Count
+};
+
+// Lower-case stage name, as in stage plans
+const char* PipelineStageName(PipelineStage stage);
+
+// Parents of 'stage' (whose outputs it reads), terminated by PipelineStage::Count
+const PipelineStage* PipelineStageParents(PipelineStage stage);
+
+/**
+ * Parameter bytes of one stage. Add every value that changes the stage's output
+ * and nothing that only changes how it is computed (backend, threads, cache modes).
+ */
+class StageParameters
+{
+public:
+    StageParameters& Add(const void* data, size_t bytes);
+    StageParameters& Add(const std::string& text);      // Length-prefixed
+
+    template <typename T>
+    StageParameters& Add(const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "hash values, not objects");
+        return Add(&value, sizeof(value));
+    }
+
+    const std::string& Bytes() const { return m_bytes; }
+
+private:
+    std::string m_bytes;
+};
+
+// One key per stage; 0 means no output (never computed, or invalidated)
+struct StageKeys
+{
+    uint64_t key[int(PipelineStage::Count)] = {};
+
+    uint64_t& operator[](PipelineStage stage) { return key[int(stage)]; }
+    uint64_t operator[](PipelineStage stage) const { return key[int(stage)]; }
+};
+
+// Keys of every stage from its own parameters and its parents' keys; never 0
+StageKeys ComputeStageKeys(const StageParameters (&parameters)[int(PipelineStage::Count)]);
+
+// Stages a run has to compute, against the keys of the outputs at hand
+struct StagePlan
+{
+    bool run[int(PipelineStage::Count)] = {};
+
+    bool Runs(PipelineStage stage) const { return run[int(stage)]; }
+    bool Empty() const;
+
+    // "finalize, write", or "nothing (up to date)"
+    std::string Describe() const;
+};
+
+/**
+ * Stages to compute to bring 'target' up to date: every stage whose cached key
+ * differs from the wanted one and that 'target' reaches through stages that
+ * run. A stage with a valid output stops the walk, so e.g. a new encoding
+ * rewrites the result without finalizing again, banded or not.
+ */
+StagePlan PlanStages(const StageKeys& wanted, const StageKeys& cached, PipelineStage target);
+
+} // namespace pcl
+
+#endif // __StageGraph_h
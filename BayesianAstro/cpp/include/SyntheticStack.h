@@ -0,0 +1,142 @@
+/**
+ * Synthetic Stack
+ *
+ * Deterministic generator of realistic frame sets with known ground truth:
+ * sky background with a gradient, a fixed star field with Poisson photon
+ * noise, read noise, hot pixels, cosmic rays, satellite trails and per-frame
+ * dithers. Every frame is a pure function of (seed, frame index), so frames
+ * can be streamed straight into the kernels, generated in parallel or written
+ * as FITS files, and the same stack is reproduced bit for bit anywhere.
+ *
+ * SyntheticReference replays the stack in double precision to give the exact
+ * per-pixel moments an engine's output is checked against, and derives the
+ * expected classification of every pixel from its ground-truth features.
+ */
+
+#ifndef __SyntheticStack_h
+#define __SyntheticStack_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pcl
+{
+
+struct SyntheticStackConfig
+{
+    int64_t height = 4096;              // FITS NAXIS1 (Julia first dimension)
+    int64_t width = 6144;
+    size_t frames = 300;
+    uint64_t seed = 1;
+
+    // Values are quantized to the output type: 16 = integer ADU in [0, 65534], -32 = Float32
+    int bitpix = 16;
+
+    double bias = 500.0;                // ADU pedestal
+    double skyLevel = 800.0;            // Mean sky, electrons (gain 1 e-/ADU)
+    double gradient = 200.0;            // Sky increase across the diagonal, electrons
+    double readNoise = 5.0;             // Electrons RMS
+
+    size_t stars = 2000;
+    double starFluxMin = 2e3;           // Total electrons per star (power law between the two)
+    double starFluxMax = 2e6;
+    double starFwhm = 3.0;              // Pixels
+
+    double hotPixelFraction = 1e-4;     // Fixed sensor defects
+    double hotPixelLevel = 20000.0;
+
+    double cosmicRaysPerMegapixel = 2.0;  // Hits per frame
+    double cosmicRayLevel = 15000.0;
+
+    double trailProbability = 0.05;     // Chance of a satellite trail per frame
+    double trailLevel = 3000.0;
+    double trailWidth = 2.0;
+
+    double ditherPixels = 8.0;          // Maximum offset of a frame from the reference frame
+};
+
+// Ground-truth features of a pixel (bit flags)
+enum SyntheticTruth : uint8_t
+{
+    TruthSky = 0,
+    TruthStar = 1,                      // Within a star core (above 10% of its peak) in any frame
+    TruthHotPixel = 2,
+    TruthCosmicRay = 4,                 // Hit in at least one frame
+    TruthTrail = 8,                     // Crossed by a trail in at least one frame
+    TruthSaturated = 16                 // Clipped at the 16-bit ceiling in at least one frame
+};
+
+class SyntheticStack
+{
+public:
+    explicit SyntheticStack(const SyntheticStackConfig& config);
+
+    const SyntheticStackConfig& Config() const { return m_config; }
+    size_t Pixels() const { return size_t(m_config.height) * size_t(m_config.width); }
+
+    // Expected sky electrons at a pixel (background and gradient, before any source or noise)
+    double SkyElectrons(int64_t row, int64_t column) const;
+
+    /**
+     * Render frame 'index' into 'pixels' (column-major, Pixels() long). When 'truth'
+     * is given, the features present in this frame are OR-ed into it.
+     */
+    void GenerateFrame(size_t index, float* pixels, uint8_t* truth = nullptr) const;
+
+    // Columns [firstColumn, firstColumn + columnCount) of frame 'index' only (a contiguous band)
+    void GenerateColumns(size_t index, int64_t firstColumn, int64_t columnCount,
+                         float* pixels, uint8_t* truth = nullptr) const;
+
+    /**
+     * Write every frame as '<directory>/<prefix>_NNNN.fits' (created if missing),
+     * using 'threads' workers (0 = hardware concurrency). Frames carry DATE-OBS one
+     * exposure apart and the generator settings as SYN* keywords.
+     */
+    bool WriteFrames(const std::string& directory, const std::string& prefix, int threads,
+                     std::vector<std::string>* paths, std::string& error) const;
+
+private:
+    struct Star
+    {
+        double row, column;             // Reference-frame position
+        double flux;
+    };
+
+    struct FrameLayout
+    {
+        double rowOffset = 0.0, columnOffset = 0.0;
+        bool trail = false;
+        double trailRow = 0.0, trailColumn = 0.0;   // A point on the trail
+        double trailSin = 0.0, trailCos = 0.0;      // Direction
+        std::vector<std::pair<size_t, float>> cosmicRays;   // Pixel index, electrons
+    };
+
+    FrameLayout Layout(size_t index) const;
+
+    SyntheticStackConfig m_config;
+    std::vector<Star> m_stars;
+    std::vector<size_t> m_hotPixels;    // Sorted pixel indices
+};
+
+/**
+ * Exact per-pixel statistics of a synthetic stack, accumulated in double precision
+ * (two passes: mean, then central moments) over regenerated frames.
+ */
+struct SyntheticReference
+{
+    std::vector<double> mean, m2, m3, m4;
+    std::vector<float> min, max;
+    std::vector<uint8_t> classes;       // DistributionCode the ground truth calls for
+    std::vector<uint8_t> truth;         // SyntheticTruth flags
+    size_t frames = 0;
+
+    // 'threads' workers split the image by columns (0 = hardware concurrency)
+    static SyntheticReference Compute(const SyntheticStack& stack, int threads = 0);
+};
+
+} // namespace pcl
+
+#endif // __SyntheticStack_h
@@ -0,0 +1,106 @@
+/**
+ * Trace Timeline
+ *
+ * Low-overhead scoped trace events for every stage of a run (header scan, strip
+ * reads, decode, packed cache, Julia calls, output encoding and writes) on every
+ * thread, exported as Chrome trace JSON (chrome://tracing, Perfetto). Each thread
+ * records into its own ring buffer, so the hot path takes no locks; when the
+ * buffer is full the oldest events are overwritten. With tracing stopped a scope
+ * costs one relaxed atomic load and a branch.
+ *
+ * Event names and argument names must be string literals (or otherwise outlive
+ * the export): only the pointers are recorded.
+ */
+
+#ifndef __TraceTimeline_h
+#define __TraceTimeline_h
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pcl
+{
+
+// Chrome trace "cat" of an event; filters and colours the timeline
+enum class TraceCategory : uint8_t
+{
+    Scan = 0,           // Header scan / frame catalog
+    Io,                 // Strip reads and waits for them
+    Decode,             // FITS sample decode
+    Cache,              // Packed frame cache maps and writes
+    Julia,              // Calls into the Julia engine
+    Compute,            // Native kernels
+    Write,              // Output encoding, compression and file writes
+    Count
+};
+
+const char* TraceCategoryName(TraceCategory category);
+
+// Events kept per thread before the oldest are overwritten (about 48 bytes each)
+constexpr size_t DEFAULT_TRACE_EVENTS_PER_THREAD = size_t(1) << 16;
+
+// Set while a trace session is recording; read through TraceEnabled()
+extern std::atomic<bool> g_traceEnabled;
+
+inline bool TraceEnabled()
+{
+    return g_traceEnabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Start a new session, discarding the previous one. Start, stop and export
+ * while no traced work is running: buffers of the old session are freed.
+ */
+void StartTrace(size_t eventsPerThread = DEFAULT_TRACE_EVENTS_PER_THREAD);
+void StopTrace();
+
+// Write the recorded session as Chrome trace JSON (call after StopTrace)
+bool WriteChromeTrace(const std::string& path, std::string& error);
+
+// Label the calling thread's track; kept across sessions, so pools may set it once at startup
+void SetTraceThreadName(const char* name);
+
+// A sample on a counter track (e.g. cumulative GC time), if tracing
+void TraceCounter(const char* name, double value);
+
+/**
+ * Records [construction, destruction) of the enclosing scope as one complete
+ * event on the calling thread, with an optional integer argument.
+ */
+class TraceScope
+{
+public:
+    TraceScope(TraceCategory category, const char* name, const char* argName = nullptr, int64_t arg = 0)
+    {
+        if (TraceEnabled())
+            Begin(category, name, argName, arg);
+    }
+
+    ~TraceScope()
+    {
+        if (m_name != nullptr)
+            End();
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    // Set the argument once it is known, e.g. bytes actually read
+    void SetArg(int64_t arg) { m_arg = arg; }
+
+private:
+    void Begin(TraceCategory category, const char* name, const char* argName, int64_t arg);
+    void End();
+
+    const char* m_name = nullptr;
+    const char* m_argName = nullptr;
+    int64_t m_arg = 0;
+    uint64_t m_start = 0;
+    TraceCategory m_category = TraceCategory::Count;
+};
+
+} // namespace pcl
+
+#endif // __TraceTimeline_h
@@ -0,0 +1,140 @@
+/**
+ * Workspace Arena
+ *
+ * Session-scoped, page-aligned buffers that outlive a single run: the per-pixel
+ * accumulator planes and output planes handed to Julia, and the ingest frame
+ * buffers. Re-running with the same geometry (e.g. while tuning parameters)
+ * reuses every buffer instead of reallocating and re-faulting it. Buffers of
+ * 2 MiB and more are backed by huge pages where the system allows, to cut TLB
+ * misses in the accumulation loop.
+ */
+
+#ifndef __WorkspaceArena_h
+#define __WorkspaceArena_h
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace pcl
+{
+
+// Huge page policy for large buffers (mirrors the hugePages process parameter)
+enum class HugePageMode : int
+{
+    Off = 0,            // Regular pages
+    Transparent = 1,    // madvise(MADV_HUGEPAGE) on 2 MiB-aligned mappings
+    HugeTLB = 2         // Reserved hugetlbfs pages, else transparent
+};
+
+constexpr size_t HUGE_PAGE_SIZE = size_t(2) << 20;
+
+// Buffer roles; ingest read buffers use WorkspaceSlot::ReadBuffer + slot index
+enum class WorkspaceSlot : uint32_t
+{
+    AccumulatorCount = 0,       // UInt16 frame counts
+    AccumulatorMean,
+    AccumulatorM2,
+    AccumulatorM3,
+    AccumulatorM4,
+    AccumulatorMin,
+    AccumulatorMax,
+    Fused,
+    Confidence,
+    Classification,             // UInt8 class codes
+    DecodedFrame,               // Float32 frame handed to Julia
+    ReadBuffer = 64             // Raw strip-read buffers, one per read-ahead slot
+};
+
+inline WorkspaceSlot ReadBufferSlot(size_t index)
+{
+    return WorkspaceSlot(uint32_t(WorkspaceSlot::ReadBuffer) + uint32_t(index));
+}
+
+// Reuse report for the current run and the arena as a whole
+struct WorkspaceStats
+{
+    size_t reused = 0;          // Buffers served from earlier runs this run
+    size_t allocated = 0;       // Buffers (re)allocated this run
+    uint64_t allocatedBytes = 0;
+    uint64_t residentBytes = 0; // Everything the arena holds
+    uint64_t peakResidentBytes = 0; // High-water mark of residentBytes since ResetPeak()
+    uint64_t runs = 0;
+
+    // What large buffers actually got: reserved hugetlbfs pages, bytes advised for
+    // transparent huge pages, and how much of those the kernel has backed so far
+    uint64_t hugetlbBytes = 0;
+    uint64_t transparentAdvisedBytes = 0;
+    uint64_t transparentBackedBytes = 0;
+    std::string hugePageNote;   // Why huge pages were not (fully) used, if known
+};
+
+class WorkspaceArena
+{
+public:
+    explicit WorkspaceArena(HugePageMode hugePages = HugePageMode::Transparent);
+    ~WorkspaceArena();
+
+    WorkspaceArena(const WorkspaceArena&) = delete;
+    WorkspaceArena& operator=(const WorkspaceArena&) = delete;
+
+    // Start a run: resets the per-run counters
+    void BeginRun();
+
+    // Policy for buffers allocated from now on; existing buffers keep their backing
+    void SetHugePageMode(HugePageMode mode);
+
+    /**
+     * Buffer of at least 'bytes' for 'slot': page-aligned for read buffers, cache-line
+     * aligned and staggered per slot for planes. The buffer from an
+     * earlier request is returned when it is large enough and not more than
+     * twice the size needed; otherwise it is replaced. Contents are unspecified.
+     * Returns nullptr if allocation fails.
+     */
+    void* Acquire(WorkspaceSlot slot, size_t bytes);
+
+    template <typename T>
+    T* Acquire(WorkspaceSlot slot, size_t count)
+    {
+        return static_cast<T*>(Acquire(slot, count * sizeof(T)));
+    }
+
+    // Free every buffer (e.g. when the module is unloaded or memory is needed back)
+    void Release();
+
+    // Current counters; transparentBackedBytes is read from /proc/self/smaps
+    WorkspaceStats Stats() const;
+
+    // Counters only, cheap enough to sample per frame
+    WorkspaceStats Counters() const;
+
+    // Restart the high-water mark from the current footprint
+    void ResetPeak();
+
+private:
+    enum class Backing { Heap, Transparent, HugeTLB };
+
+    struct Buffer
+    {
+        void* base = nullptr;       // Allocation
+        void* data = nullptr;       // Plane start (base + stagger offset)
+        size_t mapped = 0;
+        size_t capacity = 0;        // Usable bytes from 'data'
+        Backing backing = Backing::Heap;
+    };
+
+    bool Allocate(Buffer& buffer, size_t bytes);
+    void Free(Buffer& buffer);
+    void Note(const std::string& note);
+
+    mutable std::mutex m_mutex;
+    HugePageMode m_hugePages;
+    std::unordered_map<uint32_t, Buffer> m_buffers;
+    WorkspaceStats m_stats;
+};
+
+} // namespace pcl
+
+#endif // __WorkspaceArena_h
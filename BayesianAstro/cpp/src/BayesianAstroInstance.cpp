@@ -4,6 +4,7 @@
 
 #include "BayesianAstroInstance.h"
 #include "BayesianAstroParameters.h"
+#include "FrameCatalog.h"
 #include "JuliaRuntime.h"
 
 #include <pcl/Console.h>
@@ -20,6 +21,18 @@ BayesianAstroInstance::BayesianAstroInstance(const MetaProcess* m)
     , p_useGPU(TheBAUseGPUParameter->DefaultValue())
     , p_generateConfidenceMap(TheBAGenerateConfidenceMapParameter->DefaultValue())
     , p_outputPrefix(TheBAOutputPrefixParameter->DefaultValue())
+    , p_ingestBackend(BAIngestBackend::Default)
+    , p_ingestCacheMode(BAIngestCacheMode::Default)
+    , p_ingestPackedCache(BAIngestPackedCache::Default)
+    , p_fusedEncoding(BAFusedEncoding::Default)
+    , p_confidenceEncoding(BAConfidenceEncoding::Default)
+    , p_classificationEncoding(BAClassificationEncoding::Default)
+    , p_compressOutput(TheBACompressOutputParameter->DefaultValue())
+    , p_memoryBudget(TheBAMemoryBudgetParameter->DefaultValue())
+    , p_hugePages(BAHugePages::Default)
+    , p_traceTimeline(TheBATraceTimelineParameter->DefaultValue())
+    , p_hardwareCounters(TheBAHardwareCountersParameter->DefaultValue())
+    , p_deterministicReduction(TheBADeterministicReductionParameter->DefaultValue())
 {
 }
 
@@ -33,6 +46,18 @@ BayesianAstroInstance::BayesianAstroInstance(const BayesianAstroInstance& x)
     , p_generateConfidenceMap(x.p_generateConfidenceMap)
     , p_outputDirectory(x.p_outputDirectory)
     , p_outputPrefix(x.p_outputPrefix)
+    , p_ingestBackend(x.p_ingestBackend)
+    , p_ingestCacheMode(x.p_ingestCacheMode)
+    , p_ingestPackedCache(x.p_ingestPackedCache)
+    , p_fusedEncoding(x.p_fusedEncoding)
+    , p_confidenceEncoding(x.p_confidenceEncoding)
+    , p_classificationEncoding(x.p_classificationEncoding)
+    , p_compressOutput(x.p_compressOutput)
+    , p_memoryBudget(x.p_memoryBudget)
+    , p_hugePages(x.p_hugePages)
+    , p_traceTimeline(x.p_traceTimeline)
+    , p_hardwareCounters(x.p_hardwareCounters)
+    , p_deterministicReduction(x.p_deterministicReduction)
 {
 }
 
@@ -49,6 +74,18 @@ void BayesianAstroInstance::Assign(const ProcessImplementation& p)
         p_generateConfidenceMap = x->p_generateConfidenceMap;
         p_outputDirectory = x->p_outputDirectory;
         p_outputPrefix = x->p_outputPrefix;
+        p_ingestBackend = x->p_ingestBackend;
+        p_ingestCacheMode = x->p_ingestCacheMode;
+        p_ingestPackedCache = x->p_ingestPackedCache;
+        p_fusedEncoding = x->p_fusedEncoding;
+        p_confidenceEncoding = x->p_confidenceEncoding;
+        p_classificationEncoding = x->p_classificationEncoding;
+        p_compressOutput = x->p_compressOutput;
+        p_memoryBudget = x->p_memoryBudget;
+        p_hugePages = x->p_hugePages;
+        p_traceTimeline = x->p_traceTimeline;
+        p_hardwareCounters = x->p_hardwareCounters;
+        p_deterministicReduction = x->p_deterministicReduction;
     }
 }
 
@@ -98,17 +135,16 @@ bool BayesianAstroInstance::ExecuteGlobal()
     console.WriteLn("<b>BayesianAstro</b>");
     console.WriteLn(String().Format("Processing %d frames...", p_inputFiles.Length()));
 
-    // Convert StringList to std::vector
-    std::vector<std::string> inputFiles;
-    for (const String& s : p_inputFiles)
-        inputFiles.push_back(s.ToUTF8().c_str());
-
-    // Build config
+    std::vector<std::string> inputFiles = InputPaths();
     ProcessingConfig config;
-    config.fusionStrategy = static_cast<FusionStrategy>(p_fusionStrategy + 1);  // Julia is 1-indexed
-    config.outlierSigma = p_outlierSigma;
-    config.confidenceThreshold = p_confidenceThreshold;
-    config.useGPU = p_useGPU;
+    BuildConfig(config);
+
+    // Stages whose inputs and parameters are unchanged since the last run are reused
+    JuliaRuntime& runtime = JuliaRuntime::Instance();
+    const std::string outputDirectory = p_outputDirectory.ToUTF8().c_str();
+    const std::string outputPrefix = p_outputPrefix.ToUTF8().c_str();
+    console.WriteLn("Stages to run: "
+                    + String(runtime.PlanRun(inputFiles, outputDirectory, outputPrefix, config).Describe().c_str()));
 
     // Progress callback
     StandardStatus status;
@@ -122,13 +158,7 @@ bool BayesianAstroInstance::ExecuteGlobal()
     };
 
     // Execute
-    ProcessingResult result = JuliaRuntime::Instance().ProcessStack(
-        inputFiles,
-        p_outputDirectory.ToUTF8().c_str(),
-        p_outputPrefix.ToUTF8().c_str(),
-        config,
-        progressCallback
-    );
+    ProcessingResult result = runtime.Run(inputFiles, outputDirectory, outputPrefix, config, progressCallback);
 
     monitor.Complete(100);
 
@@ -141,8 +171,100 @@ bool BayesianAstroInstance::ExecuteGlobal()
     console.WriteLn("Fused image: " + String(result.fusedImagePath.c_str()));
     if (p_generateConfidenceMap)
         console.WriteLn("Confidence map: " + String(result.confidenceMapPath.c_str()));
+    if (!result.classificationMapPath.empty())
+        console.WriteLn("Classification map: " + String(result.classificationMapPath.c_str()));
+    if (result.output.fileBytes > 0)
+        console.WriteLn(String().Format("Outputs: %.2f MB written (%.1f%% of float32) in %.3f s",
+                                        result.output.fileBytes / 1048576.0,
+                                        100.0 * result.output.fileBytes / result.output.float32Bytes,
+                                        result.output.seconds));
 
     console.WriteLn(String().Format("Mean confidence: %.3f", result.meanConfidence));
+    if (p_deterministicReduction)
+        console.WriteLn(String().Format("Deterministic summary: fixed reduction tree in %.3f ms",
+                                        result.reductionSeconds * 1e3));
+    if (result.pyramidBytes > 0)
+        console.WriteLn(String().Format("Preview pyramid: %.1f MB in %.3f ms",
+                                        result.pyramidBytes / 1048576.0, result.pyramidSeconds * 1e3));
+    if (result.histogramSeconds > 0)
+        console.WriteLn(String().Format("Plane histograms: %d bins in %.3f ms", HISTOGRAM_BINS,
+                                        result.histogramSeconds * 1e3));
+
+    if (result.stages.Runs(PipelineStage::Accumulate))
+    {
+        console.WriteLn(String().Format("Frame catalog: %u cached, %u scanned in %.3f s",
+                                        unsigned(result.catalog.cached), unsigned(result.catalog.scanned),
+                                        result.catalog.seconds));
+        const IngestStats& ingest = result.ingest;
+        console.WriteLn("Ingest backend: " + String(ingest.backend.c_str())
+                        + ", page cache: " + String(ingest.cacheMode.c_str()));
+        if (!ingest.note.empty())
+            console.WarningLn("** " + String(ingest.note.c_str()));
+        console.WriteLn(String().Format("Ingest: %.1f MB/s, queue depth %.1f avg / %d peak, %llu reads",
+                                        ingest.MegabytesPerSecond(), ingest.averageQueueDepth,
+                                        ingest.peakQueueDepth, (unsigned long long)ingest.reads));
+        if (p_ingestPackedCache != BAIngestPackedCache::Off)
+            console.WriteLn(String().Format("Packed cache: %llu frames mapped, %llu entries written",
+                                            (unsigned long long)ingest.packedHits,
+                                            (unsigned long long)ingest.packedWrites));
+    }
+    const WorkspaceStats& workspace = result.workspace;
+    console.WriteLn(String().Format("Workspace: run %llu, %u buffers reused, %u allocated (%.1f MB), %.1f MB resident",
+                                    (unsigned long long)workspace.runs, unsigned(workspace.reused),
+                                    unsigned(workspace.allocated), workspace.allocatedBytes / 1048576.0,
+                                    workspace.residentBytes / 1048576.0));
+    if (workspace.hugetlbBytes + workspace.transparentAdvisedBytes > 0)
+        console.WriteLn(String().Format("Huge pages: %.1f MB hugetlbfs, %.1f MB of %.1f MB advised backed by THP",
+                                        workspace.hugetlbBytes / 1048576.0,
+                                        workspace.transparentBackedBytes / 1048576.0,
+                                        workspace.transparentAdvisedBytes / 1048576.0));
+    if (!workspace.hugePageNote.empty())
+        console.WarningLn("** " + String(workspace.hugePageNote.c_str()));
+    console.WriteLn(String().Format("Steady-state allocation: %llu bytes per frame",
+                                    (unsigned long long)result.frameAllocationBytes));
+
+    const RunMetrics& metrics = result.metrics;
+    console.WriteLn("Phase        time (s)  peak RSS (MB)  arena HWM (MB)  arena alloc (MB)  Julia alloc (MB)  GC (s)");
+    for (int i = 0; i < int(RunPhase::Count); ++i)
+    {
+        const PhaseMetrics& phase = metrics.phases[i];
+        if (phase.intervals == 0)
+            continue;
+        console.WriteLn(String().Format("%-10s %10.3f %14.1f %15.1f %17.1f %17.1f %7.3f",
+                                        RunPhaseName(RunPhase(i)), phase.seconds,
+                                        phase.peakRssBytes / 1048576.0, phase.arenaHighWaterBytes / 1048576.0,
+                                        phase.arenaAllocatedBytes / 1048576.0,
+                                        phase.juliaAllocatedBytes / 1048576.0, phase.juliaGcSeconds));
+    }
+    console.WriteLn(String().Format("Peak RSS: %.1f MB", metrics.peakRssBytes / 1048576.0));
+    if (!metrics.exactPeaks)
+        console.WarningLn("** Peak RSS could not be reset per phase; phase peaks are RSS at phase end");
+    if (p_hardwareCounters)
+    {
+        if (metrics.countersEnabled)
+        {
+            // NaN (an event the kernel would not count) prints as "nan"
+            console.WriteLn("Phase        IPC  cache miss  branch miss  est. DRAM (GB/s)  CPU (s)  threads");
+            for (int i = 0; i < int(RunPhase::Count); ++i)
+            {
+                const PhaseMetrics& phase = metrics.phases[i];
+                if (phase.intervals == 0)
+                    continue;
+                const CounterValues& c = phase.counters;
+                console.WriteLn(String().Format("%-10s %5.2f %10.1f%% %11.2f%% %17.2f %8.3f %8u",
+                                                RunPhaseName(RunPhase(i)), c.InstructionsPerCycle(),
+                                                100.0 * c.CacheMissRate(), 100.0 * c.BranchMissRate(),
+                                                c.MemoryBytes() / phase.seconds / 1e9,
+                                                c[CounterEvent::TaskClock] * 1e-9, unsigned(phase.threads.size())));
+            }
+        }
+        if (!metrics.countersNote.empty())
+            console.WarningLn("** Hardware counters: " + String(metrics.countersNote.c_str()));
+    }
+    if (!result.metricsPath.empty())
+        console.WriteLn("Metrics: " + String(result.metricsPath.c_str()));
+    if (!result.tracePath.empty())
+        console.WriteLn("Trace: " + String(result.tracePath.c_str()));
 
     return true;
 }
@@ -165,6 +287,30 @@ void* BayesianAstroInstance::LockParameter(const MetaParameter* p, size_type tab
         return p_outputDirectory.Begin();
     if (p == TheBAOutputPrefixParameter)
         return p_outputPrefix.Begin();
+    if (p == TheBAIngestBackendParameter)
+        return &p_ingestBackend;
+    if (p == TheBAIngestCacheModeParameter)
+        return &p_ingestCacheMode;
+    if (p == TheBAIngestPackedCacheParameter)
+        return &p_ingestPackedCache;
+    if (p == TheBAFusedEncodingParameter)
+        return &p_fusedEncoding;
+    if (p == TheBAConfidenceEncodingParameter)
+        return &p_confidenceEncoding;
+    if (p == TheBAClassificationEncodingParameter)
+        return &p_classificationEncoding;
+    if (p == TheBACompressOutputParameter)
+        return &p_compressOutput;
+    if (p == TheBAMemoryBudgetParameter)
+        return &p_memoryBudget;
+    if (p == TheBAHugePagesParameter)
+        return &p_hugePages;
+    if (p == TheBATraceTimelineParameter)
+        return &p_traceTimeline;
+    if (p == TheBAHardwareCountersParameter)
+        return &p_hardwareCounters;
+    if (p == TheBADeterministicReductionParameter)
+        return &p_deterministicReduction;
 
     return nullptr;
 }
@@ -217,11 +363,79 @@ size_type BayesianAstroInstance::ParameterLength(const MetaParameter* p, size_ty
 
 bool BayesianAstroInstance::ValidateInputFiles() const
 {
+    // Catalog lookup with header-only scans of new frames; no Julia round trip per file
+    FrameHeaderTable headers = LoadFrameCatalog(InputPaths());
+    size_t failed = headers.FirstFailure();
+    if (failed < headers.Size())
+    {
+        Console().CriticalLn("** Invalid input: " + String(headers.errors[failed].c_str()));
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> BayesianAstroInstance::InputPaths() const
+{
+    std::vector<std::string> paths;
+    paths.reserve(p_inputFiles.Length());
     for (const String& path : p_inputFiles)
+        paths.push_back(path.ToUTF8().c_str());
+    return paths;
+}
+
+void BayesianAstroInstance::BuildConfig(ProcessingConfig& config) const
+{
+    config.fusionStrategy = static_cast<FusionStrategy>(p_fusionStrategy + 1);  // Julia is 1-indexed
+    config.outlierSigma = p_outlierSigma;
+    config.confidenceThreshold = p_confidenceThreshold;
+    config.useGPU = p_useGPU;
+    config.ingest.backend = static_cast<IngestBackendType>(p_ingestBackend);
+    config.ingest.cacheMode = static_cast<IngestCacheMode>(p_ingestCacheMode);
+    config.ingest.packedCache = static_cast<PackedCacheMode>(p_ingestPackedCache);
+    config.output.fusedEncoding = static_cast<PlaneEncoding>(p_fusedEncoding);
+    config.output.confidenceEncoding = static_cast<PlaneEncoding>(p_confidenceEncoding);
+    config.output.writeConfidence = p_generateConfidenceMap;
+    config.output.writeClassification = p_classificationEncoding != BAClassificationEncoding::None;
+    config.output.classificationEncoding = p_classificationEncoding == BAClassificationEncoding::UInt8
+                                         ? PlaneEncoding::UInt8 : PlaneEncoding::Packed4;
+    config.output.compress = p_compressOutput;
+    config.memoryBudget = uint64_t(double(p_memoryBudget) * 1048576.0);
+    config.hugePages = static_cast<HugePageMode>(p_hugePages);
+    config.trace = p_traceTimeline;
+    config.hardwareCounters = p_hardwareCounters;
+    config.deterministic = p_deterministicReduction;
+    config.progress = m_progress;
+    config.livePreview = m_livePreview;
+}
+
+StagePlan BayesianAstroInstance::PlannedStages() const
+{
+    ProcessingConfig config;
+    BuildConfig(config);
+    return JuliaRuntime::Instance().PlanRun(InputPaths(), p_outputDirectory.ToUTF8().c_str(),
+                                            p_outputPrefix.ToUTF8().c_str(), config);
+}
+
+bool BayesianAstroInstance::RefinalizePreview(double& seconds)
+{
+    ProcessingConfig config;
+    BuildConfig(config);
+    config.trace = false;  // A trace belongs next to written outputs
+
+    // The preview is the Finalize stage's output; reading frames is left to Execute
+    JuliaRuntime& runtime = JuliaRuntime::Instance();
+    const std::vector<std::string> inputFiles = InputPaths();
+    const StagePlan plan = runtime.PlanRun(inputFiles, "", "", config);
+    if (plan.Empty() || plan.Runs(PipelineStage::Accumulate))
+        return false;
+
+    ProcessingResult result = runtime.Run(inputFiles, "", "", config);
+    if (!result.success)
     {
-        if (!JuliaRuntime::Instance().ValidateFitsFile(path.ToUTF8().c_str()))
-            return false;
+        Console().CriticalLn("** Refinalize failed: " + String(result.errorMessage.c_str()));
+        return false;
     }
+    seconds = result.metrics[RunPhase::Finalize].seconds;
     return true;
 }
 
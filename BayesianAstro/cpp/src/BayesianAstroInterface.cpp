@@ -6,12 +6,18 @@
 
 #include "BayesianAstroInterface.h"
 #include "BayesianAstroProcess.h"
+#include "JuliaRuntime.h"
 
 #include <pcl/Console.h>
 #include <pcl/ErrorHandler.h>
 
+#include <QtWebEngineCore/QWebEngineProfile>
+#include <QtWebEngineCore/QWebEngineUrlRequestJob>
+#include <QtWebEngineCore/QWebEngineUrlScheme>
+#include <QBuffer>
 #include <QVBoxLayout>
 #include <QUrl>
+#include <QVariantMap>
 #include <QDir>
 #include <QCoreApplication>
 
@@ -20,6 +26,127 @@ namespace pcl
 
 BayesianAstroInterface* TheBayesianAstroInterface = nullptr;
 
+// ============================================================================
+// Preview Tile Scheme
+// ============================================================================
+
+void RegisterPreviewScheme()
+{
+    if (QWebEngineUrlScheme::schemeByName(PREVIEW_SCHEME).name().isEmpty())
+    {
+        QWebEngineUrlScheme scheme(PREVIEW_SCHEME);
+        scheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+        scheme.setFlags(QWebEngineUrlScheme::SecureScheme | QWebEngineUrlScheme::CorsEnabled);
+        QWebEngineUrlScheme::registerScheme(scheme);
+    }
+}
+
+BayesianAstroTileHandler::BayesianAstroTileHandler(const LivePreview* live, QObject* parent)
+    : QWebEngineUrlSchemeHandler(parent)
+    , m_live(live)
+{
+}
+
+void BayesianAstroTileHandler::requestStarted(QWebEngineUrlRequestJob* job)
+{
+    // Only in-memory planes are served: no path ever reaches the filesystem
+    const QUrl url = job->requestUrl();
+    const QStringList parts = url.path().split('/', Qt::SkipEmptyParts);
+    if (url.host() == PREVIEW_HISTOGRAM_HOST)
+    {
+        ServeHistogram(job, parts);
+        return;
+    }
+    const bool live = url.host() == PREVIEW_LIVE_HOST;
+    if ((!live && url.host() != PREVIEW_HOST) || parts.size() != 5 || !parts[4].endsWith(".png"))
+    {
+        job->fail(QWebEngineUrlRequestJob::UrlInvalid);
+        return;
+    }
+
+    bool ok[4];
+    const qulonglong generation = parts[0].toULongLong(&ok[0]);
+    const int level = parts[2].toInt(&ok[1]);
+    const qlonglong tileX = parts[3].toLongLong(&ok[2]);
+    const qlonglong tileY = parts[4].chopped(4).toLongLong(&ok[3]);
+    PreviewPlane plane;
+    if (!ok[0] || !ok[1] || !ok[2] || !ok[3] || !ParsePreviewPlane(parts[1].toStdString(), plane))
+    {
+        job->fail(QWebEngineUrlRequestJob::UrlInvalid);
+        return;
+    }
+
+    // Tiles of an earlier run are gone; the generation in the URL keeps browser caches honest
+    PreviewTiler* tiler = &m_tiler;
+    if (live)
+    {
+        // The snapshot being shown stays servable until the page moves on from it
+        if (m_liveSnapshot == nullptr || m_liveSnapshot->source.generation != generation)
+        {
+            std::shared_ptr<const LiveSnapshot> snapshot = m_live != nullptr ? m_live->Latest() : nullptr;
+            if (snapshot == nullptr || snapshot->source.generation != generation)
+            {
+                job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+                return;
+            }
+            m_liveSnapshot = snapshot;
+            m_liveTiler.SetSource(snapshot->source);
+        }
+        tiler = &m_liveTiler;
+    }
+    else
+    {
+        const PreviewSource& source = JuliaRuntime::Instance().Preview();
+        if (source.Empty() || generation != source.generation)
+        {
+            job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+            return;
+        }
+        if (m_tiler.Source().generation != source.generation)
+            m_tiler.SetSource(source);
+    }
+
+    std::string png, error;
+    if (!tiler->RenderTile(plane, level, tileX, tileY, png, error))
+    {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
+    QBuffer* buffer = new QBuffer(job);
+    buffer->setData(png.data(), int(png.size()));
+    buffer->open(QIODevice::ReadOnly);
+    job->reply("image/png", buffer);
+}
+
+void BayesianAstroTileHandler::ServeHistogram(QWebEngineUrlRequestJob* job, const QStringList& parts)
+{
+    bool ok = parts.size() == 2 && parts[1].endsWith(".bin");
+    const qulonglong generation = ok ? parts[0].toULongLong(&ok) : 0;
+    HistogramPlane plane;
+    if (!ok || !ParseHistogramPlane(parts[1].chopped(4).toStdString(), plane))
+    {
+        job->fail(QWebEngineUrlRequestJob::UrlInvalid);
+        return;
+    }
+
+    // Histograms belong to the result the preview shows, and go with it
+    const JuliaRuntime& runtime = JuliaRuntime::Instance();
+    const PlaneHistogram& histogram = runtime.Histogram(plane);
+    if (runtime.Preview().Empty() || generation != runtime.Preview().generation || histogram.Empty())
+    {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
+    std::string bytes;
+    histogram.Serialize(bytes);
+    QBuffer* buffer = new QBuffer(job);
+    buffer->setData(bytes.data(), int(bytes.size()));
+    buffer->open(QIODevice::ReadOnly);
+    job->reply("application/octet-stream", buffer);
+}
+
 // ============================================================================
 // BayesianAstroBridge Implementation
 // ============================================================================
@@ -27,6 +154,16 @@ BayesianAstroInterface* TheBayesianAstroInterface = nullptr;
 BayesianAstroBridge::BayesianAstroBridge(QObject* parent)
     : QObject(parent)
 {
+    // Engine threads only bump atomic counters; this timer turns them into one message
+    // per tick, so per-frame progress never floods the WebChannel IPC. The run executes
+    // on this thread, and ticks are delivered while the status monitor processes events
+    m_progressTimer.setInterval(PROGRESS_REFRESH_MS);
+    connect(&m_progressTimer, &QTimer::timeout, this, &BayesianAstroBridge::PublishProgress);
+    connect(&m_progressTimer, &QTimer::timeout, this, &BayesianAstroBridge::PublishLivePreview);
+
+    m_refinalizeTimer.setSingleShot(true);
+    m_refinalizeTimer.setInterval(REFINALIZE_DELAY_MS);
+    connect(&m_refinalizeTimer, &QTimer::timeout, this, &BayesianAstroBridge::RefinalizePreview);
 }
 
 int BayesianAstroBridge::fusionStrategy() const
@@ -40,6 +177,7 @@ void BayesianAstroBridge::setFusionStrategy(int value)
     {
         m_instance->SetFusionStrategy(value);
         emit fusionStrategyChanged();
+        m_refinalizeTimer.start();
     }
 }
 
@@ -107,6 +245,7 @@ void BayesianAstroBridge::addFiles(const QStringList& paths)
     {
         m_instance->AddInputFile(String(path.toUtf8().constData()));
     }
+    RefreshFrameStats();
     emit filesChanged();
 }
 
@@ -121,6 +260,7 @@ void BayesianAstroBridge::clearFiles()
     if (m_instance)
     {
         m_instance->ClearInputFiles();
+        RefreshFrameStats();
         emit filesChanged();
     }
 }
@@ -136,23 +276,159 @@ QStringList BayesianAstroBridge::getFiles() const
     return result;
 }
 
+void BayesianAstroBridge::RefreshFrameStats()
+{
+    std::vector<std::string> paths;
+    if (m_instance)
+    {
+        for (const String& s : m_instance->InputFiles())
+            paths.push_back(s.ToUTF8().c_str());
+    }
+    m_frameStats = LoadFrameCatalog(paths);
+}
+
+QVariantList BayesianAstroBridge::getFrameStats() const
+{
+    // Absent keywords and unmeasured metrics are NaN, which reaches JavaScript as null
+    QVariantList result;
+    for (size_t i = 0; i < m_frameStats.Size(); ++i)
+    {
+        QVariantMap frame;
+        frame["valid"] = m_frameStats.ok[i] != 0;
+        if (m_frameStats.ok[i])
+        {
+            frame["width"] = qlonglong(m_frameStats.naxis2[i]);
+            frame["height"] = qlonglong(m_frameStats.naxis1[i]);
+            frame["bitpix"] = m_frameStats.bitpix[i];
+            frame["fileSize"] = qulonglong(m_frameStats.fileSize[i]);
+            frame["fwhm"] = m_frameStats.fwhm[i];
+            frame["background"] = m_frameStats.background[i];
+            frame["noise"] = m_frameStats.noise[i];
+            frame["exposure"] = m_frameStats.exposure[i];
+            frame["gain"] = m_frameStats.gain[i];
+            frame["timestamp"] = m_frameStats.timestamp[i];
+            frame["filter"] = QString::fromUtf8(m_frameStats.filter[i].name);
+            frame["mean"] = m_frameStats.mean[i];
+            frame["sigma"] = m_frameStats.sigma[i];
+        }
+        else
+        {
+            frame["error"] = QString::fromUtf8(m_frameStats.errors[i].c_str());
+        }
+        result.append(frame);
+    }
+    return result;
+}
+
+QVariantList BayesianAstroBridge::getStagePlan() const
+{
+    // Every stage in order, and whether Execute would compute it or reuse its output
+    QVariantList result;
+    if (!m_instance)
+        return result;
+    const StagePlan plan = m_instance->PlannedStages();
+    for (int i = 0; i < int(PipelineStage::Count); ++i)
+    {
+        QVariantMap stage;
+        stage["stage"] = QString::fromUtf8(PipelineStageName(PipelineStage(i)));
+        stage["run"] = plan.Runs(PipelineStage(i));
+        result.append(stage);
+    }
+    return result;
+}
+
+QVariantMap BayesianAstroBridge::getPreviewInfo() const
+{
+    // Tile grid of the last run, or of the latest snapshot while one runs (the result is
+    // cleared when a run starts); tiles themselves come over the preview scheme
+    QVariantMap info;
+    PreviewTiler tiler;
+    tiler.SetSource(JuliaRuntime::Instance().Preview());
+    const std::shared_ptr<const LiveSnapshot> snapshot = tiler.Source().Empty() ? m_live.Latest() : nullptr;
+    if (snapshot != nullptr)
+        tiler.SetSource(snapshot->source);
+    const PreviewSource& source = tiler.Source();
+    info["available"] = !source.Empty();
+    if (source.Empty())
+        return info;
+
+    QStringList planes;
+    for (int i = 0; i < int(PreviewPlane::Count); ++i)
+    {
+        // Snapshots have no classification yet
+        if (snapshot == nullptr || PreviewPlane(i) != PreviewPlane::Classification)
+            planes.append(PreviewPlaneName(PreviewPlane(i)));
+    }
+    info["generation"] = qulonglong(source.generation);
+    info["width"] = qlonglong(source.naxis1);
+    info["height"] = qlonglong(source.naxis2);
+    info["tileSize"] = PREVIEW_TILE_SIZE;
+    info["levels"] = tiler.Levels();
+    info["planes"] = planes;
+    info["live"] = snapshot != nullptr;
+    if (snapshot != nullptr)
+    {
+        info["step"] = qlonglong(snapshot->step);
+        info["frames"] = qulonglong(snapshot->frames);
+        info["band"] = snapshot->band;
+        info["bands"] = snapshot->bands;
+    }
+    info["baseUrl"] = QString("%1://%2/%3")
+                          .arg(PREVIEW_SCHEME, snapshot != nullptr ? PREVIEW_LIVE_HOST : PREVIEW_HOST)
+                          .arg(qulonglong(source.generation));
+
+    // Histograms of the result's planes (snapshots have none), fetched like tiles
+    QStringList histograms;
+    if (snapshot == nullptr)
+        for (int i = 0; i < int(HistogramPlane::Count); ++i)
+            if (!JuliaRuntime::Instance().Histogram(HistogramPlane(i)).Empty())
+                histograms.append(HistogramPlaneName(HistogramPlane(i)));
+    info["histograms"] = histograms;
+    if (!histograms.isEmpty())
+        info["histogramUrl"] = QString("%1://%2/%3")
+                                   .arg(PREVIEW_SCHEME, PREVIEW_HISTOGRAM_HOST)
+                                   .arg(qulonglong(source.generation));
+    return info;
+}
+
 void BayesianAstroBridge::execute()
 {
     if (!m_instance) return;
 
+    bool success = false;
+    QString message;
+
+    m_instance->SetProgressAggregator(&m_progress);
+    m_instance->SetLivePreview(&m_live);
+    m_progressTimer.start();
     try
     {
-        bool success = m_instance->ExecuteGlobal();
-        emit executionComplete(success, success ? "Processing complete" : "Processing failed");
+        success = m_instance->ExecuteGlobal();
+
+        // The run has measured quality metrics for new frames
+        RefreshFrameStats();
+        emit filesChanged();
+
+        message = success ? "Processing complete" : "Processing failed";
     }
     catch (const Exception& e)
     {
-        emit executionComplete(false, QString::fromUtf8(e.Message().ToUTF8().c_str()));
+        message = QString::fromUtf8(e.Message().ToUTF8().c_str());
     }
     catch (...)
     {
-        emit executionComplete(false, "Unknown error occurred");
+        message = "Unknown error occurred";
     }
+    m_progressTimer.stop();
+    m_instance->SetProgressAggregator(nullptr);
+    m_instance->SetLivePreview(nullptr);
+
+    // The final state of the run, whatever the last tick saw
+    m_progress.EndRun();
+    PublishProgress();
+    emit previewChanged();
+
+    emit executionComplete(success, message);
 }
 
 void BayesianAstroBridge::setOutputDirectory(const QString& path)
@@ -169,7 +445,58 @@ void BayesianAstroBridge::setOutputPrefix(const QString& prefix)
 
 void BayesianAstroBridge::reportProgress(int percent, const QString& status)
 {
-    emit progressUpdated(percent, status);
+    m_progress.SetPercent(percent);
+    m_progress.SetStatus(status.toUtf8().constData());
+
+    // Outside a run there is no tick to coalesce into
+    if (!m_progressTimer.isActive())
+        PublishProgress();
+}
+
+void BayesianAstroBridge::PublishProgress()
+{
+    ProgressSnapshot snapshot;
+    if (!m_progress.Sample(snapshot))
+        return;
+
+    // NaN (no ETA yet) reaches JavaScript as null
+    QVariantMap status;
+    status["running"] = snapshot.running;
+    status["phase"] = QString::fromUtf8(RunPhaseName(snapshot.phase));
+    status["percent"] = snapshot.percent;
+    status["status"] = QString::fromUtf8(snapshot.status.c_str());
+    status["framesDone"] = qulonglong(snapshot.framesDone);
+    status["framesTotal"] = qulonglong(snapshot.framesTotal);
+    status["band"] = snapshot.band;
+    status["bands"] = snapshot.bands;
+    status["elapsedSeconds"] = snapshot.elapsedSeconds;
+    status["framesPerSecond"] = snapshot.framesPerSecond;
+    status["megabytesPerSecond"] = snapshot.megabytesPerSecond;
+    status["etaSeconds"] = snapshot.etaSeconds;
+    status["rssBytes"] = qulonglong(snapshot.rssBytes);
+    emit statusUpdated(status);
+}
+
+void BayesianAstroBridge::PublishLivePreview()
+{
+    const uint64_t generation = m_live.Generation();
+    if (generation == m_liveGeneration)
+        return;
+    m_liveGeneration = generation;
+    emit previewChanged();
+}
+
+void BayesianAstroBridge::RefinalizePreview()
+{
+    // A run in progress replaces the accumulators anyway
+    if (!m_instance || m_progressTimer.isActive())
+        return;
+
+    double seconds = 0.0;
+    if (!m_instance->RefinalizePreview(seconds))
+        return;
+    reportProgress(100, QString("Preview refinalized in %1 ms").arg(seconds * 1e3, 0, 'f', 0));
+    emit previewChanged();
 }
 
 // ============================================================================
@@ -296,6 +623,12 @@ void BayesianAstroInterface::InitializeWebView()
     m_webChannel->registerObject(QStringLiteral("bayesianAstro"), m_bridge);
     m_webView->page()->setWebChannel(m_webChannel);
 
+    // Preview tiles bypass the channel as binary PNG; the default profile is shared, so
+    // the handler is installed once and goes away with this view
+    QWebEngineProfile* profile = m_webView->page()->profile();
+    if (profile->urlSchemeHandler(PREVIEW_SCHEME) == nullptr)
+        profile->installUrlSchemeHandler(PREVIEW_SCHEME, new BayesianAstroTileHandler(m_bridge->Live(), m_webView));
+
     // Load React app from bundled assets
     QString uiPath = QCoreApplication::applicationDirPath() + "/share/BayesianAstro/ui/index.html";
 
@@ -319,6 +652,7 @@ void BayesianAstroInterface::SyncInstanceToUI()
         emit m_bridge->confidenceThresholdChanged();
         emit m_bridge->useGPUChanged();
         emit m_bridge->generateConfidenceMapChanged();
+        m_bridge->RefreshFrameStats();
         emit m_bridge->filesChanged();
     }
 }
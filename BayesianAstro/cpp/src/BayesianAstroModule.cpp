@@ -99,6 +99,9 @@ PCL_MODULE_EXPORT int InstallPixInsightModule(int mode)
             pcl::Console().WarningLn("** BayesianAstro: Julia initialization deferred");
         }
 
+        // Before any web view exists, as Qt WebEngine requires
+        pcl::RegisterPreviewScheme();
+
         new pcl::BayesianAstroProcess;
         new pcl::BayesianAstroInterface;
     }
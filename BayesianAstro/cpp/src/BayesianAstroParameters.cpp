@@ -17,6 +17,18 @@ BAUseGPU* TheBAUseGPUParameter = nullptr;
 BAGenerateConfidenceMap* TheBAGenerateConfidenceMapParameter = nullptr;
 BAOutputDirectory* TheBAOutputDirectoryParameter = nullptr;
 BAOutputPrefix* TheBAOutputPrefixParameter = nullptr;
+BAIngestBackend* TheBAIngestBackendParameter = nullptr;
+BAIngestCacheMode* TheBAIngestCacheModeParameter = nullptr;
+BAIngestPackedCache* TheBAIngestPackedCacheParameter = nullptr;
+BAFusedEncoding* TheBAFusedEncodingParameter = nullptr;
+BAConfidenceEncoding* TheBAConfidenceEncodingParameter = nullptr;
+BAClassificationEncoding* TheBAClassificationEncodingParameter = nullptr;
+BACompressOutput* TheBACompressOutputParameter = nullptr;
+BAMemoryBudget* TheBAMemoryBudgetParameter = nullptr;
+BAHugePages* TheBAHugePagesParameter = nullptr;
+BATraceTimeline* TheBATraceTimelineParameter = nullptr;
+BAHardwareCounters* TheBAHardwareCountersParameter = nullptr;
+BADeterministicReduction* TheBADeterministicReductionParameter = nullptr;
 
 // BAFusionStrategy
 
@@ -126,4 +138,226 @@ BAOutputPrefix::BAOutputPrefix(MetaProcess* p) : MetaString(p)
 IsoString BAOutputPrefix::Id() const { return "outputPrefix"; }
 String BAOutputPrefix::DefaultValue() const { return "bayesian"; }
 
+// BAIngestBackend
+
+BAIngestBackend::BAIngestBackend(MetaProcess* p) : MetaEnumeration(p)
+{
+    TheBAIngestBackendParameter = this;
+}
+
+IsoString BAIngestBackend::Id() const { return "ingestBackend"; }
+size_type BAIngestBackend::NumberOfElements() const { return NumberOfItems; }
+
+IsoString BAIngestBackend::ElementId(size_type i) const
+{
+    switch (i)
+    {
+    case Auto: return "Auto";
+    case IoUring: return "IoUring";
+    case ThreadPool: return "ThreadPool";
+    default: return "";
+    }
+}
+
+int BAIngestBackend::ElementValue(size_type i) const { return int(i); }
+size_type BAIngestBackend::DefaultValueIndex() const { return Default; }
+
+// BAIngestCacheMode
+
+BAIngestCacheMode::BAIngestCacheMode(MetaProcess* p) : MetaEnumeration(p)
+{
+    TheBAIngestCacheModeParameter = this;
+}
+
+IsoString BAIngestCacheMode::Id() const { return "ingestCacheMode"; }
+size_type BAIngestCacheMode::NumberOfElements() const { return NumberOfItems; }
+
+IsoString BAIngestCacheMode::ElementId(size_type i) const
+{
+    switch (i)
+    {
+    case Auto: return "Auto";
+    case Buffered: return "Buffered";
+    case DirectIO: return "DirectIO";
+    case DropBehind: return "DropBehind";
+    default: return "";
+    }
+}
+
+int BAIngestCacheMode::ElementValue(size_type i) const { return int(i); }
+size_type BAIngestCacheMode::DefaultValueIndex() const { return Default; }
+
+// BAIngestPackedCache
+
+BAIngestPackedCache::BAIngestPackedCache(MetaProcess* p) : MetaEnumeration(p)
+{
+    TheBAIngestPackedCacheParameter = this;
+}
+
+IsoString BAIngestPackedCache::Id() const { return "ingestPackedCache"; }
+size_type BAIngestPackedCache::NumberOfElements() const { return NumberOfItems; }
+
+IsoString BAIngestPackedCache::ElementId(size_type i) const
+{
+    switch (i)
+    {
+    case Off: return "Off";
+    case Float32: return "Float32";
+    case Float16: return "Float16";
+    default: return "";
+    }
+}
+
+int BAIngestPackedCache::ElementValue(size_type i) const { return int(i); }
+size_type BAIngestPackedCache::DefaultValueIndex() const { return Default; }
+
+// BAFusedEncoding
+
+BAFusedEncoding::BAFusedEncoding(MetaProcess* p) : MetaEnumeration(p)
+{
+    TheBAFusedEncodingParameter = this;
+}
+
+IsoString BAFusedEncoding::Id() const { return "fusedEncoding"; }
+size_type BAFusedEncoding::NumberOfElements() const { return NumberOfItems; }
+
+IsoString BAFusedEncoding::ElementId(size_type i) const
+{
+    switch (i)
+    {
+    case Float32: return "Float32";
+    case Float16: return "Float16";
+    case UInt16: return "UInt16";
+    default: return "";
+    }
+}
+
+int BAFusedEncoding::ElementValue(size_type i) const { return int(i); }
+size_type BAFusedEncoding::DefaultValueIndex() const { return Default; }
+
+// BAConfidenceEncoding
+
+BAConfidenceEncoding::BAConfidenceEncoding(MetaProcess* p) : MetaEnumeration(p)
+{
+    TheBAConfidenceEncodingParameter = this;
+}
+
+IsoString BAConfidenceEncoding::Id() const { return "confidenceEncoding"; }
+size_type BAConfidenceEncoding::NumberOfElements() const { return NumberOfItems; }
+
+IsoString BAConfidenceEncoding::ElementId(size_type i) const
+{
+    switch (i)
+    {
+    case Float32: return "Float32";
+    case Float16: return "Float16";
+    case UInt16: return "UInt16";
+    default: return "";
+    }
+}
+
+int BAConfidenceEncoding::ElementValue(size_type i) const { return int(i); }
+size_type BAConfidenceEncoding::DefaultValueIndex() const { return Default; }
+
+// BAClassificationEncoding
+
+BAClassificationEncoding::BAClassificationEncoding(MetaProcess* p) : MetaEnumeration(p)
+{
+    TheBAClassificationEncodingParameter = this;
+}
+
+IsoString BAClassificationEncoding::Id() const { return "classificationEncoding"; }
+size_type BAClassificationEncoding::NumberOfElements() const { return NumberOfItems; }
+
+IsoString BAClassificationEncoding::ElementId(size_type i) const
+{
+    switch (i)
+    {
+    case None: return "None";
+    case UInt8: return "UInt8";
+    case Packed4: return "Packed4";
+    default: return "";
+    }
+}
+
+int BAClassificationEncoding::ElementValue(size_type i) const { return int(i); }
+size_type BAClassificationEncoding::DefaultValueIndex() const { return Default; }
+
+// BACompressOutput
+
+BACompressOutput::BACompressOutput(MetaProcess* p) : MetaBoolean(p)
+{
+    TheBACompressOutputParameter = this;
+}
+
+IsoString BACompressOutput::Id() const { return "compressOutput"; }
+bool BACompressOutput::DefaultValue() const { return false; }
+
+// BAMemoryBudget
+
+BAMemoryBudget::BAMemoryBudget(MetaProcess* p) : MetaFloat(p)
+{
+    TheBAMemoryBudgetParameter = this;
+}
+
+IsoString BAMemoryBudget::Id() const { return "memoryBudget"; }
+int BAMemoryBudget::Precision() const { return 0; }
+double BAMemoryBudget::DefaultValue() const { return 0.0; }
+double BAMemoryBudget::MinimumValue() const { return 0.0; }
+double BAMemoryBudget::MaximumValue() const { return 16777216.0; }  // 16 TiB
+
+// BAHugePages
+
+BAHugePages::BAHugePages(MetaProcess* p) : MetaEnumeration(p)
+{
+    TheBAHugePagesParameter = this;
+}
+
+IsoString BAHugePages::Id() const { return "hugePages"; }
+size_type BAHugePages::NumberOfElements() const { return NumberOfItems; }
+
+IsoString BAHugePages::ElementId(size_type i) const
+{
+    switch (i)
+    {
+    case Off: return "Off";
+    case Transparent: return "Transparent";
+    case HugeTLB: return "HugeTLB";
+    default: return "";
+    }
+}
+
+int BAHugePages::ElementValue(size_type i) const { return int(i); }
+size_type BAHugePages::DefaultValueIndex() const { return Default; }
+
+// BATraceTimeline
+
+BATraceTimeline::BATraceTimeline(MetaProcess* p) : MetaBoolean(p)
+{
+    TheBATraceTimelineParameter = this;
+}
+
+IsoString BATraceTimeline::Id() const { return "traceTimeline"; }
+bool BATraceTimeline::DefaultValue() const { return false; }
+
+// BAHardwareCounters
+
+BAHardwareCounters::BAHardwareCounters(MetaProcess* p) : MetaBoolean(p)
+{
+    TheBAHardwareCountersParameter = this;
+}
+
+IsoString BAHardwareCounters::Id() const { return "hardwareCounters"; }
+bool BAHardwareCounters::DefaultValue() const { return false; }
+
+// BADeterministicReduction
+
+BADeterministicReduction::BADeterministicReduction(MetaProcess* p) : MetaBoolean(p)
+{
+    TheBADeterministicReductionParameter = this;
+}
+
+IsoString BADeterministicReduction::Id() const { return "deterministicReduction"; }
+bool BADeterministicReduction::DefaultValue() const { return false; }
+
 } // namespace pcl
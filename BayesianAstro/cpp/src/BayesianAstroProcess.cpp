@@ -25,6 +25,18 @@ BayesianAstroProcess::BayesianAstroProcess()
     new BAGenerateConfidenceMap(this);
     new BAOutputDirectory(this);
     new BAOutputPrefix(this);
+    new BAIngestBackend(this);
+    new BAIngestCacheMode(this);
+    new BAIngestPackedCache(this);
+    new BAFusedEncoding(this);
+    new BAConfidenceEncoding(this);
+    new BAClassificationEncoding(this);
+    new BACompressOutput(this);
+    new BAMemoryBudget(this);
+    new BAHugePages(this);
+    new BATraceTimeline(this);
+    new BAHardwareCounters(this);
+    new BADeterministicReduction(this);
 }
 
 IsoString BayesianAstroProcess::Id() const
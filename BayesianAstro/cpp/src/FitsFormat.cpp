@@ -0,0 +1,414 @@
+/**
+ * FITS Format Implementation
+ */
+
+#include "FitsFormat.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <unistd.h>
+
+namespace pcl
+{
+
+namespace
+{
+
+constexpr size_t CARD_SIZE = 80;
+constexpr size_t CARDS_PER_BLOCK = FITS_BLOCK_SIZE / CARD_SIZE;
+
+// Headers are read a few blocks at a time; most fit in the first read
+constexpr size_t HEADER_READ_BLOCKS = 4;
+
+// Upper bound on header size we are willing to scan (guards against non-FITS input)
+constexpr int MAX_HEADER_BLOCKS = 1024;
+
+int64_t DaysFromCivil(int64_t y, int64_t m, int64_t d)
+{
+    // Howard Hinnant's days_from_civil: days since 1970-01-01 in the proleptic Gregorian calendar
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const int64_t yoe = y - era * 400;
+    const int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+bool ParseDigits(const char* p, int count, int& value)
+{
+    value = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (p[i] < '0' || p[i] > '9')
+            return false;
+        value = value * 10 + (p[i] - '0');
+    }
+    return true;
+}
+
+ssize_t PreadFully(int fd, void* buffer, size_t length, off_t offset)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t r = pread(fd, static_cast<char*>(buffer) + done, length - done, offset + off_t(done));
+        if (r < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (r == 0)
+            break;
+        done += size_t(r);
+    }
+    return ssize_t(done);
+}
+
+template <typename T>
+T LoadBigEndian(const uint8_t* p)
+{
+    T v;
+    memcpy(&v, p, sizeof(T));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if constexpr (sizeof(T) == 2)
+    {
+        uint16_t u; memcpy(&u, &v, 2); u = __builtin_bswap16(u); memcpy(&v, &u, 2);
+    }
+    else if constexpr (sizeof(T) == 4)
+    {
+        uint32_t u; memcpy(&u, &v, 4); u = __builtin_bswap32(u); memcpy(&v, &u, 4);
+    }
+    else if constexpr (sizeof(T) == 8)
+    {
+        uint64_t u; memcpy(&u, &v, 8); u = __builtin_bswap64(u); memcpy(&v, &u, 8);
+    }
+#endif
+    return v;
+}
+
+template <typename T, typename Acc>
+void DecodeScaled(const uint8_t* raw, float* out, size_t count, Acc bzero, Acc bscale)
+{
+    if (bzero == Acc(0) && bscale == Acc(1))
+    {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = float(LoadBigEndian<T>(raw + i * sizeof(T)));
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = float(bzero + bscale * Acc(LoadBigEndian<T>(raw + i * sizeof(T))));
+    }
+}
+
+} // namespace
+
+bool FitsCard::KeyIs(const char* key) const
+{
+    size_t i = 0;
+    for (; key[i] != '\0'; ++i)
+        if (i >= 8 || data[i] != key[i])
+            return false;
+    for (; i < 8; ++i)
+        if (data[i] != ' ')
+            return false;
+    return true;
+}
+
+bool FitsCard::NumericValue(double& value) const
+{
+    if (!HasValue())
+        return false;
+
+    const char* begin = data + 10;
+    const char* end = data + CARD_SIZE;
+    for (const char* p = begin; p < end; ++p)
+        if (*p == '/')
+        {
+            end = p;
+            break;
+        }
+    return ParseFitsNumber(begin, end, value);
+}
+
+bool FitsCard::StringValue(char* out, size_t capacity) const
+{
+    if (!HasValue() || capacity == 0)
+        return false;
+
+    const char* p = data + 10;
+    const char* end = data + CARD_SIZE;
+    while (p < end && *p == ' ')
+        ++p;
+    if (p >= end || *p != '\'')
+        return false;
+    ++p;
+
+    size_t n = 0;
+    while (p < end)
+    {
+        if (*p == '\'')
+        {
+            if (p + 1 < end && p[1] == '\'')
+                ++p;        // Escaped quote
+            else
+                break;      // Closing quote
+        }
+        if (n + 1 < capacity)
+            out[n++] = *p;
+        ++p;
+    }
+
+    // Trailing blanks are not significant in FITS strings
+    while (n > 0 && out[n - 1] == ' ')
+        --n;
+    out[n] = '\0';
+    return true;
+}
+
+bool ParseFitsNumber(const char* begin, const char* end, double& value)
+{
+    const char* p = begin;
+    while (p < end && *p == ' ')
+        ++p;
+
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-'))
+        negative = (*p++ == '-');
+
+    double mantissa = 0.0;
+    int scale = 0;
+    int digits = 0;
+
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        mantissa = mantissa * 10.0 + (*p++ - '0');
+        ++digits;
+    }
+    if (p < end && *p == '.')
+    {
+        ++p;
+        while (p < end && *p >= '0' && *p <= '9')
+        {
+            mantissa = mantissa * 10.0 + (*p++ - '0');
+            --scale;
+            ++digits;
+        }
+    }
+    if (digits == 0)
+        return false;
+
+    if (p < end && (*p == 'E' || *p == 'e' || *p == 'D' || *p == 'd'))
+    {
+        const char* q = p + 1;
+        bool expNegative = false;
+        if (q < end && (*q == '+' || *q == '-'))
+            expNegative = (*q++ == '-');
+        int exponent = 0;
+        int expDigits = 0;
+        while (q < end && *q >= '0' && *q <= '9')
+        {
+            exponent = exponent * 10 + (*q++ - '0');
+            ++expDigits;
+        }
+        if (expDigits > 0)
+        {
+            scale += expNegative ? -exponent : exponent;
+            p = q;
+        }
+    }
+
+    // Only blanks may follow the number
+    for (; p < end; ++p)
+        if (*p != ' ')
+            return false;
+
+    value = mantissa;
+    if (scale != 0)
+        value *= pow(10.0, scale);
+    if (negative)
+        value = -value;
+    return true;
+}
+
+bool ParseFitsDate(const char* text, double& unixSeconds)
+{
+    while (*text == ' ')
+        ++text;
+    size_t length = strlen(text);
+
+    int year = 0, month = 0, day = 0;
+
+    if (length >= 10 && text[4] == '-' && text[7] == '-')
+    {
+        if (!ParseDigits(text, 4, year) || !ParseDigits(text + 5, 2, month) || !ParseDigits(text + 8, 2, day))
+            return false;
+
+        double seconds = 0.0;
+        if (length >= 19 && text[10] == 'T' && text[13] == ':' && text[16] == ':')
+        {
+            int hh = 0, mm = 0, ss = 0;
+            if (!ParseDigits(text + 11, 2, hh) || !ParseDigits(text + 14, 2, mm) || !ParseDigits(text + 17, 2, ss))
+                return false;
+            seconds = hh * 3600.0 + mm * 60.0 + ss;
+
+            // Fractional seconds, to millisecond precision like the Julia parser
+            if (length > 20 && text[19] == '.')
+            {
+                double scale = 0.1;
+                for (size_t i = 20; i < length && i < 23 && text[i] >= '0' && text[i] <= '9'; ++i)
+                {
+                    seconds += (text[i] - '0') * scale;
+                    scale *= 0.1;
+                }
+            }
+        }
+
+        unixSeconds = double(DaysFromCivil(year, month, day)) * 86400.0 + seconds;
+        return true;
+    }
+
+    if (length >= 8 && text[2] == '/' && text[5] == '/')
+    {
+        if (!ParseDigits(text, 2, day) || !ParseDigits(text + 3, 2, month) || !ParseDigits(text + 6, 2, year))
+            return false;
+        unixSeconds = double(DaysFromCivil(1900 + year, month, day)) * 86400.0;
+        return true;
+    }
+
+    return false;
+}
+
+bool ParseFitsHeader(int fd, FitsImageInfo& info, FitsCardVisitor* visitor, std::string& error)
+{
+    info = FitsImageInfo();
+
+    char buffer[HEADER_READ_BLOCKS * FITS_BLOCK_SIZE];
+
+    for (int b0 = 0; b0 < MAX_HEADER_BLOCKS; b0 += int(HEADER_READ_BLOCKS))
+    {
+        ssize_t r = PreadFully(fd, buffer, sizeof(buffer), off_t(b0) * off_t(FITS_BLOCK_SIZE));
+        int blocks = r < 0 ? 0 : int(size_t(r) / FITS_BLOCK_SIZE);
+        if (blocks == 0)
+        {
+            error = "Truncated FITS header";
+            return false;
+        }
+
+        for (int bi = 0; bi < blocks; ++bi)
+        {
+            const int b = b0 + bi;
+            const char* block = buffer + size_t(bi) * FITS_BLOCK_SIZE;
+
+            for (size_t c = 0; c < CARDS_PER_BLOCK; ++c)
+            {
+                FitsCard card;
+                card.data = block + c * CARD_SIZE;
+                double value = 0.0;
+
+                if (b == 0 && c == 0)
+                {
+                    if (!card.KeyIs("SIMPLE"))
+                    {
+                        error = "Not a FITS file (missing SIMPLE card)";
+                        return false;
+                    }
+                    continue;
+                }
+
+                if (card.KeyIs("END"))
+                {
+                    info.dataOffset = uint64_t(b + 1) * FITS_BLOCK_SIZE;
+
+                    if (info.naxis < 2 || info.naxis > 3)
+                    {
+                        error = "Unsupported FITS dimensionality: " + std::to_string(info.naxis);
+                        return false;
+                    }
+                    if (info.naxes[0] <= 0 || info.naxes[1] <= 0)
+                    {
+                        error = "Invalid FITS image dimensions";
+                        return false;
+                    }
+                    switch (info.bitpix)
+                    {
+                    case 8: case 16: case 32: case 64: case -32: case -64:
+                        return true;
+                    default:
+                        error = "Unsupported BITPIX: " + std::to_string(info.bitpix);
+                        return false;
+                    }
+                }
+
+                if (card.KeyIs("BITPIX") && card.NumericValue(value))
+                    info.bitpix = int(value);
+                else if (card.KeyIs("NAXIS") && card.NumericValue(value))
+                    info.naxis = int(value);
+                else if (card.KeyIs("NAXIS1") && card.NumericValue(value))
+                    info.naxes[0] = int64_t(value);
+                else if (card.KeyIs("NAXIS2") && card.NumericValue(value))
+                    info.naxes[1] = int64_t(value);
+                else if (card.KeyIs("NAXIS3") && card.NumericValue(value))
+                    info.naxes[2] = int64_t(value);
+                else if (card.KeyIs("BZERO") && card.NumericValue(value))
+                    info.bzero = value;
+                else if (card.KeyIs("BSCALE") && card.NumericValue(value))
+                    info.bscale = value;
+                else if (visitor != nullptr)
+                    visitor->Visit(card);
+            }
+        }
+
+        if (blocks < int(HEADER_READ_BLOCKS))
+        {
+            error = "Truncated FITS header";
+            return false;
+        }
+    }
+
+    error = "FITS header has no END card";
+    return false;
+}
+
+bool ReadFitsImageInfo(int fd, FitsImageInfo& info, std::string& error)
+{
+    return ParseFitsHeader(fd, info, nullptr, error);
+}
+
+void DecodeFitsSamples(const void* raw, float* out, size_t count,
+                       int bitpix, double bzero, double bscale)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(raw);
+    const float fzero = float(bzero);
+    const float fscale = float(bscale);
+
+    switch (bitpix)
+    {
+    case 8:
+        // BITPIX 8 is unsigned by definition
+        DecodeScaled<uint8_t, float>(p, out, count, fzero, fscale);
+        break;
+    case 16:
+        DecodeScaled<int16_t, float>(p, out, count, fzero, fscale);
+        break;
+    case 32:
+        DecodeScaled<int32_t, double>(p, out, count, bzero, bscale);
+        break;
+    case 64:
+        DecodeScaled<int64_t, double>(p, out, count, bzero, bscale);
+        break;
+    case -32:
+        DecodeScaled<float, float>(p, out, count, fzero, fscale);
+        break;
+    case -64:
+        DecodeScaled<double, double>(p, out, count, bzero, bscale);
+        break;
+    default:
+        memset(out, 0, count * sizeof(float));
+        break;
+    }
+}
+
+} // namespace pcl
@@ -0,0 +1,300 @@
+/**
+ * FITS Header Scanner Implementation
+ */
+
+#include "FitsHeaderScanner.h"
+#include "TraceTimeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pcl
+{
+
+namespace
+{
+
+// Files per work item; keeps the shared counter off the hot path for large lists
+constexpr size_t SCAN_CHUNK = 16;
+
+// Header reads are latency-bound, so oversubscribe the cores
+constexpr int SCAN_THREADS_PER_CORE = 4;
+constexpr int MAX_SCAN_THREADS = 64;
+
+constexpr float MISSING = std::numeric_limits<float>::quiet_NaN();
+
+double NowSeconds()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Collects metadata keywords for one file. Lower rank wins when several
+// synonyms are present, whatever their order in the header.
+class MetadataVisitor : public FitsCardVisitor
+{
+public:
+    float fwhm = MISSING;
+    float background = MISSING;
+    float noise = MISSING;
+    float exposure = MISSING;
+    float gain = MISSING;
+    double timestamp = std::numeric_limits<double>::quiet_NaN();
+    FitsFilterName filter;
+
+    void Visit(const FitsCard& card) override
+    {
+        double value = 0.0;
+
+        if (card.KeyIs("FWHM")) Numeric(card, fwhm, m_fwhmRank, 0);
+        else if (card.KeyIs("SEEING")) Numeric(card, fwhm, m_fwhmRank, 1);
+        else if (card.KeyIs("AVGFWHM")) Numeric(card, fwhm, m_fwhmRank, 2);
+        else if (card.KeyIs("BACKGRND")) Numeric(card, background, m_backgroundRank, 0);
+        else if (card.KeyIs("SKYLEVEL")) Numeric(card, background, m_backgroundRank, 1);
+        else if (card.KeyIs("PEDESTAL")) Numeric(card, background, m_backgroundRank, 2);
+        else if (card.KeyIs("NOISE")) Numeric(card, noise, m_noiseRank, 0);
+        else if (card.KeyIs("RDNOISE")) Numeric(card, noise, m_noiseRank, 1);
+        else if (card.KeyIs("READNOIS")) Numeric(card, noise, m_noiseRank, 2);
+        else if (card.KeyIs("EXPTIME")) Numeric(card, exposure, m_exposureRank, 0);
+        else if (card.KeyIs("EXPOSURE")) Numeric(card, exposure, m_exposureRank, 1);
+        else if (card.KeyIs("GAIN")) Numeric(card, gain, m_gainRank, 0);
+        else if (card.KeyIs("EGAIN")) Numeric(card, gain, m_gainRank, 1);
+        else if (card.KeyIs("FILTER"))
+        {
+            if (!card.StringValue(filter.name, sizeof(filter.name)))
+                filter.name[0] = '\0';
+        }
+        else if (card.KeyIs("DATE-OBS"))
+        {
+            char text[32];
+            if (m_timeRank > 0 && card.StringValue(text, sizeof(text)) && ParseFitsDate(text, value))
+            {
+                timestamp = value;
+                m_timeRank = 0;
+            }
+        }
+        else if ((card.KeyIs("JD") || card.KeyIs("JD-OBS")) && m_timeRank > 1 && card.NumericValue(value))
+        {
+            timestamp = (value - 2440587.5) * 86400.0;
+            m_timeRank = 1;
+        }
+        else if ((card.KeyIs("MJD-OBS") || card.KeyIs("MJD")) && m_timeRank > 2 && card.NumericValue(value))
+        {
+            timestamp = (value - 40587.0) * 86400.0;
+            m_timeRank = 2;
+        }
+    }
+
+private:
+    static void Numeric(const FitsCard& card, float& field, int& rank, int cardRank)
+    {
+        double value = 0.0;
+        if (cardRank < rank && card.NumericValue(value))
+        {
+            field = float(value);
+            rank = cardRank;
+        }
+    }
+
+    int m_fwhmRank = 99;
+    int m_backgroundRank = 99;
+    int m_noiseRank = 99;
+    int m_exposureRank = 99;
+    int m_gainRank = 99;
+    int m_timeRank = 99;
+};
+
+void ScanOne(const std::string& path, FrameHeaderTable& table, size_t row)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        table.errors[row] = "Cannot open " + path + ": " + strerror(errno);
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0)
+    {
+        table.fileSize[row] = uint64_t(st.st_size);
+        table.modified[row] = StatModifiedNanoseconds(st);
+    }
+
+    FitsImageInfo info;
+    MetadataVisitor visitor;
+    std::string error;
+    bool ok = ParseFitsHeader(fd, info, &visitor, error);
+    close(fd);
+
+    if (!ok)
+    {
+        table.errors[row] = path + ": " + error;
+        return;
+    }
+
+    table.ok[row] = 1;
+    table.bitpix[row] = info.bitpix;
+    table.naxis[row] = info.naxis;
+    table.naxis1[row] = info.naxes[0];
+    table.naxis2[row] = info.naxes[1];
+    table.naxis3[row] = info.naxes[2];
+    table.dataOffset[row] = info.dataOffset;
+    table.bzero[row] = info.bzero;
+    table.bscale[row] = info.bscale;
+
+    table.fwhm[row] = visitor.fwhm;
+    table.background[row] = visitor.background;
+    table.noise[row] = visitor.noise;
+    table.exposure[row] = visitor.exposure;
+    table.gain[row] = visitor.gain;
+    table.timestamp[row] = visitor.timestamp;
+    table.filter[row] = visitor.filter;
+}
+
+} // namespace
+
+void FrameHeaderTable::Resize(size_t rows)
+{
+    ok.assign(rows, 0);
+    bitpix.assign(rows, 0);
+    naxis.assign(rows, 0);
+    naxis1.assign(rows, 0);
+    naxis2.assign(rows, 0);
+    naxis3.assign(rows, 0);
+    dataOffset.assign(rows, 0);
+    bzero.assign(rows, 0.0);
+    bscale.assign(rows, 1.0);
+
+    fwhm.assign(rows, MISSING);
+    background.assign(rows, MISSING);
+    noise.assign(rows, MISSING);
+    exposure.assign(rows, MISSING);
+    gain.assign(rows, MISSING);
+    timestamp.assign(rows, std::numeric_limits<double>::quiet_NaN());
+    filter.assign(rows, FitsFilterName());
+
+    fileSize.assign(rows, 0);
+    modified.assign(rows, 0);
+    mean.assign(rows, MISSING);
+    sigma.assign(rows, MISSING);
+
+    errors.assign(rows, std::string());
+}
+
+FitsImageInfo FrameHeaderTable::ImageInfo(size_t row) const
+{
+    FitsImageInfo info;
+    info.bitpix = bitpix[row];
+    info.naxis = naxis[row];
+    info.naxes[0] = naxis1[row];
+    info.naxes[1] = naxis2[row];
+    info.naxes[2] = naxis3[row];
+    info.bzero = bzero[row];
+    info.bscale = bscale[row];
+    info.dataOffset = dataOffset[row];
+    return info;
+}
+
+size_t FrameHeaderTable::FirstFailure() const
+{
+    auto it = std::find(ok.begin(), ok.end(), uint8_t(0));
+    return size_t(it - ok.begin());
+}
+
+void FrameHeaderTable::CopyRow(size_t to, const FrameHeaderTable& other, size_t from)
+{
+    ok[to] = other.ok[from];
+    bitpix[to] = other.bitpix[from];
+    naxis[to] = other.naxis[from];
+    naxis1[to] = other.naxis1[from];
+    naxis2[to] = other.naxis2[from];
+    naxis3[to] = other.naxis3[from];
+    dataOffset[to] = other.dataOffset[from];
+    bzero[to] = other.bzero[from];
+    bscale[to] = other.bscale[from];
+
+    fwhm[to] = other.fwhm[from];
+    background[to] = other.background[from];
+    noise[to] = other.noise[from];
+    exposure[to] = other.exposure[from];
+    gain[to] = other.gain[from];
+    timestamp[to] = other.timestamp[from];
+    filter[to] = other.filter[from];
+
+    fileSize[to] = other.fileSize[from];
+    modified[to] = other.modified[from];
+    mean[to] = other.mean[from];
+    sigma[to] = other.sigma[from];
+
+    errors[to] = other.errors[from];
+}
+
+FrameHeaderTable ScanFitsHeaders(const std::vector<std::string>& paths, int threads)
+{
+    FrameHeaderTable table;
+    table.Resize(paths.size());
+
+    const double start = NowSeconds();
+
+    if (threads <= 0)
+        threads = std::min(MAX_SCAN_THREADS, int(std::max(1u, std::thread::hardware_concurrency())) * SCAN_THREADS_PER_CORE);
+    const size_t chunks = (paths.size() + SCAN_CHUNK - 1) / SCAN_CHUNK;
+    threads = int(std::min<size_t>(size_t(threads), chunks));
+
+    // Each row is written by exactly one worker, so the columns need no locking
+    std::atomic<size_t> nextChunk(0);
+    auto worker = [&]()
+    {
+        for (;;)
+        {
+            size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= chunks)
+                break;
+            size_t end = std::min(paths.size(), (chunk + 1) * SCAN_CHUNK);
+            TraceScope trace(TraceCategory::Scan, "scan headers", "frames", int64_t(end - chunk * SCAN_CHUNK));
+            for (size_t row = chunk * SCAN_CHUNK; row < end; ++row)
+                ScanOne(paths[row], table, row);
+        }
+    };
+
+    if (threads <= 1)
+    {
+        worker();
+    }
+    else
+    {
+        std::vector<std::thread> pool;
+        pool.reserve(size_t(threads));
+        for (int i = 0; i < threads; ++i)
+            pool.emplace_back([&worker]()
+            {
+                SetTraceThreadName("header scan");
+                worker();
+            });
+        for (std::thread& t : pool)
+            t.join();
+    }
+
+    table.seconds = NowSeconds() - start;
+    return table;
+}
+
+int64_t StatModifiedNanoseconds(const struct stat& st)
+{
+#if defined(__APPLE__)
+    return int64_t(st.st_mtimespec.tv_sec) * 1000000000 + int64_t(st.st_mtimespec.tv_nsec);
+#else
+    return int64_t(st.st_mtim.tv_sec) * 1000000000 + int64_t(st.st_mtim.tv_nsec);
+#endif
+}
+
+} // namespace pcl
@@ -0,0 +1,552 @@
+/**
+ * FITS Writer Implementation
+ */
+
+#include "FitsWriter.h"
+#include "FitsFormat.h"
+#include "TraceTimeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace pcl
+{
+
+namespace
+{
+
+constexpr size_t CARD_SIZE = 80;
+
+// Target uncompressed tile size; tiles are whole FITS rows (Julia columns)
+constexpr size_t TILE_TARGET_BYTES = 256 * 1024;
+
+// Speed over ratio: byte-shuffled planes already compress well at the fastest level
+constexpr int GZIP_LEVEL = 1;
+
+// UInt16 encoding reserves -32768 for NaN
+constexpr int16_t UINT16_BLANK = -32768;
+constexpr double UINT16_LEVELS = 65534.0;
+
+double NowSeconds()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+void StoreBigEndian16(uint8_t* p, uint16_t v)
+{
+    p[0] = uint8_t(v >> 8);
+    p[1] = uint8_t(v);
+}
+
+void StoreBigEndian32(uint8_t* p, uint32_t v)
+{
+    p[0] = uint8_t(v >> 24);
+    p[1] = uint8_t(v >> 16);
+    p[2] = uint8_t(v >> 8);
+    p[3] = uint8_t(v);
+}
+
+void StoreBigEndian64(uint8_t* p, uint64_t v)
+{
+    StoreBigEndian32(p, uint32_t(v >> 32));
+    StoreBigEndian32(p + 4, uint32_t(v));
+}
+
+class HeaderBuilder
+{
+public:
+    void Add(const FitsKeyword& k)
+    {
+        std::string card = k.name;
+        card.resize(8, ' ');
+        card += "= ";
+        // Fixed format: non-string values right-justified to column 30
+        if (!k.value.empty() && k.value[0] == '\'')
+            card += k.value;
+        else
+            card += std::string(k.value.size() < 20 ? 20 - k.value.size() : 0, ' ') + k.value;
+        if (!k.comment.empty())
+            card += " / " + k.comment;
+        card.resize(CARD_SIZE, ' ');
+        m_text += card;
+    }
+
+    void Add(const std::vector<FitsKeyword>& keywords)
+    {
+        for (const FitsKeyword& k : keywords)
+            Add(k);
+    }
+
+    std::string Finish()
+    {
+        std::string end = "END";
+        end.resize(CARD_SIZE, ' ');
+        m_text += end;
+        m_text.resize((m_text.size() + FITS_BLOCK_SIZE - 1) / FITS_BLOCK_SIZE * FITS_BLOCK_SIZE, ' ');
+        return m_text;
+    }
+
+private:
+    std::string m_text;
+};
+
+// Encodes whole FITS rows [r0, r1) of the plane into big-endian bytes
+struct PlaneLayout
+{
+    int bitpix = 0;
+    int64_t naxis1 = 0;             // FITS row length in samples
+    int64_t naxis2 = 0;
+    size_t bytesPerSample = 0;
+    std::vector<FitsKeyword> scaling;
+    std::function<void(int64_t r0, int64_t r1, uint8_t* out)> encode;
+
+    size_t RowBytes() const { return size_t(naxis1) * bytesPerSample; }
+};
+
+bool WriteAll(int fd, const void* data, size_t length)
+{
+    const char* p = static_cast<const char*>(data);
+    while (length > 0)
+    {
+        ssize_t w = write(fd, p, length);
+        if (w < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += w;
+        length -= size_t(w);
+    }
+    return true;
+}
+
+void ParallelFor(size_t count, int threads, const std::function<void(size_t)>& body)
+{
+    if (threads <= 0)
+        threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    threads = int(std::min<size_t>(size_t(threads), count));
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+            body(i);
+    };
+
+    if (threads <= 1)
+    {
+        worker();
+        return;
+    }
+
+    std::vector<std::thread> pool;
+    pool.reserve(size_t(threads));
+    for (int i = 0; i < threads; ++i)
+        pool.emplace_back([&worker]()
+        {
+            SetTraceThreadName("output worker");
+            worker();
+        });
+    for (std::thread& t : pool)
+        t.join();
+}
+
+// GZIP_2: group the bytes of each sample by significance before deflating
+void ShuffleBytes(const uint8_t* in, uint8_t* out, size_t samples, size_t width)
+{
+    for (size_t b = 0; b < width; ++b)
+        for (size_t i = 0; i < samples; ++i)
+            out[b * samples + i] = in[i * width + b];
+}
+
+bool GzipCompress(const uint8_t* in, size_t length, std::vector<uint8_t>& out)
+{
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    // windowBits 15 + 16 selects the gzip container expected by GZIP_1/GZIP_2
+    if (deflateInit2(&z, GZIP_LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+
+    out.resize(deflateBound(&z, uLong(length)) + 32);
+    z.next_in = const_cast<Bytef*>(in);
+    z.avail_in = uInt(length);
+    z.next_out = out.data();
+    z.avail_out = uInt(out.size());
+
+    int rc = deflate(&z, Z_FINISH);
+    out.resize(z.total_out);
+    deflateEnd(&z);
+    return rc == Z_STREAM_END;
+}
+
+bool WritePlane(const std::string& path, const PlaneLayout& layout, bool compress, int threads,
+                const std::vector<FitsKeyword>& keywords, std::string& error, uint64_t& fileBytes)
+{
+    TraceScope trace(TraceCategory::Write, "write plane", "bitpix", layout.bitpix);
+    const size_t rowBytes = layout.RowBytes();
+    const int64_t tileRows = std::max<int64_t>(1, std::min<int64_t>(layout.naxis2, int64_t(TILE_TARGET_BYTES / std::max<size_t>(rowBytes, 1))));
+    const size_t tileCount = size_t((layout.naxis2 + tileRows - 1) / tileRows);
+
+    std::string header;
+    std::vector<uint8_t> plain;
+    std::vector<std::vector<uint8_t>> tiles;
+
+    if (!compress)
+    {
+        HeaderBuilder h;
+        h.Add(FitsKeyword::Logical("SIMPLE", true, "conforms to FITS standard"));
+        h.Add(FitsKeyword::Integer("BITPIX", layout.bitpix));
+        h.Add(FitsKeyword::Integer("NAXIS", 2));
+        h.Add(FitsKeyword::Integer("NAXIS1", layout.naxis1));
+        h.Add(FitsKeyword::Integer("NAXIS2", layout.naxis2));
+        h.Add(layout.scaling);
+        h.Add(keywords);
+        header = h.Finish();
+
+        // Tiles here are just parallel encode ranges into one contiguous data unit
+        size_t dataBytes = rowBytes * size_t(layout.naxis2);
+        plain.resize((dataBytes + FITS_BLOCK_SIZE - 1) / FITS_BLOCK_SIZE * FITS_BLOCK_SIZE, 0);
+        ParallelFor(tileCount, threads, [&](size_t t)
+        {
+            TraceScope tileTrace(TraceCategory::Write, "encode tile", "tile", int64_t(t));
+            int64_t r0 = int64_t(t) * tileRows;
+            int64_t r1 = std::min(layout.naxis2, r0 + tileRows);
+            layout.encode(r0, r1, plain.data() + size_t(r0) * rowBytes);
+        });
+    }
+    else
+    {
+        tiles.resize(tileCount);
+        std::atomic<bool> failed(false);
+        ParallelFor(tileCount, threads, [&](size_t t)
+        {
+            TraceScope tileTrace(TraceCategory::Write, "compress tile", "tile", int64_t(t));
+            int64_t r0 = int64_t(t) * tileRows;
+            int64_t r1 = std::min(layout.naxis2, r0 + tileRows);
+            size_t bytes = size_t(r1 - r0) * rowBytes;
+            std::vector<uint8_t> raw(bytes);
+            layout.encode(r0, r1, raw.data());
+            if (layout.bytesPerSample > 1)
+            {
+                std::vector<uint8_t> shuffled(bytes);
+                ShuffleBytes(raw.data(), shuffled.data(), bytes / layout.bytesPerSample, layout.bytesPerSample);
+                raw.swap(shuffled);
+            }
+            if (!GzipCompress(raw.data(), bytes, tiles[t]))
+                failed = true;
+        });
+        if (failed)
+        {
+            error = "Compression failed";
+            return false;
+        }
+
+        size_t heapBytes = 0;
+        size_t maxTile = 0;
+        for (const auto& tile : tiles)
+        {
+            heapBytes += tile.size();
+            maxTile = std::max(maxTile, tile.size());
+        }
+
+        HeaderBuilder primary;
+        primary.Add(FitsKeyword::Logical("SIMPLE", true, "conforms to FITS standard"));
+        primary.Add(FitsKeyword::Integer("BITPIX", 8));
+        primary.Add(FitsKeyword::Integer("NAXIS", 0));
+        primary.Add(FitsKeyword::Logical("EXTEND", true));
+        header = primary.Finish();
+
+        HeaderBuilder h;
+        h.Add(FitsKeyword::String("XTENSION", "BINTABLE", "binary table extension"));
+        h.Add(FitsKeyword::Integer("BITPIX", 8));
+        h.Add(FitsKeyword::Integer("NAXIS", 2));
+        h.Add(FitsKeyword::Integer("NAXIS1", 16, "one 1QB descriptor per tile"));
+        h.Add(FitsKeyword::Integer("NAXIS2", int64_t(tileCount)));
+        h.Add(FitsKeyword::Integer("PCOUNT", int64_t(heapBytes)));
+        h.Add(FitsKeyword::Integer("GCOUNT", 1));
+        h.Add(FitsKeyword::Integer("TFIELDS", 1));
+        h.Add(FitsKeyword::String("TTYPE1", "COMPRESSED_DATA"));
+        h.Add(FitsKeyword::String("TFORM1", "1QB(" + std::to_string(maxTile) + ")"));
+        h.Add(FitsKeyword::Logical("ZIMAGE", true, "tile-compressed image"));
+        h.Add(FitsKeyword::Integer("ZBITPIX", layout.bitpix));
+        h.Add(FitsKeyword::Integer("ZNAXIS", 2));
+        h.Add(FitsKeyword::Integer("ZNAXIS1", layout.naxis1));
+        h.Add(FitsKeyword::Integer("ZNAXIS2", layout.naxis2));
+        h.Add(FitsKeyword::Integer("ZTILE1", layout.naxis1));
+        h.Add(FitsKeyword::Integer("ZTILE2", tileRows));
+        h.Add(FitsKeyword::String("ZCMPTYPE", layout.bytesPerSample > 1 ? "GZIP_2" : "GZIP_1"));
+        if (layout.bitpix < 0)
+            h.Add(FitsKeyword::String("ZQUANTIZ", "NONE", "lossless"));
+        h.Add(layout.scaling);
+        h.Add(keywords);
+        header += h.Finish();
+
+        // Descriptor table followed directly by the heap. 1QB descriptors hold 64-bit
+        // offsets, as the heap of a large plane can pass 4 GiB
+        size_t tableBytes = tileCount * 16;
+        plain.resize((tableBytes + heapBytes + FITS_BLOCK_SIZE - 1) / FITS_BLOCK_SIZE * FITS_BLOCK_SIZE, 0);
+        size_t offset = 0;
+        for (size_t t = 0; t < tileCount; ++t)
+        {
+            StoreBigEndian64(plain.data() + t * 16, tiles[t].size());
+            StoreBigEndian64(plain.data() + t * 16 + 8, offset);
+            memcpy(plain.data() + tableBytes + offset, tiles[t].data(), tiles[t].size());
+            offset += tiles[t].size();
+        }
+    }
+
+    TraceScope fileTrace(TraceCategory::Write, "write file", "bytes", int64_t(header.size() + plain.size()));
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        error = "Cannot create " + path + ": " + strerror(errno);
+        return false;
+    }
+    bool ok = WriteAll(fd, header.data(), header.size()) && WriteAll(fd, plain.data(), plain.size());
+    if (!ok)
+        error = "Write failed for " + path + ": " + strerror(errno);
+    if (close(fd) != 0 && ok)
+    {
+        error = "Write failed for " + path + ": " + strerror(errno);
+        ok = false;
+    }
+
+    fileBytes = header.size() + plain.size();
+    return ok;
+}
+
+void FiniteRange(const float* data, size_t count, double& low, double& high)
+{
+    float lo = std::numeric_limits<float>::infinity();
+    float hi = -std::numeric_limits<float>::infinity();
+    for (size_t i = 0; i < count; ++i)
+        if (std::isfinite(data[i]))
+        {
+            lo = std::min(lo, data[i]);
+            hi = std::max(hi, data[i]);
+        }
+    low = lo <= hi ? lo : 0.0;
+    high = lo <= hi ? hi : 0.0;
+}
+
+bool Finish(bool ok, double start, int64_t height, int64_t width, uint64_t fileBytes, PlaneWriteStats* stats)
+{
+    if (stats != nullptr)
+    {
+        stats->float32Bytes = uint64_t(height) * uint64_t(width) * 4;
+        stats->fileBytes = fileBytes;
+        stats->seconds = NowSeconds() - start;
+    }
+    return ok;
+}
+
+} // namespace
+
+FitsKeyword FitsKeyword::Logical(const std::string& name, bool value, const std::string& comment)
+{
+    return FitsKeyword{name, value ? "T" : "F", comment};
+}
+
+FitsKeyword FitsKeyword::Integer(const std::string& name, int64_t value, const std::string& comment)
+{
+    return FitsKeyword{name, std::to_string(value), comment};
+}
+
+FitsKeyword FitsKeyword::Real(const std::string& name, double value, const std::string& comment)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%.17G", value);
+    std::string s = text;
+    if (s.find_first_of(".E") == std::string::npos)
+        s += ".0";
+    return FitsKeyword{name, s, comment};
+}
+
+FitsKeyword FitsKeyword::String(const std::string& name, const std::string& value, const std::string& comment)
+{
+    std::string quoted = "'";
+    for (char c : value)
+    {
+        quoted += c;
+        if (c == '\'')
+            quoted += '\'';
+    }
+    // Fixed-format strings are at least 8 characters between the quotes
+    if (quoted.size() < 9)
+        quoted.resize(9, ' ');
+    quoted += '\'';
+    return FitsKeyword{name, quoted, comment};
+}
+
+float RoundToHalfPrecision(float x)
+{
+    if (!std::isfinite(x))
+        return x;
+    uint32_t bits;
+    memcpy(&bits, &x, 4);
+    // Round to nearest even on the 10 retained significand bits
+    bits = (bits + 0xFFFu + ((bits >> 13) & 1u)) & ~0x1FFFu;
+    float y;
+    memcpy(&y, &bits, 4);
+    return y;
+}
+
+bool WriteFitsPlane(const std::string& path, const float* data, int64_t height, int64_t width,
+                    const PlaneWriteOptions& options, const std::vector<FitsKeyword>& keywords,
+                    PlaneWriteStats* stats, std::string& error)
+{
+    const double start = NowSeconds();
+
+    PlaneLayout layout;
+    layout.naxis1 = height;
+    layout.naxis2 = width;
+    bool compress = options.compress;
+
+    switch (options.encoding)
+    {
+    case PlaneEncoding::Float32:
+    case PlaneEncoding::Float16:
+    {
+        const bool half = options.encoding == PlaneEncoding::Float16;
+        layout.bitpix = -32;
+        layout.bytesPerSample = 4;
+        if (half)
+        {
+            // Rounded significands only pay off once the zeroed low bytes are compressed away
+            compress = true;
+            layout.scaling.push_back(FitsKeyword::String("BAENCODE", "FLOAT16", "half-precision significand"));
+        }
+        layout.encode = [=](int64_t r0, int64_t r1, uint8_t* out)
+        {
+            const float* in = data + size_t(r0) * size_t(height);
+            size_t n = size_t(r1 - r0) * size_t(height);
+            for (size_t i = 0; i < n; ++i)
+            {
+                float v = half ? RoundToHalfPrecision(in[i]) : in[i];
+                uint32_t bits;
+                memcpy(&bits, &v, 4);
+                StoreBigEndian32(out + i * 4, bits);
+            }
+        };
+        break;
+    }
+    case PlaneEncoding::UInt16:
+    {
+        double low = options.low;
+        double high = options.high;
+        if (std::isnan(low) || std::isnan(high))
+            FiniteRange(data, size_t(height) * size_t(width), low, high);
+        const double scale = high > low ? (high - low) / UINT16_LEVELS : 1.0;
+        const double zero = low + 32767.0 * scale;
+
+        layout.bitpix = 16;
+        layout.bytesPerSample = 2;
+        layout.scaling.push_back(FitsKeyword::Real("BSCALE", scale));
+        layout.scaling.push_back(FitsKeyword::Real("BZERO", zero));
+        layout.scaling.push_back(FitsKeyword::Integer("BLANK", UINT16_BLANK, "NaN"));
+        layout.scaling.push_back(FitsKeyword::String("BAENCODE", "UINT16", "scaled 16-bit"));
+        layout.encode = [=](int64_t r0, int64_t r1, uint8_t* out)
+        {
+            const float* in = data + size_t(r0) * size_t(height);
+            size_t n = size_t(r1 - r0) * size_t(height);
+            const double inverse = 1.0 / scale;
+            for (size_t i = 0; i < n; ++i)
+            {
+                int16_t raw = UINT16_BLANK;
+                if (std::isfinite(in[i]))
+                {
+                    double level = std::round((double(in[i]) - low) * inverse);
+                    raw = int16_t(std::min(std::max(level, 0.0), UINT16_LEVELS) - 32767.0);
+                }
+                StoreBigEndian16(out + i * 2, uint16_t(raw));
+            }
+        };
+        break;
+    }
+    default:
+        error = "Class encodings require an 8-bit code plane";
+        return false;
+    }
+
+    uint64_t fileBytes = 0;
+    bool ok = WritePlane(path, layout, compress, options.threads, keywords, error, fileBytes);
+    return Finish(ok, start, height, width, fileBytes, stats);
+}
+
+bool WriteFitsPlane(const std::string& path, const uint8_t* data, int64_t height, int64_t width,
+                    const PlaneWriteOptions& options, const std::vector<FitsKeyword>& keywords,
+                    PlaneWriteStats* stats, std::string& error)
+{
+    const double start = NowSeconds();
+
+    PlaneLayout layout;
+    layout.bitpix = 8;
+    layout.bytesPerSample = 1;
+    layout.naxis2 = width;
+
+    switch (options.encoding)
+    {
+    case PlaneEncoding::UInt8:
+        layout.naxis1 = height;
+        layout.encode = [=](int64_t r0, int64_t r1, uint8_t* out)
+        {
+            memcpy(out, data + size_t(r0) * size_t(height), size_t(r1 - r0) * size_t(height));
+        };
+        break;
+
+    case PlaneEncoding::Packed4:
+    {
+        // A nibble holds codes 0..15; anything larger would be written as a different class
+        const size_t pixels = size_t(height) * size_t(width);
+        const uint8_t* wide = std::find_if(data, data + pixels, [](uint8_t code) { return code > 0x0F; });
+        if (wide != data + pixels)
+        {
+            error = "Packed4 encoding needs class codes below 16; pixel " + std::to_string(wide - data) +
+                    " has code " + std::to_string(*wide);
+            return false;
+        }
+
+        const int64_t packed = (height + 1) / 2;
+        layout.naxis1 = packed;
+        layout.scaling.push_back(FitsKeyword::String("BAENCODE", "PACKED4", "two 4-bit codes per byte"));
+        layout.scaling.push_back(FitsKeyword::Integer("BANAXIS1", height, "unpacked NAXIS1"));
+        layout.encode = [=](int64_t r0, int64_t r1, uint8_t* out)
+        {
+            for (int64_t r = r0; r < r1; ++r)
+            {
+                const uint8_t* in = data + size_t(r) * size_t(height);
+                uint8_t* row = out + size_t(r - r0) * size_t(packed);
+                for (int64_t i = 0; i < packed; ++i)
+                {
+                    uint8_t lo = in[2 * i];
+                    uint8_t hi = 2 * i + 1 < height ? in[2 * i + 1] : uint8_t(0);
+                    row[i] = uint8_t(lo | (hi << 4));
+                }
+            }
+        };
+        break;
+    }
+    default:
+        error = "Code planes support only UInt8 and Packed4 encodings";
+        return false;
+    }
+
+    uint64_t fileBytes = 0;
+    bool ok = WritePlane(path, layout, options.compress, options.threads, keywords, error, fileBytes);
+    return Finish(ok, start, height, width, fileBytes, stats);
+}
+
+} // namespace pcl
@@ -0,0 +1,382 @@
+/**
+ * Frame Catalog Implementation
+ */
+
+#include "FrameCatalog.h"
+#include "TraceTimeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pcl
+{
+
+namespace
+{
+
+// File layout: CatalogHeader, then per entry a uint16 name length, the name
+// bytes and a CatalogRecord. Native byte order: the catalog is a local cache,
+// and any header mismatch simply discards it.
+constexpr char CATALOG_MAGIC[8] = {'B', 'A', 'C', 'A', 'T', 'L', 'O', 'G'};
+constexpr uint32_t CATALOG_VERSION = 1;
+
+struct CatalogHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t count;
+};
+
+struct CatalogRecord
+{
+    uint64_t fileSize;
+    int64_t modified;
+    uint64_t dataOffset;
+    int64_t naxes[3];
+    double bzero;
+    double bscale;
+    double timestamp;
+    int32_t bitpix;
+    int32_t naxis;
+    float fwhm;
+    float background;
+    float noise;
+    float exposure;
+    float gain;
+    float mean;
+    float sigma;
+    char filter[FITS_FILTER_NAME_SIZE];
+};
+
+using CatalogEntries = std::unordered_map<std::string, CatalogRecord>;
+
+struct DirectoryCatalog
+{
+    CatalogEntries entries;
+    std::vector<size_t> rows;       // Rows of the current path list in this directory
+    bool dirty = false;
+};
+
+double NowSeconds()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+void SplitPath(const std::string& path, std::string& directory, std::string& name)
+{
+    size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos)
+    {
+        directory = ".";
+        name = path;
+    }
+    else
+    {
+        directory = slash == 0 ? "/" : path.substr(0, slash);
+        name = path.substr(slash + 1);
+    }
+}
+
+std::string CatalogPath(const std::string& directory)
+{
+    return directory + "/" + FRAME_CATALOG_FILE_NAME;
+}
+
+CatalogEntries ReadCatalog(const std::string& directory)
+{
+    CatalogEntries entries;
+
+    FILE* f = fopen(CatalogPath(directory).c_str(), "rb");
+    if (f == nullptr)
+        return entries;
+
+    CatalogHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1
+        || memcmp(header.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC)) != 0
+        || header.version != CATALOG_VERSION
+        || header.recordSize != sizeof(CatalogRecord))
+    {
+        fclose(f);
+        return entries;
+    }
+
+    entries.reserve(size_t(header.count));
+    std::string name;
+    for (uint64_t i = 0; i < header.count; ++i)
+    {
+        uint16_t length = 0;
+        CatalogRecord record;
+        if (fread(&length, sizeof(length), 1, f) != 1)
+            break;
+        name.resize(length);
+        if ((length > 0 && fread(&name[0], 1, length, f) != length)
+            || fread(&record, sizeof(record), 1, f) != 1)
+            break;
+        record.filter[FITS_FILTER_NAME_SIZE - 1] = '\0';
+        entries[name] = record;
+    }
+
+    fclose(f);
+    return entries;
+}
+
+bool WriteCatalog(const std::string& directory, const CatalogEntries& entries)
+{
+    // Write to a temporary and rename, so concurrent readers never see a torn catalog
+    std::string path = CatalogPath(directory);
+    std::string temp = path + ".tmp." + std::to_string(getpid());
+
+    FILE* f = fopen(temp.c_str(), "wb");
+    if (f == nullptr)
+        return false;
+
+    CatalogHeader header;
+    memcpy(header.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+    header.version = CATALOG_VERSION;
+    header.recordSize = sizeof(CatalogRecord);
+    header.count = entries.size();
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    for (const auto& entry : entries)
+    {
+        if (!ok)
+            break;
+        uint16_t length = uint16_t(entry.first.size());
+        ok = fwrite(&length, sizeof(length), 1, f) == 1
+          && fwrite(entry.first.data(), 1, length, f) == length
+          && fwrite(&entry.second, sizeof(CatalogRecord), 1, f) == 1;
+    }
+
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(temp.c_str(), path.c_str()) != 0)
+    {
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+CatalogRecord RecordFromRow(const FrameHeaderTable& table, size_t row)
+{
+    CatalogRecord record;
+    memset(&record, 0, sizeof(record));
+    record.fileSize = table.fileSize[row];
+    record.modified = table.modified[row];
+    record.dataOffset = table.dataOffset[row];
+    record.naxes[0] = table.naxis1[row];
+    record.naxes[1] = table.naxis2[row];
+    record.naxes[2] = table.naxis3[row];
+    record.bzero = table.bzero[row];
+    record.bscale = table.bscale[row];
+    record.timestamp = table.timestamp[row];
+    record.bitpix = table.bitpix[row];
+    record.naxis = table.naxis[row];
+    record.fwhm = table.fwhm[row];
+    record.background = table.background[row];
+    record.noise = table.noise[row];
+    record.exposure = table.exposure[row];
+    record.gain = table.gain[row];
+    record.mean = table.mean[row];
+    record.sigma = table.sigma[row];
+    memcpy(record.filter, table.filter[row].name, FITS_FILTER_NAME_SIZE);
+    return record;
+}
+
+void RowFromRecord(FrameHeaderTable& table, size_t row, const CatalogRecord& record)
+{
+    table.ok[row] = 1;
+    table.fileSize[row] = record.fileSize;
+    table.modified[row] = record.modified;
+    table.dataOffset[row] = record.dataOffset;
+    table.naxis1[row] = record.naxes[0];
+    table.naxis2[row] = record.naxes[1];
+    table.naxis3[row] = record.naxes[2];
+    table.bzero[row] = record.bzero;
+    table.bscale[row] = record.bscale;
+    table.timestamp[row] = record.timestamp;
+    table.bitpix[row] = record.bitpix;
+    table.naxis[row] = record.naxis;
+    table.fwhm[row] = record.fwhm;
+    table.background[row] = record.background;
+    table.noise[row] = record.noise;
+    table.exposure[row] = record.exposure;
+    table.gain[row] = record.gain;
+    table.mean[row] = record.mean;
+    table.sigma[row] = record.sigma;
+    memcpy(table.filter[row].name, record.filter, FITS_FILTER_NAME_SIZE);
+}
+
+// Drop entries for files that no longer exist or have changed since they were cataloged
+void PruneStale(const std::string& directory, CatalogEntries& entries)
+{
+    for (auto it = entries.begin(); it != entries.end(); )
+    {
+        uint64_t size = 0;
+        int64_t modified = 0;
+        if (!StatFile(directory + "/" + it->first, size, modified)
+            || size != it->second.fileSize || modified != it->second.modified)
+            it = entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+std::unordered_map<std::string, DirectoryCatalog> GroupByDirectory(const std::vector<std::string>& paths,
+                                                                   std::vector<std::string>& names)
+{
+    std::unordered_map<std::string, DirectoryCatalog> catalogs;
+    names.resize(paths.size());
+    std::string directory;
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        SplitPath(paths[i], directory, names[i]);
+        catalogs[directory].rows.push_back(i);
+    }
+    for (auto& catalog : catalogs)
+        catalog.second.entries = ReadCatalog(catalog.first);
+    return catalogs;
+}
+
+} // namespace
+
+bool StatFile(const std::string& path, uint64_t& size, int64_t& modified)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return false;
+    size = uint64_t(st.st_size);
+    modified = StatModifiedNanoseconds(st);
+    return true;
+}
+
+FrameHeaderTable LoadFrameCatalog(const std::vector<std::string>& paths, CatalogStats* stats, int threads)
+{
+    TraceScope trace(TraceCategory::Scan, "load catalog", "frames", int64_t(paths.size()));
+    const double start = NowSeconds();
+
+    FrameHeaderTable table;
+    table.Resize(paths.size());
+
+    std::vector<std::string> names;
+    auto catalogs = GroupByDirectory(paths, names);
+
+    std::vector<size_t> missRows;
+    std::vector<std::string> missPaths;
+    for (auto& catalog : catalogs)
+    {
+        for (size_t row : catalog.second.rows)
+        {
+            uint64_t size = 0;
+            int64_t modified = 0;
+            auto it = catalog.second.entries.find(names[row]);
+            if (it != catalog.second.entries.end()
+                && StatFile(paths[row], size, modified)
+                && size == it->second.fileSize && modified == it->second.modified)
+            {
+                RowFromRecord(table, row, it->second);
+            }
+            else
+            {
+                missRows.push_back(row);
+                missPaths.push_back(paths[row]);
+                catalog.second.dirty = true;
+            }
+        }
+    }
+
+    if (!missPaths.empty())
+    {
+        FrameHeaderTable scanned = ScanFitsHeaders(missPaths, threads);
+        for (size_t i = 0; i < missRows.size(); ++i)
+            table.CopyRow(missRows[i], scanned, i);
+
+        for (auto& catalog : catalogs)
+        {
+            if (!catalog.second.dirty)
+                continue;
+            PruneStale(catalog.first, catalog.second.entries);
+            for (size_t row : catalog.second.rows)
+                if (table.ok[row])
+                    catalog.second.entries[names[row]] = RecordFromRow(table, row);
+            WriteCatalog(catalog.first, catalog.second.entries);
+        }
+    }
+
+    table.seconds = NowSeconds() - start;
+    if (stats != nullptr)
+    {
+        stats->cached = paths.size() - missPaths.size();
+        stats->scanned = missPaths.size();
+        stats->seconds = table.seconds;
+    }
+    return table;
+}
+
+bool StoreFrameCatalog(const std::vector<std::string>& paths, const FrameHeaderTable& table)
+{
+    TraceScope trace(TraceCategory::Scan, "store catalog", "frames", int64_t(paths.size()));
+    if (table.Size() != paths.size())
+        return false;
+
+    std::vector<std::string> names;
+    auto catalogs = GroupByDirectory(paths, names);
+
+    bool ok = true;
+    for (auto& catalog : catalogs)
+    {
+        for (size_t row : catalog.second.rows)
+            if (table.ok[row])
+                catalog.second.entries[names[row]] = RecordFromRow(table, row);
+        ok = WriteCatalog(catalog.first, catalog.second.entries) && ok;
+    }
+    return ok;
+}
+
+void MeasureFrameQuality(const float* pixels, size_t count, float& mean, float& sigma)
+{
+    // Shifted two-accumulator form: exact enough for frame statistics, one pass, vectorizable
+    double shift = 0.0;
+    for (size_t i = 0; i < count; ++i)
+        if (std::isfinite(pixels[i]))
+        {
+            shift = pixels[i];
+            break;
+        }
+
+    double sum = 0.0;
+    double sumSq = 0.0;
+    size_t n = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        double x = double(pixels[i]) - shift;
+        if (std::isfinite(x))
+        {
+            sum += x;
+            sumSq += x * x;
+            ++n;
+        }
+    }
+
+    if (n == 0)
+    {
+        mean = sigma = std::numeric_limits<float>::quiet_NaN();
+        return;
+    }
+
+    double m = sum / double(n);
+    double variance = n > 1 ? (sumSq - sum * m) / double(n - 1) : 0.0;
+    mean = float(shift + m);
+    sigma = float(std::sqrt(std::max(variance, 0.0)));
+}
+
+} // namespace pcl
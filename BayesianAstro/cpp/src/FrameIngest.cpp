@@ -0,0 +1,641 @@
+/**
+ * Frame Ingest Implementation
+ */
+
+#include "FrameIngest.h"
+#include "TraceTimeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pcl
+{
+
+namespace
+{
+
+// Buffer, offset and length alignment; satisfies O_DIRECT on any logical block size up to 4 KiB
+constexpr size_t BUFFER_ALIGNMENT = 4096;
+
+double NowSeconds()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+size_t AlignUp(size_t n, size_t a)
+{
+    return (n + a - 1) / a * a;
+}
+
+uint64_t AlignDown(uint64_t n, uint64_t a)
+{
+    return n / a * a;
+}
+
+// Drop the first 'length' bytes of a file (0 = all) from the page cache. posix_fadvise
+// is missing on macOS, where drop-behind is a no-op
+void DropCachedPages(int fd, off_t length)
+{
+#if defined(POSIX_FADV_DONTNEED)
+    posix_fadvise(fd, 0, length, POSIX_FADV_DONTNEED);
+#else
+    (void)fd;
+    (void)length;
+#endif
+}
+
+const char* CacheModeName(IngestCacheMode mode)
+{
+    switch (mode)
+    {
+    case IngestCacheMode::DirectIO: return "direct";
+    case IngestCacheMode::DropBehind: return "drop-behind";
+    default: return "buffered";
+    }
+}
+
+uint8_t* AllocateAligned(size_t bytes)
+{
+    void* p = nullptr;
+    if (posix_memalign(&p, BUFFER_ALIGNMENT, AlignUp(bytes, BUFFER_ALIGNMENT)) != 0)
+        return nullptr;
+    return static_cast<uint8_t*>(p);
+}
+
+} // namespace
+
+FrameIngest::FrameIngest(const std::vector<std::string>& files, const IngestOptions& options,
+                         const FrameHeaderTable* headers, WorkspaceArena* workspace)
+    : m_files(files)
+    , m_options(options)
+    , m_headers(headers != nullptr && headers->Size() == files.size() ? headers : nullptr)
+    , m_workspace(workspace)
+{
+}
+
+FrameIngest::~FrameIngest()
+{
+    // Drain outstanding reads before their buffers are freed
+    if (m_backend)
+    {
+        while (m_backend->InFlight() > 0)
+        {
+            m_completions.clear();
+            m_backend->Reap(m_completions, size_t(m_backend->InFlight()));
+        }
+    }
+
+    for (Slot& slot : m_slots)
+    {
+        Release(slot);
+        if (m_workspace == nullptr)
+            free(slot.buffer);
+    }
+    UnmapPackedFrame(m_mapping);
+}
+
+bool FrameIngest::Open(std::string& error)
+{
+    TraceScope trace(TraceCategory::Io, "open ingest");
+    if (m_files.empty())
+    {
+        error = "No input files";
+        return false;
+    }
+
+    // Geometry comes from the first frame; every other frame is checked against it
+    int fd = m_headers != nullptr ? -1 : open(m_files[0].c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0 && m_headers == nullptr)
+    {
+        error = "Cannot open " + m_files[0] + ": " + strerror(errno);
+        return false;
+    }
+    FitsImageInfo info;
+    bool ok = ReadHeader(0, fd, info, error);
+    if (fd >= 0)
+        close(fd);
+    if (!ok)
+        return false;
+
+    m_height = info.Height();
+    m_width = info.Width();
+    m_firstColumn = std::max<int64_t>(0, m_options.firstColumn);
+    m_bandColumns = m_width - m_firstColumn;
+    if (m_options.columnCount > 0)
+        m_bandColumns = std::min(m_bandColumns, m_options.columnCount);
+    if (m_bandColumns <= 0)
+    {
+        error = "Column band starts past the last column (" + std::to_string(m_width) + ")";
+        return false;
+    }
+    m_pixelCount = size_t(m_height * m_bandColumns);
+    if (m_workspace != nullptr)
+        m_pixels = m_workspace->Acquire<float>(WorkspaceSlot::DecodedFrame, m_pixelCount);
+    else
+    {
+        m_ownedPixels.resize(m_pixelCount);
+        m_pixels = m_ownedPixels.data();
+    }
+    if (m_pixels == nullptr)
+    {
+        error = "Out of memory allocating the decode buffer";
+        return false;
+    }
+
+    m_options.queueDepth = std::max(1, m_options.queueDepth);
+    m_options.readAheadFrames = std::max(1, std::min(m_options.readAheadFrames, int(m_files.size())));
+    m_options.stripBytes = AlignUp(std::max<size_t>(m_options.stripBytes, BUFFER_ALIGNMENT), BUFFER_ALIGNMENT);
+
+    if (m_backend == nullptr)
+        m_backend = IngestBackend::Create(m_options.backend, m_options.queueDepth,
+                                          m_options.workerThreads, m_stats.note);
+
+    m_cacheMode = ResolveCacheMode();
+    m_stats.cacheMode = CacheModeName(m_cacheMode);
+
+    // Pooled, page-aligned frame buffers, registered with the backend when supported
+    m_slots.resize(size_t(m_options.readAheadFrames));
+    std::vector<std::pair<void*, size_t>> registrations;
+    for (Slot& slot : m_slots)
+    {
+        // Reads are block-aligned around the data unit, so allow one block of slack at each end
+        slot.capacity = AlignUp(size_t(BandBytes(info)), BUFFER_ALIGNMENT) + 2 * BUFFER_ALIGNMENT;
+        slot.buffer = AllocateSlotBuffer(slot, slot.capacity);
+        if (slot.buffer == nullptr)
+        {
+            error = "Out of memory allocating ingest buffers";
+            return false;
+        }
+        registrations.emplace_back(slot.buffer, slot.capacity);
+    }
+    if (m_backend->RegisterBuffers(registrations))
+    {
+        for (size_t i = 0; i < m_slots.size(); ++i)
+            m_slots[i].bufferIndex = int(i);
+    }
+
+    m_stats.backend = m_backend->Name();
+    m_startTime = NowSeconds();
+
+    for (size_t i = 0; i < m_slots.size(); ++i)
+        Fill(m_slots[i], i);
+
+    return Pump(false, error);
+}
+
+uint64_t FrameIngest::BandOffset(const FitsImageInfo& info) const
+{
+    return info.dataOffset + uint64_t(m_firstColumn * m_height) * info.BytesPerPixel();
+}
+
+uint64_t FrameIngest::BandBytes(const FitsImageInfo& info) const
+{
+    return uint64_t(m_bandColumns * m_height) * info.BytesPerPixel();
+}
+
+bool FrameIngest::ReadHeader(size_t frameIndex, int fd, FitsImageInfo& info, std::string& error) const
+{
+    if (m_headers != nullptr)
+    {
+        if (!m_headers->ok[frameIndex])
+        {
+            error = m_headers->errors[frameIndex];
+            return false;
+        }
+        info = m_headers->ImageInfo(frameIndex);
+        return true;
+    }
+
+    if (!ReadFitsImageInfo(fd, info, error))
+    {
+        error = m_files[frameIndex] + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+IngestCacheMode FrameIngest::ResolveCacheMode() const
+{
+    if (m_options.cacheMode != IngestCacheMode::Auto)
+        return m_options.cacheMode;
+
+    // Streaming more than a fraction of RAM through the page cache evicts everything else
+    uint64_t datasetBytes = 0;
+    if (m_headers != nullptr)
+    {
+        for (uint64_t size : m_headers->fileSize)
+            datasetBytes += size;
+    }
+    else
+    {
+        for (const std::string& path : m_files)
+        {
+            struct stat st;
+            if (stat(path.c_str(), &st) == 0)
+                datasetBytes += uint64_t(st.st_size);
+        }
+    }
+
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGE_SIZE);
+    if (pages <= 0 || pageSize <= 0)
+        return IngestCacheMode::Buffered;
+
+    double ramBytes = double(pages) * double(pageSize);
+    return double(datasetBytes) > m_options.directIORamFraction * ramBytes
+         ? IngestCacheMode::DirectIO
+         : IngestCacheMode::Buffered;
+}
+
+void FrameIngest::Fill(Slot& slot, size_t frameIndex)
+{
+    slot.active = frameIndex < m_files.size();
+    slot.frame = frameIndex;
+    slot.failed = false;
+    slot.error.clear();
+    slot.pendingReads = 0;
+
+    if (!slot.active)
+        return;
+
+    const std::string& path = m_files[frameIndex];
+
+    slot.direct = false;
+    slot.fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (slot.fd < 0)
+    {
+        slot.failed = true;
+        slot.error = "Cannot open " + path + ": " + strerror(errno);
+        return;
+    }
+
+    // Headers are small and unaligned, so they are always parsed through a buffered fd
+    if (!ReadHeader(frameIndex, slot.fd, slot.info, slot.error))
+    {
+        slot.failed = true;
+        return;
+    }
+
+    if (slot.info.Height() != m_height || slot.info.Width() != m_width)
+    {
+        slot.failed = true;
+        slot.error = "Frame " + std::to_string(frameIndex + 1) + " has different dimensions: ("
+                   + std::to_string(slot.info.Height()) + ", " + std::to_string(slot.info.Width())
+                   + ") vs (" + std::to_string(m_height) + ", " + std::to_string(m_width) + ")";
+        return;
+    }
+
+    if (m_options.packedCache != PackedCacheMode::Off)
+    {
+        // An entry made from this exact source (size and mtime) replaces the read entirely
+        struct stat st;
+        if (m_headers != nullptr)
+        {
+            slot.sourceSize = m_headers->fileSize[frameIndex];
+            slot.sourceModified = m_headers->modified[frameIndex];
+        }
+        else if (fstat(slot.fd, &st) == 0)
+        {
+            slot.sourceSize = uint64_t(st.st_size);
+            slot.sourceModified = StatModifiedNanoseconds(st);
+        }
+
+        slot.packedFd = OpenPackedFrame(path, m_options.packedCache, slot.sourceSize, slot.sourceModified,
+                                        m_height, m_width, slot.packed);
+        if (slot.packedFd >= 0)
+        {
+            close(slot.fd);
+            slot.fd = -1;
+            return;
+        }
+    }
+
+#ifdef O_DIRECT
+    if (m_cacheMode == IngestCacheMode::DirectIO && !m_directUnsupported)
+    {
+        int directFd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+        if (directFd >= 0)
+        {
+            DropCachedPages(slot.fd, off_t(slot.info.dataOffset));
+            close(slot.fd);
+            slot.fd = directFd;
+            slot.direct = true;
+        }
+        else
+        {
+            // e.g. tmpfs or some network filesystems: keep the page cache clean the other way
+            m_directUnsupported = true;
+            m_stats.cacheMode = CacheModeName(IngestCacheMode::DropBehind);
+            if (!m_stats.note.empty())
+                m_stats.note += "; ";
+            m_stats.note += std::string("O_DIRECT unavailable (") + strerror(errno) + "); using drop-behind";
+        }
+    }
+#endif
+
+    // Block-aligned read window around the band; reads past EOF are simply short
+    const uint64_t dataStart = BandOffset(slot.info);
+    uint64_t readStart = AlignDown(dataStart, BUFFER_ALIGNMENT);
+    slot.dataEnd = dataStart + BandBytes(slot.info);
+    slot.dataSkip = size_t(dataStart - readStart);
+    size_t bytes = AlignUp(size_t(slot.dataEnd - readStart), BUFFER_ALIGNMENT);
+
+    if (bytes > slot.capacity)
+    {
+        // Wider BITPIX than the first frame: grow this slot outside the registered pool
+        if (m_workspace == nullptr)
+            free(slot.buffer);
+        slot.capacity = bytes;
+        slot.buffer = AllocateSlotBuffer(slot, slot.capacity);
+        slot.bufferIndex = -1;
+        if (slot.buffer == nullptr)
+        {
+            slot.capacity = 0;
+            slot.failed = true;
+            slot.error = "Out of memory allocating ingest buffer";
+            return;
+        }
+    }
+
+    for (size_t offset = 0; offset < bytes; offset += m_options.stripBytes)
+    {
+        ReadRequest r;
+        r.fd = slot.fd;
+        r.offset = readStart + offset;
+        r.length = std::min(m_options.stripBytes, bytes - offset);
+        r.buffer = slot.buffer + offset;
+        r.bufferIndex = slot.bufferIndex;
+        r.tag = uint64_t(&slot - m_slots.data());
+        m_queued.push_back(r);
+        ++slot.pendingReads;
+    }
+}
+
+bool FrameIngest::Pump(bool wait, std::string& error)
+{
+    // Top up the queue with as many strips as the backend will take, as one batch
+    int room = m_backend->QueueDepth() - m_backend->InFlight();
+    if (room > 0 && !m_queued.empty())
+    {
+        m_batch.clear();
+        while (room-- > 0 && !m_queued.empty())
+        {
+            ReadRequest r = m_queued.front();
+            m_queued.pop_front();
+
+            // Tags carry a unique id; the owning slot is recovered from the in-flight table
+            uint64_t tag = m_nextTag++;
+            m_inFlight.emplace(tag, r);
+            r.tag = tag;
+            m_batch.push_back(r);
+        }
+
+        if (!m_backend->Submit(m_batch, error))
+            return false;
+
+        int depth = m_backend->InFlight();
+        m_depthSum += depth;
+        ++m_depthSamples;
+        m_stats.peakQueueDepth = std::max(m_stats.peakQueueDepth, depth);
+        m_stats.averageQueueDepth = m_depthSum / double(m_depthSamples);
+    }
+
+    if (m_backend->InFlight() == 0)
+        return true;
+
+    m_completions.clear();
+    m_backend->Reap(m_completions, wait ? 1 : 0);
+
+    for (const ReadCompletion& c : m_completions)
+    {
+        auto it = m_inFlight.find(c.tag);
+        if (it == m_inFlight.end())
+            continue;
+        ReadRequest r = it->second;
+        m_inFlight.erase(it);
+
+        Slot& slot = m_slots[size_t(r.tag)];
+        ++m_stats.reads;
+
+        if (c.result < 0)
+        {
+            slot.failed = true;
+            slot.error = m_files[slot.frame] + ": read failed: " + strerror(int(-c.result));
+            --slot.pendingReads;
+        }
+        else if (c.result == 0 && r.offset < slot.dataEnd)
+        {
+            slot.failed = true;
+            slot.error = m_files[slot.frame] + ": unexpected end of file";
+            --slot.pendingReads;
+        }
+        else
+        {
+            m_stats.bytesRead += uint64_t(c.result);
+            if (size_t(c.result) < r.length && r.offset + uint64_t(c.result) < slot.dataEnd)
+            {
+                // Short read: queue the remainder of the strip at the front. O_DIRECT needs the
+                // retry block-aligned, so it resumes at the last whole block and reads the overlap again
+                uint64_t advance = slot.direct ? AlignDown(uint64_t(c.result), BUFFER_ALIGNMENT)
+                                               : uint64_t(c.result);
+                struct stat st;
+                if (advance == 0 && (fstat(slot.fd, &st) != 0
+                                     || r.offset + uint64_t(c.result) >= uint64_t(st.st_size)))
+                {
+                    // A partial block that ends at EOF: the file is shorter than its header says
+                    slot.failed = true;
+                    slot.error = m_files[slot.frame] + ": unexpected end of file";
+                    --slot.pendingReads;
+                    continue;
+                }
+                r.offset += advance;
+                r.buffer = static_cast<uint8_t*>(r.buffer) + advance;
+                r.length -= size_t(advance);
+                m_queued.push_front(r);
+            }
+            else
+                --slot.pendingReads;
+        }
+    }
+
+    return true;
+}
+
+bool FrameIngest::Next(IngestFrame& frame, std::string& error)
+{
+    // The previous frame may still point into its cache entry
+    UnmapPackedFrame(m_mapping);
+
+    if (m_nextFrame >= m_files.size() || m_slots.empty())
+        return false;
+
+    Slot& slot = m_slots[m_nextFrame % m_slots.size()];
+
+    if (slot.pendingReads > 0)
+    {
+        TraceScope trace(TraceCategory::Io, "wait for reads", "frame", int64_t(m_nextFrame));
+        while (slot.pendingReads > 0)
+        {
+            if (!Pump(true, error))
+                return false;
+        }
+    }
+
+    if (slot.failed)
+    {
+        error = slot.error;
+        return false;
+    }
+
+    const float* pixels = m_pixels;
+    frame.packed = false;
+    if (slot.packedFd >= 0)
+    {
+        int fd = slot.packedFd;
+        slot.packedFd = -1;
+        std::string packedError;
+        TraceScope trace(TraceCategory::Cache, "packed frame", "frame", int64_t(slot.frame));
+        if (MapPackedFrame(fd, slot.packed, m_mapping, packedError))
+        {
+            // Float32 entries are consumed straight from the mapping
+            const size_t first = size_t(m_firstColumn * m_height);
+            if (slot.packed.encoding == uint32_t(PackedCacheMode::Float32))
+                pixels = static_cast<const float*>(m_mapping.payload) + first;
+            else
+                DecodePackedFrame(m_mapping, m_pixels, first, m_pixelCount);
+            frame.packed = true;
+            ++m_stats.packedHits;
+            ++m_stats.reads;
+            m_stats.bytesRead += slot.packed.PayloadBytes();
+        }
+        else
+        {
+            if (!m_stats.note.empty())
+                m_stats.note += "; ";
+            m_stats.note += "packed cache entry for " + m_files[slot.frame] + " discarded (" + packedError + ")";
+            if (!ReadSourceFrame(slot, error))
+                return false;
+            StorePacked(slot);
+        }
+    }
+    else
+    {
+        {
+            TraceScope trace(TraceCategory::Decode, "decode", "frame", int64_t(slot.frame));
+            DecodeFitsSamples(slot.buffer + slot.dataSkip, m_pixels, m_pixelCount,
+                              slot.info.bitpix, slot.info.bzero, slot.info.bscale);
+        }
+        StorePacked(slot);
+    }
+
+    frame.index = m_nextFrame;
+    frame.path = &m_files[m_nextFrame];
+    frame.pixels = pixels;
+    frame.height = m_height;
+    frame.width = m_bandColumns;
+    frame.firstColumn = m_firstColumn;
+
+    // The raw buffer is free again: start reading the frame one pool-length ahead
+    Release(slot);
+    Fill(slot, m_nextFrame + m_slots.size());
+    ++m_nextFrame;
+
+    if (!Pump(false, error))
+        return false;
+
+    m_stats.seconds = NowSeconds() - m_startTime;
+    return true;
+}
+
+void FrameIngest::Release(Slot& slot)
+{
+    if (slot.packedFd >= 0)
+    {
+        close(slot.packedFd);
+        slot.packedFd = -1;
+    }
+
+    if (slot.fd >= 0)
+    {
+        // Consumed frames are dropped from the page cache unless buffered reads were requested
+        if (!slot.direct && m_cacheMode != IngestCacheMode::Buffered)
+            DropCachedPages(slot.fd, 0);
+        close(slot.fd);
+        slot.fd = -1;
+    }
+}
+
+bool FrameIngest::ReadSourceFrame(Slot& slot, std::string& error)
+{
+    // Synchronous fallback for a damaged cache entry; rare enough not to need the queue
+    TraceScope trace(TraceCategory::Io, "read source frame", "frame", int64_t(slot.frame));
+    const std::string& path = m_files[slot.frame];
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        error = "Cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    std::vector<uint8_t> raw(size_t(BandBytes(slot.info)));
+    const uint64_t offset = BandOffset(slot.info);
+    size_t done = 0;
+    while (done < raw.size())
+    {
+        ssize_t r = pread(fd, raw.data() + done, raw.size() - done, off_t(offset + done));
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+        {
+            error = path + (r < 0 ? ": read failed: " + std::string(strerror(errno)) : ": unexpected end of file");
+            close(fd);
+            return false;
+        }
+        done += size_t(r);
+    }
+    close(fd);
+
+    m_stats.bytesRead += raw.size();
+    ++m_stats.reads;
+    DecodeFitsSamples(raw.data(), m_pixels, m_pixelCount,
+                      slot.info.bitpix, slot.info.bzero, slot.info.bscale);
+    return true;
+}
+
+void FrameIngest::StorePacked(const Slot& slot)
+{
+    // Entries hold whole frames, so banded passes only read them
+    if (m_options.packedCache == PackedCacheMode::Off || !m_packedWritable || IsBanded())
+        return;
+
+    TraceScope trace(TraceCategory::Cache, "store packed frame", "frame", int64_t(slot.frame));
+    std::string packedError;
+    if (WritePackedFrame(m_files[slot.frame], m_options.packedCache, slot.sourceSize, slot.sourceModified,
+                         m_pixels, m_height, m_width, packedError))
+    {
+        ++m_stats.packedWrites;
+        return;
+    }
+
+    // e.g. a read-only data directory: keep ingesting, stop trying to cache
+    m_packedWritable = false;
+    if (!m_stats.note.empty())
+        m_stats.note += "; ";
+    m_stats.note += "packed cache disabled: " + packedError;
+}
+
+uint8_t* FrameIngest::AllocateSlotBuffer(const Slot& slot, size_t bytes)
+{
+    if (m_workspace != nullptr)
+        return m_workspace->Acquire<uint8_t>(ReadBufferSlot(size_t(&slot - m_slots.data())), bytes);
+    return AllocateAligned(bytes);
+}
+
+} // namespace pcl
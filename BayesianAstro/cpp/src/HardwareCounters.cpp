@@ -0,0 +1,406 @@
+/**
+ * Hardware Counters Implementation
+ */
+
+#include "HardwareCounters.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#define BA_HAVE_PERF_EVENTS 1
+#endif
+
+namespace pcl
+{
+
+namespace
+{
+
+constexpr double NOT_AVAILABLE = std::numeric_limits<double>::quiet_NaN();
+
+double Ratio(const CounterValues& v, CounterEvent numerator, CounterEvent denominator)
+{
+    if (!v.Has(numerator) || !v.Has(denominator) || v[denominator] == 0)
+        return NOT_AVAILABLE;
+    return double(v[numerator]) / double(v[denominator]);
+}
+
+std::string ThreadName(int tid)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/comm", tid);
+    FILE* f = fopen(path, "r");
+    if (f == nullptr)
+        return std::string();
+    char name[64] = {};
+    if (fgets(name, sizeof(name), f) == nullptr)
+        name[0] = '\0';
+    fclose(f);
+    std::string text = name;
+    text.erase(text.find_last_not_of("\n") + 1);
+    return text;
+}
+
+bool ThreadAlive(int tid)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d", tid);
+    return access(path, F_OK) == 0;
+}
+
+std::vector<int> ProcessThreads()
+{
+    std::vector<int> tids;
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr)
+        return tids;
+    while (dirent* entry = readdir(dir))
+    {
+        int tid = atoi(entry->d_name);
+        if (tid > 0)
+            tids.push_back(tid);
+    }
+    closedir(dir);
+    return tids;
+}
+
+#ifdef BA_HAVE_PERF_EVENTS
+
+struct EventSpec
+{
+    uint32_t type;
+    uint64_t config;
+};
+
+// In CounterEvent order; the first (task clock, a software event) leads every group
+const EventSpec EVENT_SPECS[int(CounterEvent::Count)] = {
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES }
+};
+
+int OpenEvent(const EventSpec& spec, int tid, int groupFd)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = spec.type;
+    attr.config = spec.config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID
+                     | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // User space only: allowed unprivileged at perf_event_paranoid <= 2
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return int(syscall(__NR_perf_event_open, &attr, tid, -1, groupFd, PERF_FLAG_FD_CLOEXEC));
+}
+
+std::string Paranoid()
+{
+    FILE* f = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+    if (f == nullptr)
+        return "unknown";
+    int level = 0;
+    bool ok = fscanf(f, "%d", &level) == 1;
+    fclose(f);
+    return ok ? std::to_string(level) : "unknown";
+}
+
+std::string OpenFailure(int error)
+{
+    if (error == EACCES || error == EPERM)
+        return "not permitted (kernel.perf_event_paranoid = " + Paranoid() + ")";
+    if (error == ENOENT || error == EOPNOTSUPP || error == ENODEV)
+        return "not supported by this CPU or hypervisor";
+    if (error == ENOSYS)
+        return "perf_event_open unavailable in this kernel";
+    return strerror(error);
+}
+
+#endif
+
+} // namespace
+
+const char* CounterEventName(CounterEvent event)
+{
+    switch (event)
+    {
+    case CounterEvent::TaskClock: return "task_clock_ns";
+    case CounterEvent::Cycles: return "cycles";
+    case CounterEvent::Instructions: return "instructions";
+    case CounterEvent::CacheReferences: return "cache_references";
+    case CounterEvent::CacheMisses: return "cache_misses";
+    case CounterEvent::Branches: return "branches";
+    case CounterEvent::BranchMisses: return "branch_misses";
+    case CounterEvent::PageFaults: return "page_faults";
+    case CounterEvent::ContextSwitches: return "context_switches";
+    default: return "unknown";
+    }
+}
+
+void CounterValues::Add(const CounterValues& other)
+{
+    for (int i = 0; i < int(CounterEvent::Count); ++i)
+        values[i] += other.values[i];
+    available |= other.available;
+    multiplexed = multiplexed || other.multiplexed;
+}
+
+CounterValues CounterValues::Since(const CounterValues& earlier) const
+{
+    // Scaled (multiplexed) values are estimates and may step back slightly
+    CounterValues delta = *this;
+    for (int i = 0; i < int(CounterEvent::Count); ++i)
+        delta.values[i] = values[i] - std::min(values[i], earlier.values[i]);
+    return delta;
+}
+
+bool CounterValues::IsZero() const
+{
+    for (uint64_t v : values)
+        if (v != 0)
+            return false;
+    return true;
+}
+
+double CounterValues::InstructionsPerCycle() const
+{
+    return Ratio(*this, CounterEvent::Instructions, CounterEvent::Cycles);
+}
+
+double CounterValues::CacheMissRate() const
+{
+    return Ratio(*this, CounterEvent::CacheMisses, CounterEvent::CacheReferences);
+}
+
+double CounterValues::BranchMissRate() const
+{
+    return Ratio(*this, CounterEvent::BranchMisses, CounterEvent::Branches);
+}
+
+double CounterValues::MemoryBytes() const
+{
+    return Has(CounterEvent::CacheMisses) ? double((*this)[CounterEvent::CacheMisses]) * CACHE_LINE_BYTES
+                                          : NOT_AVAILABLE;
+}
+
+std::string CounterValues::ToJson() const
+{
+    std::string json = "{";
+    char text[96];
+    for (int i = 0; i < int(CounterEvent::Count); ++i)
+    {
+        if (!Has(CounterEvent(i)))
+            continue;
+        snprintf(text, sizeof(text), "%s\"%s\": %llu", json.size() > 1 ? ", " : "",
+                 CounterEventName(CounterEvent(i)), (unsigned long long)values[i]);
+        json += text;
+    }
+
+    const std::pair<const char*, double> derived[] = {
+        { "ipc", InstructionsPerCycle() },
+        { "cache_miss_rate", CacheMissRate() },
+        { "branch_miss_rate", BranchMissRate() },
+        { "memory_bytes", MemoryBytes() }
+    };
+    for (const auto& d : derived)
+    {
+        if (std::isnan(d.second))
+            continue;
+        snprintf(text, sizeof(text), "%s\"%s\": %.6g", json.size() > 1 ? ", " : "", d.first, d.second);
+        json += text;
+    }
+    if (multiplexed)
+        json += json.size() > 1 ? ", \"multiplexed\": true" : "\"multiplexed\": true";
+    json += "}";
+    return json;
+}
+
+CounterGroup::~CounterGroup()
+{
+    Close();
+}
+
+void CounterGroup::Close()
+{
+    // Members before the leader
+    for (size_t i = m_fds.size(); i-- > 0;)
+        close(m_fds[i]);
+    m_fds.clear();
+    m_ids.clear();
+    m_events.clear();
+    m_leader = -1;
+}
+
+bool CounterGroup::Open(int tid, std::string& error)
+{
+    Close();
+#ifdef BA_HAVE_PERF_EVENTS
+    std::string missing;
+    for (int i = 0; i < int(CounterEvent::Count); ++i)
+    {
+        int fd = OpenEvent(EVENT_SPECS[i], tid, m_leader);
+        if (fd < 0)
+        {
+            const std::string reason = OpenFailure(errno);
+            if (m_leader < 0)
+            {
+                error = "perf_event_open: " + reason;
+                return false;
+            }
+            // Reported once, after the list of missing events
+            if (missing.empty())
+                missing = reason;
+            continue;
+        }
+
+        uint64_t id = 0;
+        if (ioctl(fd, PERF_EVENT_IOC_ID, &id) != 0)
+        {
+            close(fd);
+            continue;
+        }
+        if (m_leader < 0)
+            m_leader = fd;
+        m_fds.push_back(fd);
+        m_ids.push_back(id);
+        m_events.push_back(CounterEvent(i));
+    }
+
+    if (!missing.empty())
+    {
+        error = "some events unavailable (";
+        for (int i = 0, n = 0; i < int(CounterEvent::Count); ++i)
+        {
+            if (std::find(m_events.begin(), m_events.end(), CounterEvent(i)) != m_events.end())
+                continue;
+            error += n++ > 0 ? ", " : "";
+            error += CounterEventName(CounterEvent(i));
+        }
+        error += "): " + missing;
+    }
+    return true;
+#else
+    (void)tid;
+    error = "hardware counters need Linux perf_event_open";
+    return false;
+#endif
+}
+
+bool CounterGroup::Read(CounterValues& values) const
+{
+    values = CounterValues();
+    if (m_leader < 0)
+        return false;
+
+    // { nr, time_enabled, time_running, { value, id } × nr }
+    uint64_t buffer[3 + 2 * int(CounterEvent::Count)];
+    ssize_t bytes = read(m_leader, buffer, sizeof(buffer));
+    if (bytes < ssize_t(3 * sizeof(uint64_t)))
+        return false;
+
+    const uint64_t count = std::min<uint64_t>(buffer[0], uint64_t(CounterEvent::Count));
+    const uint64_t enabled = buffer[1];
+    const uint64_t running = buffer[2];
+    const double scale = running > 0 && running < enabled ? double(enabled) / double(running) : 1.0;
+    values.multiplexed = scale != 1.0;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        const uint64_t value = buffer[3 + 2 * i];
+        const uint64_t id = buffer[4 + 2 * i];
+        auto it = std::find(m_ids.begin(), m_ids.end(), id);
+        if (it == m_ids.end())
+            continue;
+        const CounterEvent event = m_events[size_t(it - m_ids.begin())];
+        values.values[int(event)] = uint64_t(double(value) * scale);
+        values.available |= 1u << int(event);
+    }
+    return true;
+}
+
+bool ProcessCounters::Open()
+{
+    m_groups.clear();
+    m_note.clear();
+    m_failed = false;
+    Refresh();
+    return IsOpen();
+}
+
+void ProcessCounters::Refresh()
+{
+    if (m_failed)
+        return;
+
+    const std::vector<int> tids = ProcessThreads();
+
+    // Exited threads keep their final counts and give back their descriptors
+    for (Thread& thread : m_groups)
+    {
+        if (thread.group->IsOpen() && std::find(tids.begin(), tids.end(), thread.tid) == tids.end())
+        {
+            thread.group->Read(thread.final);
+            thread.group->Close();
+        }
+    }
+
+    for (int tid : tids)
+    {
+        if (std::any_of(m_groups.begin(), m_groups.end(),
+                        [tid](const Thread& t) { return t.tid == tid && t.group->IsOpen(); }))
+            continue;
+
+        Thread thread;
+        thread.tid = tid;
+        thread.name = ThreadName(tid);
+        thread.group = std::make_unique<CounterGroup>();
+        std::string note;
+        if (!thread.group->Open(tid, note))
+        {
+            // A thread that exited meanwhile is skipped; anything else disables sampling
+            if (!ThreadAlive(tid))
+                continue;
+            m_note = note;
+            m_failed = m_groups.empty();
+            if (m_failed)
+                return;
+            continue;
+        }
+        if (m_note.empty())
+            m_note = note;
+        m_groups.push_back(std::move(thread));
+    }
+}
+
+void ProcessCounters::Sample(std::vector<ThreadCounters>& threads) const
+{
+    threads.resize(m_groups.size());
+    for (size_t i = 0; i < m_groups.size(); ++i)
+    {
+        threads[i].tid = m_groups[i].tid;
+        threads[i].name = m_groups[i].name;
+        if (m_groups[i].group->IsOpen())
+            m_groups[i].group->Read(threads[i].values);
+        else
+            threads[i].values = m_groups[i].final;
+    }
+}
+
+} // namespace pcl
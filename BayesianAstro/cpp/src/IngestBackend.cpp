@@ -0,0 +1,457 @@
+/**
+ * Ingest Backend Implementation
+ *
+ * io_uring is driven through raw syscalls so no liburing dependency is needed.
+ */
+
+#include "IngestBackend.h"
+#include "TraceTimeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+// Headers from before 5.6 have neither IORING_OP_READ nor the opcode probe
+#ifdef IO_URING_OP_SUPPORTED
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define BA_HAVE_IO_URING 1
+#endif
+#endif
+
+namespace pcl
+{
+
+// ============================================================================
+// pread thread pool backend
+// ============================================================================
+
+class PreadPoolBackend : public IngestBackend
+{
+public:
+    PreadPoolBackend(int queueDepth, int workerThreads)
+        : m_queueDepth(queueDepth)
+    {
+        int n = workerThreads > 0 ? workerThreads : int(std::thread::hardware_concurrency());
+        n = std::max(1, std::min(n, queueDepth));
+        for (int i = 0; i < n; ++i)
+            m_workers.emplace_back([this] { WorkerLoop(); });
+    }
+
+    ~PreadPoolBackend() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_requestReady.notify_all();
+        for (std::thread& t : m_workers)
+            t.join();
+    }
+
+    const char* Name() const override { return "pread"; }
+    int QueueDepth() const override { return m_queueDepth; }
+    int InFlight() const override { return m_inFlight.load(std::memory_order_relaxed); }
+
+    bool Submit(const std::vector<ReadRequest>& batch, std::string&) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const ReadRequest& r : batch)
+                m_requests.push_back(r);
+            m_inFlight.fetch_add(int(batch.size()), std::memory_order_relaxed);
+        }
+        m_requestReady.notify_all();
+        return true;
+    }
+
+    size_t Reap(std::vector<ReadCompletion>& out, size_t minCount) override
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        size_t needed = std::min(minCount, size_t(std::max(0, m_inFlight.load(std::memory_order_relaxed))));
+        m_completionReady.wait(lock, [&] { return m_completions.size() >= needed; });
+
+        size_t n = m_completions.size();
+        out.insert(out.end(), m_completions.begin(), m_completions.end());
+        m_completions.clear();
+        m_inFlight.fetch_sub(int(n), std::memory_order_relaxed);
+        return n;
+    }
+
+private:
+    void WorkerLoop()
+    {
+        SetTraceThreadName("pread worker");
+        for (;;)
+        {
+            ReadRequest r;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_requestReady.wait(lock, [&] { return m_stopping || !m_requests.empty(); });
+                if (m_stopping && m_requests.empty())
+                    return;
+                r = m_requests.front();
+                m_requests.pop_front();
+            }
+
+            TraceScope trace(TraceCategory::Io, "pread", "bytes", int64_t(r.length));
+            ReadCompletion c;
+            c.tag = r.tag;
+            size_t done = 0;
+            while (done < r.length)
+            {
+                ssize_t n = pread(r.fd, static_cast<char*>(r.buffer) + done, r.length - done,
+                                  off_t(r.offset + done));
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    c.result = -errno;
+                    break;
+                }
+                if (n == 0)
+                    break;
+                done += size_t(n);
+            }
+            if (c.result == 0)
+                c.result = int64_t(done);
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_completions.push_back(c);
+            }
+            m_completionReady.notify_one();
+        }
+    }
+
+    int m_queueDepth;
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_requestReady;
+    std::condition_variable m_completionReady;
+    std::deque<ReadRequest> m_requests;
+    std::vector<ReadCompletion> m_completions;
+    std::atomic<int> m_inFlight{0};
+    bool m_stopping = false;
+};
+
+// ============================================================================
+// io_uring backend
+// ============================================================================
+
+#ifdef BA_HAVE_IO_URING
+
+class IoUringBackend : public IngestBackend
+{
+public:
+    ~IoUringBackend() override
+    {
+        if (m_sqes != nullptr)
+            munmap(m_sqes, m_sqesSize);
+        if (m_cqRing != nullptr && m_cqRing != m_sqRing)
+            munmap(m_cqRing, m_cqRingSize);
+        if (m_sqRing != nullptr)
+            munmap(m_sqRing, m_sqRingSize);
+        if (m_ringFd >= 0)
+            close(m_ringFd);
+    }
+
+    bool Setup(int queueDepth, std::string& error)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+
+        m_ringFd = int(syscall(__NR_io_uring_setup, unsigned(queueDepth), &params));
+        if (m_ringFd < 0)
+        {
+            error = std::string("io_uring_setup failed: ") + strerror(errno);
+            return false;
+        }
+
+        m_queueDepth = int(std::min(params.sq_entries, params.cq_entries));
+
+        m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap)
+            m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+
+        m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        m_ringFd, IORING_OFF_SQ_RING);
+        if (m_sqRing == MAP_FAILED)
+        {
+            m_sqRing = nullptr;
+            error = "io_uring SQ ring mmap failed";
+            return false;
+        }
+
+        if (singleMmap)
+            m_cqRing = m_sqRing;
+        else
+        {
+            m_cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            m_ringFd, IORING_OFF_CQ_RING);
+            if (m_cqRing == MAP_FAILED)
+            {
+                m_cqRing = nullptr;
+                error = "io_uring CQ ring mmap failed";
+                return false;
+            }
+        }
+
+        m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe*>(mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE,
+                                                 MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES));
+        if (m_sqes == MAP_FAILED)
+        {
+            m_sqes = nullptr;
+            error = "io_uring SQE mmap failed";
+            return false;
+        }
+
+        char* sq = static_cast<char*>(m_sqRing);
+        m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        m_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        char* cq = static_cast<char*>(m_cqRing);
+        m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        m_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // Kernels 5.1-5.5 set up a ring but reject IORING_OP_READ with EINVAL at the first
+        // read; they have no opcode probe either, so a failed probe means no plain reads
+        bool read = false;
+        if (!ProbeOpcodes(read, m_readFixed) || !read)
+        {
+            error = "io_uring lacks IORING_OP_READ (kernel older than 5.6)";
+            return false;
+        }
+
+        return true;
+    }
+
+    const char* Name() const override { return m_fixedBuffers ? "io_uring (registered buffers)" : "io_uring"; }
+    int QueueDepth() const override { return m_queueDepth; }
+    int InFlight() const override { return m_inFlight; }
+
+    bool RegisterBuffers(const std::vector<std::pair<void*, size_t>>& buffers) override
+    {
+        if (!m_readFixed)
+            return false;
+
+        std::vector<iovec> iov(buffers.size());
+        for (size_t i = 0; i < buffers.size(); ++i)
+        {
+            iov[i].iov_base = buffers[i].first;
+            iov[i].iov_len = buffers[i].second;
+        }
+
+        // Fails under a low RLIMIT_MEMLOCK on older kernels; plain reads are used then
+        int r = int(syscall(__NR_io_uring_register, m_ringFd, IORING_REGISTER_BUFFERS,
+                            iov.data(), unsigned(iov.size())));
+        m_fixedBuffers = (r == 0);
+        return m_fixedBuffers;
+    }
+
+    bool Submit(const std::vector<ReadRequest>& batch, std::string& error) override
+    {
+        if (batch.empty())
+            return true;
+
+        TraceScope trace(TraceCategory::Io, "io_uring submit", "reads", int64_t(batch.size()));
+        unsigned tail = *m_sqTail;
+        for (const ReadRequest& r : batch)
+        {
+            unsigned index = tail & m_sqMask;
+            io_uring_sqe* sqe = &m_sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+
+            if (m_fixedBuffers && r.bufferIndex >= 0)
+            {
+                sqe->opcode = IORING_OP_READ_FIXED;
+                sqe->buf_index = uint16_t(r.bufferIndex);
+            }
+            else
+                sqe->opcode = IORING_OP_READ;
+
+            sqe->fd = r.fd;
+            sqe->off = r.offset;
+            sqe->addr = reinterpret_cast<uint64_t>(r.buffer);
+            sqe->len = uint32_t(r.length);
+            sqe->user_data = r.tag;
+
+            m_sqArray[index] = index;
+            ++tail;
+        }
+        __atomic_store_n(m_sqTail, tail, __ATOMIC_RELEASE);
+
+        unsigned toSubmit = unsigned(batch.size());
+        while (toSubmit > 0)
+        {
+            int n = int(syscall(__NR_io_uring_enter, m_ringFd, toSubmit, 0u, 0u, nullptr, 0));
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                // The completion queue is full: park its entries for Reap, then submit again
+                if (errno == EBUSY || errno == EAGAIN)
+                {
+                    if (MakeCompletionRoom(error))
+                        continue;
+                    return false;
+                }
+                error = std::string("io_uring_enter failed: ") + strerror(errno);
+                return false;
+            }
+            toSubmit -= unsigned(n);
+            m_inFlight += n;
+        }
+        return true;
+    }
+
+    size_t Reap(std::vector<ReadCompletion>& out, size_t minCount) override
+    {
+        size_t reaped = m_pending.size();
+        out.insert(out.end(), m_pending.begin(), m_pending.end());
+        m_pending.clear();
+        for (;;)
+        {
+            reaped += DrainCompletions(out);
+
+            if (reaped >= minCount || m_inFlight - int(reaped) <= 0)
+                break;
+
+            unsigned wanted = unsigned(minCount - reaped);
+            int r = int(syscall(__NR_io_uring_enter, m_ringFd, 0u, wanted, unsigned(IORING_ENTER_GETEVENTS),
+                                nullptr, 0));
+            if (r < 0 && errno != EINTR)
+                break;
+        }
+        m_inFlight -= int(reaped);
+        return reaped;
+    }
+
+private:
+    // Move every posted completion to `out` and free its completion queue slot
+    size_t DrainCompletions(std::vector<ReadCompletion>& out)
+    {
+        size_t drained = 0;
+        unsigned head = *m_cqHead;
+        unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail)
+        {
+            const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+            ReadCompletion c;
+            c.tag = cqe.user_data;
+            c.result = cqe.res;
+            out.push_back(c);
+            ++head;
+            ++drained;
+        }
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+        return drained;
+    }
+
+    // Free completion queue slots so a rejected submit can go through. Completions are
+    // parked in m_pending (still counted in flight) until Reap hands them out. When none
+    // are posted yet this waits for one; it fails only if no read is outstanding.
+    bool MakeCompletionRoom(std::string& error)
+    {
+        if (DrainCompletions(m_pending) > 0)
+            return true;
+
+        if (m_inFlight - int(m_pending.size()) <= 0)
+        {
+            error = std::string("io_uring_enter failed with no reads outstanding: ") + strerror(errno);
+            return false;
+        }
+
+        int r = int(syscall(__NR_io_uring_enter, m_ringFd, 0u, 1u, unsigned(IORING_ENTER_GETEVENTS), nullptr, 0));
+        if (r < 0 && errno != EINTR)
+        {
+            error = std::string("io_uring_enter failed waiting for completions: ") + strerror(errno);
+            return false;
+        }
+        DrainCompletions(m_pending);
+        return true;
+    }
+
+    // Whether the kernel supports plain and fixed-buffer reads (IORING_REGISTER_PROBE, 5.6+)
+    bool ProbeOpcodes(bool& read, bool& readFixed) const
+    {
+        const unsigned opcodes = 256;
+        std::vector<char> storage(sizeof(io_uring_probe) + opcodes * sizeof(io_uring_probe_op), 0);
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+        if (syscall(__NR_io_uring_register, m_ringFd, IORING_REGISTER_PROBE, probe, opcodes) < 0)
+            return false;
+
+        auto supported = [&](unsigned op)
+        { return op < probe->ops_len && (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0; };
+        read = supported(IORING_OP_READ);
+        readFixed = supported(IORING_OP_READ_FIXED);
+        return true;
+    }
+
+    int m_ringFd = -1;
+    int m_queueDepth = 0;
+    int m_inFlight = 0;             // Submitted and not yet returned by Reap, m_pending included
+    std::vector<ReadCompletion> m_pending;
+    bool m_readFixed = false;       // IORING_OP_READ_FIXED supported
+    bool m_fixedBuffers = false;
+
+    void* m_sqRing = nullptr;
+    void* m_cqRing = nullptr;
+    size_t m_sqRingSize = 0;
+    size_t m_cqRingSize = 0;
+    io_uring_sqe* m_sqes = nullptr;
+    size_t m_sqesSize = 0;
+
+    unsigned* m_sqTail = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned* m_sqArray = nullptr;
+    unsigned* m_cqHead = nullptr;
+    unsigned* m_cqTail = nullptr;
+    unsigned m_cqMask = 0;
+    io_uring_cqe* m_cqes = nullptr;
+};
+
+#endif // BA_HAVE_IO_URING
+
+// ============================================================================
+// Factory
+// ============================================================================
+
+std::unique_ptr<IngestBackend> IngestBackend::Create(IngestBackendType type, int queueDepth,
+                                                     int workerThreads, std::string& note)
+{
+    queueDepth = std::max(1, queueDepth);
+
+    if (type != IngestBackendType::PreadPool)
+    {
+#ifdef BA_HAVE_IO_URING
+        std::unique_ptr<IoUringBackend> ring(new IoUringBackend);
+        std::string error;
+        if (ring->Setup(queueDepth, error))
+            return ring;
+        note = error + "; falling back to pread thread pool";
+#else
+        note = "io_uring not supported on this platform; using pread thread pool";
+#endif
+    }
+
+    return std::unique_ptr<IngestBackend>(new PreadPoolBackend(queueDepth, workerThreads));
+}
+
+} // namespace pcl
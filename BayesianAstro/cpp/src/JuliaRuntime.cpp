@@ -5,10 +5,18 @@
  */
 
 #include "JuliaRuntime.h"
+#include "FrameCatalog.h"
+#include "StackKernels.h"
+#include "TraceTimeline.h"
 #include <julia.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <filesystem>
 #include <sstream>
+#include <thread>
+#include <utility>
 
 namespace pcl
 {
@@ -24,15 +32,16 @@ JuliaRuntime::~JuliaRuntime()
     Shutdown();
 }
 
-bool JuliaRuntime::Initialize(const std::string& juliaHome)
+bool JuliaRuntime::Initialize(const std::string& juliaHome, const std::string& modulePath)
 {
     if (m_initialized)
         return true;
 
-    // Set JULIA_HOME if provided
+    // Set JULIA_HOME if provided; putenv keeps the string, so it must outlive the call
     if (!juliaHome.empty())
     {
-        std::string envVar = "JULIA_HOME=" + juliaHome;
+        static std::string envVar;
+        envVar = "JULIA_HOME=" + juliaHome;
         putenv(const_cast<char*>(envVar.c_str()));
     }
 
@@ -46,7 +55,8 @@ bool JuliaRuntime::Initialize(const std::string& juliaHome)
 
     // Find our Julia module path (relative to the module binary)
     // TODO: Determine actual path at runtime
-    m_juliaModulePath = std::filesystem::current_path().string() + "/julia";
+    m_juliaModulePath = !modulePath.empty() ? modulePath
+                                            : std::filesystem::current_path().string() + "/julia";
 
     // Load BayesianAstro module
     if (!LoadBayesianAstroModule())
@@ -66,6 +76,13 @@ void JuliaRuntime::Shutdown()
         jl_atexit_hook(0);
         m_initialized = false;
     }
+    m_preview = PreviewSource();
+    m_stageKeys = StageKeys();
+    m_writtenFiles.clear();
+    m_pyramid.Release();
+    for (PlaneHistogram& histogram : m_histograms)
+        histogram.Release();
+    m_workspace.Release();
 }
 
 bool JuliaRuntime::LoadBayesianAstroModule()
@@ -96,6 +113,25 @@ bool JuliaRuntime::LoadBayesianAstroModule()
     {
         m_processStackFunc = jl_get_function(baModule, "process_stack");
         m_validateFitsFunc = jl_get_function(baModule, "validate_fits");
+        m_beginStackFunc = jl_get_function(baModule, "begin_stack");
+        m_accumulateFrameFunc = jl_get_function(baModule, "accumulate_frame!");
+        m_finishStackFunc = jl_get_function(baModule, "finish_stack!");
+        m_refinalizeStackFunc = jl_get_function(baModule, "refinalize_stack!");
+        m_memoryCountersFunc = jl_get_function(baModule, "memory_counters!");
+
+        // A missing export would otherwise only show as a failed run or zeroed metrics
+        const std::pair<const char*, jl_function_t*> required[] = {
+            {"begin_stack", m_beginStackFunc},
+            {"accumulate_frame!", m_accumulateFrameFunc},
+            {"finish_stack!", m_finishStackFunc},
+            {"refinalize_stack!", m_refinalizeStackFunc},
+            {"memory_counters!", m_memoryCountersFunc},
+        };
+        for (const auto& [name, func] : required)
+        {
+            if (func == nullptr)
+                fprintf(stderr, "BayesianAstro: Julia entry point %s not found\n", name);
+        }
     }
 
     return true;
@@ -130,6 +166,358 @@ std::string JuliaRuntime::GetGPUInfo() const
     return std::string(jl_string_ptr(result));
 }
 
+namespace
+{
+
+const char* FusionStrategyName(FusionStrategy strategy)
+{
+    switch (strategy)
+    {
+    case FusionStrategy::MLE: return "MLE";
+    case FusionStrategy::ConfidenceWeighted: return "CONFIDENCE_WEIGHTED";
+    case FusionStrategy::Lucky: return "LUCKY";
+    case FusionStrategy::MultiScale: return "MULTISCALE";
+    }
+    return "UNKNOWN";
+}
+
+void AddStats(PlaneWriteStats& total, const PlaneWriteStats& plane)
+{
+    total.float32Bytes += plane.float32Bytes;
+    total.fileBytes += plane.fileBytes;
+    total.seconds += plane.seconds;
+}
+
+// Ingest throughput over the passes of a banded run
+void AddStats(IngestStats& total, const IngestStats& pass)
+{
+    if (total.reads + pass.reads > 0)
+        total.averageQueueDepth = (total.averageQueueDepth * double(total.reads)
+                                   + pass.averageQueueDepth * double(pass.reads))
+                                / double(total.reads + pass.reads);
+    total.peakQueueDepth = std::max(total.peakQueueDepth, pass.peakQueueDepth);
+    total.bytesRead += pass.bytesRead;
+    total.reads += pass.reads;
+    total.seconds += pass.seconds;
+    total.packedHits += pass.packedHits;
+    total.packedWrites += pass.packedWrites;
+    total.backend = pass.backend;
+    total.cacheMode = pass.cacheMode;
+    if (total.note.empty())
+        total.note = pass.note;
+}
+
+// Records a run's trace session when requested, and stops it on every exit path
+struct TraceRun
+{
+    explicit TraceRun(bool enabled)
+        : active(enabled)
+    {
+        if (active)
+            StartTrace();
+    }
+
+    ~TraceRun()
+    {
+        if (active)
+            StopTrace();
+    }
+
+    bool active;
+};
+
+/**
+ * Mean confidence and class counts of the whole output planes with the fixed
+ * reduction tree: leaf partials are stored by leaf index and combined pairwise,
+ * so neither 'threads' nor the band layout the planes were finalized in changes
+ * a bit. Replaces the per-band summaries Julia returned.
+ */
+void DeterministicSummary(ProcessingResult& result, const float* confidence, const uint8_t* classification,
+                          size_t pixels, int threads)
+{
+    TraceScope trace(TraceCategory::Compute, "deterministic summary", "pixels", int64_t(pixels));
+    const size_t leaves = (pixels + REDUCTION_LEAF_PIXELS - 1) / REDUCTION_LEAF_PIXELS;
+    std::vector<double> partials(leaves);
+    std::vector<uint64_t> counts(size_t(std::max(1, threads)) * 8, 0);
+
+    auto work = [&](size_t worker, size_t stride)
+    {
+        for (size_t leaf = worker; leaf < leaves; leaf += stride)
+        {
+            const size_t first = leaf * REDUCTION_LEAF_PIXELS;
+            const size_t count = std::min(REDUCTION_LEAF_PIXELS, pixels - first);
+            partials[leaf] = SumPlane(confidence + first, count);
+            CountClasses(classification + first, count, &counts[worker * 8]);
+        }
+    };
+    const size_t workers = std::min(leaves, size_t(std::max(1, threads)));
+    std::vector<std::thread> pool;
+    for (size_t w = 1; w < workers; ++w)
+        pool.emplace_back(work, w, workers);
+    work(0, std::max<size_t>(1, workers));
+    for (std::thread& t : pool)
+        t.join();
+
+    uint64_t total[8] = {};
+    for (size_t i = 0; i < counts.size(); ++i)
+        total[i % 8] += counts[i];
+    auto classCount = [&](DistributionCode code) { return int(total[int(code)]); };
+
+    result.totalPixels = int(pixels);
+    result.meanConfidence = pixels > 0 ? float(PairwiseSum(partials.data(), leaves) / double(pixels)) : 0.0f;
+    result.gaussianPixels = classCount(DistributionCode::Gaussian);
+    result.poissonPixels = classCount(DistributionCode::Poisson);
+    result.bimodalPixels = classCount(DistributionCode::Bimodal);
+    result.artifactPixels = classCount(DistributionCode::SkewedRight) + classCount(DistributionCode::SkewedLeft)
+                          + classCount(DistributionCode::Uniform);
+}
+
+// Write the result planes (column-major, height x width) with the configured encodings
+bool WriteOutputPlanes(ProcessingResult& result, const float* fused, const float* confidence,
+                       const uint8_t* classification, int64_t height, int64_t width, int64_t frames,
+                       const ProcessingConfig& config, std::string& error)
+{
+    const OutputOptions& output = config.output;
+    PlaneWriteOptions options;
+    options.compress = output.compress;
+    options.threads = output.threads;
+    PlaneWriteStats stats;
+
+    options.encoding = output.fusedEncoding;
+    if (!WriteFitsPlane(result.fusedImagePath, fused, height, width, options,
+                        { FitsKeyword::Logical("BAYESIAN", true),
+                          FitsKeyword::Integer("NFRAMES", frames),
+                          FitsKeyword::String("FUSION", FusionStrategyName(config.fusionStrategy)) },
+                        &stats, error))
+        return false;
+    AddStats(result.output, stats);
+
+    if (output.writeConfidence)
+    {
+        options.encoding = output.confidenceEncoding;
+        options.low = 0.0;
+        options.high = 1.0;
+        if (!WriteFitsPlane(result.confidenceMapPath, confidence, height, width, options,
+                            { FitsKeyword::String("DATATYPE", "CONFIDENCE"),
+                              FitsKeyword::String("RANGE", "0.0-1.0") },
+                            &stats, error))
+            return false;
+        AddStats(result.output, stats);
+    }
+
+    if (output.writeClassification)
+    {
+        options.encoding = output.classificationEncoding;
+        if (!WriteFitsPlane(result.classificationMapPath, classification, height, width, options,
+                            { FitsKeyword::String("DATATYPE", "CLASSIFICATION") },
+                            &stats, error))
+            return false;
+        AddStats(result.output, stats);
+    }
+
+    return true;
+}
+
+// Julia expression building the run's ProcessingConfig
+std::string JuliaConfigExpression(const ProcessingConfig& config)
+{
+    std::ostringstream configCmd;
+    configCmd << "ProcessingConfig("
+              << "fusion_strategy=FusionStrategy(" << static_cast<int>(config.fusionStrategy) << "), "
+              << "confidence_threshold=Float32(" << config.confidenceThreshold << "), "
+              << "outlier_sigma=Float32(" << config.outlierSigma << "), "
+              << "tile_size=(" << config.tileSizeX << ", " << config.tileSizeY << "), "
+              << "use_gpu=" << (config.useGPU ? "true" : "false")
+              << ")";
+    return configCmd.str();
+}
+
+// Add a finish_stack! / refinalize_stack! summary, weighting its confidence by its pixels
+void AddSummary(ProcessingResult& result, double& confidenceSum, jl_value_t* summary)
+{
+    int bandPixels = int(jl_unbox_int64(jl_get_field(summary, "total_pixels")));
+    result.totalPixels += bandPixels;
+    confidenceSum += double(jl_unbox_float32(jl_get_field(summary, "mean_confidence"))) * bandPixels;
+    result.gaussianPixels += int(jl_unbox_int64(jl_get_field(summary, "gaussian_pixels")));
+    result.poissonPixels += int(jl_unbox_int64(jl_get_field(summary, "poisson_pixels")));
+    result.bimodalPixels += int(jl_unbox_int64(jl_get_field(summary, "bimodal_pixels")));
+    result.artifactPixels += int(jl_unbox_int64(jl_get_field(summary, "artifact_pixels")));
+    result.frameAllocationBytes = std::max(result.frameAllocationBytes,
+                                           uint64_t(jl_unbox_int64(jl_get_field(summary, "frame_alloc_bytes"))));
+}
+
+// Keys of the Accumulate, Finalize and Write stages of a run (see StageGraph.h)
+StageKeys RunStageKeys(const std::vector<std::string>& inputFiles, const std::string& outputDirectory,
+                       const std::string& outputPrefix, const ProcessingConfig& config)
+{
+    StageParameters parameters[int(PipelineStage::Count)];
+
+    // Streaming accumulation depends on the frames alone; an unreadable one never matches
+    StageParameters& accumulate = parameters[int(PipelineStage::Accumulate)];
+    for (const std::string& path : inputFiles)
+    {
+        uint64_t size = 0;
+        int64_t modified = -1;
+        StatFile(path, size, modified);
+        accumulate.Add(path).Add(size).Add(modified);
+    }
+
+    // The confidence threshold stays out until finalize reads it; it cannot change the planes yet
+    StageParameters& finalize = parameters[int(PipelineStage::Finalize)];
+    finalize.Add(int(config.fusionStrategy)).Add(config.useGPU);
+
+    const OutputOptions& output = config.output;
+    StageParameters& write = parameters[int(PipelineStage::Write)];
+    write.Add(outputDirectory).Add(outputPrefix);
+    write.Add(int(output.fusedEncoding)).Add(int(output.confidenceEncoding)).Add(int(output.classificationEncoding));
+    write.Add(output.writeConfidence).Add(output.writeClassification).Add(output.compress);
+
+    return ComputeStageKeys(parameters);
+}
+
+void SetOutputPaths(ProcessingResult& result, const std::string& outputDirectory, const std::string& outputPrefix,
+                    const OutputOptions& output)
+{
+    std::string outputBase = outputDirectory + "/" + outputPrefix;
+    result.fusedImagePath = outputBase + "_fused.fits";
+    result.confidenceMapPath = outputBase + "_confidence.fits";
+    if (output.writeClassification)
+        result.classificationMapPath = outputBase + "_classification.fits";
+    result.metricsPath = outputBase + "_metrics.json";
+}
+
+// Output planes, then the run metrics and the trace timeline next to them
+bool WriteRunOutputs(ProcessingResult& result, void* const planes[10], int64_t height, int64_t width,
+                     int64_t frames, const std::string& outputDirectory, const std::string& outputPrefix,
+                     const ProcessingConfig& writeConfig, PhaseRecorder& phases, TraceRun& trace,
+                     std::string& writeError)
+{
+    std::string outputBase = outputDirectory + "/" + outputPrefix;
+    SetOutputPaths(result, outputDirectory, outputPrefix, writeConfig.output);
+
+    phases.Begin(RunPhase::Write);
+    bool written = WriteOutputPlanes(result, static_cast<const float*>(planes[7]),
+                                     static_cast<const float*>(planes[8]), static_cast<const uint8_t*>(planes[9]),
+                                     height, width, frames, writeConfig, writeError);
+    phases.End();
+
+    // Machine-readable copy of the run metrics, for sizing machines and tracking regressions
+    if (written)
+    {
+        const std::string json = result.metrics.ToJson();
+        FILE* f = fopen(result.metricsPath.c_str(), "wb");
+        bool ok = f != nullptr && fwrite(json.data(), 1, json.size(), f) == json.size();
+        if (f != nullptr)
+            ok = fclose(f) == 0 && ok;
+        if (!ok)
+        {
+            written = false;
+            writeError = "cannot write " + result.metricsPath;
+        }
+    }
+
+    // Timeline of every stage and thread, for chrome://tracing or Perfetto
+    if (written && trace.active)
+    {
+        StopTrace();
+        trace.active = false;
+        result.tracePath = outputBase + "_trace.json";
+        written = WriteChromeTrace(result.tracePath, writeError);
+    }
+    return written;
+}
+
+} // namespace
+
+/**
+ * Acquire the per-pixel planes of a run from the session workspace, in the order
+ * begin_stack/finish_stack! take them: count (UInt16), mean, M2, M3, M4, min, max
+ * (Float32) sized for one band, then fused and confidence (Float32) and
+ * classification (UInt8) for the whole frame.
+ */
+bool JuliaRuntime::AcquireWorkspacePlanes(size_t bandPixels, size_t pixels, void* planes[10])
+{
+    planes[0] = m_workspace.Acquire<uint16_t>(WorkspaceSlot::AccumulatorCount, bandPixels);
+    planes[1] = m_workspace.Acquire<float>(WorkspaceSlot::AccumulatorMean, bandPixels);
+    planes[2] = m_workspace.Acquire<float>(WorkspaceSlot::AccumulatorM2, bandPixels);
+    planes[3] = m_workspace.Acquire<float>(WorkspaceSlot::AccumulatorM3, bandPixels);
+    planes[4] = m_workspace.Acquire<float>(WorkspaceSlot::AccumulatorM4, bandPixels);
+    planes[5] = m_workspace.Acquire<float>(WorkspaceSlot::AccumulatorMin, bandPixels);
+    planes[6] = m_workspace.Acquire<float>(WorkspaceSlot::AccumulatorMax, bandPixels);
+
+    for (int i = 0; i < 7; ++i)
+        if (planes[i] == nullptr)
+            return false;
+    return AcquireOutputPlanes(pixels, planes);
+}
+
+bool JuliaRuntime::AcquireOutputPlanes(size_t pixels, void* planes[10])
+{
+    planes[7] = m_workspace.Acquire<float>(WorkspaceSlot::Fused, pixels);
+    planes[8] = m_workspace.Acquire<float>(WorkspaceSlot::Confidence, pixels);
+    planes[9] = m_workspace.Acquire<uint8_t>(WorkspaceSlot::Classification, pixels);
+    return planes[7] != nullptr && planes[8] != nullptr && planes[9] != nullptr;
+}
+
+void JuliaRuntime::BuildPreviewPyramid(ProcessingResult& result, void* const planes[10], int64_t height,
+                                       int64_t width, const ProcessingConfig& config, int threads)
+{
+    // Without a pyramid of these planes the tiler samples them instead
+    if (!config.previewPyramid)
+    {
+        m_pyramid.Release();
+        return;
+    }
+
+    PreviewSource source;
+    source.fused = static_cast<const float*>(planes[7]);
+    source.confidence = static_cast<const float*>(planes[8]);
+    source.classification = static_cast<const uint8_t*>(planes[9]);
+    source.naxis1 = height;
+    source.naxis2 = width;
+    const auto start = std::chrono::steady_clock::now();
+    m_pyramid.Build(source, threads);
+    result.pyramidSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.pyramidBytes = m_pyramid.Bytes();
+}
+
+void JuliaRuntime::BuildHistograms(ProcessingResult& result, void* const planes[10], int64_t height,
+                                   int64_t width, bool accumulators, const ProcessingConfig& config, int threads)
+{
+    for (PlaneHistogram& histogram : m_histograms)
+        histogram.Release();
+    if (!config.previewHistograms)
+        return;
+
+    const auto start = std::chrono::steady_clock::now();
+    HistogramSource source;
+    source.naxis1 = height;
+    source.naxis2 = width;
+    source.values = static_cast<const float*>(planes[7]);
+    m_histograms[int(HistogramPlane::Fused)].Build(source, threads);
+    source.values = static_cast<const float*>(planes[8]);
+    m_histograms[int(HistogramPlane::Confidence)].Build(source, 0.0f, 1.0f, threads);
+    if (accumulators)
+    {
+        source.values = nullptr;
+        source.n = static_cast<const uint16_t*>(planes[0]);
+        source.m2 = static_cast<const float*>(planes[2]);
+        m_histograms[int(HistogramPlane::Variance)].Build(source, threads);
+    }
+    result.histogramSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void JuliaRuntime::PublishPreview(void* const planes[10], int64_t height, int64_t width)
+{
+    m_preview.fused = static_cast<const float*>(planes[7]);
+    m_preview.confidence = static_cast<const float*>(planes[8]);
+    m_preview.classification = static_cast<const uint8_t*>(planes[9]);
+    m_preview.naxis1 = height;
+    m_preview.naxis2 = width;
+    m_preview.pyramid = &m_pyramid;
+    m_preview.generation = ++m_previewGeneration;
+}
+
 ProcessingResult JuliaRuntime::ProcessStack(
     const std::vector<std::string>& inputFiles,
     const std::string& outputDirectory,
@@ -146,111 +534,576 @@ ProcessingResult JuliaRuntime::ProcessStack(
         return result;
     }
 
-    // Build Julia array of input files
-    std::ostringstream filesArrayCmd;
-    filesArrayCmd << "String[";
-    for (size_t i = 0; i < inputFiles.size(); ++i)
+    if (!m_beginStackFunc || !m_accumulateFrameFunc || !m_finishStackFunc)
     {
-        if (i > 0) filesArrayCmd << ", ";
-        filesArrayCmd << "\"" << inputFiles[i] << "\"";
+        result.success = false;
+        result.errorMessage = "BayesianAstro.jl does not provide the streaming stack API";
+        return result;
     }
-    filesArrayCmd << "]";
 
-    jl_value_t* filesArray = jl_eval_string(filesArrayCmd.str().c_str());
-    if (jl_exception_occurred())
+    // The planes and, if it succeeds, the outputs are about to be replaced. Inputs are
+    // keyed before any is read, so a frame changing during the run invalidates it
+    m_preview = PreviewSource();
+    m_stageKeys = StageKeys();
+    m_writtenFiles.clear();
+    const StageKeys keys = RunStageKeys(inputFiles, outputDirectory, outputPrefix, config);
+    result.stages.run[int(PipelineStage::Accumulate)] = true;
+    result.stages.run[int(PipelineStage::Finalize)] = true;
+    result.stages.run[int(PipelineStage::Write)] = true;
+
+    TraceRun trace(config.trace);
+    SetTraceThreadName("host");
+
+    // Coarse steps go to the callback and the aggregator; per-frame counts only to the
+    // aggregator, whose sampler coalesces them
+    ProgressAggregator* progress = config.progress;
+    ProgressRun progressRun(progress, inputFiles.size());
+    auto report = [&](int percent, const std::string& status)
+    {
+        if (progress != nullptr)
+        {
+            progress->SetPercent(percent);
+            progress->SetStatus(status.c_str());
+        }
+        if (progressCallback)
+            progressCallback(percent, status);
+    };
+
+    // Hardware counters on every thread, Julia's included; degrades to whatever the
+    // kernel allows (perf_event_paranoid, PMU access in VMs) and says why
+    ProcessCounters counters;
+    if (config.hardwareCounters)
+    {
+        result.metrics.countersEnabled = counters.Open();
+        result.metrics.countersNote = counters.Note();
+    }
+
+    // Per-phase time, RSS, allocations and GC; Julia reports its cumulative counters
+    // into a two-word buffer, so sampling them allocates nothing on the Julia side.
+    // A pending exception is left for the caller to report (a call would clear it)
+    uint64_t juliaCounters[2] = { 0, 0 };
+    PhaseRecorder phases(result.metrics, &m_workspace,
+        [&](uint64_t& allocatedBytes, uint64_t& gcNanoseconds)
+        {
+            if (m_memoryCountersFunc != nullptr && jl_exception_occurred() == nullptr)
+            {
+                TraceScope sample(TraceCategory::Julia, "memory_counters!");
+                jl_call1(m_memoryCountersFunc, jl_box_uint64(uint64_t(reinterpret_cast<uintptr_t>(juliaCounters))));
+            }
+            allocatedBytes = juliaCounters[0];
+            gcNanoseconds = juliaCounters[1];
+
+            // Sampled at every phase boundary, i.e. around each frame: GC shows up per frame
+            TraceCounter("Julia GC (ms)", double(gcNanoseconds) * 1e-6);
+            TraceCounter("Julia allocated (MB)", double(allocatedBytes) / 1048576.0);
+        },
+        &counters);
+
+    // Headers come from the frame catalog where unchanged, else a parallel header-only
+    // scan; either way every frame is validated up front, before any pixel I/O
+    phases.Begin(RunPhase::Scan);
+    FrameHeaderTable headers = LoadFrameCatalog(inputFiles, &result.catalog, config.threads);
+    phases.End();
+    size_t failed = headers.FirstFailure();
+    if (failed < headers.Size())
     {
-        HandleJuliaException();
         result.success = false;
-        result.errorMessage = "Failed to create input file list";
+        result.errorMessage = "Invalid input frame: " + headers.errors[failed];
         return result;
     }
 
-    // Build ProcessingConfig in Julia
-    std::ostringstream configCmd;
-    configCmd << "ProcessingConfig("
-              << "fusion_strategy=" << static_cast<int>(config.fusionStrategy) << ", "
-              << "confidence_threshold=" << config.confidenceThreshold << "f0, "
-              << "outlier_sigma=" << config.outlierSigma << "f0, "
-              << "tile_size=(" << config.tileSizeX << ", " << config.tileSizeY << "), "
-              << "use_gpu=" << (config.useGPU ? "true" : "false")
-              << ")";
+    // Tile the run to the memory budget: the whole frame in one pass when it fits, else
+    // column bands, each accumulated in its own pass over the frames
+    const FitsImageInfo geometry = headers.ImageInfo(0);
+    const int64_t height = geometry.Height();
+    const int64_t width = geometry.Width();
+
+    MemoryPlanInputs planInputs;
+    planInputs.budgetBytes = config.memoryBudget;
+    planInputs.height = height;
+    planInputs.width = width;
+    planInputs.frameCount = inputFiles.size();
+    planInputs.sourceBytesPerPixel = geometry.BytesPerPixel();
+    planInputs.hardwareThreads = config.threads;
+    result.memoryPlan = PlanMemory(planInputs);
+    const MemoryPlan& plan = result.memoryPlan;
+
+    report(0, plan.Describe());
+
+    IngestOptions ingestOptions = config.ingest;
+    ingestOptions.readAheadFrames = plan.readAheadFrames;
+    ingestOptions.queueDepth = plan.queueDepth;
+    ingestOptions.stripBytes = plan.stripBytes;
+    ingestOptions.workerThreads = plan.workerThreads;
+    ingestOptions.columnCount = plan.bandColumns;
 
-    jl_value_t* juliaConfig = jl_eval_string(configCmd.str().c_str());
+    ProcessingConfig writeConfig = config;
+    writeConfig.output.threads = plan.outputThreads;
+
+    // Frame buffers and per-pixel planes come from the session workspace, so repeated
+    // runs of the same geometry allocate nothing
+    m_workspace.SetHugePageMode(config.hugePages);
+    m_workspace.BeginRun();
+    void* planes[10];
+    if (!AcquireWorkspacePlanes(size_t(height * plan.bandColumns), size_t(height * width), planes))
+    {
+        result.success = false;
+        result.errorMessage = "Failed to allocate stack workspace";
+        return result;
+    }
+
+    // args[0] holds the session of the current band and args[11] the config for the whole
+    // run; args[1..10] are per-call temporaries
+    jl_value_t** args;
+    JL_GC_PUSHARGS(args, 12);
+
+    args[11] = jl_eval_string(JuliaConfigExpression(config).c_str());
     if (jl_exception_occurred())
     {
         HandleJuliaException();
+        JL_GC_POP();
         result.success = false;
         result.errorMessage = "Failed to create processing config";
         return result;
     }
 
-    // Report progress: starting
-    if (progressCallback)
-        progressCallback(0, "Loading frames...");
+    report(0, "Loading frames...");
 
-    // Call process_directory function
-    std::ostringstream processCmd;
-    processCmd << "process_directory("
-               << "\"" << outputDirectory << "/" << outputPrefix << "\", "
-               << "config=" << configCmd.str()
-               << ")";
+    const size_t frameCount = inputFiles.size();
+    const size_t totalSteps = frameCount * size_t(plan.passes);
+    bool measured = false;
+    double confidenceSum = 0.0;
 
-    // Note: This is simplified - full implementation would pass the file array
-    // and handle progress callbacks via Julia's channel mechanism
+    // Snapshots are gathered between accumulate calls, which hold the planes while Julia writes
+    LivePreview* live = config.livePreview;
+    LiveRun liveRun(live, height, width);
 
-    jl_eval_string(processCmd.str().c_str());
+    for (int pass = 0; pass < plan.passes; ++pass)
+    {
+        // Native ingest reads frames ahead with deep queues; Julia accumulates them in place
+        ingestOptions.firstColumn = int64_t(pass) * plan.bandColumns;
+        if (progress != nullptr)
+        {
+            progress->SetPhase(RunPhase::Accumulate);
+            progress->SetBand(pass + 1, plan.passes);
+        }
+        phases.Begin(RunPhase::Ingest);
+        FrameIngest ingest(inputFiles, ingestOptions, &headers, &m_workspace);
+        std::string ingestError;
+        if (!ingest.Open(ingestError))
+        {
+            JL_GC_POP();
+            result.success = false;
+            result.errorMessage = "Failed to open input frames: " + ingestError;
+            return result;
+        }
 
-    if (jl_exception_occurred())
+        // begin_stack(height, columns, config, accumulator plane pointers...)
+        phases.Begin(RunPhase::Accumulate);
+        args[1] = jl_box_int64(height);
+        args[2] = jl_box_int64(ingest.BandColumns());
+        args[3] = args[11];
+        for (int i = 0; i < 7; ++i)
+            args[4 + i] = jl_box_uint64(uint64_t(reinterpret_cast<uintptr_t>(planes[i])));
+        {
+            TraceScope call(TraceCategory::Julia, "begin_stack", "band", pass);
+            args[0] = jl_call(m_beginStackFunc, args + 1, 10);
+        }
+        if (jl_exception_occurred())
+        {
+            HandleJuliaException();
+            JL_GC_POP();
+            result.success = false;
+            result.errorMessage = "Failed to allocate stack accumulators";
+            return result;
+        }
+
+        if (live != nullptr)
+        {
+            AccumulatorPlanes accumulator;
+            accumulator.n = static_cast<uint16_t*>(planes[0]);
+            accumulator.mean = static_cast<float*>(planes[1]);
+            accumulator.m2 = static_cast<float*>(planes[2]);
+            accumulator.m3 = static_cast<float*>(planes[3]);
+            accumulator.m4 = static_cast<float*>(planes[4]);
+            accumulator.min = static_cast<float*>(planes[5]);
+            accumulator.max = static_cast<float*>(planes[6]);
+            accumulator.pixels = size_t(height * ingest.BandColumns());
+            live->BeginBand(accumulator, ingest.FirstColumn(), ingest.BandColumns(), pass + 1, plan.passes);
+        }
+
+        IngestFrame frame;
+        phases.Begin(RunPhase::Ingest);
+        while (ingest.Next(frame, ingestError))
+        {
+            phases.Begin(RunPhase::Accumulate);
+            args[1] = jl_box_uint64(uint64_t(reinterpret_cast<uintptr_t>(frame.pixels)));
+            args[2] = jl_box_int64(frame.height);
+            args[3] = jl_box_int64(frame.width);
+            {
+                TraceScope call(TraceCategory::Julia, "accumulate_frame!", "frame", int64_t(frame.index));
+                LivePlanesLock hold(live);
+                jl_call(m_accumulateFrameFunc, args, 4);
+            }
+            phases.Begin(RunPhase::Ingest);
+
+            // Quality metrics are measured once per frame and then served from the catalog;
+            // they need the whole frame, so banded runs leave them to a later unbanded run
+            if (!ingest.IsBanded() && std::isnan(headers.mean[frame.index]))
+            {
+                TraceScope measure(TraceCategory::Compute, "measure quality", "frame", int64_t(frame.index));
+                MeasureFrameQuality(frame.pixels, size_t(frame.height * frame.width),
+                                    headers.mean[frame.index], headers.sigma[frame.index]);
+                measured = true;
+            }
+
+            if (jl_exception_occurred())
+            {
+                HandleJuliaException();
+                JL_GC_POP();
+                result.success = false;
+                result.errorMessage = "Accumulation failed - see console for details";
+                return result;
+            }
+
+            if (live != nullptr)
+                live->FrameAccumulated();
+
+            size_t step = size_t(pass) * frameCount + frame.index + 1;
+            int percent = int(90 * step / totalSteps);
+            if (progress != nullptr)
+            {
+                progress->AddFrames(1, uint64_t(frame.height * frame.width) * geometry.BytesPerPixel());
+                progress->SetPercent(percent);
+            }
+            if (progressCallback)
+            {
+                std::string status = "Frame " + std::to_string(frame.index + 1) + "/" + std::to_string(frameCount);
+                if (plan.passes > 1)
+                    status += ", band " + std::to_string(pass + 1) + "/" + std::to_string(plan.passes);
+                progressCallback(percent, status);
+            }
+        }
+
+        phases.End();
+        AddStats(result.ingest, ingest.Stats());
+
+        if (!ingestError.empty())
+        {
+            JL_GC_POP();
+            result.success = false;
+            result.errorMessage = "Ingest failed: " + ingestError;
+            return result;
+        }
+
+        // The band's final state, before the next begin_stack resets its planes
+        if (live != nullptr)
+            live->EndBand();
+
+        if (progress != nullptr)
+            progress->SetPhase(RunPhase::Finalize);
+        report(int(90 * (size_t(pass) + 1) * frameCount / totalSteps),
+               plan.passes > 1 ? "Finalizing band " + std::to_string(pass + 1) + "..." : "Finalizing...");
+
+        // Julia finalizes the band into its columns of the workspace output planes
+        const size_t offset = size_t(ingest.FirstColumn() * height);
+        args[1] = jl_box_uint64(uint64_t(reinterpret_cast<uintptr_t>(static_cast<float*>(planes[7]) + offset)));
+        args[2] = jl_box_uint64(uint64_t(reinterpret_cast<uintptr_t>(static_cast<float*>(planes[8]) + offset)));
+        args[3] = jl_box_uint64(uint64_t(reinterpret_cast<uintptr_t>(static_cast<uint8_t*>(planes[9]) + offset)));
+        phases.Begin(RunPhase::Finalize);
+        {
+            TraceScope call(TraceCategory::Julia, "finish_stack!", "band", pass);
+            args[4] = jl_call(m_finishStackFunc, args, 4);
+        }
+        phases.End();
+
+        if (jl_exception_occurred())
+        {
+            HandleJuliaException();
+            JL_GC_POP();
+            result.success = false;
+            result.errorMessage = "Processing failed - see console for details";
+            return result;
+        }
+
+        AddSummary(result, confidenceSum, args[4]);
+    }
+
+    JL_GC_POP();
+
+    if (result.totalPixels > 0)
+        result.meanConfidence = float(confidenceSum / result.totalPixels);
+
+    // Every zoom level of the preview and the plane histograms, while the planes are hot in cache
+    phases.Begin(RunPhase::Finalize);
+    BuildPreviewPyramid(result, planes, height, width, config, plan.outputThreads);
+    BuildHistograms(result, planes, height, width, plan.passes == 1, config, plan.outputThreads);
+    phases.End();
+
+    // The band-weighted mean above depends on how the run was banded; the fixed tree does not
+    if (config.deterministic)
+    {
+        phases.Begin(RunPhase::Finalize);
+        const auto start = std::chrono::steady_clock::now();
+        DeterministicSummary(result, static_cast<const float*>(planes[8]), static_cast<const uint8_t*>(planes[9]),
+                             size_t(height * width), plan.outputThreads);
+        result.reductionSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        phases.End();
+    }
+
+    if (measured)
+        StoreFrameCatalog(inputFiles, headers);
+
+    if (progress != nullptr)
+        progress->SetPhase(RunPhase::Write);
+    report(95, "Writing outputs...");
+
+    std::string writeError;
+    result.workspace = m_workspace.Stats();
+    if (!WriteRunOutputs(result, planes, height, width, int64_t(frameCount), outputDirectory, outputPrefix,
+                         writeConfig, phases, trace, writeError))
     {
-        HandleJuliaException();
         result.success = false;
-        result.errorMessage = "Processing failed - see console for details";
+        result.errorMessage = "Failed to write outputs: " + writeError;
         return result;
     }
 
-    // Build result paths
     result.success = true;
-    result.fusedImagePath = outputDirectory + "/" + outputPrefix + "_fused.fits";
-    result.confidenceMapPath = outputDirectory + "/" + outputPrefix + "_confidence.fits";
+    PublishPreview(planes, height, width);
 
-    if (progressCallback)
-        progressCallback(100, "Complete");
+    // What the session now holds: the whole image's accumulators after a single pass (a
+    // banded run keeps only its last band's), the output planes and the files
+    if (plan.passes == 1)
+        m_stageKeys[PipelineStage::Accumulate] = keys[PipelineStage::Accumulate];
+    m_keptHeight = height;
+    m_keptWidth = width;
+    m_keptFrames = int64_t(frameCount);
+    m_stageKeys[PipelineStage::Finalize] = keys[PipelineStage::Finalize];
+    m_stageKeys[PipelineStage::Write] = keys[PipelineStage::Write];
+    RecordWrittenFiles(result);
+
+    report(100, "Complete");
 
     return result;
 }
 
-bool JuliaRuntime::ValidateFitsFile(const std::string& path) const
+StageKeys JuliaRuntime::CachedStageKeys() const
 {
-    if (!m_initialized)
-        return false;
+    StageKeys cached = m_stageKeys;
+    for (const WrittenFile& file : m_writtenFiles)
+    {
+        uint64_t size = 0;
+        int64_t modified = 0;
+        if (!StatFile(file.path, size, modified) || size != file.size || modified != file.modified)
+            cached[PipelineStage::Write] = 0;
+    }
+    return cached;
+}
 
-    std::ostringstream cmd;
-    cmd << "try; FITS(\"" << path << "\", \"r\"); true; catch; false; end";
+void JuliaRuntime::RecordWrittenFiles(const ProcessingResult& result)
+{
+    m_writtenFiles.clear();
+    for (const std::string* path : { &result.fusedImagePath, &result.confidenceMapPath,
+                                     &result.classificationMapPath, &result.metricsPath })
+    {
+        WrittenFile file;
+        file.path = *path;
+        if (!file.path.empty() && StatFile(file.path, file.size, file.modified))
+            m_writtenFiles.push_back(file);
+    }
+}
 
-    jl_value_t* result = jl_eval_string(cmd.str().c_str());
-    if (jl_exception_occurred())
-        return false;
+StagePlan JuliaRuntime::PlanRun(const std::vector<std::string>& inputFiles, const std::string& outputDirectory,
+                                const std::string& outputPrefix, const ProcessingConfig& config) const
+{
+    const StageKeys keys = RunStageKeys(inputFiles, outputDirectory, outputPrefix, config);
+    return PlanStages(keys, CachedStageKeys(),
+                      outputDirectory.empty() ? PipelineStage::Finalize : PipelineStage::Write);
+}
 
-    return jl_unbox_bool(result);
+ProcessingResult JuliaRuntime::Run(
+    const std::vector<std::string>& inputFiles,
+    const std::string& outputDirectory,
+    const std::string& outputPrefix,
+    const ProcessingConfig& config,
+    ProgressCallback progressCallback)
+{
+    const StageKeys keys = RunStageKeys(inputFiles, outputDirectory, outputPrefix, config);
+    const StagePlan plan = PlanStages(keys, CachedStageKeys(),
+                                      outputDirectory.empty() ? PipelineStage::Finalize : PipelineStage::Write);
+    if (plan.Runs(PipelineStage::Accumulate))
+        return ProcessStack(inputFiles, outputDirectory, outputPrefix, config, progressCallback);
+    return RunCachedStages(plan, keys, outputDirectory, outputPrefix, config, progressCallback);
 }
 
-std::pair<int, int> JuliaRuntime::GetImageDimensions(const std::string& path) const
+ProcessingResult JuliaRuntime::RunCachedStages(const StagePlan& stages, const StageKeys& keys,
+                                               const std::string& outputDirectory, const std::string& outputPrefix,
+                                               const ProcessingConfig& config, ProgressCallback progressCallback)
 {
-    if (!m_initialized)
-        return {0, 0};
+    ProcessingResult result;
+    result.stages = stages;
+    const bool finalize = stages.Runs(PipelineStage::Finalize);
+    const bool write = stages.Runs(PipelineStage::Write);
 
-    std::ostringstream cmd;
-    cmd << "let f = FITS(\"" << path << "\", \"r\"); "
-        << "sz = size(read(f[1])); close(f); (sz[1], sz[2]); end";
+    if (!m_initialized || (finalize && m_refinalizeStackFunc == nullptr))
+    {
+        result.success = false;
+        result.errorMessage = "BayesianAstro.jl does not provide refinalize_stack!";
+        return result;
+    }
 
-    jl_value_t* result = jl_eval_string(cmd.str().c_str());
-    if (jl_exception_occurred() || !jl_is_tuple(result))
-        return {0, 0};
+    TraceRun trace(config.trace);
+    SetTraceThreadName("host");
+
+    ProgressAggregator* progress = config.progress;
+    ProgressRun progressRun(progress, 0);
+    auto report = [&](int percent, const std::string& status)
+    {
+        if (progress != nullptr)
+        {
+            progress->SetPercent(percent);
+            progress->SetStatus(status.c_str());
+        }
+        if (progressCallback)
+            progressCallback(percent, status);
+    };
+
+    PhaseRecorder phases(result.metrics, &m_workspace);
+    const int64_t height = m_keptHeight;
+    const int64_t width = m_keptWidth;
+    const size_t pixels = size_t(height * width);
+
+    MemoryPlanInputs planInputs;
+    planInputs.budgetBytes = config.memoryBudget;
+    planInputs.height = height;
+    planInputs.width = width;
+    planInputs.frameCount = size_t(m_keptFrames);
+    planInputs.hardwareThreads = config.threads;
+    result.memoryPlan = PlanMemory(planInputs);
+
+    // The sizes of the run that filled them, so every slot returns its buffer as is. Only a
+    // finalize reads the accumulators, which an unbanded run left at full size
+    m_workspace.BeginRun();
+    void* planes[10] = {};
+    if (!(finalize ? AcquireWorkspacePlanes(pixels, pixels, planes) : AcquireOutputPlanes(pixels, planes)))
+    {
+        m_stageKeys = StageKeys();
+        result.success = false;
+        result.errorMessage = "Failed to allocate stack workspace";
+        return result;
+    }
+
+    if (finalize)
+    {
+        // The output planes are about to be overwritten; the accumulators are only read
+        m_preview = PreviewSource();
+        m_stageKeys[PipelineStage::Finalize] = 0;
+        if (progress != nullptr)
+            progress->SetPhase(RunPhase::Finalize);
+        report(0, "Refinalizing kept accumulators...");
+
+        // refinalize_stack!(height, width, config, accumulator planes..., output planes...)
+        jl_value_t** args;
+        JL_GC_PUSHARGS(args, 14);
+        args[0] = jl_box_int64(height);
+        args[1] = jl_box_int64(width);
+        args[2] = jl_eval_string(JuliaConfigExpression(config).c_str());
+        if (jl_exception_occurred())
+        {
+            HandleJuliaException();
+            JL_GC_POP();
+            result.success = false;
+            result.errorMessage = "Failed to create processing config";
+            return result;
+        }
+        for (int i = 0; i < 10; ++i)
+            args[3 + i] = jl_box_uint64(uint64_t(reinterpret_cast<uintptr_t>(planes[i])));
 
-    int height = jl_unbox_int64(jl_get_nth_field(result, 0));
-    int width = jl_unbox_int64(jl_get_nth_field(result, 1));
+        phases.Begin(RunPhase::Finalize);
+        {
+            TraceScope call(TraceCategory::Julia, "refinalize_stack!", "pixels", height * width);
+            args[13] = jl_call(m_refinalizeStackFunc, args, 13);
+        }
+        phases.End();
+
+        if (jl_exception_occurred())
+        {
+            HandleJuliaException();
+            JL_GC_POP();
+            result.success = false;
+            result.errorMessage = "Processing failed - see console for details";
+            return result;
+        }
+
+        double confidenceSum = 0.0;
+        AddSummary(result, confidenceSum, args[13]);
+        JL_GC_POP();
+        if (result.totalPixels > 0)
+            result.meanConfidence = float(confidenceSum / result.totalPixels);
+
+        phases.Begin(RunPhase::Finalize);
+        BuildPreviewPyramid(result, planes, height, width, config, result.memoryPlan.outputThreads);
+        BuildHistograms(result, planes, height, width, true, config, result.memoryPlan.outputThreads);
+        phases.End();
+
+        m_stageKeys[PipelineStage::Finalize] = keys[PipelineStage::Finalize];
+        PublishPreview(planes, height, width);
+    }
 
-    return {width, height};
+    // Without a finalize there is no Julia summary; the fixed tree summarizes the cached planes
+    if (config.deterministic || !finalize)
+    {
+        phases.Begin(RunPhase::Finalize);
+        const auto start = std::chrono::steady_clock::now();
+        DeterministicSummary(result, static_cast<const float*>(planes[8]), static_cast<const uint8_t*>(planes[9]),
+                             pixels, result.memoryPlan.outputThreads);
+        result.reductionSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        phases.End();
+    }
+
+    result.workspace = m_workspace.Stats();
+    if (!outputDirectory.empty())
+        SetOutputPaths(result, outputDirectory, outputPrefix, config.output);
+    if (write)
+    {
+        if (progress != nullptr)
+            progress->SetPhase(RunPhase::Write);
+        report(95, "Writing outputs...");
+
+        ProcessingConfig writeConfig = config;
+        writeConfig.output.threads = result.memoryPlan.outputThreads;
+        std::string writeError;
+        m_stageKeys[PipelineStage::Write] = 0;
+        if (!WriteRunOutputs(result, planes, height, width, m_keptFrames, outputDirectory, outputPrefix,
+                             writeConfig, phases, trace, writeError))
+        {
+            result.success = false;
+            result.errorMessage = "Failed to write outputs: " + writeError;
+            return result;
+        }
+        m_stageKeys[PipelineStage::Write] = keys[PipelineStage::Write];
+        RecordWrittenFiles(result);
+    }
+
+    result.success = true;
+
+    report(100, "Complete");
+
+    return result;
+}
+
+bool JuliaRuntime::ValidateFitsFile(const std::string& path) const
+{
+    return LoadFrameCatalog({path}).ok[0] != 0;
+}
+
+std::pair<int, int> JuliaRuntime::GetImageDimensions(const std::string& path) const
+{
+    FrameHeaderTable headers = LoadFrameCatalog({path});
+    if (!headers.ok[0])
+        return {0, 0};
+
+    return {int(headers.naxis2[0]), int(headers.naxis1[0])};
 }
 
 void JuliaRuntime::HandleJuliaException()
@@ -258,8 +1111,9 @@ void JuliaRuntime::HandleJuliaException()
     jl_value_t* ex = jl_exception_occurred();
     if (ex)
     {
-        jl_value_t* str = jl_call1(jl_get_function(jl_base_module, "sprint"),
-                                    jl_get_function(jl_base_module, "showerror"));
+        jl_exception_clear();
+        jl_value_t* str = jl_call2(jl_get_function(jl_base_module, "sprint"),
+                                   jl_get_function(jl_base_module, "showerror"), ex);
         if (str && jl_is_string(str))
         {
             // Log error - in real implementation would use Console::CriticalLn
@@ -0,0 +1,252 @@
+/**
+ * Live Preview Implementation
+ */
+
+#include "LivePreview.h"
+#include "TraceTimeline.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+namespace pcl
+{
+
+LivePreview::LivePreview(int everyFrames, double everySeconds)
+    : m_everyFrames(std::max(everyFrames, 1))
+    , m_everySeconds(everySeconds)
+{
+}
+
+LivePreview::~LivePreview()
+{
+    EndRun();
+}
+
+void LivePreview::BeginRun(int64_t height, int64_t width)
+{
+    EndRun();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_height = height;
+    m_width = width;
+    m_band = Band();
+    m_latest.reset();
+    m_running = true;
+    m_stopping = false;
+    m_pending = false;
+    m_gathering = false;
+    m_frames.store(0, std::memory_order_relaxed);
+    m_firstFrame = true;
+    m_requestedFrames = 0;
+    m_requestedAt = std::chrono::steady_clock::now();
+    m_worker = std::thread([this] { WorkerLoop(); });
+}
+
+void LivePreview::BeginBand(const AccumulatorPlanes& planes, int64_t firstColumn, int64_t columns, int band,
+                            int bands)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_band.planes = planes;
+    m_band.firstColumn = firstColumn;
+    m_band.columns = columns;
+    m_band.band = band;
+    m_band.bands = std::max(bands, 1);
+    m_frames.store(0, std::memory_order_relaxed);
+    m_requestedFrames = 0;
+    m_requestedAt = std::chrono::steady_clock::now();
+}
+
+void LivePreview::FrameAccumulated()
+{
+    const uint64_t frames = m_frames.fetch_add(1, std::memory_order_relaxed) + 1;
+    const auto now = std::chrono::steady_clock::now();
+
+    // The first frame of a run goes out at once: a wrong file set shows immediately
+    if (!m_firstFrame && frames < m_requestedFrames + uint64_t(m_everyFrames)
+        && std::chrono::duration<double>(now - m_requestedAt).count() < m_everySeconds)
+        return;
+    m_firstFrame = false;
+    m_requestedFrames = frames;
+    m_requestedAt = now;
+    Request();
+}
+
+void LivePreview::Request()
+{
+    // A snapshot still being gathered absorbs the request; the next one is due soon enough
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running || m_pending || m_gathering)
+        return;
+    m_pending = true;
+    m_wake.notify_one();
+}
+
+void LivePreview::EndBand()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_running)
+        return;
+    m_pending = true;
+    m_wake.notify_one();
+    m_idle.wait(lock, [&] { return !m_pending && !m_gathering; });
+}
+
+void LivePreview::EndRun()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running)
+            return;
+        m_running = false;
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_worker.join();
+}
+
+std::shared_ptr<const LiveSnapshot> LivePreview::Latest() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_latest;
+}
+
+void LivePreview::WorkerLoop()
+{
+    SetTraceThreadName("live preview");
+#if defined(__linux__)
+    // The nice value is per thread on Linux; 'who' = 0 is the calling thread
+    setpriority(PRIO_PROCESS, 0, getpriority(PRIO_PROCESS, 0) + LIVE_PREVIEW_NICE);
+#endif
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_wake.wait(lock, [&] { return m_stopping || m_pending; });
+        if (!m_pending)
+            return;
+        m_pending = false;
+        m_gathering = true;
+        const Band band = m_band;
+        const std::shared_ptr<const LiveSnapshot> previous = m_latest;
+        lock.unlock();
+
+        std::shared_ptr<LiveSnapshot> next;
+        if (band.planes.n != nullptr)
+        {
+            const uint64_t frames = m_frames.load(std::memory_order_relaxed);
+            TraceScope trace(TraceCategory::Compute, "live preview", "frames", int64_t(frames));
+            next = Gather(band, frames, previous);
+        }
+
+        lock.lock();
+        if (next != nullptr)
+        {
+            const uint64_t generation = m_generation.load(std::memory_order_relaxed) + 1;
+            next->source.generation = generation;
+            m_latest = std::move(next);
+            m_generation.store(generation, std::memory_order_release);
+        }
+        m_gathering = false;
+        m_idle.notify_all();
+    }
+}
+
+std::shared_ptr<LiveSnapshot> LivePreview::Gather(const Band& band, uint64_t frames,
+                                                  const std::shared_ptr<const LiveSnapshot>& previous)
+{
+    // Snapshot rows follow plane columns (NAXIS2), snapshot pixels run along NAXIS1
+    const int64_t height = m_height;
+    const int64_t step = std::max<int64_t>(1, (std::max(height, m_width) + LIVE_PREVIEW_SIZE - 1) / LIVE_PREVIEW_SIZE);
+    const int64_t across = (height + step - 1) / step;
+    const int64_t down = (m_width + step - 1) / step;
+    const int perAxis = int(std::min<int64_t>(step, LIVE_PREVIEW_TAPS));
+
+    // Earlier bands' rows carry over from the previous snapshot
+    auto next = std::make_shared<LiveSnapshot>();
+    const size_t pixels = size_t(across * down);
+    if (previous != nullptr && previous->mean.size() == pixels)
+    {
+        next->mean = previous->mean;
+        next->confidence = previous->confidence;
+    }
+    else
+    {
+        next->mean.assign(pixels, NAN);
+        next->confidence.assign(pixels, NAN);
+    }
+    next->step = step;
+    next->frames = frames;
+    next->band = band.band;
+    next->bands = band.bands;
+    next->source.fused = next->mean.data();
+    next->source.confidence = next->confidence.data();
+    next->source.naxis1 = across;
+    next->source.naxis2 = down;
+
+    // Taps along NAXIS1, shared by every row; positions past the edge are -1
+    std::vector<int64_t> tapsX(size_t(across) * size_t(perAxis));
+    for (int64_t x = 0; x < across; ++x)
+        for (int t = 0; t < perAxis; ++t)
+        {
+            const int64_t position = x * step + (2 * t + 1) * step / (2 * perAxis);
+            tapsX[size_t(x) * size_t(perAxis) + size_t(t)] = position < height ? position : -1;
+        }
+
+    const AccumulatorPlanes& acc = band.planes;
+    const int64_t bandEnd = band.firstColumn + band.columns;
+    const int64_t firstRow = band.firstColumn / step;
+    const int64_t lastRow = std::min(down, (bandEnd + step - 1) / step);
+    for (int64_t strip = firstRow; strip < lastRow; strip += LIVE_PREVIEW_STRIP_ROWS)
+    {
+        std::lock_guard<std::mutex> planes(m_planesMutex);
+        for (int64_t y = strip; y < std::min(strip + LIVE_PREVIEW_STRIP_ROWS, lastRow); ++y)
+        {
+            // Plane columns of this row inside the band; the rest belong to a neighbour
+            int64_t columns[LIVE_PREVIEW_TAPS];
+            int columnCount = 0;
+            for (int t = 0; t < perAxis; ++t)
+            {
+                const int64_t column = y * step + (2 * t + 1) * step / (2 * perAxis);
+                if (column >= band.firstColumn && column < bandEnd)
+                    columns[columnCount++] = column - band.firstColumn;
+            }
+            if (columnCount == 0)
+                continue;
+
+            float* meanOut = next->mean.data() + size_t(y * across);
+            float* confidenceOut = next->confidence.data() + size_t(y * across);
+            for (int64_t x = 0; x < across; ++x)
+            {
+                // The mean averages every tap; confidence, a full classification per
+                // sample and as costly as finalizing, scores the first one
+                const int64_t* taps = tapsX.data() + size_t(x) * size_t(perAxis);
+                float meanSum = 0.0f;
+                float confidence = NAN;
+                int n = 0;
+                for (int c = 0; c < columnCount; ++c)
+                {
+                    const size_t base = size_t(columns[c] * height);
+                    for (int t = 0; t < perAxis && taps[t] >= 0; ++t)
+                    {
+                        const size_t i = base + size_t(taps[t]);
+                        if (acc.n[i] == 0 || !std::isfinite(acc.mean[i]))
+                            continue;
+                        meanSum += acc.mean[i];
+                        if (n++ == 0)
+                            confidence = ConfidenceMoments(acc.n[i], acc.mean[i], acc.m2[i], acc.m3[i], acc.m4[i],
+                                                           acc.min[i], acc.max[i]);
+                    }
+                }
+                meanOut[x] = n > 0 ? meanSum / float(n) : NAN;
+                confidenceOut[x] = confidence;
+            }
+        }
+    }
+    return next;
+}
+
+} // namespace pcl
@@ -0,0 +1,179 @@
+/**
+ * Memory Planner Implementation
+ */
+
+#include "MemoryPlanner.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+#include <unistd.h>
+
+namespace pcl
+{
+
+namespace
+{
+
+// Read-ahead buffers are block-aligned with one block of slack at each end (see FrameIngest)
+constexpr uint64_t READ_ALIGNMENT = 4096;
+
+constexpr int MIN_READ_AHEAD = 2;       // Keeps one frame reading while another is consumed
+constexpr int MAX_READ_AHEAD = 8;       // Deeper pools stop paying off once the queue is full
+constexpr int MAX_QUEUE_DEPTH = 64;
+constexpr size_t MAX_STRIP_BYTES = 1 << 20;
+constexpr int64_t MIN_BAND_COLUMNS = 16;
+
+uint64_t AlignUp(uint64_t n, uint64_t a)
+{
+    return (n + a - 1) / a * a;
+}
+
+uint64_t ReadBufferBytes(int64_t height, int64_t columns, size_t bytesPerPixel)
+{
+    return AlignUp(uint64_t(height) * uint64_t(columns) * bytesPerPixel, READ_ALIGNMENT) + 2 * READ_ALIGNMENT;
+}
+
+std::string FormatBytes(uint64_t bytes)
+{
+    char text[32];
+    if (bytes >= (uint64_t(1) << 30))
+        snprintf(text, sizeof(text), "%.2f GB", double(bytes) / double(uint64_t(1) << 30));
+    else if (bytes >= (1 << 20))
+        snprintf(text, sizeof(text), "%.1f MB", double(bytes) / double(1 << 20));
+    else
+        snprintf(text, sizeof(text), "%.0f KB", double(bytes) / 1024.0);
+    return text;
+}
+
+} // namespace
+
+uint64_t MemoryPlan::PeakBytes() const
+{
+    // Everything lives in the session workspace, so the write phase adds to the accumulation phase
+    return accumulatorBytes + decodeBytes + readAheadBytes + outputBytes + writerBytes;
+}
+
+std::string MemoryPlan::Describe() const
+{
+    char line[256];
+    std::string text;
+
+    snprintf(line, sizeof(line), "Memory plan: budget %s, predicted peak %s\n",
+             FormatBytes(budgetBytes).c_str(), FormatBytes(PeakBytes()).c_str());
+    text += line;
+
+    if (passes == 1)
+        snprintf(line, sizeof(line), "  Bands: 1 pass over all %lld columns\n", (long long)bandColumns);
+    else
+        snprintf(line, sizeof(line), "  Bands: %d passes of up to %lld columns (frames are read once per pass)\n",
+                 passes, (long long)bandColumns);
+    text += line;
+
+    snprintf(line, sizeof(line), "  Read-ahead: %d frames, queue depth %d x %s strips, %d I/O threads\n",
+             readAheadFrames, queueDepth, FormatBytes(stripBytes).c_str(), workerThreads);
+    text += line;
+
+    snprintf(line, sizeof(line), "  Accumulators %s, frame buffers %s, outputs %s, writer %s",
+             FormatBytes(accumulatorBytes).c_str(), FormatBytes(decodeBytes + readAheadBytes).c_str(),
+             FormatBytes(outputBytes).c_str(), FormatBytes(writerBytes).c_str());
+    text += line;
+
+    if (!fitsBudget)
+        text += "\n  ** The smallest layout exceeds the budget; expect paging";
+
+    return text;
+}
+
+uint64_t PhysicalMemoryBytes()
+{
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGE_SIZE);
+    if (pages <= 0 || pageSize <= 0)
+        return 0;
+    return uint64_t(pages) * uint64_t(pageSize);
+}
+
+uint64_t DefaultMemoryBudget()
+{
+    uint64_t ram = PhysicalMemoryBytes();
+    if (ram == 0)
+        return uint64_t(4) << 30;
+    return uint64_t(DEFAULT_MEMORY_BUDGET_FRACTION * double(ram));
+}
+
+MemoryPlan PlanMemory(const MemoryPlanInputs& inputs)
+{
+    MemoryPlan plan;
+    plan.budgetBytes = inputs.budgetBytes > 0 ? inputs.budgetBytes : DefaultMemoryBudget();
+
+    const int hardwareThreads = inputs.hardwareThreads > 0
+                              ? inputs.hardwareThreads
+                              : int(std::max(1u, std::thread::hardware_concurrency()));
+    const int64_t height = std::max<int64_t>(1, inputs.height);
+    const int64_t width = std::max<int64_t>(1, inputs.width);
+    const size_t bytesPerPixel = std::max<size_t>(1, inputs.sourceBytesPerPixel);
+    const int maxReadAhead = int(std::min<size_t>(std::max<size_t>(1, inputs.frameCount), MAX_READ_AHEAD));
+    const int minReadAhead = std::min(MIN_READ_AHEAD, maxReadAhead);
+
+    // Result planes cover the whole frame whatever the banding
+    const uint64_t pixels = uint64_t(height) * uint64_t(width);
+    plan.outputBytes = pixels * OUTPUT_BYTES_PER_PIXEL;
+    plan.writerBytes = pixels * sizeof(float);
+    const uint64_t fixed = plan.outputBytes + plan.writerBytes;
+
+    auto footprint = [&](int64_t columns, int readAhead)
+    {
+        return fixed + uint64_t(height) * uint64_t(columns) * (ACCUMULATOR_BYTES_PER_PIXEL + sizeof(float))
+             + uint64_t(readAhead) * ReadBufferBytes(height, columns, bytesPerPixel);
+    };
+
+    // Every extra pass re-reads the whole stack, so the fewest passes win over deeper read-ahead
+    int64_t columns = width;
+    if (footprint(width, minReadAhead) > plan.budgetBytes)
+    {
+        const uint64_t perColumn = uint64_t(height) * (ACCUMULATOR_BYTES_PER_PIXEL + sizeof(float)
+                                                       + uint64_t(minReadAhead) * bytesPerPixel);
+        const uint64_t overhead = fixed + uint64_t(minReadAhead) * 3 * READ_ALIGNMENT;
+        columns = plan.budgetBytes > overhead ? int64_t((plan.budgetBytes - overhead) / perColumn) : 0;
+
+        // If even the result planes do not fit, no banding can avoid paging; keep the hot
+        // per-band planes to half the budget rather than degenerating into slivers
+        const int64_t minimum = std::min(width, MIN_BAND_COLUMNS);
+        if (columns < minimum)
+        {
+            columns = std::min(width, std::max(minimum, int64_t(plan.budgetBytes / 2 / perColumn)));
+            plan.fitsBudget = false;
+        }
+
+        // Balance the bands so the last pass is not a sliver
+        plan.passes = int((width + columns - 1) / columns);
+        columns = (width + plan.passes - 1) / plan.passes;
+    }
+    plan.bandColumns = columns;
+
+    int readAhead = minReadAhead;
+    while (readAhead < maxReadAhead && footprint(columns, readAhead + 1) <= plan.budgetBytes)
+        ++readAhead;
+    plan.readAheadFrames = readAhead;
+
+    // Strips no larger than a band, and no more in flight than the pool can hold
+    const uint64_t bandBytes = uint64_t(height) * uint64_t(columns) * bytesPerPixel;
+    plan.stripBytes = size_t(std::min<uint64_t>(MAX_STRIP_BYTES, AlignUp(bandBytes, READ_ALIGNMENT)));
+    const uint64_t stripsPerFrame = (ReadBufferBytes(height, columns, bytesPerPixel) + plan.stripBytes - 1)
+                                  / plan.stripBytes;
+    plan.queueDepth = int(std::min<uint64_t>(MAX_QUEUE_DEPTH, uint64_t(readAhead) * stripsPerFrame));
+    plan.workerThreads = std::min(hardwareThreads, plan.queueDepth);
+    plan.outputThreads = hardwareThreads;
+
+    plan.accumulatorBytes = uint64_t(height) * uint64_t(columns) * ACCUMULATOR_BYTES_PER_PIXEL;
+    plan.decodeBytes = uint64_t(height) * uint64_t(columns) * sizeof(float);
+    plan.readAheadBytes = uint64_t(readAhead) * ReadBufferBytes(height, columns, bytesPerPixel);
+    if (plan.PeakBytes() > plan.budgetBytes)
+        plan.fitsBudget = false;
+
+    return plan;
+}
+
+} // namespace pcl
@@ -0,0 +1,329 @@
+/**
+ * Packed Frame Cache Implementation
+ */
+
+#include "PackedFrameCache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pcl
+{
+
+namespace
+{
+
+constexpr char PACKED_MAGIC[8] = {'B', 'A', 'P', 'A', 'C', 'K', 'E', 'D'};
+constexpr uint32_t PACKED_VERSION = 1;
+constexpr float HALF_MAX = 65504.0f;
+
+static_assert(sizeof(PackedFrameHeader) <= PACKED_FRAME_PAYLOAD_OFFSET, "packed header overflows payload offset");
+
+void SplitPath(const std::string& path, std::string& directory, std::string& name)
+{
+    size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos)
+    {
+        directory = ".";
+        name = path;
+    }
+    else
+    {
+        directory = slash == 0 ? "/" : path.substr(0, slash);
+        name = path.substr(slash + 1);
+    }
+}
+
+bool WriteAll(int fd, const void* data, size_t length)
+{
+    const char* p = static_cast<const char*>(data);
+    while (length > 0)
+    {
+        ssize_t w = write(fd, p, length);
+        if (w < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += w;
+        length -= size_t(w);
+    }
+    return true;
+}
+
+uint64_t Rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+// Largest power-of-two scale that keeps every finite sample within the half range
+int32_t HalfScaleExponent(const float* pixels, size_t count)
+{
+    float maxAbs = 0.0f;
+    for (size_t i = 0; i < count; ++i)
+    {
+        float a = std::fabs(pixels[i]);
+        if (a > maxAbs && std::isfinite(a))
+            maxAbs = a;
+    }
+    if (maxAbs == 0.0f)
+        return 0;
+
+    int32_t e = int32_t(std::floor(std::log2(double(HALF_MAX) / double(maxAbs))));
+    e = std::max(-120, std::min(120, e));
+    while (e > -120 && std::ldexp(double(maxAbs), e) > double(HALF_MAX))
+        --e;
+    return e;
+}
+
+} // namespace
+
+std::string PackedFramePath(const std::string& sourcePath)
+{
+    std::string directory, name;
+    SplitPath(sourcePath, directory, name);
+    return directory + "/" + PACKED_CACHE_DIRECTORY_NAME + "/" + name + ".bapack";
+}
+
+int OpenPackedFrame(const std::string& sourcePath, PackedCacheMode mode,
+                    uint64_t sourceSize, int64_t sourceModified, int64_t height, int64_t width,
+                    PackedFrameHeader& header)
+{
+    if (mode == PackedCacheMode::Off)
+        return -1;
+
+    int fd = open(PackedFramePath(sourcePath).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+    bool ok = pread(fd, &header, sizeof(header), 0) == ssize_t(sizeof(header))
+           && memcmp(header.magic, PACKED_MAGIC, sizeof(PACKED_MAGIC)) == 0
+           && header.version == PACKED_VERSION
+           && header.encoding == uint32_t(mode)
+           && header.height == height && header.width == width
+           && header.sourceSize == sourceSize && header.sourceModified == sourceModified
+           && fstat(fd, &st) == 0
+           && uint64_t(st.st_size) >= PACKED_FRAME_PAYLOAD_OFFSET + header.PayloadBytes();
+    if (!ok)
+    {
+        close(fd);
+        return -1;
+    }
+
+    // Start paging the entry in while earlier frames are being consumed (not on macOS,
+    // which has no posix_fadvise)
+#if defined(POSIX_FADV_WILLNEED)
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+    return fd;
+}
+
+bool MapPackedFrame(int fd, const PackedFrameHeader& header, PackedFrameMapping& mapping, std::string& error)
+{
+    mapping.header = header;
+    mapping.length = PACKED_FRAME_PAYLOAD_OFFSET + header.PayloadBytes();
+    mapping.address = mmap(nullptr, mapping.length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping.address == MAP_FAILED)
+    {
+        mapping.address = nullptr;
+        error = std::string("mmap failed: ") + strerror(errno);
+        return false;
+    }
+    madvise(mapping.address, mapping.length, MADV_SEQUENTIAL);
+
+    mapping.payload = static_cast<const uint8_t*>(mapping.address) + PACKED_FRAME_PAYLOAD_OFFSET;
+    if (HashPackedPayload(mapping.payload, header.PayloadBytes()) != header.hash)
+    {
+        UnmapPackedFrame(mapping);
+        error = "content hash mismatch";
+        return false;
+    }
+    return true;
+}
+
+void UnmapPackedFrame(PackedFrameMapping& mapping)
+{
+    if (mapping.address != nullptr)
+        munmap(mapping.address, mapping.length);
+    mapping.address = nullptr;
+    mapping.length = 0;
+    mapping.payload = nullptr;
+}
+
+void DecodePackedFrame(const PackedFrameMapping& mapping, float* pixels, size_t first, size_t count)
+{
+    if (mapping.header.encoding == uint32_t(PackedCacheMode::Float32))
+    {
+        memcpy(pixels, static_cast<const float*>(mapping.payload) + first, count * sizeof(float));
+        return;
+    }
+
+    // One table lookup per sample, with the frame's scale folded into the table
+    std::vector<float> table(65536);
+    const float scale = std::ldexp(1.0f, -mapping.header.scaleExponent);
+    for (size_t h = 0; h < table.size(); ++h)
+        table[h] = HalfToFloat(uint16_t(h)) * scale;
+
+    const uint16_t* in = static_cast<const uint16_t*>(mapping.payload) + first;
+    for (size_t i = 0; i < count; ++i)
+        pixels[i] = table[in[i]];
+}
+
+bool WritePackedFrame(const std::string& sourcePath, PackedCacheMode mode,
+                      uint64_t sourceSize, int64_t sourceModified,
+                      const float* pixels, int64_t height, int64_t width, std::string& error)
+{
+    if (mode == PackedCacheMode::Off)
+        return true;
+
+    std::string directory, name;
+    SplitPath(sourcePath, directory, name);
+    std::string cacheDirectory = directory + "/" + PACKED_CACHE_DIRECTORY_NAME;
+    if (mkdir(cacheDirectory.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        error = "Cannot create " + cacheDirectory + ": " + strerror(errno);
+        return false;
+    }
+
+    PackedFrameHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PACKED_MAGIC, sizeof(PACKED_MAGIC));
+    header.version = PACKED_VERSION;
+    header.encoding = uint32_t(mode);
+    header.height = height;
+    header.width = width;
+    header.sourceSize = sourceSize;
+    header.sourceModified = sourceModified;
+
+    const size_t count = size_t(height * width);
+    std::vector<uint16_t> half;
+    const void* payload = pixels;
+    if (mode == PackedCacheMode::Float16)
+    {
+        header.scaleExponent = HalfScaleExponent(pixels, count);
+        const float scale = std::ldexp(1.0f, header.scaleExponent);
+        half.resize(count);
+        for (size_t i = 0; i < count; ++i)
+            half[i] = FloatToHalf(pixels[i] * scale);
+        payload = half.data();
+    }
+    header.hash = HashPackedPayload(payload, header.PayloadBytes());
+
+    uint8_t prefix[PACKED_FRAME_PAYLOAD_OFFSET] = {};
+    memcpy(prefix, &header, sizeof(header));
+
+    // Write to a temporary and rename, so an interrupted run never leaves a torn entry
+    std::string path = cacheDirectory + "/" + name + ".bapack";
+    std::string temp = path + ".tmp." + std::to_string(getpid());
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        error = "Cannot create " + temp + ": " + strerror(errno);
+        return false;
+    }
+
+    bool ok = WriteAll(fd, prefix, sizeof(prefix)) && WriteAll(fd, payload, header.PayloadBytes());
+    if (!ok)
+        error = "Cannot write " + temp + ": " + strerror(errno);
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(temp.c_str(), path.c_str()) != 0)
+    {
+        if (error.empty())
+            error = "Cannot write " + path + ": " + strerror(errno);
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+uint64_t HashPackedPayload(const void* data, size_t length)
+{
+    constexpr uint64_t P1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4FULL;
+
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t lanes[4] = { P1 + P2, P2, 0, 0 - P1 };
+
+    // Independent lanes keep the multipliers busy; the hash runs at memory bandwidth
+    size_t blocks = length / 32;
+    for (size_t b = 0; b < blocks; ++b, p += 32)
+    {
+        for (int k = 0; k < 4; ++k)
+        {
+            uint64_t w;
+            memcpy(&w, p + 8 * k, sizeof(w));
+            lanes[k] = Rotl(lanes[k] + w * P2, 31) * P1;
+        }
+    }
+
+    uint64_t h = uint64_t(length) * P1;
+    for (int k = 0; k < 4; ++k)
+        h = (h ^ Rotl(lanes[k], 7 * k + 1)) * P2;
+    for (size_t i = 0; i < length % 32; ++i)
+        h = (h ^ p[i]) * P1;
+
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    return h;
+}
+
+uint16_t FloatToHalf(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    const uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+    uint32_t a = bits & 0x7FFFFFFF;
+
+    if (a >= 0x7F800000)                // Infinity or NaN (keep NaN quiet)
+        return sign | 0x7C00 | (a > 0x7F800000 ? 0x0200 : 0);
+    if (a >= 0x477FF000)                // Rounds to 65520 or above
+        return sign | 0x7C00;
+    if (a < 0x38800000)                 // Below the smallest normal half: subnormal or zero
+    {
+        float f;
+        memcpy(&f, &a, sizeof(f));
+        return sign | uint16_t(std::nearbyint(f * 16777216.0f));
+    }
+
+    // Rebias the exponent and round the significand to 10 bits, ties to even
+    a += 0xC8000FFF + ((a >> 13) & 1);
+    return sign | uint16_t(a >> 13);
+}
+
+float HalfToFloat(uint16_t h)
+{
+    const uint32_t sign = uint32_t(h & 0x8000) << 16;
+    const uint32_t exponent = (h >> 10) & 0x1F;
+    const uint32_t mantissa = h & 0x3FF;
+
+    uint32_t bits;
+    if (exponent == 0)
+    {
+        float f = float(mantissa) * (1.0f / 16777216.0f);
+        memcpy(&bits, &f, sizeof(bits));
+        bits |= sign;
+    }
+    else if (exponent == 31)
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    else
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+} // namespace pcl
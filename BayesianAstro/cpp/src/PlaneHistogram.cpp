@@ -0,0 +1,343 @@
+/**
+ * Plane Histogram Implementation
+ */
+
+#include "PlaneHistogram.h"
+#include "TraceTimeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+namespace pcl
+{
+
+const double HISTOGRAM_PERCENTILES[HISTOGRAM_PERCENTILE_COUNT] = { 0.1, 1, 5, 25, 50, 75, 95, 99, 99.9 };
+
+namespace
+{
+
+const char* const PLANE_NAMES[int(HistogramPlane::Count)] = { "fused", "confidence", "variance" };
+
+const char HISTOGRAM_MAGIC[4] = { 'B', 'A', 'H', '1' };
+constexpr size_t HISTOGRAM_HEADER_BYTES = 56 + 4 * HISTOGRAM_PERCENTILE_COUNT;
+
+// Sample 'i' of the plane, as Welford.variance computes it for the variance
+inline float SourceSample(const HistogramSource& source, size_t i)
+{
+    if (source.values != nullptr)
+        return source.values[i];
+    return source.n[i] < 2 ? 0.0f : source.m2[i] / float(source.n[i] - 1);
+}
+
+// Samples [offset, offset + count) of the plane: the plane itself, or computed into 'buffer'
+const float* SourceRun(const HistogramSource& source, size_t offset, size_t count, std::vector<float>& buffer)
+{
+    if (source.values != nullptr)
+        return source.values + offset;
+    buffer.resize(count);
+    for (size_t i = 0; i < count; ++i)
+        buffer[i] = SourceSample(source, offset + i);
+    return buffer.data();
+}
+
+template <typename T>
+void Append(std::string& out, T value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+} // namespace
+
+// Running sums of one worker, merged into the histogram's at the end
+struct PlaneHistogram::Totals
+{
+    std::vector<uint64_t> counts = std::vector<uint64_t>(HISTOGRAM_BINS, 0);
+    uint64_t below = 0;
+    uint64_t above = 0;
+    uint64_t nonFinite = 0;
+    std::vector<float> buffer;
+};
+
+const char* HistogramPlaneName(HistogramPlane plane)
+{
+    return plane >= HistogramPlane::Fused && plane < HistogramPlane::Count ? PLANE_NAMES[int(plane)] : "unknown";
+}
+
+bool ParseHistogramPlane(const std::string& name, HistogramPlane& plane)
+{
+    for (int i = 0; i < int(HistogramPlane::Count); ++i)
+        if (name == PLANE_NAMES[i])
+        {
+            plane = HistogramPlane(i);
+            return true;
+        }
+    return false;
+}
+
+void PlaneHistogram::Build(const HistogramSource& source, int threads)
+{
+    if (source.Empty())
+    {
+        Release();
+        return;
+    }
+
+    // Quantiles of an evenly spread sample, clipped at both ends
+    const size_t pixels = size_t(source.naxis1) * size_t(source.naxis2);
+    const size_t stride = std::max<size_t>(1, pixels / HISTOGRAM_RANGE_SAMPLES);
+    std::vector<float> sample;
+    sample.reserve(pixels / stride + 1);
+    for (size_t i = 0; i < pixels; i += stride)
+    {
+        const float v = SourceSample(source, i);
+        if (std::isfinite(v))
+            sample.push_back(v);
+    }
+
+    float low = 0.0f, high = 1.0f;
+    if (!sample.empty())
+    {
+        const size_t clipped = size_t(HISTOGRAM_RANGE_CLIP * double(sample.size() - 1));
+        std::nth_element(sample.begin(), sample.begin() + clipped, sample.end());
+        low = sample[clipped];
+        std::nth_element(sample.begin(), sample.end() - 1 - clipped, sample.end());
+        high = sample[sample.size() - 1 - clipped];
+        if (!(high > low))
+        {
+            // A constant plane still gets a range its value falls inside
+            const float pad = std::max(std::fabs(low), 1.0f) * 1e-3f;
+            low -= pad;
+            high += pad;
+        }
+    }
+    Build(source, low, high, threads);
+}
+
+void PlaneHistogram::Build(const HistogramSource& source, float low, float high, int threads)
+{
+    if (source.Empty() || !(high > low))
+    {
+        Release();
+        return;
+    }
+
+    m_naxis1 = source.naxis1;
+    m_naxis2 = source.naxis2;
+    m_tilesDown = (m_naxis1 + HISTOGRAM_TILE_SIZE - 1) / HISTOGRAM_TILE_SIZE;
+    m_tilesAcross = (m_naxis2 + HISTOGRAM_TILE_SIZE - 1) / HISTOGRAM_TILE_SIZE;
+    m_low = low;
+    m_high = high;
+    m_scale = float(HISTOGRAM_BINS / (double(high) - double(low)));
+
+    const int64_t tiles = m_tilesDown * m_tilesAcross;
+    m_tileBins.resize(size_t(tiles) * HISTOGRAM_BINS);
+    m_tiles.resize(size_t(tiles));
+
+    TraceScope trace(TraceCategory::Compute, "build histogram", "tiles", tiles);
+    const int workers = int(std::min<int64_t>(
+        threads > 0 ? threads : int(std::max(1u, std::thread::hardware_concurrency())), tiles));
+
+    // Workers take tiles in turn, each into its own totals
+    std::vector<Totals> totals(static_cast<size_t>(workers));
+    std::atomic<int64_t> next(0);
+    auto work = [&](int worker)
+    {
+        for (int64_t tile = next++; tile < tiles; tile = next++)
+            BinTile(source, tile, totals[size_t(worker)]);
+    };
+    std::vector<std::thread> pool;
+    for (int w = 1; w < workers; ++w)
+        pool.emplace_back(work, w);
+    work(0);
+    for (std::thread& thread : pool)
+        thread.join();
+
+    m_counts.assign(HISTOGRAM_BINS, 0);
+    m_below = m_above = m_nonFinite = 0;
+    for (const Totals& t : totals)
+    {
+        for (int b = 0; b < HISTOGRAM_BINS; ++b)
+            m_counts[size_t(b)] += t.counts[size_t(b)];
+        m_below += t.below;
+        m_above += t.above;
+        m_nonFinite += t.nonFinite;
+    }
+    UpdateExtremes();
+}
+
+void PlaneHistogram::Update(const HistogramSource& source, int64_t first1, int64_t count1, int64_t first2,
+                            int64_t count2)
+{
+    if (Empty() || source.Empty() || source.naxis1 != m_naxis1 || source.naxis2 != m_naxis2)
+        return;
+
+    const int64_t last1 = std::min(first1 + count1, m_naxis1);
+    const int64_t last2 = std::min(first2 + count2, m_naxis2);
+    first1 = std::max<int64_t>(first1, 0);
+    first2 = std::max<int64_t>(first2, 0);
+    if (first1 >= last1 || first2 >= last2)
+        return;
+
+    Totals added;
+    for (int64_t across = first2 / HISTOGRAM_TILE_SIZE; across <= (last2 - 1) / HISTOGRAM_TILE_SIZE; ++across)
+        for (int64_t down = first1 / HISTOGRAM_TILE_SIZE; down <= (last1 - 1) / HISTOGRAM_TILE_SIZE; ++down)
+        {
+            // Take the tile's old counts out of the totals, then bin it again
+            const int64_t tile = across * m_tilesDown + down;
+            const uint32_t* bins = m_tileBins.data() + size_t(tile) * HISTOGRAM_BINS;
+            for (int b = 0; b < HISTOGRAM_BINS; ++b)
+                m_counts[size_t(b)] -= bins[b];
+            const TileStats& stats = m_tiles[size_t(tile)];
+            m_below -= stats.below;
+            m_above -= stats.above;
+            m_nonFinite -= stats.nonFinite;
+            BinTile(source, tile, added);
+        }
+
+    for (int b = 0; b < HISTOGRAM_BINS; ++b)
+        m_counts[size_t(b)] += added.counts[size_t(b)];
+    m_below += added.below;
+    m_above += added.above;
+    m_nonFinite += added.nonFinite;
+    UpdateExtremes();
+}
+
+void PlaneHistogram::BinTile(const HistogramSource& source, int64_t tile, Totals& totals)
+{
+    const int64_t down = tile % m_tilesDown;
+    const int64_t across = tile / m_tilesDown;
+    const int64_t first1 = down * HISTOGRAM_TILE_SIZE;
+    const int64_t rows = std::min(HISTOGRAM_TILE_SIZE, m_naxis1 - first1);
+    const int64_t first2 = across * HISTOGRAM_TILE_SIZE;
+    const int64_t last2 = std::min(first2 + HISTOGRAM_TILE_SIZE, m_naxis2);
+
+    uint32_t* bins = m_tileBins.data() + size_t(tile) * HISTOGRAM_BINS;
+    std::fill(bins, bins + HISTOGRAM_BINS, 0u);
+    TileStats stats;
+    float lo = std::numeric_limits<float>::infinity();
+    float hi = -std::numeric_limits<float>::infinity();
+    const float low = m_low;
+    const float high = m_high;
+    const float scale = m_scale;
+
+    // Each tile column is a contiguous run of one plane column
+    for (int64_t column = first2; column < last2; ++column)
+    {
+        const float* in = SourceRun(source, size_t(column * m_naxis1 + first1), size_t(rows), totals.buffer);
+        for (int64_t i = 0; i < rows; ++i)
+        {
+            const float v = in[i];
+            if (!std::isfinite(v))
+            {
+                ++stats.nonFinite;
+                continue;
+            }
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+            if (v < low)
+                ++stats.below;
+            else if (v > high)
+                ++stats.above;
+            else
+                ++bins[std::min(int((v - low) * scale), HISTOGRAM_BINS - 1)];
+        }
+    }
+    stats.min = lo;
+    stats.max = hi;
+    m_tiles[size_t(tile)] = stats;
+
+    for (int b = 0; b < HISTOGRAM_BINS; ++b)
+        totals.counts[size_t(b)] += bins[b];
+    totals.below += stats.below;
+    totals.above += stats.above;
+    totals.nonFinite += stats.nonFinite;
+}
+
+void PlaneHistogram::UpdateExtremes()
+{
+    float lo = std::numeric_limits<float>::infinity();
+    float hi = -std::numeric_limits<float>::infinity();
+    for (const TileStats& stats : m_tiles)
+    {
+        lo = std::min(lo, stats.min);
+        hi = std::max(hi, stats.max);
+    }
+    m_samples = uint64_t(m_naxis1) * uint64_t(m_naxis2) - m_nonFinite;
+    m_min = m_samples > 0 ? lo : std::numeric_limits<float>::quiet_NaN();
+    m_max = m_samples > 0 ? hi : std::numeric_limits<float>::quiet_NaN();
+}
+
+void PlaneHistogram::Release()
+{
+    std::vector<uint32_t>().swap(m_tileBins);
+    std::vector<TileStats>().swap(m_tiles);
+    std::vector<uint64_t>().swap(m_counts);
+    m_naxis1 = m_naxis2 = m_tilesDown = m_tilesAcross = 0;
+    m_samples = m_below = m_above = m_nonFinite = 0;
+    m_min = m_max = std::numeric_limits<float>::quiet_NaN();
+}
+
+double PlaneHistogram::Percentile(double percent) const
+{
+    if (m_samples == 0)
+        return std::numeric_limits<double>::quiet_NaN();
+
+    // Rank of the percentile, walked through below, the bins and above in turn; each
+    // bucket's samples are taken as spread evenly over its span
+    const double target = std::min(std::max(percent, 0.0), 100.0) / 100.0 * double(m_samples);
+    double value = m_max;
+    double seen = 0.0;
+    if (m_below > 0 && target <= double(m_below))
+        value = m_min + (double(m_low) - m_min) * (target / double(m_below));
+    else
+    {
+        seen = double(m_below);
+        const double width = (double(m_high) - double(m_low)) / HISTOGRAM_BINS;
+        int b = 0;
+        for (; b < HISTOGRAM_BINS; ++b)
+        {
+            const double count = double(m_counts[size_t(b)]);
+            if (count > 0.0 && seen + count >= target)
+            {
+                value = m_low + width * (b + (target - seen) / count);
+                break;
+            }
+            seen += count;
+        }
+        if (b == HISTOGRAM_BINS && m_above > 0)
+            value = m_high + (double(m_max) - m_high) * std::min((target - seen) / double(m_above), 1.0);
+    }
+    return std::min(std::max(value, double(m_min)), double(m_max));
+}
+
+void PlaneHistogram::Serialize(std::string& out) const
+{
+    out.clear();
+    out.reserve(HISTOGRAM_HEADER_BYTES + m_counts.size() * sizeof(uint32_t));
+    out.append(HISTOGRAM_MAGIC, 4);
+    Append(out, uint32_t(m_counts.size()));
+    Append(out, m_low);
+    Append(out, m_high);
+    Append(out, m_min);
+    Append(out, m_max);
+    Append(out, m_samples);
+    Append(out, m_below);
+    Append(out, m_above);
+    Append(out, m_nonFinite);
+    for (double percent : HISTOGRAM_PERCENTILES)
+        Append(out, float(Percentile(percent)));
+    for (uint64_t count : m_counts)
+        Append(out, uint32_t(std::min<uint64_t>(count, std::numeric_limits<uint32_t>::max())));
+}
+
+uint64_t PlaneHistogram::Bytes() const
+{
+    return m_tileBins.capacity() * sizeof(uint32_t) + m_tiles.capacity() * sizeof(TileStats) +
+           m_counts.capacity() * sizeof(uint64_t);
+}
+
+} // namespace pcl
@@ -0,0 +1,574 @@
+/**
+ * Preview Tiles Implementation
+ */
+
+#include "PreviewTiles.h"
+#include "StackKernels.h"
+#include "TraceTimeline.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace pcl
+{
+
+namespace
+{
+
+const char* const PLANE_NAMES[int(PreviewPlane::Count)] = { "fused", "confidence", "classification" };
+
+// One colour per DistributionCode; 0 is "no data"
+const uint8_t CLASS_PALETTE[8][3] = {
+    {   0,   0,   0 },      // No data
+    {  64, 160,  96 },      // Gaussian
+    {  64, 128, 224 },      // Poisson
+    { 224, 160,  32 },      // Bimodal
+    { 208,  64,  64 },      // SkewedRight
+    { 176,  64, 176 },      // SkewedLeft
+    { 224, 224, 224 },      // Uniform
+    {  96,  96,  96 },      // Unknown
+};
+
+// Automatic STF defaults: shadows 2.8 normalized MADs below the median, background at 0.25
+constexpr double STF_SHADOWS_CLIPPING = -2.8;
+constexpr double STF_TARGET_BACKGROUND = 0.25;
+constexpr double MAD_TO_SIGMA = 1.4826;
+
+// Pyramid rows per worker below which a level is decimated on fewer threads
+constexpr int64_t PYRAMID_MIN_ROWS = 64;
+
+const uint8_t PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+// PNG row filter types
+constexpr uint8_t PNG_FILTER_NONE = 0;
+constexpr uint8_t PNG_FILTER_SUB = 1;
+
+void AppendBigEndian(std::string& out, uint32_t value)
+{
+    const char bytes[4] = { char(value >> 24), char(value >> 16), char(value >> 8), char(value) };
+    out.append(bytes, 4);
+}
+
+void AppendChunk(std::string& png, const char type[4], const uint8_t* data, size_t size)
+{
+    AppendBigEndian(png, uint32_t(size));
+    const size_t start = png.size();
+    png.append(type, 4);
+    if (size > 0)
+        png.append(reinterpret_cast<const char*>(data), size);
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, reinterpret_cast<const Bytef*>(png.data() + start), uInt(png.size() - start));
+    AppendBigEndian(png, uint32_t(crc));
+}
+
+double MidtonesTransfer(double midtones, double x)
+{
+    if (x <= 0.0)
+        return 0.0;
+    if (x >= 1.0)
+        return 1.0;
+    return (midtones - 1.0) * x / ((2.0 * midtones - 1.0) * x - midtones);
+}
+
+// Sample positions along one axis for 'count' display pixels starting at 'origin';
+// taps outside the image are -1
+void PlaceTaps(std::vector<int64_t>& taps, int64_t origin, int count, int64_t step, int perAxis, int64_t limit)
+{
+    taps.resize(size_t(count) * size_t(perAxis));
+    for (int i = 0; i < count; ++i)
+    {
+        const int64_t first = (origin + i) * step;
+        for (int t = 0; t < perAxis; ++t)
+        {
+            const int64_t position = first + (2 * t + 1) * step / (2 * perAxis);
+            taps[size_t(i) * size_t(perAxis) + size_t(t)] = position < limit ? position : -1;
+        }
+    }
+}
+
+// Display size along one axis at 'level'
+int64_t LevelSize(int64_t size, int level)
+{
+    const int64_t step = int64_t(1) << level;
+    return (size + step - 1) / step;
+}
+
+// Run body(first, last) over [0, rows) in contiguous ranges on up to 'workers' threads;
+// levels too small to be worth a thread run on the caller
+template <typename Body>
+void ParallelRows(int64_t rows, int workers, Body body)
+{
+    const int64_t threads = std::max<int64_t>(1, std::min<int64_t>(workers, rows / PYRAMID_MIN_ROWS));
+    std::vector<std::thread> pool;
+    for (int64_t t = 1; t < threads; ++t)
+        pool.emplace_back(body, rows * t / threads, rows * (t + 1) / threads);
+    body(0, rows / threads);
+    for (std::thread& thread : pool)
+        thread.join();
+}
+
+} // namespace
+
+const char* PreviewPlaneName(PreviewPlane plane)
+{
+    return plane >= PreviewPlane::Fused && plane < PreviewPlane::Count ? PLANE_NAMES[int(plane)] : "unknown";
+}
+
+bool ParsePreviewPlane(const std::string& name, PreviewPlane& plane)
+{
+    for (int i = 0; i < int(PreviewPlane::Count); ++i)
+        if (name == PLANE_NAMES[i])
+        {
+            plane = PreviewPlane(i);
+            return true;
+        }
+    return false;
+}
+
+bool EncodePng(const uint8_t* pixels, int width, int height, const uint8_t* palette, int colors,
+               std::string& png)
+{
+    if (width <= 0 || height <= 0 || (palette != nullptr && (colors < 1 || colors > 256)))
+        return false;
+
+    // Sub filtering suits smooth greyscale; palette indices compress better unfiltered
+    const size_t stride = size_t(width) + 1;
+    std::vector<uint8_t> raw(stride * size_t(height));
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* in = pixels + size_t(y) * size_t(width);
+        uint8_t* out = raw.data() + size_t(y) * stride;
+        if (palette != nullptr)
+        {
+            out[0] = PNG_FILTER_NONE;
+            memcpy(out + 1, in, size_t(width));
+        }
+        else
+        {
+            out[0] = PNG_FILTER_SUB;
+            out[1] = in[0];
+            for (int x = 1; x < width; ++x)
+                out[1 + x] = uint8_t(in[x] - in[x - 1]);
+        }
+    }
+
+    // Run-length deflate: after the Sub filter, sky tiles are mostly noise (where string
+    // matching buys nothing) and runs of flat background, and it is the fastest strategy
+    std::vector<uint8_t> compressed(compressBound(uLong(raw.size())));
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, 15, 8, Z_RLE) != Z_OK)
+        return false;
+    stream.next_in = raw.data();
+    stream.avail_in = uInt(raw.size());
+    stream.next_out = compressed.data();
+    stream.avail_out = uInt(compressed.size());
+    const bool deflated = deflate(&stream, Z_FINISH) == Z_STREAM_END;
+    const size_t compressedSize = stream.total_out;
+    deflateEnd(&stream);
+    if (!deflated)
+        return false;
+
+    uint8_t header[13];
+    const uint32_t dimensions[2] = { uint32_t(width), uint32_t(height) };
+    for (int i = 0; i < 2; ++i)
+        for (int b = 0; b < 4; ++b)
+            header[i * 4 + b] = uint8_t(dimensions[i] >> (24 - 8 * b));
+    header[8] = 8;                              // Bit depth
+    header[9] = palette != nullptr ? 3 : 0;     // Indexed or greyscale
+    header[10] = header[11] = header[12] = 0;   // Deflate, adaptive filtering, no interlace
+
+    png.clear();
+    png.reserve(sizeof(PNG_SIGNATURE) + 64 + size_t(colors) * 3 + compressedSize);
+    png.append(reinterpret_cast<const char*>(PNG_SIGNATURE), sizeof(PNG_SIGNATURE));
+    AppendChunk(png, "IHDR", header, sizeof(header));
+    if (palette != nullptr)
+        AppendChunk(png, "PLTE", palette, size_t(colors) * 3);
+    AppendChunk(png, "IDAT", compressed.data(), compressedSize);
+    AppendChunk(png, "IEND", nullptr, 0);
+    return true;
+}
+
+int PreviewLevelCount(int64_t naxis1, int64_t naxis2)
+{
+    if (naxis1 <= 0 || naxis2 <= 0)
+        return 0;
+    int levels = 1;
+    while (LevelSize(naxis1, levels - 1) > PREVIEW_TILE_SIZE || LevelSize(naxis2, levels - 1) > PREVIEW_TILE_SIZE)
+        ++levels;
+    return levels;
+}
+
+// ----------------------------------------------------------------------------
+
+void PreviewStretch::Fit(const float* fused, size_t pixels)
+{
+    TraceScope trace(TraceCategory::Compute, "fit preview stretch");
+    *this = PreviewStretch();
+
+    const size_t stride = std::max<size_t>(1, pixels / PREVIEW_STRETCH_SAMPLES);
+    std::vector<float> sample;
+    sample.reserve(pixels / stride + 1);
+    for (size_t i = 0; i < pixels; i += stride)
+        if (std::isfinite(fused[i]))
+            sample.push_back(fused[i]);
+    if (sample.empty())
+        return;
+
+    float lo, hi;
+    PlaneMinMax(sample.data(), sample.size(), lo, hi);
+    low = lo;
+    scale = hi > lo ? 1.0f / (hi - lo) : 1.0f;
+    for (float& v : sample)
+        v = (v - low) * scale;
+
+    const size_t middle = sample.size() / 2;
+    std::nth_element(sample.begin(), sample.begin() + middle, sample.end());
+    const double median = sample[middle];
+    for (float& v : sample)
+        v = float(std::fabs(v - median));
+    std::nth_element(sample.begin(), sample.begin() + middle, sample.end());
+    const double mad = MAD_TO_SIGMA * sample[middle];
+
+    const double clipped = std::min(std::max(median + STF_SHADOWS_CLIPPING * mad, 0.0), 1.0);
+    shadows = float(clipped);
+    // The midtones balance that maps the clipped median to the target background
+    if (median > clipped)
+        midtones = float(MidtonesTransfer(STF_TARGET_BACKGROUND, median - clipped));
+}
+
+void PreviewStretch::Apply(const float* in, uint8_t* out, int count) const
+{
+    // Single precision and branch-free apart from NaN (black), so the loop vectorizes
+    const float l = low;
+    const float s = scale;
+    const float c = shadows;
+    const float clip = c < 1.0f ? 1.0f / (1.0f - c) : 0.0f;
+    const float m = midtones;
+    for (int i = 0; i < count; ++i)
+    {
+        float x = ((in[i] - l) * s - c) * clip;
+        x = std::min(std::max(x, 0.0f), 1.0f);
+        const float y = (m - 1.0f) * x / ((2.0f * m - 1.0f) * x - m);
+        out[i] = in[i] == in[i] ? uint8_t(y * 255.0f + 0.5f) : 0;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void PreviewPyramid::Build(const PreviewSource& source, int threads)
+{
+    m_naxis1 = source.naxis1;
+    m_naxis2 = source.naxis2;
+    for (auto& levels : m_levels)
+        for (auto& level : levels)
+            level.clear();
+    const int levelCount = PreviewLevelCount(m_naxis1, m_naxis2);
+    if (levelCount <= 1)
+        return;
+
+    TraceScope trace(TraceCategory::Compute, "build preview pyramid", "levels", levelCount);
+    const int workers = threads > 0 ? threads : int(std::max(1u, std::thread::hardware_concurrency()));
+    if (source.fused != nullptr)
+        m_stretch.Fit(source.fused, size_t(m_naxis1) * size_t(m_naxis2));
+
+    for (int p = 0; p < int(PreviewPlane::Count); ++p)
+    {
+        const PreviewPlane plane = PreviewPlane(p);
+        const void* base = plane == PreviewPlane::Fused ? static_cast<const void*>(source.fused)
+                         : plane == PreviewPlane::Confidence ? static_cast<const void*>(source.confidence)
+                         : static_cast<const void*>(source.classification);
+        if (base == nullptr)
+            continue;
+        std::vector<std::vector<uint8_t>>& levels = m_levels[p];
+        levels.resize(size_t(levelCount - 1));
+
+        const float* above = static_cast<const float*>(base);
+        const uint8_t* aboveClasses = static_cast<const uint8_t*>(base);
+        for (int level = 1; level < levelCount; ++level)
+        {
+            const int64_t aboveWidth = LevelSize(m_naxis1, level - 1);
+            const int64_t aboveHeight = LevelSize(m_naxis2, level - 1);
+            const int64_t width = LevelSize(m_naxis1, level);
+            const int64_t height = LevelSize(m_naxis2, level);
+            std::vector<uint8_t>& bytes = levels[size_t(level - 1)];
+            bytes.resize(size_t(width * height));
+
+            if (plane == PreviewPlane::Classification)
+            {
+                // Most frequent class of each block; averaging codes would invent classes
+                ParallelRows(height, workers, [&](int64_t first, int64_t last)
+                {
+                    for (int64_t y = first; y < last; ++y)
+                        for (int64_t x = 0; x < width; ++x)
+                        {
+                            int counts[8] = {};
+                            for (int64_t by = 2 * y; by < std::min(2 * y + 2, aboveHeight); ++by)
+                                for (int64_t bx = 2 * x; bx < std::min(2 * x + 2, aboveWidth); ++bx)
+                                    ++counts[aboveClasses[by * aboveWidth + bx] & 7];
+                            bytes[size_t(y * width + x)] = uint8_t(std::max_element(counts, counts + 8) - counts);
+                        }
+                });
+                aboveClasses = bytes.data();
+                continue;
+            }
+
+            // Float levels ping-pong between the scratch buffers; only bytes are kept
+            std::vector<float>& below = m_scratch[(level - 1) & 1];
+            below.resize(size_t(width * height));
+            ParallelRows(height, workers, [&](int64_t first, int64_t last)
+            {
+                for (int64_t y = first; y < last; ++y)
+                {
+                    const float* row0 = above + size_t(2 * y * aboveWidth);
+                    const float* row1 = 2 * y + 1 < aboveHeight ? row0 + aboveWidth : nullptr;
+                    float* out = below.data() + size_t(y * width);
+                    for (int64_t x = 0; x < width; ++x)
+                    {
+                        const int64_t bx = 2 * x;
+                        const bool pair = bx + 1 < aboveWidth;
+                        float sum = 0.0f;
+                        int n = 0;
+                        auto add = [&](float v)
+                        {
+                            if (std::isfinite(v))
+                            {
+                                sum += v;
+                                ++n;
+                            }
+                        };
+                        add(row0[bx]);
+                        if (pair)
+                            add(row0[bx + 1]);
+                        if (row1 != nullptr)
+                        {
+                            add(row1[bx]);
+                            if (pair)
+                                add(row1[bx + 1]);
+                        }
+                        out[x] = n > 0 ? sum / float(n) : NAN;
+                    }
+
+                    uint8_t* display = bytes.data() + size_t(y * width);
+                    if (plane == PreviewPlane::Fused)
+                        m_stretch.Apply(out, display, int(width));
+                    else
+                        for (int64_t x = 0; x < width; ++x)
+                            display[x] = out[x] == out[x]
+                                       ? uint8_t(std::min(std::max(out[x], 0.0f), 1.0f) * 255.0f + 0.5f) : 0;
+                }
+            });
+            above = below.data();
+        }
+    }
+}
+
+void PreviewPyramid::Release()
+{
+    for (auto& levels : m_levels)
+        std::vector<std::vector<uint8_t>>().swap(levels);
+    for (auto& scratch : m_scratch)
+        std::vector<float>().swap(scratch);
+    m_naxis1 = 0;
+    m_naxis2 = 0;
+}
+
+const uint8_t* PreviewPyramid::Level(PreviewPlane plane, int level) const
+{
+    if (plane < PreviewPlane::Fused || plane >= PreviewPlane::Count || level < 1)
+        return nullptr;
+    const std::vector<std::vector<uint8_t>>& levels = m_levels[int(plane)];
+    if (size_t(level - 1) >= levels.size() || levels[size_t(level - 1)].empty())
+        return nullptr;
+    return levels[size_t(level - 1)].data();
+}
+
+uint64_t PreviewPyramid::Bytes() const
+{
+    uint64_t bytes = 0;
+    for (const auto& levels : m_levels)
+        for (const auto& level : levels)
+            bytes += level.size();
+    return bytes;
+}
+
+// ----------------------------------------------------------------------------
+
+void PreviewTiler::SetSource(const PreviewSource& source)
+{
+    m_source = source;
+    m_stretchFitted = false;
+}
+
+const PreviewPyramid* PreviewTiler::Pyramid() const
+{
+    const PreviewPyramid* pyramid = m_source.pyramid;
+    return pyramid != nullptr && pyramid->Naxis1() == m_source.naxis1 && pyramid->Naxis2() == m_source.naxis2
+         ? pyramid : nullptr;
+}
+
+int PreviewTiler::Levels() const
+{
+    return m_source.Empty() ? 0 : PreviewLevelCount(m_source.naxis1, m_source.naxis2);
+}
+
+int64_t PreviewTiler::LevelWidth(int level) const
+{
+    return LevelSize(m_source.naxis1, level);
+}
+
+int64_t PreviewTiler::LevelHeight(int level) const
+{
+    return LevelSize(m_source.naxis2, level);
+}
+
+int64_t PreviewTiler::TilesAcross(int level) const
+{
+    return (LevelWidth(level) + PREVIEW_TILE_SIZE - 1) / PREVIEW_TILE_SIZE;
+}
+
+int64_t PreviewTiler::TilesDown(int level) const
+{
+    return (LevelHeight(level) + PREVIEW_TILE_SIZE - 1) / PREVIEW_TILE_SIZE;
+}
+
+bool PreviewTiler::RenderTile(PreviewPlane plane, int level, int64_t tileX, int64_t tileY, std::string& png,
+                              std::string& error)
+{
+    if (m_source.Empty())
+    {
+        error = "no preview available";
+        return false;
+    }
+    if (plane < PreviewPlane::Fused || plane >= PreviewPlane::Count
+        || level < 0 || level >= Levels()
+        || tileX < 0 || tileX >= TilesAcross(level) || tileY < 0 || tileY >= TilesDown(level))
+    {
+        error = "no such tile";
+        return false;
+    }
+    if ((plane == PreviewPlane::Fused && m_source.fused == nullptr)
+        || (plane == PreviewPlane::Confidence && m_source.confidence == nullptr)
+        || (plane == PreviewPlane::Classification && m_source.classification == nullptr))
+    {
+        error = "plane not in this preview";
+        return false;
+    }
+
+    TraceScope trace(TraceCategory::Compute, "render preview tile", "level", level);
+    const PreviewPyramid* pyramid = Pyramid();
+    if (plane == PreviewPlane::Fused && !m_stretchFitted)
+    {
+        if (pyramid != nullptr)
+            m_stretch = pyramid->Stretch();
+        else
+            m_stretch.Fit(m_source.fused, size_t(m_source.naxis1) * size_t(m_source.naxis2));
+        m_stretchFitted = true;
+    }
+
+    const int width = int(std::min<int64_t>(PREVIEW_TILE_SIZE, LevelWidth(level) - tileX * PREVIEW_TILE_SIZE));
+    const int height = int(std::min<int64_t>(PREVIEW_TILE_SIZE, LevelHeight(level) - tileY * PREVIEW_TILE_SIZE));
+    m_pixels.resize(size_t(width) * size_t(height));
+    const bool indexed = plane == PreviewPlane::Classification;
+
+    // Reduced levels of a result are ready-made display bytes: copy the tile's rows
+    const uint8_t* prebuilt = pyramid != nullptr ? pyramid->Level(plane, level) : nullptr;
+    if (prebuilt != nullptr)
+    {
+        const int64_t levelWidth = LevelWidth(level);
+        for (int y = 0; y < height; ++y)
+            memcpy(m_pixels.data() + size_t(y) * size_t(width),
+                   prebuilt + size_t((tileY * PREVIEW_TILE_SIZE + y) * levelWidth + tileX * PREVIEW_TILE_SIZE),
+                   size_t(width));
+        if (!EncodePng(m_pixels.data(), width, height, indexed ? &CLASS_PALETTE[0][0] : nullptr, indexed ? 8 : 0, png))
+        {
+            error = "PNG encoding failed";
+            return false;
+        }
+        return true;
+    }
+
+    const int64_t step = int64_t(1) << level;
+    const int perAxis = int(std::min<int64_t>(step, PREVIEW_MAX_TAPS));
+    PlaceTaps(m_tapsX, tileX * PREVIEW_TILE_SIZE, width, step, perAxis, m_source.naxis1);
+    PlaceTaps(m_tapsY, tileY * PREVIEW_TILE_SIZE, height, step, perAxis, m_source.naxis2);
+    m_row.resize(size_t(width));
+    const float* data = plane == PreviewPlane::Fused ? m_source.fused : m_source.confidence;
+    for (int y = 0; y < height; ++y)
+    {
+        const int64_t* rowTaps = m_tapsY.data() + size_t(y) * size_t(perAxis);
+        uint8_t* out = m_pixels.data() + size_t(y) * size_t(width);
+
+        if (plane == PreviewPlane::Classification)
+        {
+            // Most frequent class among the taps; averaging codes would invent classes
+            for (int x = 0; x < width; ++x)
+            {
+                const int64_t* columnTaps = m_tapsX.data() + size_t(x) * size_t(perAxis);
+                int counts[8] = {};
+                for (int ty = 0; ty < perAxis && rowTaps[ty] >= 0; ++ty)
+                {
+                    const uint8_t* row = m_source.classification + size_t(rowTaps[ty]) * size_t(m_source.naxis1);
+                    for (int tx = 0; tx < perAxis && columnTaps[tx] >= 0; ++tx)
+                        ++counts[row[columnTaps[tx]] & 7];
+                }
+                out[x] = uint8_t(std::max_element(counts, counts + 8) - counts);
+            }
+            continue;
+        }
+
+        // At full resolution a tile row is a contiguous run of one plane column
+        const float* row;
+        if (perAxis == 1)
+        {
+            row = data + size_t(rowTaps[0]) * size_t(m_source.naxis1) + size_t(m_tapsX[0]);
+        }
+        else
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                const int64_t* columnTaps = m_tapsX.data() + size_t(x) * size_t(perAxis);
+                float sum = 0.0f;
+                int n = 0;
+                for (int ty = 0; ty < perAxis && rowTaps[ty] >= 0; ++ty)
+                {
+                    const float* taps = data + size_t(rowTaps[ty]) * size_t(m_source.naxis1);
+                    for (int tx = 0; tx < perAxis && columnTaps[tx] >= 0; ++tx)
+                    {
+                        const float v = taps[columnTaps[tx]];
+                        if (std::isfinite(v))
+                        {
+                            sum += v;
+                            ++n;
+                        }
+                    }
+                }
+                m_row[size_t(x)] = n > 0 ? sum / float(n) : NAN;
+            }
+            row = m_row.data();
+        }
+
+        if (plane == PreviewPlane::Fused)
+        {
+            m_stretch.Apply(row, out, width);
+        }
+        else
+        {
+            for (int x = 0; x < width; ++x)
+                out[x] = row[x] == row[x] ? uint8_t(std::min(std::max(row[x], 0.0f), 1.0f) * 255.0f + 0.5f) : 0;
+        }
+    }
+
+    if (!EncodePng(m_pixels.data(), width, height, indexed ? &CLASS_PALETTE[0][0] : nullptr, indexed ? 8 : 0, png))
+    {
+        error = "PNG encoding failed";
+        return false;
+    }
+    return true;
+}
+
+} // namespace pcl
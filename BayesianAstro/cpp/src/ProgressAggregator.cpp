@@ -0,0 +1,212 @@
+/**
+ * Progress Aggregator Implementation
+ */
+
+#include "ProgressAggregator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace pcl
+{
+
+namespace
+{
+
+int64_t NowNanoseconds()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+ProgressAggregator::ProgressAggregator()
+{
+    for (size_t i = 0; i < STATUS_WORDS; ++i)
+        m_status[i].store(0, std::memory_order_relaxed);
+}
+
+void ProgressAggregator::BeginRun(uint64_t frameCount)
+{
+    m_phase.store(int(RunPhase::Scan), std::memory_order_relaxed);
+    m_percent.store(0, std::memory_order_relaxed);
+    m_band.store(0, std::memory_order_relaxed);
+    m_bands.store(1, std::memory_order_relaxed);
+    m_frameCount.store(frameCount, std::memory_order_relaxed);
+    m_frames.store(0, std::memory_order_relaxed);
+    m_bytes.store(0, std::memory_order_relaxed);
+    m_endNanoseconds.store(0, std::memory_order_relaxed);
+    m_startNanoseconds.store(NowNanoseconds(), std::memory_order_relaxed);
+    m_running.store(true, std::memory_order_relaxed);
+    Touch();
+}
+
+void ProgressAggregator::EndRun()
+{
+    if (!m_running.load(std::memory_order_relaxed))
+        return;
+    m_endNanoseconds.store(NowNanoseconds(), std::memory_order_relaxed);
+    m_running.store(false, std::memory_order_relaxed);
+    Touch();
+}
+
+void ProgressAggregator::SetPhase(RunPhase phase)
+{
+    m_phase.store(int(phase), std::memory_order_relaxed);
+    Touch();
+}
+
+void ProgressAggregator::SetBand(int band, int bands)
+{
+    m_band.store(band, std::memory_order_relaxed);
+    m_bands.store(std::max(bands, 1), std::memory_order_relaxed);
+    Touch();
+}
+
+void ProgressAggregator::SetPercent(int percent)
+{
+    m_percent.store(std::min(std::max(percent, 0), 100), std::memory_order_relaxed);
+    Touch();
+}
+
+void ProgressAggregator::SetStatus(const char* status)
+{
+    char text[PROGRESS_STATUS_SIZE] = {};
+    strncpy(text, status, PROGRESS_STATUS_SIZE - 1);
+
+    // Odd sequence while the words are being replaced; the writer never waits on the reader
+    const uint32_t sequence = m_statusSequence.load(std::memory_order_relaxed);
+    m_statusSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < STATUS_WORDS; ++i)
+    {
+        uint64_t word;
+        memcpy(&word, text + i * sizeof(uint64_t), sizeof(word));
+        m_status[i].store(word, std::memory_order_relaxed);
+    }
+    m_statusSequence.store(sequence + 2, std::memory_order_release);
+    Touch();
+}
+
+void ProgressAggregator::AddFrames(uint64_t frames, uint64_t bytes)
+{
+    m_frames.fetch_add(frames, std::memory_order_relaxed);
+    m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    Touch();
+}
+
+bool ProgressAggregator::Sample(ProgressSnapshot& snapshot)
+{
+    const uint64_t version = m_version.load(std::memory_order_acquire);
+    const bool running = m_running.load(std::memory_order_relaxed);
+    if (!running && version == m_sampledVersion)
+        return false;
+    m_sampledVersion = version;
+
+    // Retry while a status write is in flight or overlapped the copy
+    char text[PROGRESS_STATUS_SIZE];
+    for (;;)
+    {
+        const uint32_t before = m_statusSequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0)
+            continue;
+        for (size_t i = 0; i < STATUS_WORDS; ++i)
+        {
+            const uint64_t word = m_status[i].load(std::memory_order_relaxed);
+            memcpy(text + i * sizeof(uint64_t), &word, sizeof(word));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_statusSequence.load(std::memory_order_relaxed) == before)
+            break;
+    }
+    text[PROGRESS_STATUS_SIZE - 1] = '\0';
+
+    const int64_t start = m_startNanoseconds.load(std::memory_order_relaxed);
+    const int64_t end = m_endNanoseconds.load(std::memory_order_relaxed);
+    if (start != m_sampledStart)
+    {
+        // A new run: rates start over
+        m_sampledStart = start;
+        m_sampledSeconds = 0.0;
+        m_sampledFrames = 0;
+        m_sampledBytes = 0;
+        m_framesPerSecond = m_bytesPerSecond = -1.0;
+    }
+
+    const int64_t now = running || end == 0 ? NowNanoseconds() : end;
+    const double elapsed = start == 0 ? 0.0 : double(now - start) * 1e-9;
+    const uint64_t frames = m_frames.load(std::memory_order_relaxed);
+    const uint64_t bytes = m_bytes.load(std::memory_order_relaxed);
+
+    if (!running)
+    {
+        // A finished run reports its averages
+        m_framesPerSecond = elapsed > 0.0 ? double(frames) / elapsed : 0.0;
+        m_bytesPerSecond = elapsed > 0.0 ? double(bytes) / elapsed : 0.0;
+    }
+    else if (elapsed > m_sampledSeconds)
+    {
+        const double interval = elapsed - m_sampledSeconds;
+        // Counters of a run that restarted mid-sample can read behind the last sample
+        const double framesPerSecond = double(frames > m_sampledFrames ? frames - m_sampledFrames : 0) / interval;
+        const double bytesPerSecond = double(bytes > m_sampledBytes ? bytes - m_sampledBytes : 0) / interval;
+        if (m_framesPerSecond < 0.0)
+        {
+            m_framesPerSecond = framesPerSecond;
+            m_bytesPerSecond = bytesPerSecond;
+        }
+        else
+        {
+            m_framesPerSecond += PROGRESS_RATE_SMOOTHING * (framesPerSecond - m_framesPerSecond);
+            m_bytesPerSecond += PROGRESS_RATE_SMOOTHING * (bytesPerSecond - m_bytesPerSecond);
+        }
+    }
+    m_sampledSeconds = elapsed;
+    m_sampledFrames = frames;
+    m_sampledBytes = bytes;
+
+    const uint64_t frameCount = m_frameCount.load(std::memory_order_relaxed);
+    snapshot.running = running;
+    snapshot.phase = RunPhase(m_phase.load(std::memory_order_relaxed));
+    snapshot.percent = m_percent.load(std::memory_order_relaxed);
+    snapshot.status = text;
+    snapshot.band = m_band.load(std::memory_order_relaxed);
+    snapshot.bands = m_bands.load(std::memory_order_relaxed);
+    snapshot.framesTotal = frameCount * uint64_t(snapshot.bands);
+    snapshot.framesDone = frames;
+    snapshot.elapsedSeconds = elapsed;
+    snapshot.framesPerSecond = std::max(m_framesPerSecond, 0.0);
+    snapshot.megabytesPerSecond = std::max(m_bytesPerSecond, 0.0) / 1048576.0;
+    snapshot.rssBytes = CurrentRssBytes();
+
+    // Per-frame steps publish only counters; the status line is composed here, once per sample
+    if (running && snapshot.phase == RunPhase::Accumulate && snapshot.band > 0 && frameCount > 0)
+    {
+        const uint64_t bandStart = uint64_t(snapshot.band - 1) * frameCount;
+        const uint64_t inBand = std::min<uint64_t>(frames > bandStart ? frames - bandStart : 0, frameCount);
+        char line[PROGRESS_STATUS_SIZE];
+        if (snapshot.bands > 1)
+            snprintf(line, sizeof(line), "Frame %llu/%llu, band %d/%d", (unsigned long long)inBand,
+                     (unsigned long long)frameCount, snapshot.band, snapshot.bands);
+        else
+            snprintf(line, sizeof(line), "Frame %llu/%llu", (unsigned long long)inBand,
+                     (unsigned long long)frameCount);
+        snapshot.status = line;
+    }
+
+    // Percent covers the whole run (scan, bands, finalize, write), so extrapolate it linearly
+    if (!running || snapshot.percent >= 100)
+        snapshot.etaSeconds = 0.0;
+    else if (snapshot.percent > 0)
+        snapshot.etaSeconds = elapsed * double(100 - snapshot.percent) / double(snapshot.percent);
+    else
+        snapshot.etaSeconds = std::numeric_limits<double>::quiet_NaN();
+
+    return true;
+}
+
+} // namespace pcl
@@ -0,0 +1,265 @@
+/**
+ * Run Metrics Implementation
+ */
+
+#include "RunMetrics.h"
+#include "WorkspaceArena.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define BA_HAVE_MALLINFO2 1
+#endif
+
+namespace pcl
+{
+
+namespace
+{
+
+double NowSeconds()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// A "<key>: <n> kB" line of /proc/self/status
+uint64_t StatusKilobytes(const char* key)
+{
+    FILE* f = fopen("/proc/self/status", "r");
+    if (f == nullptr)
+        return 0;
+
+    const size_t keyLength = strlen(key);
+    uint64_t kb = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f) != nullptr)
+    {
+        if (strncmp(line, key, keyLength) == 0 && line[keyLength] == ':')
+        {
+            unsigned long long value = 0;
+            if (sscanf(line + keyLength + 1, "%llu", &value) == 1)
+                kb = value;
+            break;
+        }
+    }
+    fclose(f);
+    return kb * 1024;
+}
+
+void AppendPhase(std::string& json, const char* name, const PhaseMetrics& p, bool counters, bool last)
+{
+    char text[512];
+    snprintf(text, sizeof(text),
+             "    \"%s\": {\"intervals\": %llu, \"seconds\": %.6f, \"peak_rss_bytes\": %llu, "
+             "\"arena_allocated_bytes\": %llu, \"heap_growth_bytes\": %lld, "
+             "\"julia_allocated_bytes\": %llu, \"julia_gc_seconds\": %.6f, "
+             "\"arena_high_water_bytes\": %llu",
+             name, (unsigned long long)p.intervals, p.seconds, (unsigned long long)p.peakRssBytes,
+             (unsigned long long)p.arenaAllocatedBytes, (long long)p.heapGrowthBytes,
+             (unsigned long long)p.juliaAllocatedBytes, p.juliaGcSeconds,
+             (unsigned long long)p.arenaHighWaterBytes);
+    json += text;
+
+    if (counters)
+    {
+        json += ",\n      \"counters\": " + p.counters.ToJson() + ",\n      \"threads\": [";
+        for (size_t i = 0; i < p.threads.size(); ++i)
+        {
+            const ThreadCounters& t = p.threads[i];
+            snprintf(text, sizeof(text), "%s\n        {\"tid\": %d, \"name\": \"", i > 0 ? "," : "", t.tid);
+            json += text;
+            for (char c : t.name)
+                if (c != '"' && c != '\\' && static_cast<unsigned char>(c) >= 0x20)
+                    json += c;
+            json += "\", \"counters\": " + t.values.ToJson() + "}";
+        }
+        json += p.threads.empty() ? "]" : "\n      ]";
+    }
+
+    json += last ? "}\n" : "},\n";
+}
+
+// Add one thread's counts over a phase interval to the phase total and its per-thread entry
+void AddThreadCounters(PhaseMetrics& p, const ThreadCounters& thread, const CounterValues& delta)
+{
+    p.counters.Add(delta);
+    for (ThreadCounters& t : p.threads)
+    {
+        if (t.tid == thread.tid && t.name == thread.name)
+        {
+            t.values.Add(delta);
+            return;
+        }
+    }
+    ThreadCounters entry;
+    entry.tid = thread.tid;
+    entry.name = thread.name;
+    entry.values = delta;
+    p.threads.push_back(entry);
+}
+
+} // namespace
+
+const char* RunPhaseName(RunPhase phase)
+{
+    switch (phase)
+    {
+    case RunPhase::Scan: return "scan";
+    case RunPhase::Ingest: return "ingest";
+    case RunPhase::Accumulate: return "accumulate";
+    case RunPhase::Finalize: return "finalize";
+    case RunPhase::Write: return "write";
+    default: return "unknown";
+    }
+}
+
+std::string RunMetrics::ToJson() const
+{
+    char text[160];
+    std::string json = "{\n";
+    snprintf(text, sizeof(text), "  \"peak_rss_bytes\": %llu,\n  \"exact_peaks\": %s,\n  \"counters_enabled\": %s,\n",
+             (unsigned long long)peakRssBytes, exactPeaks ? "true" : "false", countersEnabled ? "true" : "false");
+    json += text;
+    if (!countersNote.empty())
+    {
+        json += "  \"counters_note\": \"";
+        for (char c : countersNote)
+            if (c != '"' && c != '\\' && static_cast<unsigned char>(c) >= 0x20)
+                json += c;
+        json += "\",\n";
+    }
+    json += "  \"phases\": {\n";
+
+    const int count = int(RunPhase::Count);
+    for (int i = 0; i < count; ++i)
+        AppendPhase(json, RunPhaseName(RunPhase(i)), phases[i], countersEnabled, i + 1 == count);
+
+    json += "  }\n}\n";
+    return json;
+}
+
+uint64_t CurrentRssBytes()
+{
+    return StatusKilobytes("VmRSS");
+}
+
+uint64_t PeakRssBytes()
+{
+    return StatusKilobytes("VmHWM");
+}
+
+bool ResetPeakRss()
+{
+    // "5" resets only the peak RSS counter; nothing else about the address space changes
+    int fd = open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    bool ok = write(fd, "5", 1) == 1;
+    close(fd);
+    return ok;
+}
+
+PhaseRecorder::PhaseRecorder(RunMetrics& metrics, WorkspaceArena* arena, JuliaCounters julia,
+                             ProcessCounters* counters)
+    : m_metrics(metrics)
+    , m_arena(arena)
+    , m_julia(std::move(julia))
+    , m_counters(counters != nullptr && counters->IsOpen() ? counters : nullptr)
+{
+}
+
+uint64_t PhaseRecorder::NativeHeapBytes() const
+{
+#ifdef BA_HAVE_MALLINFO2
+    struct mallinfo2 info = mallinfo2();
+    return uint64_t(info.uordblks) + uint64_t(info.hblkhd);
+#else
+    return 0;
+#endif
+}
+
+void PhaseRecorder::Begin(RunPhase phase)
+{
+    // Back-to-back phases share one counter sample: the end of one is the start of the next
+    const bool chained = m_phase != RunPhase::Count;
+    if (chained)
+        End();
+
+    m_phase = phase;
+    if (!ResetPeakRss())
+        m_metrics.exactPeaks = false;
+
+    if (m_arena != nullptr)
+    {
+        m_arena->ResetPeak();
+        m_arenaAllocated = m_arena->Counters().allocatedBytes;
+    }
+    m_heapBytes = NativeHeapBytes();
+    if (m_julia)
+        m_julia(m_juliaAllocated, m_juliaGc);
+    if (m_counters != nullptr)
+    {
+        // Threads started since the last boundary count from zero
+        m_counters->Refresh();
+        if (!chained)
+            m_counters->Sample(m_counterStart);
+    }
+    m_start = NowSeconds();
+}
+
+void PhaseRecorder::End()
+{
+    if (m_phase == RunPhase::Count)
+        return;
+
+    PhaseMetrics& p = m_metrics.phases[int(m_phase)];
+    p.seconds += NowSeconds() - m_start;
+    ++p.intervals;
+
+    if (m_counters != nullptr)
+    {
+        m_counters->Sample(m_counterSample);
+        for (size_t i = 0; i < m_counterSample.size(); ++i)
+        {
+            const ThreadCounters& now = m_counterSample[i];
+            CounterValues delta = i < m_counterStart.size() ? now.values.Since(m_counterStart[i].values) : now.values;
+            if (!delta.IsZero())
+                AddThreadCounters(p, now, delta);
+        }
+        m_counterStart.swap(m_counterSample);
+    }
+
+    if (m_julia)
+    {
+        uint64_t allocated = 0, gc = 0;
+        m_julia(allocated, gc);
+        p.juliaAllocatedBytes += allocated - std::min(allocated, m_juliaAllocated);
+        p.juliaGcSeconds += double(gc - std::min(gc, m_juliaGc)) * 1e-9;
+    }
+
+    p.heapGrowthBytes += int64_t(NativeHeapBytes()) - int64_t(m_heapBytes);
+
+    if (m_arena != nullptr)
+    {
+        WorkspaceStats arena = m_arena->Counters();
+        p.arenaAllocatedBytes += arena.allocatedBytes - std::min(arena.allocatedBytes, m_arenaAllocated);
+        p.arenaHighWaterBytes = std::max(p.arenaHighWaterBytes, arena.peakResidentBytes);
+    }
+
+    // Without a reset the high-water mark is the process lifetime peak
+    uint64_t peak = m_metrics.exactPeaks ? PeakRssBytes() : CurrentRssBytes();
+    p.peakRssBytes = std::max(p.peakRssBytes, peak);
+    m_metrics.peakRssBytes = std::max(m_metrics.peakRssBytes, p.peakRssBytes);
+
+    m_phase = RunPhase::Count;
+}
+
+} // namespace pcl
@@ -0,0 +1,354 @@
+/**
+ * Stack Kernels Implementation
+ */
+
+#include "StackKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+#define BA_NO_VECTORIZE __attribute__((optimize("no-tree-vectorize")))
+#else
+#define BA_NO_VECTORIZE
+#endif
+
+#define BA_RESTRICT __restrict__
+
+namespace pcl
+{
+
+namespace
+{
+
+// Pixels per tile of the frame-batched update: seven planes of 1024 pixels (26 KiB) stay in L1
+constexpr size_t BATCH_TILE_PIXELS = 1024;
+
+// Julia's min/max propagate NaN; std::min/std::max do not
+inline float NanMin(float a, float b)
+{
+    return (a != a || b < a) ? (a != a ? a : b) : (b != b ? b : a);
+}
+
+inline float NanMax(float a, float b)
+{
+    return (a != a || b > a) ? (a != a ? a : b) : (b != b ? b : a);
+}
+
+// Julia clamp(x, lo, hi): NaN passes through
+inline float Clamp(float x, float lo, float hi)
+{
+    return x > hi ? hi : (x < lo ? lo : x);
+}
+
+/**
+ * One Welford update of the count and central moments (Welford.welford_step).
+ * M4 before M3 before M2: each update uses the previous lower moments.
+ */
+inline void WelfordStep(uint16_t& n, float& mean, float& m2, float& m3, float& m4, float value)
+{
+    const float n1f = float(n);
+    const uint16_t n2 = uint16_t(n + 1);
+    const float nf = float(n2);
+
+    const float delta = value - mean;
+    const float deltaN = delta / nf;
+    const float deltaN2 = deltaN * deltaN;
+    const float term1 = delta * deltaN * n1f;
+
+    m4 += term1 * deltaN2 * (nf * nf - 3.0f * nf + 3.0f) + 6.0f * deltaN2 * m2 - 4.0f * deltaN * m3;
+    m3 += term1 * deltaN * (nf - 2.0f) - 3.0f * deltaN * m2;
+    m2 += term1;
+    mean += deltaN;
+    n = n2;
+}
+
+// Vectorizable update of 'count' pixels starting at the given plane pointers
+inline void AccumulateRange(uint16_t* BA_RESTRICT n, float* BA_RESTRICT mean, float* BA_RESTRICT m2,
+                            float* BA_RESTRICT m3, float* BA_RESTRICT m4, float* BA_RESTRICT lo,
+                            float* BA_RESTRICT hi, const float* BA_RESTRICT frame, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float value = frame[i];
+        uint16_t ni = n[i];
+        float meani = mean[i], m2i = m2[i], m3i = m3[i], m4i = m4[i];
+        WelfordStep(ni, meani, m2i, m3i, m4i, value);
+        n[i] = ni;
+        mean[i] = meani;
+        m2[i] = m2i;
+        m3[i] = m3i;
+        m4[i] = m4i;
+        lo[i] = NanMin(lo[i], value);
+        hi[i] = NanMax(hi[i], value);
+    }
+}
+
+// Welford.skewness / Welford.kurtosis (excess); m2 ≈ 0 in Julia is exactly zero here
+inline float Skewness(uint16_t n, float m2, float m3)
+{
+    if (n < 3 || m2 == 0.0f)
+        return 0.0f;
+    return std::sqrt(float(n)) * m3 / std::pow(m2, 1.5f);
+}
+
+inline float Kurtosis(uint16_t n, float m2, float m4)
+{
+    if (n < 4 || m2 == 0.0f)
+        return 0.0f;
+    return float(n) * m4 / (m2 * m2) - 3.0f;
+}
+
+// Classification.classify_distribution
+DistributionCode Classify(uint16_t n, float mean, float var, float skew, float kurt, float lo, float hi)
+{
+    if (n < 5)
+        return DistributionCode::Unknown;
+
+    const float range = hi - lo;
+    if (range > 0.0f && var / (range * range) < 0.1f)
+        return DistributionCode::Uniform;
+
+    if (mean > 0.0f && std::fabs(var - mean) / mean < 0.3f && skew > 0.0f)
+        return DistributionCode::Poisson;
+
+    if (kurt < -0.5f)
+        return DistributionCode::Bimodal;
+
+    if (std::fabs(skew) > 0.5f)
+        return skew > 0.0f ? DistributionCode::SkewedRight : DistributionCode::SkewedLeft;
+
+    if (std::fabs(skew) <= 0.5f && std::fabs(kurt) <= 1.0f)
+        return DistributionCode::Gaussian;
+
+    return DistributionCode::Unknown;
+}
+
+// Confidence.compute_confidence
+float Confidence(uint16_t n, float var, float skew, float kurt, DistributionCode code)
+{
+    if (n < 2)
+        return 0.0f;
+
+    const float sampleFactor = std::min(1.0f, float(n) / 100.0f);
+    const float varianceFactor = var > 0.0f ? 1.0f / (1.0f + var / 100.0f) : 1.0f;
+
+    float distributionFactor;
+    switch (code)
+    {
+    case DistributionCode::Gaussian: distributionFactor = 1.0f; break;
+    case DistributionCode::Poisson: distributionFactor = 0.9f; break;
+    case DistributionCode::Bimodal: distributionFactor = 0.5f; break;
+    case DistributionCode::SkewedRight:
+    case DistributionCode::SkewedLeft: distributionFactor = 0.3f; break;
+    case DistributionCode::Uniform: distributionFactor = 0.2f; break;
+    default: distributionFactor = 0.5f; break;
+    }
+
+    const float outlierFactor = 1.0f / (1.0f + 0.5f * std::fabs(skew) + 0.2f * std::fabs(kurt));
+
+    const float confidence = 0.2f * sampleFactor + 0.3f * varianceFactor +
+                             0.3f * distributionFactor + 0.2f * outlierFactor;
+    return Clamp(confidence, 0.0f, 1.0f);
+}
+
+} // namespace
+
+AccumulatorPlanes AccumulatorPlanes::Slice(size_t first, size_t count) const
+{
+    return AccumulatorPlanes{ n + first, mean + first, m2 + first, m3 + first, m4 + first,
+                              min + first, max + first, count };
+}
+
+void ResetAccumulator(const AccumulatorPlanes& acc)
+{
+    std::fill_n(acc.n, acc.pixels, uint16_t(0));
+    std::fill_n(acc.mean, acc.pixels, 0.0f);
+    std::fill_n(acc.m2, acc.pixels, 0.0f);
+    std::fill_n(acc.m3, acc.pixels, 0.0f);
+    std::fill_n(acc.m4, acc.pixels, 0.0f);
+    std::fill_n(acc.min, acc.pixels, std::numeric_limits<float>::infinity());
+    std::fill_n(acc.max, acc.pixels, -std::numeric_limits<float>::infinity());
+}
+
+BA_NO_VECTORIZE
+void AccumulateFrameScalar(const AccumulatorPlanes& acc, const float* frame)
+{
+    for (size_t i = 0; i < acc.pixels; ++i)
+    {
+        WelfordStep(acc.n[i], acc.mean[i], acc.m2[i], acc.m3[i], acc.m4[i], frame[i]);
+        acc.min[i] = NanMin(acc.min[i], frame[i]);
+        acc.max[i] = NanMax(acc.max[i], frame[i]);
+    }
+}
+
+void AccumulateFrame(const AccumulatorPlanes& acc, const float* frame)
+{
+    AccumulateRange(acc.n, acc.mean, acc.m2, acc.m3, acc.m4, acc.min, acc.max, frame, acc.pixels);
+}
+
+void AccumulateFrames(const AccumulatorPlanes& acc, const float* const* frames, size_t frameCount)
+{
+    for (size_t first = 0; first < acc.pixels; first += BATCH_TILE_PIXELS)
+    {
+        const size_t count = std::min(BATCH_TILE_PIXELS, acc.pixels - first);
+        for (size_t f = 0; f < frameCount; ++f)
+            AccumulateRange(acc.n + first, acc.mean + first, acc.m2 + first, acc.m3 + first, acc.m4 + first,
+                            acc.min + first, acc.max + first, frames[f] + first, count);
+    }
+}
+
+void FinalizeAccumulator(const AccumulatorPlanes& acc, float* fused, float* confidence, uint8_t* classes)
+{
+    for (size_t i = 0; i < acc.pixels; ++i)
+    {
+        const uint16_t n = acc.n[i];
+        const float m2 = acc.m2[i];
+        const float var = n < 2 ? 0.0f : m2 / float(uint16_t(n - 1));
+        const float skew = Skewness(n, m2, acc.m3[i]);
+        const float kurt = Kurtosis(n, m2, acc.m4[i]);
+        const DistributionCode code = Classify(n, acc.mean[i], var, skew, kurt, acc.min[i], acc.max[i]);
+
+        fused[i] = acc.mean[i];
+        confidence[i] = Confidence(n, var, skew, kurt, code);
+        classes[i] = uint8_t(code);
+    }
+}
+
+DistributionCode ClassifyMoments(uint16_t n, float mean, float m2, float m3, float m4, float min, float max)
+{
+    const float var = n < 2 ? 0.0f : m2 / float(uint16_t(n - 1));
+    return Classify(n, mean, var, Skewness(n, m2, m3), Kurtosis(n, m2, m4), min, max);
+}
+
+float ConfidenceMoments(uint16_t n, float mean, float m2, float m3, float m4, float min, float max)
+{
+    const float var = n < 2 ? 0.0f : m2 / float(uint16_t(n - 1));
+    const float skew = Skewness(n, m2, m3);
+    const float kurt = Kurtosis(n, m2, m4);
+    return Confidence(n, var, skew, kurt, Classify(n, mean, var, skew, kurt, min, max));
+}
+
+void MergeAccumulators(const AccumulatorPlanes& into, const AccumulatorPlanes& from)
+{
+    for (size_t i = 0; i < into.pixels; ++i)
+    {
+        if (from.n[i] == 0)
+            continue;
+        if (into.n[i] == 0)
+        {
+            into.n[i] = from.n[i];
+            into.mean[i] = from.mean[i];
+            into.m2[i] = from.m2[i];
+            into.m3[i] = from.m3[i];
+            into.m4[i] = from.m4[i];
+            into.min[i] = from.min[i];
+            into.max[i] = from.max[i];
+            continue;
+        }
+
+        const float n1 = float(into.n[i]), n2 = float(from.n[i]);
+        const float n = n1 + n2;
+        const float mA2 = into.m2[i], mB2 = from.m2[i];
+        const float mA3 = into.m3[i], mB3 = from.m3[i];
+
+        const float delta = from.mean[i] - into.mean[i];
+        const float delta2 = delta * delta;
+        const float delta3 = delta2 * delta;
+        const float delta4 = delta3 * delta;
+
+        into.n[i] = uint16_t(n);
+        into.mean[i] = (n1 * into.mean[i] + n2 * from.mean[i]) / n;
+        into.m2[i] = mA2 + mB2 + delta2 * n1 * n2 / n;
+        into.m3[i] = mA3 + mB3 + delta3 * n1 * n2 * (n1 - n2) / (n * n) +
+                     3.0f * delta * (n1 * mB2 - n2 * mA2) / n;
+        into.m4[i] = into.m4[i] + from.m4[i] +
+                     delta4 * n1 * n2 * (n1 * n1 - n1 * n2 + n2 * n2) / (n * n * n) +
+                     6.0f * delta2 * (n1 * n1 * mB2 + n2 * n2 * mA2) / (n * n) +
+                     4.0f * delta * (n1 * mB3 - n2 * mA3) / n;
+        into.min[i] = NanMin(into.min[i], from.min[i]);
+        into.max[i] = NanMax(into.max[i], from.max[i]);
+    }
+}
+
+void StretchPlane(float* BA_RESTRICT out, const float* BA_RESTRICT in, size_t count, float blackPoint, float whitePoint)
+{
+    const float range = whitePoint - blackPoint;
+    if (!(range > 0.0f))
+    {
+        std::fill_n(out, count, 0.0f);
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+        out[i] = Clamp((in[i] - blackPoint) / range, 0.0f, 1.0f);
+}
+
+void PlaneMinMax(const float* BA_RESTRICT in, size_t count, float& minValue, float& maxValue)
+{
+    // Comparisons with NaN are false, so NaN samples never replace a bound
+    float lo = std::numeric_limits<float>::infinity();
+    float hi = -std::numeric_limits<float>::infinity();
+    size_t i = 0;
+
+#ifdef __SSE2__
+    // GCC will not vectorize an ordered min/max reduction without -ffast-math; MINPS/MAXPS
+    // return their second operand on NaN, which is the same rule as the scalar loop
+    __m128 lo4 = _mm_set1_ps(lo), hi4 = _mm_set1_ps(hi);
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 v = _mm_loadu_ps(in + i);
+        lo4 = _mm_min_ps(v, lo4);
+        hi4 = _mm_max_ps(v, hi4);
+    }
+    float lanes[8];
+    _mm_storeu_ps(lanes, lo4);
+    _mm_storeu_ps(lanes + 4, hi4);
+    lo = std::min({ lanes[0], lanes[1], lanes[2], lanes[3] });
+    hi = std::max({ lanes[4], lanes[5], lanes[6], lanes[7] });
+#endif
+
+    for (; i < count; ++i)
+    {
+        lo = in[i] < lo ? in[i] : lo;
+        hi = in[i] > hi ? in[i] : hi;
+    }
+    minValue = lo;
+    maxValue = hi;
+}
+
+double SumPlane(const float* BA_RESTRICT in, size_t count)
+{
+    // Eight independent lanes, combined in a fixed order: vectorizes without reassociation
+    double lanes[8] = {};
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        for (size_t k = 0; k < 8; ++k)
+            lanes[k] += double(in[i + k]);
+    for (size_t k = 0; i < count; ++i, ++k)
+        lanes[k] += double(in[i]);
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+double PairwiseSum(double* partials, size_t count)
+{
+    if (count == 0)
+        return 0.0;
+    for (size_t stride = 1; stride < count; stride *= 2)
+        for (size_t i = 0; i + stride < count; i += 2 * stride)
+            partials[i] += partials[i + stride];
+    return partials[0];
+}
+
+void CountClasses(const uint8_t* BA_RESTRICT classes, size_t count, uint64_t counts[8])
+{
+    for (size_t i = 0; i < count; ++i)
+        ++counts[classes[i] & 7];
+}
+
+} // namespace pcl
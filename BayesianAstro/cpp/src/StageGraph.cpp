@@ -0,0 +1,102 @@
+/**
+ * Stage Graph Implementation
+ */
+
+#include "StageGraph.h"
+#include "PackedFrameCache.h"
+
+namespace pcl
+{
+
+namespace
+{
+
+constexpr int STAGE_COUNT = int(PipelineStage::Count);
+
+// Parent lists, each terminated by Count; stages are in topological order
+const PipelineStage STAGE_PARENTS[STAGE_COUNT][2] = {
+    { PipelineStage::Count, PipelineStage::Count },         // Accumulate
+    { PipelineStage::Accumulate, PipelineStage::Count },    // Finalize
+    { PipelineStage::Finalize, PipelineStage::Count },      // Write
+};
+
+void MarkStale(const StageKeys& wanted, const StageKeys& cached, PipelineStage stage, StagePlan& plan)
+{
+    if (plan.run[int(stage)] || wanted[stage] == cached[stage])
+        return;
+    plan.run[int(stage)] = true;
+    for (const PipelineStage* parent = PipelineStageParents(stage); *parent != PipelineStage::Count; ++parent)
+        MarkStale(wanted, cached, *parent, plan);
+}
+
+} // namespace
+
+const char* PipelineStageName(PipelineStage stage)
+{
+    switch (stage)
+    {
+    case PipelineStage::Accumulate: return "accumulate";
+    case PipelineStage::Finalize:   return "finalize";
+    case PipelineStage::Write:      return "write";
+    default:                        return "unknown";
+    }
+}
+
+const PipelineStage* PipelineStageParents(PipelineStage stage)
+{
+    return STAGE_PARENTS[int(stage)];
+}
+
+StageParameters& StageParameters::Add(const void* data, size_t bytes)
+{
+    m_bytes.append(static_cast<const char*>(data), bytes);
+    return *this;
+}
+
+StageParameters& StageParameters::Add(const std::string& text)
+{
+    const uint64_t length = text.size();
+    Add(&length, sizeof(length));
+    return Add(text.data(), text.size());
+}
+
+StageKeys ComputeStageKeys(const StageParameters (&parameters)[STAGE_COUNT])
+{
+    StageKeys keys;
+    for (int s = 0; s < STAGE_COUNT; ++s)
+    {
+        StageParameters chained = parameters[s];
+        for (const PipelineStage* parent = PipelineStageParents(PipelineStage(s)); *parent != PipelineStage::Count;
+             ++parent)
+            chained.Add(keys[*parent]);
+        const uint64_t hash = HashPackedPayload(chained.Bytes().data(), chained.Bytes().size());
+        keys.key[s] = hash != 0 ? hash : 1;
+    }
+    return keys;
+}
+
+bool StagePlan::Empty() const
+{
+    for (bool stage : run)
+        if (stage)
+            return false;
+    return true;
+}
+
+std::string StagePlan::Describe() const
+{
+    std::string stages;
+    for (int s = 0; s < STAGE_COUNT; ++s)
+        if (run[s])
+            stages += (stages.empty() ? "" : ", ") + std::string(PipelineStageName(PipelineStage(s)));
+    return stages.empty() ? "nothing (up to date)" : stages;
+}
+
+StagePlan PlanStages(const StageKeys& wanted, const StageKeys& cached, PipelineStage target)
+{
+    StagePlan plan;
+    MarkStale(wanted, cached, target, plan);
+    return plan;
+}
+
+} // namespace pcl
@@ -0,0 +1,486 @@
+/**
+ * Synthetic Stack Implementation
+ */
+
+#include "SyntheticStack.h"
+#include "FitsWriter.h"
+#include "StackKernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace pcl
+{
+
+namespace
+{
+
+constexpr double PI = 3.14159265358979323846;
+
+// Exposure spacing of the DATE-OBS sequence, from 2024-01-01T00:00:00 UTC
+constexpr double EXPOSURE_SECONDS = 60.0;
+constexpr time_t FIRST_EXPOSURE = 1704067200;
+
+// Expected sky electrons below which photon counting, not Gaussian noise, describes a pixel
+constexpr double POISSON_REGIME_ELECTRONS = 20.0;
+
+// Frames below which any class is a guess (types.jl UNKNOWN)
+constexpr size_t MIN_CLASSIFIED_FRAMES = 5;
+
+// Half-width of the star-frame fractions around one half that make a pixel bimodal
+constexpr double STAR_BIMODAL_FRACTION = 0.25;
+
+// 16-bit frames are clipped to this ADU ceiling
+constexpr double ADU_CEILING = 65534.0;
+
+// Independent random streams of the counter-based generator
+enum Stream : uint64_t
+{
+    StreamPixel = 1,
+    StreamPixelPair,
+    StreamStar,
+    StreamHotPixel,
+    StreamDither,
+    StreamCosmicRay,
+    StreamTrail
+};
+
+// splitmix64 finalizer: a full-avalanche 64-bit mix
+inline uint64_t Mix(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Random bits as a pure function of (seed, stream, a, b): the same on every platform and thread
+inline uint64_t Hash(uint64_t seed, Stream stream, uint64_t a, uint64_t b = 0)
+{
+    return Mix(Mix(Mix(seed ^ (uint64_t(stream) << 56)) ^ a) ^ b);
+}
+
+// Uniform in (0, 1)
+inline double Uniform(uint64_t bits)
+{
+    return (double(bits >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+// Two independent standard normals (Box-Muller)
+inline void Normals(uint64_t bits1, uint64_t bits2, double& z0, double& z1)
+{
+    const double r = std::sqrt(-2.0 * std::log(Uniform(bits1)));
+    const double theta = 2.0 * PI * Uniform(bits2);
+    z0 = r * std::cos(theta);
+    z1 = r * std::sin(theta);
+}
+
+// Poisson sample: inversion for small means, the normal limit otherwise
+inline double Poisson(double lambda, double u, double z)
+{
+    if (lambda <= 0.0)
+        return 0.0;
+    if (lambda >= 30.0)
+        return std::max(0.0, std::round(lambda + std::sqrt(lambda) * z));
+
+    double p = std::exp(-lambda);
+    double cumulative = p;
+    int k = 0;
+    while (u > cumulative && k < 200)
+    {
+        ++k;
+        p *= lambda / k;
+        cumulative += p;
+    }
+    return double(k);
+}
+
+void ParallelFor(size_t count, int threads, const std::function<void(size_t)>& body)
+{
+    if (threads <= 0)
+        threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    threads = int(std::min<size_t>(size_t(threads), count));
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+            body(i);
+    };
+
+    if (threads <= 1)
+    {
+        worker();
+        return;
+    }
+
+    std::vector<std::thread> pool;
+    pool.reserve(size_t(threads));
+    for (int i = 0; i < threads; ++i)
+        pool.emplace_back(worker);
+    for (std::thread& t : pool)
+        t.join();
+}
+
+std::string DateObs(size_t index)
+{
+    const time_t t = FIRST_EXPOSURE + time_t(double(index) * EXPOSURE_SECONDS);
+    struct tm utc;
+    gmtime_r(&t, &utc);
+    char text[32];
+    strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &utc);
+    return text;
+}
+
+/**
+ * Class the generator put into a pixel, from its ground-truth flags (types.jl meanings)
+ * and the fraction of frames a star core covered it. Clipped samples are saturated
+ * (UNIFORM); a transient hit adds a bright tail (SKEWED_RIGHT). A dithered star core
+ * over a fraction q of the frames is a two-level mixture: bimodal while its excess
+ * kurtosis is below -0.5 (q within STAR_BIMODAL_FRACTION of one half), else skewed
+ * towards the minority level. Sky, hot pixels and steady star cores are a level with
+ * noise, Poisson when few photons arrive.
+ */
+DistributionCode ExpectedClass(uint8_t truth, double starFraction, size_t frames, double skyElectrons)
+{
+    if (frames < MIN_CLASSIFIED_FRAMES)
+        return DistributionCode::Unknown;
+    if (truth & TruthSaturated)
+        return DistributionCode::Uniform;
+    if (truth & (TruthCosmicRay | TruthTrail))
+        return DistributionCode::SkewedRight;
+    if ((truth & TruthStar) && starFraction < 1.0)
+    {
+        if (std::fabs(starFraction - 0.5) <= STAR_BIMODAL_FRACTION)
+            return DistributionCode::Bimodal;
+        return starFraction < 0.5 ? DistributionCode::SkewedRight : DistributionCode::SkewedLeft;
+    }
+    if (!(truth & (TruthHotPixel | TruthStar)) && skyElectrons < POISSON_REGIME_ELECTRONS)
+        return DistributionCode::Poisson;
+    return DistributionCode::Gaussian;
+}
+
+} // namespace
+
+SyntheticStack::SyntheticStack(const SyntheticStackConfig& config)
+    : m_config(config)
+{
+    const double h = double(config.height), w = double(config.width);
+
+    // Star field in reference-frame coordinates; flux follows dN/dF ∝ F^-2 between the limits
+    m_stars.reserve(config.stars);
+    for (size_t k = 0; k < config.stars; ++k)
+    {
+        const double u = Uniform(Hash(config.seed, StreamStar, k, 2));
+        const double flux = config.starFluxMin * config.starFluxMax /
+                            (config.starFluxMax - u * (config.starFluxMax - config.starFluxMin));
+        m_stars.push_back({ Uniform(Hash(config.seed, StreamStar, k, 0)) * h,
+                            Uniform(Hash(config.seed, StreamStar, k, 1)) * w, flux });
+    }
+
+    const size_t pixels = Pixels();
+    const size_t hot = size_t(std::llround(config.hotPixelFraction * double(pixels)));
+    for (size_t k = 0; k < hot && pixels > 0; ++k)
+        m_hotPixels.push_back(size_t(Hash(config.seed, StreamHotPixel, k) % pixels));
+    std::sort(m_hotPixels.begin(), m_hotPixels.end());
+    m_hotPixels.erase(std::unique(m_hotPixels.begin(), m_hotPixels.end()), m_hotPixels.end());
+}
+
+SyntheticStack::FrameLayout SyntheticStack::Layout(size_t index) const
+{
+    const SyntheticStackConfig& c = m_config;
+    FrameLayout layout;
+
+    layout.rowOffset = (2.0 * Uniform(Hash(c.seed, StreamDither, index, 0)) - 1.0) * c.ditherPixels;
+    layout.columnOffset = (2.0 * Uniform(Hash(c.seed, StreamDither, index, 1)) - 1.0) * c.ditherPixels;
+
+    if (Uniform(Hash(c.seed, StreamTrail, index, 0)) < c.trailProbability)
+    {
+        const double angle = PI * Uniform(Hash(c.seed, StreamTrail, index, 1));
+        layout.trail = true;
+        layout.trailRow = Uniform(Hash(c.seed, StreamTrail, index, 2)) * double(c.height);
+        layout.trailColumn = Uniform(Hash(c.seed, StreamTrail, index, 3)) * double(c.width);
+        layout.trailSin = std::sin(angle);
+        layout.trailCos = std::cos(angle);
+    }
+
+    // Hit count is Poisson; each hit deposits into one pixel and, half the time, its neighbour
+    const size_t pixels = Pixels();
+    const double expected = c.cosmicRaysPerMegapixel * double(pixels) / 1e6;
+    double z0, z1;
+    Normals(Hash(c.seed, StreamCosmicRay, index, 0), Hash(c.seed, StreamCosmicRay, index, 1), z0, z1);
+    const size_t hits = size_t(Poisson(expected, Uniform(Hash(c.seed, StreamCosmicRay, index, 2)), z0));
+    for (size_t k = 0; k < hits && pixels > 0; ++k)
+    {
+        const uint64_t bits = Hash(c.seed, StreamCosmicRay, index, 3 + k);
+        const size_t pixel = size_t(bits % pixels);
+        const float level = float(c.cosmicRayLevel * (0.5 + 0.5 * Uniform(Mix(bits))));
+        layout.cosmicRays.emplace_back(pixel, level);
+        if ((bits >> 63) != 0 && (pixel + 1) % size_t(c.height) != 0)
+            layout.cosmicRays.emplace_back(pixel + 1, 0.5f * level);
+    }
+
+    return layout;
+}
+
+double SyntheticStack::SkyElectrons(int64_t row, int64_t column) const
+{
+    const SyntheticStackConfig& c = m_config;
+    const double x = double(column) / double(std::max<int64_t>(1, c.width - 1));
+    return c.skyLevel + c.gradient * (0.5 * (double(row) / std::max<int64_t>(1, c.height - 1) + x) - 0.5);
+}
+
+void SyntheticStack::GenerateFrame(size_t index, float* pixels, uint8_t* truth) const
+{
+    GenerateColumns(index, 0, m_config.width, pixels, truth);
+}
+
+void SyntheticStack::GenerateColumns(size_t index, int64_t firstColumn, int64_t columnCount,
+                                     float* pixels, uint8_t* truth) const
+{
+    const SyntheticStackConfig& c = m_config;
+    const int64_t h = c.height;
+    const size_t count = size_t(h) * size_t(columnCount);
+    const size_t base = size_t(firstColumn) * size_t(h);
+    const FrameLayout layout = Layout(index);
+
+    // Expected electrons: sky with a diagonal gradient, fixed to the sensor
+    for (int64_t j = 0; j < columnCount; ++j)
+    {
+        float* column = pixels + size_t(j) * size_t(h);
+        for (int64_t i = 0; i < h; ++i)
+            column[i] = float(SkyElectrons(i, firstColumn + j));
+    }
+
+    // Stars move with the dither; Gaussian PSF sampled at pixel centres out to 4 sigma
+    const double sigma = c.starFwhm / 2.3548200450309493;
+    const double radius = std::ceil(4.0 * sigma);
+    const double norm = 1.0 / (2.0 * PI * sigma * sigma);
+    for (const Star& star : m_stars)
+    {
+        const double row = star.row + layout.rowOffset;
+        const double col = star.column + layout.columnOffset;
+        const int64_t j0 = std::max<int64_t>(firstColumn, int64_t(std::floor(col - radius)));
+        const int64_t j1 = std::min<int64_t>(firstColumn + columnCount - 1, int64_t(std::ceil(col + radius)));
+        const int64_t i0 = std::max<int64_t>(0, int64_t(std::floor(row - radius)));
+        const int64_t i1 = std::min<int64_t>(h - 1, int64_t(std::ceil(row + radius)));
+        const double peak = star.flux * norm;
+        for (int64_t j = j0; j <= j1; ++j)
+            for (int64_t i = i0; i <= i1; ++i)
+            {
+                const double dr = double(i) - row, dc = double(j) - col;
+                const double profile = std::exp(-(dr * dr + dc * dc) / (2.0 * sigma * sigma));
+                const size_t p = size_t(j - firstColumn) * size_t(h) + size_t(i);
+                pixels[p] += float(peak * profile);
+                if (truth != nullptr && profile > 0.1)
+                    truth[p] |= TruthStar;
+            }
+    }
+
+    if (layout.trail)
+    {
+        const double halfWidth = 0.5 * c.trailWidth;
+        for (int64_t j = 0; j < columnCount; ++j)
+            for (int64_t i = 0; i < h; ++i)
+            {
+                const double distance = std::fabs(-(double(i) - layout.trailRow) * layout.trailSin +
+                                                  (double(firstColumn + j) - layout.trailColumn) * layout.trailCos);
+                if (distance > 4.0 * halfWidth)
+                    continue;
+                const size_t p = size_t(j) * size_t(h) + size_t(i);
+                pixels[p] += float(c.trailLevel * std::exp(-distance * distance / (2.0 * halfWidth * halfWidth)));
+                if (truth != nullptr && distance <= halfWidth)
+                    truth[p] |= TruthTrail;
+            }
+    }
+
+    // Hot pixels are sensor defects: fixed position, present in every frame
+    for (auto it = std::lower_bound(m_hotPixels.begin(), m_hotPixels.end(), base);
+         it != m_hotPixels.end() && *it < base + count; ++it)
+    {
+        pixels[*it - base] += float(c.hotPixelLevel);
+        if (truth != nullptr)
+            truth[*it - base] |= TruthHotPixel;
+    }
+
+    for (const auto& ray : layout.cosmicRays)
+    {
+        if (ray.first < base || ray.first >= base + count)
+            continue;
+        pixels[ray.first - base] += ray.second;
+        if (truth != nullptr)
+            truth[ray.first - base] |= TruthCosmicRay;
+    }
+
+    // Photon noise on the expected electrons, then read noise, bias and quantization
+    for (size_t p = 0; p < count; ++p)
+    {
+        const uint64_t pixel = base + p;
+        const uint64_t bits = Hash(c.seed, StreamPixel, index, pixel);
+        double z0, z1;
+        Normals(bits, Hash(c.seed, StreamPixelPair, index, pixel), z0, z1);
+        double value = Poisson(double(pixels[p]), Uniform(Mix(bits)), z0) + c.readNoise * z1 + c.bias;
+        if (c.bitpix == 16)
+        {
+            value = std::round(value);
+            if (truth != nullptr && value >= ADU_CEILING)
+                truth[p] |= TruthSaturated;
+            value = std::min(std::max(value, 0.0), ADU_CEILING);
+        }
+        pixels[p] = float(value);
+    }
+}
+
+bool SyntheticStack::WriteFrames(const std::string& directory, const std::string& prefix, int threads,
+                                 std::vector<std::string>* paths, std::string& error) const
+{
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec)
+    {
+        error = "cannot create " + directory + ": " + ec.message();
+        return false;
+    }
+
+    std::vector<std::string> names(m_config.frames);
+    for (size_t f = 0; f < m_config.frames; ++f)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "_%04zu.fits", f);
+        names[f] = (std::filesystem::path(directory) / (prefix + name)).string();
+    }
+
+    // 16-bit frames hold integer ADU exactly: BSCALE 1, BZERO 32767
+    PlaneWriteOptions options;
+    options.encoding = m_config.bitpix == 16 ? PlaneEncoding::UInt16 : PlaneEncoding::Float32;
+    options.low = 0.0;
+    options.high = 65534.0;
+    options.threads = 1;
+
+    std::atomic<bool> failed(false);
+    std::string firstError;
+    std::mutex errorMutex;
+    ParallelFor(m_config.frames, threads, [&](size_t f)
+    {
+        if (failed)
+            return;
+        std::vector<float> pixels(Pixels());
+        GenerateFrame(f, pixels.data());
+
+        const FrameLayout layout = Layout(f);
+        std::vector<FitsKeyword> keywords = {
+            FitsKeyword::String("DATE-OBS", DateObs(f), "synthetic exposure start (UTC)"),
+            FitsKeyword::Real("EXPTIME", EXPOSURE_SECONDS, "exposure time (s)"),
+            FitsKeyword::Integer("SYNSEED", int64_t(m_config.seed), "synthetic stack seed"),
+            FitsKeyword::Integer("SYNFRAME", int64_t(f), "synthetic frame index"),
+            FitsKeyword::Real("SYNDROW", layout.rowOffset, "dither along NAXIS1 (pixels)"),
+            FitsKeyword::Real("SYNDCOL", layout.columnOffset, "dither along NAXIS2 (pixels)"),
+            FitsKeyword::Integer("SYNCRAYS", int64_t(layout.cosmicRays.size()), "cosmic ray hits"),
+            FitsKeyword::Logical("SYNTRAIL", layout.trail, "satellite trail present")
+        };
+
+        std::string frameError;
+        if (!WriteFitsPlane(names[f], pixels.data(), m_config.height, m_config.width, options, keywords,
+                            nullptr, frameError))
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!failed.exchange(true))
+                firstError = frameError;
+        }
+    });
+
+    if (failed)
+    {
+        error = firstError;
+        return false;
+    }
+    if (paths != nullptr)
+        *paths = names;
+    return true;
+}
+
+SyntheticReference SyntheticReference::Compute(const SyntheticStack& stack, int threads)
+{
+    const SyntheticStackConfig& c = stack.Config();
+    const size_t pixels = stack.Pixels();
+    const size_t h = size_t(c.height);
+
+    SyntheticReference ref;
+    ref.frames = c.frames;
+    ref.mean.assign(pixels, 0.0);
+    ref.m2.assign(pixels, 0.0);
+    ref.m3.assign(pixels, 0.0);
+    ref.m4.assign(pixels, 0.0);
+    ref.min.assign(pixels, std::numeric_limits<float>::infinity());
+    ref.max.assign(pixels, -std::numeric_limits<float>::infinity());
+    ref.classes.assign(pixels, uint8_t(DistributionCode::Unknown));
+    ref.truth.assign(pixels, TruthSky);
+
+    // Bands of whole columns; each worker regenerates only its band of every frame
+    const int64_t bandColumns = std::max<int64_t>(1, int64_t((1u << 20) / std::max<size_t>(1, h)));
+    const size_t bands = size_t((c.width + bandColumns - 1) / bandColumns);
+    const double n = double(c.frames);
+
+    ParallelFor(bands, threads, [&](size_t band)
+    {
+        const int64_t first = int64_t(band) * bandColumns;
+        const int64_t columns = std::min(bandColumns, c.width - first);
+        const size_t offset = size_t(first) * h;
+        const size_t count = size_t(columns) * h;
+        std::vector<float> frame(count);
+        std::vector<uint8_t> features(count);
+        std::vector<uint32_t> starFrames(count, 0);
+
+        // Pass 1: mean, extrema, truth flags and the frames each pixel was in a star core
+        for (size_t f = 0; f < c.frames; ++f)
+        {
+            std::fill(features.begin(), features.end(), uint8_t(TruthSky));
+            stack.GenerateColumns(f, first, columns, frame.data(), features.data());
+            for (size_t p = 0; p < count; ++p)
+            {
+                ref.truth[offset + p] |= features[p];
+                starFrames[p] += (features[p] & TruthStar) != 0;
+                ref.mean[offset + p] += frame[p];
+                ref.min[offset + p] = std::min(ref.min[offset + p], frame[p]);
+                ref.max[offset + p] = std::max(ref.max[offset + p], frame[p]);
+            }
+        }
+        for (size_t p = 0; p < count; ++p)
+            ref.mean[offset + p] /= n;
+
+        // Pass 2: central moment sums about the exact mean
+        for (size_t f = 0; f < c.frames; ++f)
+        {
+            stack.GenerateColumns(f, first, columns, frame.data());
+            for (size_t p = 0; p < count; ++p)
+            {
+                const double d = double(frame[p]) - ref.mean[offset + p];
+                const double d2 = d * d;
+                ref.m2[offset + p] += d2;
+                ref.m3[offset + p] += d2 * d;
+                ref.m4[offset + p] += d2 * d2;
+            }
+        }
+
+        // Expected classes from the ground truth, not from a classifier of the moments
+        for (int64_t j = 0; j < columns; ++j)
+            for (size_t i = 0; i < h; ++i)
+            {
+                const size_t p = offset + size_t(j) * h + i;
+                ref.classes[p] = uint8_t(ExpectedClass(ref.truth[p], double(starFrames[p - offset]) / n, c.frames,
+                                                       stack.SkyElectrons(int64_t(i), first + j)));
+            }
+    });
+
+    return ref;
+}
+
+} // namespace pcl
@@ -0,0 +1,287 @@
+/**
+ * Trace Timeline Implementation
+ */
+
+#include "TraceTimeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace pcl
+{
+
+std::atomic<bool> g_traceEnabled(false);
+
+namespace
+{
+
+// Buffers start small and grow to the session's limit, so short-lived pool threads stay cheap
+constexpr size_t INITIAL_EVENTS_PER_THREAD = 1024;
+
+struct TraceRecord
+{
+    const char* name;
+    const char* argName;        // nullptr = no argument
+    int64_t arg;
+    uint64_t start;             // Nanoseconds since the session started
+    uint64_t duration;
+    double value;               // Counter samples only
+    TraceCategory category;
+    bool counter;
+};
+
+struct TraceBuffer
+{
+    int tid = 0;
+    const char* threadName = nullptr;
+    size_t capacity = 0;
+    uint64_t written = 0;
+    std::vector<TraceRecord> records;
+
+    void Push(const TraceRecord& record)
+    {
+        if (records.size() < capacity)
+            records.push_back(record);
+        else
+            records[size_t(written % capacity)] = record;
+        ++written;
+    }
+};
+
+struct TraceSession
+{
+    std::mutex mutex;           // Guards 'buffers'; taken once per thread per session
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    std::atomic<uint32_t> generation{ 0 };
+    size_t eventsPerThread = DEFAULT_TRACE_EVENTS_PER_THREAD;
+    uint64_t origin = 0;
+};
+
+TraceSession& Session()
+{
+    static TraceSession session;
+    return session;
+}
+
+thread_local TraceBuffer* t_buffer = nullptr;
+thread_local uint32_t t_generation = 0;
+thread_local const char* t_threadName = nullptr;
+
+uint64_t NowNanoseconds()
+{
+    using namespace std::chrono;
+    return uint64_t(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+// The calling thread's buffer in the current session, registered on first use
+TraceBuffer* ThreadBuffer()
+{
+    TraceSession& session = Session();
+    const uint32_t generation = session.generation.load(std::memory_order_acquire);
+    if (t_buffer != nullptr && t_generation == generation)
+        return t_buffer;
+
+    std::lock_guard<std::mutex> lock(session.mutex);
+    auto buffer = std::make_unique<TraceBuffer>();
+    buffer->tid = int(session.buffers.size()) + 1;
+    buffer->threadName = t_threadName;
+    buffer->capacity = session.eventsPerThread;
+    buffer->records.reserve(std::min(session.eventsPerThread, INITIAL_EVENTS_PER_THREAD));
+    t_buffer = buffer.get();
+    t_generation = generation;
+    session.buffers.push_back(std::move(buffer));
+    return t_buffer;
+}
+
+void AppendEscaped(std::string& json, const char* text)
+{
+    json += '"';
+    for (const char* p = text; *p != '\0'; ++p)
+    {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\')
+        {
+            json += '\\';
+            json += char(c);
+        }
+        else if (c < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            json += escaped;
+        }
+        else
+            json += char(c);
+    }
+    json += '"';
+}
+
+void AppendRecord(std::string& json, const TraceRecord& r, int tid)
+{
+    char text[160];
+    json += "    {\"name\": ";
+    AppendEscaped(json, r.name);
+    if (r.counter)
+    {
+        snprintf(text, sizeof(text), ", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, \"tid\": %d, \"args\": {\"value\": %.6g}}",
+                 double(r.start) * 1e-3, tid, r.value);
+        json += text;
+        return;
+    }
+
+    snprintf(text, sizeof(text), ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d",
+             TraceCategoryName(r.category), double(r.start) * 1e-3, double(r.duration) * 1e-3, tid);
+    json += text;
+    if (r.argName != nullptr)
+    {
+        json += ", \"args\": {";
+        AppendEscaped(json, r.argName);
+        snprintf(text, sizeof(text), ": %lld}", (long long)r.arg);
+        json += text;
+    }
+    json += '}';
+}
+
+} // namespace
+
+const char* TraceCategoryName(TraceCategory category)
+{
+    switch (category)
+    {
+    case TraceCategory::Scan: return "scan";
+    case TraceCategory::Io: return "io";
+    case TraceCategory::Decode: return "decode";
+    case TraceCategory::Cache: return "cache";
+    case TraceCategory::Julia: return "julia";
+    case TraceCategory::Compute: return "compute";
+    case TraceCategory::Write: return "write";
+    default: return "other";
+    }
+}
+
+void StartTrace(size_t eventsPerThread)
+{
+    TraceSession& session = Session();
+    g_traceEnabled.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(session.mutex);
+        session.buffers.clear();
+        session.eventsPerThread = std::max<size_t>(1, eventsPerThread);
+        session.origin = NowNanoseconds();
+        session.generation.fetch_add(1, std::memory_order_release);
+    }
+    g_traceEnabled.store(true, std::memory_order_release);
+}
+
+void StopTrace()
+{
+    g_traceEnabled.store(false, std::memory_order_release);
+}
+
+void SetTraceThreadName(const char* name)
+{
+    t_threadName = name;
+    if (t_buffer != nullptr && t_generation == Session().generation.load(std::memory_order_acquire))
+        t_buffer->threadName = name;
+}
+
+void TraceCounter(const char* name, double value)
+{
+    if (!TraceEnabled())
+        return;
+
+    TraceRecord r = {};
+    r.name = name;
+    r.start = NowNanoseconds() - Session().origin;
+    r.value = value;
+    r.counter = true;
+    ThreadBuffer()->Push(r);
+}
+
+void TraceScope::Begin(TraceCategory category, const char* name, const char* argName, int64_t arg)
+{
+    m_name = name;
+    m_argName = argName;
+    m_arg = arg;
+    m_category = category;
+    m_start = NowNanoseconds();
+}
+
+void TraceScope::End()
+{
+    // A scope still open when the session stopped is dropped
+    if (!TraceEnabled())
+        return;
+
+    const uint64_t end = NowNanoseconds();
+    const uint64_t origin = Session().origin;
+
+    TraceRecord r;
+    r.name = m_name;
+    r.argName = m_argName;
+    r.arg = m_arg;
+    r.start = m_start - std::min(m_start, origin);
+    r.duration = end - m_start;
+    r.value = 0.0;
+    r.category = m_category;
+    r.counter = false;
+    ThreadBuffer()->Push(r);
+}
+
+bool WriteChromeTrace(const std::string& path, std::string& error)
+{
+    TraceSession& session = Session();
+    std::lock_guard<std::mutex> lock(session.mutex);
+
+    uint64_t dropped = 0;
+    size_t events = 0;
+    for (const auto& buffer : session.buffers)
+    {
+        dropped += buffer->written - buffer->records.size();
+        events += buffer->records.size();
+    }
+
+    std::string json;
+    json.reserve(events * 128 + 4096);
+    json += "{\n  \"displayTimeUnit\": \"ms\",\n";
+    char text[128];
+    snprintf(text, sizeof(text), "  \"otherData\": {\"dropped_events\": %llu},\n", (unsigned long long)dropped);
+    json += text;
+    json += "  \"traceEvents\": [\n";
+    json += "    {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"BayesianAstro\"}}";
+
+    for (const auto& buffer : session.buffers)
+    {
+        char fallback[32];
+        snprintf(fallback, sizeof(fallback), "thread %d", buffer->tid);
+        snprintf(text, sizeof(text), ",\n    {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": ",
+                 buffer->tid);
+        json += text;
+        AppendEscaped(json, buffer->threadName != nullptr ? buffer->threadName : fallback);
+        json += "}}";
+
+        // Oldest first: a wrapped ring starts at the slot written next
+        const size_t count = buffer->records.size();
+        const size_t first = buffer->written > count ? size_t(buffer->written % count) : 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            json += ",\n";
+            AppendRecord(json, buffer->records[(first + i) % count], buffer->tid);
+        }
+    }
+    json += "\n  ]\n}\n";
+
+    FILE* f = fopen(path.c_str(), "wb");
+    bool ok = f != nullptr && fwrite(json.data(), 1, json.size(), f) == json.size();
+    if (f != nullptr)
+        ok = fclose(f) == 0 && ok;
+    if (!ok)
+        error = "cannot write " + path;
+    return ok;
+}
+
+} // namespace pcl
@@ -0,0 +1,285 @@
+/**
+ * Workspace Arena Implementation
+ */
+
+#include "WorkspaceArena.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace pcl
+{
+
+namespace
+{
+
+size_t PageSize()
+{
+    long page = sysconf(_SC_PAGE_SIZE);
+    return page > 0 ? size_t(page) : 4096;
+}
+
+size_t AlignUp(size_t n, size_t a)
+{
+    return (n + a - 1) / a * a;
+}
+
+/**
+ * Start offset of a plane within its allocation. Planes walked in lockstep by the
+ * accumulation loop must not share cache sets: with identical (page or 2 MiB)
+ * alignment, ten streams compete for the same L1/L2 sets and run several times
+ * slower. Each plane is shifted by its own multiple of a page plus a cache line.
+ * Read buffers stay page-aligned for O_DIRECT.
+ */
+size_t StaggerOffset(WorkspaceSlot slot)
+{
+    const uint32_t index = uint32_t(slot);
+    return index < uint32_t(WorkspaceSlot::ReadBuffer) ? size_t(index) * (4096 + 64) : 0;
+}
+
+// Anonymous mapping aligned to a huge page boundary, so every 2 MiB extent can be a huge page
+void* MapAligned(size_t bytes)
+{
+    size_t span = bytes + HUGE_PAGE_SIZE;
+    void* p = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return nullptr;
+
+    uintptr_t start = reinterpret_cast<uintptr_t>(p);
+    uintptr_t aligned = AlignUp(start, HUGE_PAGE_SIZE);
+    if (aligned > start)
+        munmap(p, aligned - start);
+    size_t tail = (start + span) - (aligned + bytes);
+    if (tail > 0)
+        munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+    return reinterpret_cast<void*>(aligned);
+}
+
+// Transparent huge page policy of the running kernel: "always", "madvise", "never" or ""
+std::string TransparentHugePagePolicy()
+{
+    FILE* f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (f == nullptr)
+        return "";
+    char line[128] = {};
+    if (fgets(line, sizeof(line), f) == nullptr)
+        line[0] = '\0';
+    fclose(f);
+
+    const char* open = strchr(line, '[');
+    const char* close = open != nullptr ? strchr(open, ']') : nullptr;
+    return close != nullptr ? std::string(open + 1, close) : "";
+}
+
+// AnonHugePages of the mappings that overlap [begin, end) ranges, from /proc/self/smaps
+uint64_t AnonHugeBytes(const std::vector<std::pair<uintptr_t, uintptr_t>>& ranges)
+{
+    FILE* f = fopen("/proc/self/smaps", "r");
+    if (f == nullptr)
+        return 0;
+
+    uint64_t total = 0;
+    bool inside = false;
+    char line[512];
+    while (fgets(line, sizeof(line), f) != nullptr)
+    {
+        unsigned long begin, end;
+        unsigned long long kb;
+        if (sscanf(line, "%lx-%lx ", &begin, &end) == 2 && strchr(line, '-') < strchr(line, ' '))
+        {
+            inside = std::any_of(ranges.begin(), ranges.end(), [&](const std::pair<uintptr_t, uintptr_t>& r)
+                                 { return r.first < end && begin < r.second; });
+        }
+        else if (inside && sscanf(line, "AnonHugePages: %llu kB", &kb) == 1)
+            total += uint64_t(kb) * 1024;
+    }
+    fclose(f);
+    return total;
+}
+
+} // namespace
+
+WorkspaceArena::WorkspaceArena(HugePageMode hugePages)
+    : m_hugePages(hugePages)
+{
+}
+
+WorkspaceArena::~WorkspaceArena()
+{
+    Release();
+}
+
+void WorkspaceArena::BeginRun()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.reused = 0;
+    m_stats.allocated = 0;
+    m_stats.allocatedBytes = 0;
+    ++m_stats.runs;
+}
+
+void WorkspaceArena::SetHugePageMode(HugePageMode mode)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_hugePages = mode;
+}
+
+void* WorkspaceArena::Acquire(WorkspaceSlot slot, size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    bytes = AlignUp(std::max<size_t>(bytes, 1), PageSize());
+
+    Buffer& buffer = m_buffers[uint32_t(slot)];
+    if (buffer.data != nullptr && buffer.capacity >= bytes && buffer.capacity <= 2 * bytes)
+    {
+        ++m_stats.reused;
+        return buffer.data;
+    }
+
+    Free(buffer);
+    const size_t offset = StaggerOffset(slot);
+    if (!Allocate(buffer, bytes + offset))
+        return nullptr;
+    buffer.data = static_cast<uint8_t*>(buffer.base) + offset;
+    buffer.capacity = buffer.mapped - offset;
+
+    ++m_stats.allocated;
+    m_stats.allocatedBytes += buffer.mapped;
+    m_stats.residentBytes += buffer.mapped;
+    m_stats.peakResidentBytes = std::max(m_stats.peakResidentBytes, m_stats.residentBytes);
+    return buffer.data;
+}
+
+bool WorkspaceArena::Allocate(Buffer& buffer, size_t bytes)
+{
+    // Small buffers would only waste most of a huge page
+    if (m_hugePages != HugePageMode::Off && bytes >= HUGE_PAGE_SIZE)
+    {
+        const size_t mapped = AlignUp(bytes, HUGE_PAGE_SIZE);
+
+#ifdef MAP_HUGETLB
+        if (m_hugePages == HugePageMode::HugeTLB)
+        {
+            // Reserved at map time, so a short pool fails here rather than at first touch
+            void* p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED)
+            {
+                buffer = Buffer{ p, p, mapped, mapped, Backing::HugeTLB };
+                m_stats.hugetlbBytes += mapped;
+                return true;
+            }
+            Note("hugetlbfs pages unavailable (" + std::string(strerror(errno))
+                 + "; see vm.nr_hugepages), using transparent huge pages");
+        }
+#endif
+
+#ifdef MADV_HUGEPAGE
+        if (void* p = MapAligned(mapped))
+        {
+            if (madvise(p, mapped, MADV_HUGEPAGE) == 0)
+                m_stats.transparentAdvisedBytes += mapped;
+            else
+                Note("madvise(MADV_HUGEPAGE) failed: " + std::string(strerror(errno)));
+            buffer = Buffer{ p, p, mapped, mapped, Backing::Transparent };
+            return true;
+        }
+#endif
+    }
+
+    void* p = nullptr;
+    if (posix_memalign(&p, PageSize(), bytes) != 0)
+        return false;
+    buffer = Buffer{ p, p, bytes, bytes, Backing::Heap };
+    return true;
+}
+
+void WorkspaceArena::Free(Buffer& buffer)
+{
+    if (buffer.base == nullptr)
+        return;
+
+    switch (buffer.backing)
+    {
+    case Backing::Heap:
+        free(buffer.base);
+        break;
+    case Backing::HugeTLB:
+        munmap(buffer.base, buffer.mapped);
+        m_stats.hugetlbBytes -= buffer.mapped;
+        break;
+    case Backing::Transparent:
+        munmap(buffer.base, buffer.mapped);
+        m_stats.transparentAdvisedBytes -= std::min<uint64_t>(m_stats.transparentAdvisedBytes, buffer.mapped);
+        break;
+    }
+
+    m_stats.residentBytes -= buffer.mapped;
+    buffer = Buffer();
+}
+
+void WorkspaceArena::Note(const std::string& note)
+{
+    if (m_stats.hugePageNote.find(note) != std::string::npos)
+        return;
+    if (!m_stats.hugePageNote.empty())
+        m_stats.hugePageNote += "; ";
+    m_stats.hugePageNote += note;
+}
+
+void WorkspaceArena::Release()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& entry : m_buffers)
+        Free(entry.second);
+    m_buffers.clear();
+}
+
+WorkspaceStats WorkspaceArena::Counters() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void WorkspaceArena::ResetPeak()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.peakResidentBytes = m_stats.residentBytes;
+}
+
+WorkspaceStats WorkspaceArena::Stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    WorkspaceStats stats = m_stats;
+
+    std::vector<std::pair<uintptr_t, uintptr_t>> ranges;
+    for (const auto& entry : m_buffers)
+    {
+        if (entry.second.backing == Backing::Transparent)
+        {
+            uintptr_t begin = reinterpret_cast<uintptr_t>(entry.second.base);
+            ranges.emplace_back(begin, begin + entry.second.mapped);
+        }
+    }
+    if (!ranges.empty())
+    {
+        // smaps reports whole VMAs, which the kernel may merge with neighbouring anonymous memory
+        stats.transparentBackedBytes = std::min(AnonHugeBytes(ranges), stats.transparentAdvisedBytes);
+
+        // The kernel policy explains a zero count better than anything measured here
+        std::string policy = TransparentHugePagePolicy();
+        if (policy == "never" && stats.hugePageNote.empty())
+            stats.hugePageNote = "transparent huge pages are disabled (transparent_hugepage/enabled = never)";
+    }
+
+    return stats;
+}
+
+} // namespace pcl
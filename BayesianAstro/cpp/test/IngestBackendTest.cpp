@@ -0,0 +1,214 @@
+/**
+ * Ingest Backend Test
+ *
+ * Drives FrameIngest through a backend that performs the reads with pread and
+ * cuts chosen completions short, as a kernel may under memory pressure or on
+ * network filesystems. A short read must be resumed to a correct frame in both
+ * buffered and O_DIRECT modes; on an O_DIRECT fd the resumed read has to stay
+ * block-aligned, which the backend checks the way the kernel does (EINVAL).
+ */
+
+#include "FitsWriter.h"
+#include "FrameIngest.h"
+#include "IngestBackend.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace pcl;
+
+namespace
+{
+
+constexpr size_t BLOCK = 4096;
+
+int g_failures = 0;
+
+#define CHECK(cond)                                                           \
+    do                                                                        \
+    {                                                                         \
+        if (!(cond))                                                          \
+        {                                                                     \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++g_failures;                                                     \
+        }                                                                     \
+    } while (0)
+
+// Synchronous pread backend that reports 'shortBytes' instead of the full count for
+// the read numbered 'shortRead' (0-based), and rejects misaligned O_DIRECT reads
+class ShortReadBackend : public IngestBackend
+{
+public:
+    ShortReadBackend(int queueDepth, int shortRead, size_t shortBytes)
+        : m_queueDepth(queueDepth), m_shortRead(shortRead), m_shortBytes(shortBytes)
+    {
+    }
+
+    const char* Name() const override { return "short-read"; }
+    int QueueDepth() const override { return m_queueDepth; }
+    int InFlight() const override { return int(m_completions.size()); }
+
+    bool Submit(const std::vector<ReadRequest>& batch, std::string&) override
+    {
+        for (const ReadRequest& r : batch)
+        {
+            ReadCompletion c;
+            c.tag = r.tag;
+            c.result = Read(r);
+            m_completions.push_back(c);
+        }
+        return true;
+    }
+
+    size_t Reap(std::vector<ReadCompletion>& out, size_t) override
+    {
+        size_t n = m_completions.size();
+        out.insert(out.end(), m_completions.begin(), m_completions.end());
+        m_completions.clear();
+        return n;
+    }
+
+    int ShortReads() const { return m_shortReads; }
+    int MisalignedDirectReads() const { return m_misaligned; }
+
+private:
+    int64_t Read(const ReadRequest& r)
+    {
+        int flags = fcntl(r.fd, F_GETFL);
+#ifdef O_DIRECT
+        if (flags >= 0 && (flags & O_DIRECT) != 0
+            && (r.offset % BLOCK != 0 || uintptr_t(r.buffer) % BLOCK != 0 || r.length % BLOCK != 0))
+        {
+            ++m_misaligned;
+            return -EINVAL;
+        }
+#else
+        (void)flags;
+#endif
+        ssize_t n = pread(r.fd, r.buffer, r.length, off_t(r.offset));
+        if (n < 0)
+            return -int64_t(errno);
+
+        // The kernel filled the buffer but reports fewer bytes, as a real short completion would
+        if (m_reads++ == m_shortRead && m_shortBytes < size_t(n))
+        {
+            n = ssize_t(m_shortBytes);
+            ++m_shortReads;
+        }
+        return int64_t(n);
+    }
+
+    int m_queueDepth;
+    int m_shortRead;
+    size_t m_shortBytes;
+    int m_reads = 0;
+    int m_shortReads = 0;
+    int m_misaligned = 0;
+    std::vector<ReadCompletion> m_completions;
+};
+
+std::vector<float> TestPlane(int64_t height, int64_t width)
+{
+    std::vector<float> plane(size_t(height * width));
+    for (size_t i = 0; i < plane.size(); ++i)
+        plane[i] = float(i % 9973) * 0.25f;
+    return plane;
+}
+
+// Read one frame through a ShortReadBackend; returns the ingest error, if any
+std::string ReadFrame(const std::string& path, IngestCacheMode cacheMode, int shortRead, size_t shortBytes,
+                      std::vector<float>& pixels, std::string& cacheModeName, int& shortReads, int& misaligned)
+{
+    IngestOptions options;
+    options.queueDepth = 4;
+    options.readAheadFrames = 1;
+    options.stripBytes = 4 * BLOCK;
+    options.cacheMode = cacheMode;
+
+    FrameIngest ingest({path}, options);
+    auto backend = std::make_unique<ShortReadBackend>(options.queueDepth, shortRead, shortBytes);
+    ShortReadBackend* reads = backend.get();
+    ingest.SetBackend(std::move(backend));
+
+    std::string error;
+    IngestFrame frame;
+    if (ingest.Open(error) && ingest.Next(frame, error))
+        pixels.assign(frame.pixels, frame.pixels + frame.height * frame.width);
+
+    cacheModeName = ingest.Stats().cacheMode;
+    shortReads = reads->ShortReads();
+    misaligned = reads->MisalignedDirectReads();
+    return error;
+}
+
+void TestShortRead(const std::string& path, const std::vector<float>& plane, IngestCacheMode cacheMode)
+{
+    // Three whole blocks and part of a fourth: O_DIRECT resumes at the third block boundary
+    std::vector<float> pixels;
+    std::string mode;
+    int shortReads = 0, misaligned = 0;
+    std::string error = ReadFrame(path, cacheMode, 0, 3 * BLOCK + 1000, pixels, mode, shortReads, misaligned);
+
+    printf("short read, %s: %s\n", mode.c_str(), error.empty() ? "ok" : error.c_str());
+    CHECK(error.empty());
+    CHECK(shortReads == 1);
+    CHECK(misaligned == 0);
+    CHECK(pixels == plane);
+}
+
+void TestTruncatedDirect(const std::string& path)
+{
+    // The file ends mid-block inside the data: the resumed read must fail, not spin
+    std::vector<float> pixels;
+    std::string mode;
+    int shortReads = 0, misaligned = 0;
+    std::string error = ReadFrame(path, IngestCacheMode::DirectIO, -1, 0, pixels, mode, shortReads, misaligned);
+
+    printf("truncated, %s: %s\n", mode.c_str(), error.c_str());
+    CHECK(error.find("unexpected end of file") != std::string::npos);
+    CHECK(misaligned == 0);
+}
+
+} // namespace
+
+int main()
+{
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / ("ba_ingest_test_" + std::to_string(getpid()));
+    fs::create_directories(dir);
+
+    const int64_t height = 96, width = 160;
+    std::vector<float> plane = TestPlane(height, width);
+    std::string path = (dir / "frame.fits").string();
+    std::string error;
+    if (!WriteFitsPlane(path, plane.data(), height, width, PlaneWriteOptions(), {}, nullptr, error))
+    {
+        fprintf(stderr, "cannot write %s: %s\n", path.c_str(), error.c_str());
+        return 1;
+    }
+
+    TestShortRead(path, plane, IngestCacheMode::Buffered);
+    TestShortRead(path, plane, IngestCacheMode::DirectIO);
+
+    std::string truncated = (dir / "truncated.fits").string();
+    fs::copy_file(path, truncated);
+    fs::resize_file(truncated, fs::file_size(path) - 3 * BLOCK - 100);
+    TestTruncatedDirect(truncated);
+
+    fs::remove_all(dir);
+
+    if (g_failures != 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
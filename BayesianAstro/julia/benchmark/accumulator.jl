@@ -0,0 +1,79 @@
+#=
+Accumulator layout benchmark: Matrix{PixelDistribution} (one heap object per
+pixel) vs DistributionAccumulator (structure of arrays).
+
+Reports, for each layout: allocation time and bytes, GC-tracked objects,
+resident size, per-frame accumulation time and finalization time.
+
+Usage:
+    julia --project=. -t auto benchmark/accumulator.jl [megapixels] [frames]
+=#
+
+using BayesianAstro
+using Printf
+
+function legacy_accumulate!(distributions::Matrix{PixelDistribution}, frame::Matrix{Float32})
+    height, width = size(frame)
+    Threads.@threads for j in 1:width
+        for i in 1:height
+            accumulate!(distributions[i, j], frame[i, j])
+        end
+    end
+    return nothing
+end
+
+function legacy_finalize(distributions::Matrix{PixelDistribution})
+    height, width = size(distributions)
+    output = Matrix{Float32}(undef, height, width)
+    confidence = Matrix{Float32}(undef, height, width)
+    Threads.@threads for j in 1:width
+        for i in 1:height
+            dist = distributions[i, j]
+            output[i, j] = dist.mean
+            confidence[i, j] = compute_confidence(dist)
+        end
+    end
+    return (output, confidence)
+end
+
+function measure(label, make, accumulate, finalize, frames)
+    # Warm up compilation on a tiny instance
+    small = make(4, 4)
+    accumulate(small, rand(Float32, 4, 4))
+    finalize(small)
+
+    height, width = size(frames[1])
+    GC.gc()
+    t_alloc = @elapsed begin
+        bytes_alloc = @allocated (acc = make(height, width))
+    end
+    resident = Base.summarysize(acc)
+
+    GC.gc()
+    t_acc = @elapsed for frame in frames
+        accumulate(acc, frame)
+    end
+    t_gc = @elapsed GC.gc(true)
+    t_fin = @elapsed finalize(acc)
+
+    mpix = height * width / 1e6
+    @printf("%-28s alloc %6.3f s (%8.1f MB)  resident %8.1f MB  accumulate %7.1f ms/frame (%6.1f Mpx/s)  full GC %6.3f s  finalize %6.3f s\n",
+            label, t_alloc, bytes_alloc / 2^20, resident / 2^20,
+            1000 * t_acc / length(frames), mpix * length(frames) / t_acc, t_gc, t_fin)
+end
+
+function main(megapixels::Float64=8.0, n_frames::Int=10)
+    height = 2048
+    width = max(1, round(Int, megapixels * 1e6 / height))
+    frames = [rand(Float32, height, width) .* 1000 for _ in 1:n_frames]
+    println("$(height)×$(width) ($(round(height * width / 1e6, digits=1)) Mpx), $n_frames frames, $(Threads.nthreads()) threads")
+
+    measure("Matrix{PixelDistribution}",
+            (h, w) -> [PixelDistribution() for _ in 1:h, _ in 1:w],
+            legacy_accumulate!, legacy_finalize, frames)
+    measure("DistributionAccumulator",
+            DistributionAccumulator, cpu_accumulate!, cpu_finalize!, frames)
+end
+
+main(length(ARGS) >= 1 ? parse(Float64, ARGS[1]) : 8.0,
+     length(ARGS) >= 2 ? parse(Int, ARGS[2]) : 10)
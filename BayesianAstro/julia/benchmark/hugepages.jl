@@ -0,0 +1,97 @@
+#=
+Huge page benchmark: accumulate and finalize throughput of a DistributionAccumulator
+whose planes live in anonymous mappings, the way the PixInsight module's workspace
+arena provides them.
+
+Layouts:
+- 4 KiB pages (MADV_NOHUGEPAGE), planes staggered
+- 2 MiB transparent huge pages (MADV_HUGEPAGE), planes staggered (the arena's layout)
+- 2 MiB transparent huge pages, every plane 2 MiB-aligned (shows cache-set aliasing)
+
+Reports Mpx/s per layout and how much of the mapping the kernel backed with huge
+pages (AnonHugePages). Linux only.
+
+Usage:
+    julia --project=. -t auto benchmark/hugepages.jl [megapixels] [frames]
+=#
+
+using BayesianAstro
+using Printf
+
+const HUGE_PAGE = 2^21
+const PROT_READ_WRITE = Cint(3)
+const MAP_PRIVATE_ANONYMOUS = Cint(0x22)
+const MADV_HUGEPAGE = Cint(14)
+const MADV_NOHUGEPAGE = Cint(15)
+
+# Same shift as the arena's StaggerOffset: a page plus a cache line per plane
+stagger(index) = index * (4096 + 64)
+
+"""
+Map a 2 MiB-aligned anonymous plane. The mapping is never unmapped; the benchmark
+process is short-lived.
+"""
+function mapped_plane(::Type{T}, dims, huge::Bool, offset::Int) where T
+    bytes = prod(dims) * sizeof(T) + offset
+    span = cld(bytes, HUGE_PAGE) * HUGE_PAGE + HUGE_PAGE
+    p = ccall(:mmap, Ptr{Cvoid}, (Ptr{Cvoid}, Csize_t, Cint, Cint, Cint, Int64),
+              C_NULL, span, PROT_READ_WRITE, MAP_PRIVATE_ANONYMOUS, -1, 0)
+    p == Ptr{Cvoid}(typemax(UInt)) && error("mmap failed")
+    base = Ptr{UInt8}(cld(UInt(p), HUGE_PAGE) * HUGE_PAGE)
+    ccall(:madvise, Cint, (Ptr{Cvoid}, Csize_t, Cint), base, span - HUGE_PAGE,
+          huge ? MADV_HUGEPAGE : MADV_NOHUGEPAGE)
+    return unsafe_wrap(Matrix{T}, Ptr{T}(base + offset), dims)
+end
+
+function anon_huge_bytes()
+    for line in eachline("/proc/self/smaps_rollup")
+        startswith(line, "AnonHugePages:") && return parse(Int, split(line)[2]) * 1024
+    end
+    return 0
+end
+
+function measure(label, huge::Bool, staggered::Bool, frames)
+    height, width = size(frames[1])
+    dims = (height, width)
+    offset(i) = staggered ? stagger(i) : 0
+
+    huge_before = anon_huge_bytes()
+    acc = DistributionAccumulator(mapped_plane(UInt16, dims, huge, offset(0)),
+                                  (mapped_plane(Float32, dims, huge, offset(i)) for i in 1:6)...)
+    output = mapped_plane(Float32, dims, huge, offset(7))
+    confidence = mapped_plane(Float32, dims, huge, offset(8))
+    classes = mapped_plane(UInt8, dims, huge, offset(9))
+
+    t_touch = @elapsed reset!(acc)
+    cpu_accumulate!(acc, frames[1])  # compile and fault in
+    reset!(acc)
+
+    t_acc = @elapsed for frame in frames
+        cpu_accumulate!(acc, frame)
+    end
+    t_fin = @elapsed cpu_finalize!(output, confidence, classes, acc)
+
+    mpix = height * width / 1e6
+    @printf("%-34s first touch %6.3f s  accumulate %7.1f Mpx/s  finalize %7.1f Mpx/s  huge pages %8.1f MB\n",
+            label, t_touch, mpix * length(frames) / t_acc, mpix / t_fin,
+            (anon_huge_bytes() - huge_before) / 2^20)
+end
+
+function main(megapixels::Float64=24.0, n_frames::Int=10)
+    height = 4096
+    width = max(1, round(Int, megapixels * 1e6 / height))
+    frames = [rand(Float32, height, width) .* 1000 for _ in 1:n_frames]
+    println("$(height)×$(width) ($(round(height * width / 1e6, digits=1)) Mpx), $n_frames frames, $(Threads.nthreads()) threads")
+
+    # Warm up compilation on a tiny accumulator
+    small = DistributionAccumulator(4, 4)
+    cpu_accumulate!(small, rand(Float32, 4, 4))
+    cpu_finalize!(zeros(Float32, 4, 4), zeros(Float32, 4, 4), zeros(UInt8, 4, 4), small)
+
+    measure("4 KiB pages, staggered", false, true, frames)
+    measure("2 MiB huge pages, staggered", true, true, frames)
+    measure("2 MiB huge pages, 2 MiB-aligned", true, false, frames)
+end
+
+main(length(ARGS) >= 1 ? parse(Float64, ARGS[1]) : 24.0,
+     length(ARGS) >= 2 ? parse(Int, ARGS[2]) : 10)
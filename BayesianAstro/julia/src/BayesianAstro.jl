@@ -5,7 +5,8 @@ A distribution-aware astrophotography stacking pipeline that preserves statistic
 information across frames for intelligent fusion decisions.
 
 ## Key Features
-- Per-pixel statistical distribution tracking via Welford's algorithm
+- Per-pixel statistical distribution tracking via Welford's algorithm, stored as a
+  structure of arrays (one matrix per moment) on both CPU and GPU
 - Confidence metrics derived from distribution properties  
 - Multiple fusion strategies (MLE, confidence-weighted, lucky imaging, multi-scale)
 - GPU acceleration via CUDA.jl
@@ -62,17 +63,20 @@ include("visualization/ConfidenceMaps.jl")
 
 # Re-export submodule functions
 using .FitsIO: load_fits, save_fits, load_frame_sequence, find_fits_files, parse_fits_date
+using .FitsIO: encode_plane, decode_plane, round_to_float16_precision
 using .Welford: accumulate!, finalize_statistics, reset!, variance, stddev, skewness, kurtosis, merge
 using .Classification: classify_distribution, is_artifact_candidate, is_reliable
 using .Confidence: compute_confidence, compute_pixel_result, confidence_weight
-using .Strategies: fuse_mle, fuse_confidence_weighted, fuse_lucky, fuse_multiscale, select_fusion_strategy
-using .Pipeline: process_stack, process_directory
+using .Strategies: fuse_mle, fuse_confidence_weighted, fuse_lucky, fuse_multiscale, fuse_pixel, select_fusion_strategy
+using .Pipeline: process_stack, process_directory, StackSession, begin_stack, accumulate_frame!,
+                 finalize_stack, finish_stack, finish_stack!, refinalize_stack!, memory_counters!
 using .ConfidenceMaps: generate_confidence_map, generate_classification_map, apply_confidence_colormap
 using .Kernels: is_gpu_available, create_gpu_context, destroy_gpu_context, GPUContext, cpu_accumulate!, cpu_finalize!, cpu_stretch!
 
 # Public API - Types
-export PixelDistribution, PixelResult, DistributionType, FrameMetadata, ProcessingConfig
-export ImageStack, FusionStrategy
+export AbstractPixelDistribution, PixelDistribution, PixelMoments, DistributionAccumulator
+export PixelResult, DistributionType, FrameMetadata, ProcessingConfig
+export ImageStack, FusionStrategy, OutputEncoding
 
 # Distribution type enum values
 export GAUSSIAN, POISSON, BIMODAL, SKEWED_RIGHT, SKEWED_LEFT, UNIFORM, UNKNOWN
@@ -80,8 +84,12 @@ export GAUSSIAN, POISSON, BIMODAL, SKEWED_RIGHT, SKEWED_LEFT, UNIFORM, UNKNOWN
 # Fusion strategy enum values
 export MLE, CONFIDENCE_WEIGHTED, LUCKY, MULTISCALE
 
+# Output encoding enum values
+export ENCODE_FLOAT32, ENCODE_FLOAT16, ENCODE_UINT16, ENCODE_UINT8, ENCODE_PACKED4
+
 # I/O functions
 export load_fits, save_fits, load_frame_sequence, find_fits_files, parse_fits_date
+export encode_plane, decode_plane, round_to_float16_precision
 
 # Statistics functions
 export accumulate!, finalize_statistics, reset!, variance, stddev, skewness, kurtosis
@@ -93,10 +101,12 @@ export classify_distribution, is_artifact_candidate, is_reliable
 export compute_confidence, compute_pixel_result, confidence_weight
 
 # Fusion functions
-export fuse_mle, fuse_confidence_weighted, fuse_lucky, fuse_multiscale, select_fusion_strategy
+export fuse_mle, fuse_confidence_weighted, fuse_lucky, fuse_multiscale, fuse_pixel, select_fusion_strategy
 
 # Pipeline functions
 export process_stack, process_directory
+export StackSession, begin_stack, accumulate_frame!, finalize_stack, finish_stack, finish_stack!, refinalize_stack!
+export memory_counters!
 
 # Visualization functions
 export generate_confidence_map, generate_classification_map, apply_confidence_colormap
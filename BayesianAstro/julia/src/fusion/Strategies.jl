@@ -6,22 +6,28 @@ final output values.
 """
 module Strategies
 
-using ..BayesianAstro: PixelDistribution, PixelResult, DistributionType, 
-                       FrameMetadata, FusionStrategy, ImageStack
-using ..Welford: variance, finalize_statistics
+using ..BayesianAstro: AbstractPixelDistribution, DistributionAccumulator, PixelResult,
+                       DistributionType, FrameMetadata, FusionStrategy, ImageStack,
+                       GAUSSIAN, POISSON, BIMODAL, SKEWED_RIGHT, SKEWED_LEFT,
+                       MLE, CONFIDENCE_WEIGHTED, LUCKY, MULTISCALE
+using ..Welford: accumulate!, variance, skewness, finalize_statistics
 using ..Classification: classify_distribution, is_reliable
 using ..Confidence: compute_confidence, compute_pixel_result
 
-export fuse_mle, fuse_confidence_weighted, fuse_lucky, fuse_multiscale
+export fuse_mle, fuse_confidence_weighted, fuse_lucky, fuse_multiscale, fuse_pixel
 export select_fusion_strategy
 
+# Below this absolute skewness the moments show no dominant cluster, and lucky
+# fusion of a distribution keeps the mean (the classifier's skewness threshold)
+const LUCKY_MIN_SKEWNESS = 0.5f0
+
 """
-    fuse_mle(dist::PixelDistribution) -> Float32
+    fuse_mle(dist::AbstractPixelDistribution) -> Float32
 
 Maximum Likelihood Estimation fusion.
 For Gaussian distributions, MLE estimate is simply the mean.
 """
-function fuse_mle(dist::PixelDistribution)::Float32
+function fuse_mle(dist::AbstractPixelDistribution)::Float32
     if dist.n == 0
         return 0.0f0
     end
@@ -45,13 +51,13 @@ function fuse_mle(dist::PixelDistribution)::Float32
 end
 
 """
-    fuse_confidence_weighted(dists::Vector{PixelDistribution}, 
+    fuse_confidence_weighted(dists::AbstractVector{<:AbstractPixelDistribution},
                              values::Vector{Float32}) -> Float32
 
 Confidence-weighted mean across frames.
 Each frame's contribution is weighted by confidence and inverse variance.
 """
-function fuse_confidence_weighted(dists::Vector{PixelDistribution}, 
+function fuse_confidence_weighted(dists::AbstractVector{<:AbstractPixelDistribution},
                                    values::Vector{Float32})::Float32
     @assert length(dists) == length(values)
     
@@ -134,7 +140,36 @@ function fuse_lucky(values::Vector{Float32}, metadata::Vector{FrameMetadata})::F
 end
 
 """
-    fuse_multiscale(dist::PixelDistribution, 
+    fuse_lucky(dist::AbstractPixelDistribution) -> Float32
+
+Per-pixel lucky imaging from the accumulated moments alone, for when the
+per-frame values are gone (finalizing kept accumulators). The frames are
+modelled as two clusters with the pixel's mean, variance and skewness, and
+the value of the larger one is returned: a transient seen in a few frames
+(cosmic ray, satellite, a gust of bad seeing) no longer pulls the result.
+Symmetric distributions have no larger cluster and keep the mean.
+"""
+function fuse_lucky(dist::AbstractPixelDistribution)::Float32
+    if dist.n == 0
+        return 0.0f0
+    end
+
+    skew = skewness(dist)
+    if abs(skew) <= LUCKY_MIN_SKEWNESS
+        return dist.mean
+    end
+
+    # Two-point distribution with the same moments: the smaller cluster holds a
+    # fraction q of the frames, on the side the skewness points to
+    q = (1.0f0 - abs(skew) / sqrt(skew * skew + 4.0f0)) / 2.0f0
+    offset = sqrt(variance(dist; corrected=false) * q / (1.0f0 - q))
+    value = skew > 0 ? dist.mean - offset : dist.mean + offset
+
+    return clamp(value, dist.min, dist.max)
+end
+
+"""
+    fuse_multiscale(dist::AbstractPixelDistribution,
                     spatial_frequency::Symbol) -> Float32
 
 Multi-scale fusion: different strategies at different spatial frequencies.
@@ -148,7 +183,7 @@ Multi-scale fusion: different strategies at different spatial frequencies.
 - Mid frequency: Confidence-weighted
 - Low frequency: Mean (maximize SNR for smooth gradients)
 """
-function fuse_multiscale(dist::PixelDistribution, spatial_frequency::Symbol)::Float32
+function fuse_multiscale(dist::AbstractPixelDistribution, spatial_frequency::Symbol)::Float32
     if dist.n == 0
         return 0.0f0
     end
@@ -167,6 +202,24 @@ function fuse_multiscale(dist::PixelDistribution, spatial_frequency::Symbol)::Fl
     end
 end
 
+"""
+    fuse_pixel(dist::AbstractPixelDistribution, strategy::FusionStrategy) -> Float32
+
+Fuse one pixel from its accumulated moments, as finalization does. Each
+strategy uses its single-distribution form: with one distribution per pixel
+confidence weighting is MLE, multi-scale without spatial frequencies is its
+mid-frequency (MLE) form, and lucky imaging keeps the dominant cluster.
+"""
+function fuse_pixel(dist::AbstractPixelDistribution, strategy::FusionStrategy)::Float32
+    if strategy == LUCKY
+        return fuse_lucky(dist)
+    elseif strategy == MULTISCALE
+        return fuse_multiscale(dist, :mid)
+    else
+        return fuse_mle(dist)
+    end
+end
+
 """
     select_fusion_strategy(dtype::DistributionType) -> FusionStrategy
 
@@ -193,17 +246,13 @@ CPU reference implementation.
 function fuse_image(stack::ImageStack{T}, strategy::FusionStrategy) where T
     height, width, n_frames = size(stack)
     
-    # Initialize distribution array
-    distributions = [PixelDistribution() for _ in 1:height, _ in 1:width]
+    # Structure-of-arrays accumulators (one matrix per moment)
+    distributions = DistributionAccumulator(height, width)
     
     # Accumulate statistics from all frames
     @info "Accumulating statistics from $n_frames frames..."
     for (frame_idx, frame) in enumerate(stack.frames)
-        for j in 1:width
-            for i in 1:height
-                accumulate!(distributions[i, j], Float32(frame[i, j]))
-            end
-        end
+        accumulate!(distributions, frame)
         
         if frame_idx % 10 == 0
             @info "  Processed $frame_idx/$n_frames frames"
@@ -218,12 +267,7 @@ function fuse_image(stack::ImageStack{T}, strategy::FusionStrategy) where T
         for i in 1:height
             dist = distributions[i, j]
             
-            fused_value = if strategy == MLE
-                fuse_mle(dist)
-            else
-                # Default to MLE for now
-                fuse_mle(dist)
-            end
+            fused_value = fuse_pixel(dist, strategy)
             
             results[i, j] = compute_pixel_result(dist, fused_value)
         end
@@ -232,7 +276,4 @@ function fuse_image(stack::ImageStack{T}, strategy::FusionStrategy) where T
     return results
 end
 
-# Import accumulate! for internal use
-using ..Welford: accumulate!
-
 end # module Strategies
@@ -12,12 +12,14 @@ Falls back to CPU implementation if CUDA is not available.
 """
 module Kernels
 
-using ..BayesianAstro: PixelDistribution, PixelResult, DistributionType,
+using ..BayesianAstro: DistributionAccumulator, PixelResult, DistributionType,
                        ProcessingConfig, CUDA_AVAILABLE, GAUSSIAN, POISSON,
-                       BIMODAL, SKEWED_RIGHT, SKEWED_LEFT, UNIFORM, UNKNOWN
-using ..Welford: variance, skewness, kurtosis
+                       BIMODAL, SKEWED_RIGHT, SKEWED_LEFT, UNIFORM, UNKNOWN,
+                       FusionStrategy, MLE
+using ..Welford: accumulate!, variance, skewness, kurtosis
 using ..Classification: classify_distribution
 using ..Confidence: compute_confidence
+using ..Strategies: fuse_pixel
 
 export gpu_accumulate!, gpu_finalize!, gpu_fuse!, gpu_stretch!
 export is_gpu_available, create_gpu_context, destroy_gpu_context
@@ -631,62 +633,57 @@ end  # _load_cuda_kernels
 """
     cpu_accumulate!(distributions, frame)
 
-CPU fallback for frame accumulation using threads.
+CPU fallback for frame accumulation using threads. Operates on the same
+structure-of-arrays layout as `gpu_accumulate!`.
 """
 function cpu_accumulate!(
-    distributions::Matrix{PixelDistribution},
-    frame::Matrix{Float32}
+    distributions::DistributionAccumulator,
+    frame::AbstractMatrix{<:Real}
 )
-    height, width = size(frame)
-    @assert size(distributions) == (height, width)
-
-    Threads.@threads for j in 1:width
-        for i in 1:height
-            dist = distributions[i, j]
-            value = frame[i, j]
-
-            # Welford update
-            n1 = dist.n
-            dist.n += 1
-            n = dist.n
-
-            dist.min = min(dist.min, value)
-            dist.max = max(dist.max, value)
-
-            delta = value - dist.mean
-            delta_n = delta / n
-            delta_n2 = delta_n * delta_n
-            term1 = delta * delta_n * n1
-
-            dist.mean += delta_n
-            dist.m4 += term1 * delta_n2 * (n*n - 3*n + 3) + 6 * delta_n2 * dist.m2 - 4 * delta_n * dist.m3
-            dist.m3 += term1 * delta_n * (n - 2) - 3 * delta_n * dist.m2
-            dist.m2 += term1
-        end
-    end
-
+    accumulate!(distributions, frame)
     return nothing
 end
 
 """
-    cpu_finalize!(distributions) -> (output, confidence, dist_types)
+    cpu_finalize!(distributions; strategy=MLE) -> (output, confidence, dist_types)
 
 CPU fallback for finalization.
 """
-function cpu_finalize!(distributions::Matrix{PixelDistribution})
+function cpu_finalize!(distributions::DistributionAccumulator; strategy::FusionStrategy=MLE)
     height, width = size(distributions)
 
     output = Matrix{Float32}(undef, height, width)
     confidence = Matrix{Float32}(undef, height, width)
     dist_types = Matrix{DistributionType}(undef, height, width)
 
+    return cpu_finalize!(output, confidence, dist_types, distributions; strategy=strategy)
+end
+
+"""
+    cpu_finalize!(output, confidence, dist_types, distributions; strategy=MLE) -> (output, confidence, dist_types)
+
+Finalize into caller-provided planes (e.g. host-owned workspace memory).
+`dist_types` may hold `DistributionType` values or their `UInt8` codes.
+Each pixel is fused with `fuse_pixel` for `strategy`.
+"""
+function cpu_finalize!(
+    output::AbstractMatrix{Float32},
+    confidence::AbstractMatrix{Float32},
+    dist_types::AbstractMatrix{T},
+    distributions::DistributionAccumulator;
+    strategy::FusionStrategy=MLE
+) where {T<:Union{DistributionType,UInt8}}
+    height, width = size(distributions)
+    @assert size(output) == size(confidence) == size(dist_types) == (height, width)
+
     Threads.@threads for j in 1:width
-        for i in 1:height
-            dist = distributions[i, j]
+        @inbounds for i in 1:height
+            dist = distributions[i, j]  # PixelMoments: loaded into registers, no allocation
 
-            output[i, j] = dist.mean  # MLE
+            output[i, j] = fuse_pixel(dist, strategy)
             confidence[i, j] = compute_confidence(dist)
-            dist_types[i, j] = classify_distribution(dist)
+            dtype = classify_distribution(dist)
+            dist_types[i, j] = T === UInt8 ? UInt8(Integer(dtype)) : dtype
         end
     end
 
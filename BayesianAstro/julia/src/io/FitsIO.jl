@@ -8,10 +8,12 @@ module FitsIO
 
 using FITSIO
 using Dates
-using ..BayesianAstro: FrameMetadata, ImageStack
+using ..BayesianAstro: FrameMetadata, ImageStack, OutputEncoding
+using ..BayesianAstro: ENCODE_FLOAT32, ENCODE_FLOAT16, ENCODE_UINT16, ENCODE_UINT8, ENCODE_PACKED4
 
 export load_fits, save_fits, load_frame_sequence, get_fits_metadata
 export load_fits_cube, find_fits_files, parse_fits_date
+export encode_plane, decode_plane, round_to_float16_precision
 
 """
     load_fits(filepath::String) -> Matrix{Float32}
@@ -22,10 +24,15 @@ Handles both 2D images and 3D cubes (returns first plane).
 function load_fits(filepath::String)::Matrix{Float32}
     f = FITS(filepath, "r")
     try
-        data = read(f[1])
+        hdu = image_hdu(f)
+        data = read(hdu)
         
         # Handle different dimensionalities
         if ndims(data) == 2
+            header = read_header(hdu)
+            if haskey(header, "BAENCODE") && strip(string(header["BAENCODE"])) == "PACKED4"
+                return Float32.(decode_plane(UInt8.(data), ENCODE_PACKED4; height=Int(header["BANAXIS1"])))
+            end
             return Float32.(data)
         elseif ndims(data) == 3
             # Return first channel/plane
@@ -56,19 +63,120 @@ function load_fits_cube(filepath::String)::Array{Float32, 3}
     end
 end
 
+# Tile-compressed files keep the image in the first extension behind an empty primary
+function image_hdu(f::FITS)
+    return length(f) > 1 && isempty(size(f[1])) ? f[2] : f[1]
+end
+
 """
-    save_fits(filepath::String, data::AbstractMatrix; header_cards=Dict())
+    round_to_float16_precision(x::Float32) -> Float32
 
-Save image data to a FITS file with optional header cards.
+Round the significand of `x` to IEEE half precision (11 bits, round to nearest even)
+while keeping the Float32 exponent range, so large ADU values cannot overflow.
 """
-function save_fits(filepath::String, data::AbstractMatrix; header_cards::Dict{String,Any}=Dict{String,Any}())
-    f = FITS(filepath, "w")
+function round_to_float16_precision(x::Float32)::Float32
+    isfinite(x) || return x
+    bits = reinterpret(UInt32, x)
+    bits = (bits + 0x00000fff + ((bits >> 13) & 0x00000001)) & ~UInt32(0x1fff)
+    return reinterpret(Float32, bits)
+end
+
+"""
+    encode_plane(data::AbstractMatrix, encoding::OutputEncoding; range=nothing) -> (encoded, cards)
+
+Encode a result plane for storage and return the stored array together with the
+header cards needed to interpret it. `range` fixes the `(low, high)` span of
+`ENCODE_UINT16` (default: the finite extrema of `data`).
+"""
+function encode_plane(data::AbstractMatrix, encoding::OutputEncoding; range=nothing)
+    cards = Dict{String,Any}()
+
+    if encoding == ENCODE_FLOAT32
+        return Float32.(data), cards
+    elseif encoding == ENCODE_FLOAT16
+        cards["BAENCODE"] = "FLOAT16"
+        return round_to_float16_precision.(Float32.(data)), cards
+    elseif encoding == ENCODE_UINT16
+        # 65534 levels; -32768 is reserved for NaN (BLANK)
+        finite = filter(isfinite, data)
+        low, high = range !== nothing ? Float64.(range) :
+                    isempty(finite) ? (0.0, 0.0) : Float64.(extrema(finite))
+        scale = high > low ? (high - low) / 65534 : 1.0
+        encoded = map(data) do x
+            isfinite(x) || return Int16(-32768)
+            Int16(clamp(round(Int, (x - low) / scale), 0, 65534) - 32767)
+        end
+        cards["BSCALE"] = scale
+        cards["BZERO"] = low + 32767 * scale
+        cards["BLANK"] = -32768
+        cards["BAENCODE"] = "UINT16"
+        return encoded, cards
+    elseif encoding == ENCODE_UINT8
+        return UInt8.(data), cards
+    else # ENCODE_PACKED4
+        h, w = size(data)
+        packed = zeros(UInt8, cld(h, 2), w)
+        for j in 1:w, i in 1:h
+            code = UInt8(data[i, j]) & 0x0f
+            packed[(i + 1) >> 1, j] |= isodd(i) ? code : code << 4
+        end
+        cards["BAENCODE"] = "PACKED4"
+        cards["BANAXIS1"] = h
+        return packed, cards
+    end
+end
+
+"""
+    decode_plane(encoded::AbstractMatrix, encoding::OutputEncoding; scale=1.0, zero=0.0, height=0)
+
+Invert `encode_plane`. `scale`/`zero` are the BSCALE/BZERO of `ENCODE_UINT16`;
+`height` is the unpacked first dimension (BANAXIS1) of `ENCODE_PACKED4`.
+"""
+function decode_plane(encoded::AbstractMatrix, encoding::OutputEncoding;
+                      scale::Real=1.0, zero::Real=0.0, height::Integer=0)
+    if encoding == ENCODE_UINT16
+        return map(r -> r == -32768 ? NaN32 : Float32(zero + scale * r), encoded)
+    elseif encoding == ENCODE_PACKED4
+        w = size(encoded, 2)
+        decoded = Matrix{UInt8}(undef, height, w)
+        for j in 1:w, i in 1:height
+            byte = encoded[(i + 1) >> 1, j]
+            decoded[i, j] = isodd(i) ? byte & 0x0f : byte >> 4
+        end
+        return decoded
+    else
+        return copy(encoded)
+    end
+end
+
+"""
+    save_fits(filepath::String, data::AbstractMatrix; header_cards=Dict(),
+              encoding=ENCODE_FLOAT32, compress=false, range=nothing)
+
+Save image data to a FITS file with optional header cards. `encoding` selects
+the stored representation (see `encode_plane`); `compress` enables lossless
+GZIP tile compression, which `ENCODE_FLOAT16` always uses.
+"""
+function save_fits(filepath::String, data::AbstractMatrix; header_cards::Dict{String,Any}=Dict{String,Any}(),
+                   encoding::OutputEncoding=ENCODE_FLOAT32, compress::Bool=false, range=nothing)
+    encoded, cards = encode_plane(data, encoding; range=range)
+
+    # CFITSIO extended filename syntax; q 0 keeps float planes lossless
+    if compress || encoding == ENCODE_FLOAT16
+        method = sizeof(eltype(encoded)) > 1 ? "GZIP_2" : "GZIP_1"
+        target = filepath * "[compress $method; q 0]"
+    else
+        target = filepath
+    end
+
+    f = FITS(target, "w")
     try
-        write(f, Float32.(data))
+        write(f, encoded)
+        hdu = image_hdu(f)
         
-        # Add custom header cards
-        for (key, value) in header_cards
-            write_key(f[1], key, value)
+        # Encoding cards first, then custom header cards
+        for (key, value) in merge(cards, header_cards)
+            write_key(hdu, key, value)
         end
     finally
         close(f)
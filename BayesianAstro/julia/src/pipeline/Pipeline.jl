@@ -3,17 +3,276 @@ High-level pipeline orchestration for the Bayesian stacking workflow.
 """
 module Pipeline
 
-using ..BayesianAstro: PixelDistribution, PixelResult, DistributionType,
+using ..BayesianAstro: DistributionAccumulator, PixelResult, DistributionType,
                        FrameMetadata, FusionStrategy, ProcessingConfig,
-                       ImageStack, CUDA_AVAILABLE
+                       ImageStack, CUDA_AVAILABLE,
+                       GAUSSIAN, POISSON, BIMODAL, SKEWED_RIGHT, SKEWED_LEFT, UNIFORM
 using ..FitsIO: load_fits, save_fits, load_frame_sequence, find_fits_files
-using ..Welford: accumulate!, finalize_statistics
+using ..Welford: accumulate!, finalize_statistics, reset!
 using ..Classification: classify_distribution
 using ..Confidence: compute_confidence, compute_pixel_result
 using ..Strategies: fuse_mle, fuse_confidence_weighted
 using ..Kernels: is_gpu_available, cpu_accumulate!, cpu_finalize!
 
 export process_stack, process_directory, extract_values, extract_confidences
+export extract_values!, extract_confidences!
+export StackSession, begin_stack, accumulate_frame!, finalize_stack, finish_stack, finish_stack!
+export refinalize_stack!
+export memory_counters!
+
+"""
+    StackSession
+
+Incremental stacking state for callers that stream frames one at a time,
+such as the native ingest path of the PixInsight module.
+
+# Fields
+- `config::ProcessingConfig`: Processing configuration
+- `distributions::DistributionAccumulator`: Per-pixel accumulators (structure of arrays)
+- `height::Int`, `width::Int`: Frame geometry
+- `n_frames::Int`: Frames accumulated so far
+- `t_start::Float64`: Wall-clock start of accumulation
+- `frame::Matrix{Float32}`, `frame_ptr::UInt`: Wrapper of the last caller-owned frame,
+  reused while the caller keeps handing over the same buffer
+- `frame_alloc_bytes::Int`: Bytes allocated while accumulating frames after the first
+"""
+mutable struct StackSession
+    config::ProcessingConfig
+    distributions::DistributionAccumulator
+    height::Int
+    width::Int
+    n_frames::Int
+    t_start::Float64
+    frame::Matrix{Float32}
+    frame_ptr::UInt
+    frame_alloc_bytes::Int
+end
+
+function StackSession(config::ProcessingConfig, distributions::DistributionAccumulator)
+    height, width = size(distributions)
+    return StackSession(config, distributions, height, width, 0, time(),
+                        Matrix{Float32}(undef, 0, 0), UInt(0), 0)
+end
+
+function log_stack_start(height::Integer, width::Integer, config::ProcessingConfig)
+    @info "Processing stack: $(width)×$(height) pixels"
+    @info "Fusion strategy: $(config.fusion_strategy)"
+    @info "GPU available: $(is_gpu_available() && config.use_gpu)"
+end
+
+"""
+    begin_stack(height, width, config) -> StackSession
+
+Allocate accumulators for a stack of `height`×`width` frames.
+"""
+function begin_stack(height::Integer, width::Integer, config::ProcessingConfig)
+    log_stack_start(height, width, config)
+    distributions = DistributionAccumulator(height, width)
+
+    @info "Phase 1: Accumulating statistics..."
+    return StackSession(config, distributions)
+end
+
+# Accumulator over caller-owned planes (column-major `height`×`width`), as they are
+function wrap_accumulator(height::Integer, width::Integer, n_ptr::UInt, mean_ptr::UInt, m2_ptr::UInt,
+                          m3_ptr::UInt, m4_ptr::UInt, min_ptr::UInt, max_ptr::UInt)
+    dims = (Int(height), Int(width))
+    plane(ptr) = unsafe_wrap(Matrix{Float32}, Ptr{Float32}(ptr), dims)
+    return DistributionAccumulator(
+        unsafe_wrap(Matrix{UInt16}, Ptr{UInt16}(n_ptr), dims),
+        plane(mean_ptr), plane(m2_ptr), plane(m3_ptr), plane(m4_ptr),
+        plane(min_ptr), plane(max_ptr))
+end
+
+"""
+    begin_stack(height, width, config, n_ptr, mean_ptr, m2_ptr, m3_ptr, m4_ptr, min_ptr, max_ptr) -> StackSession
+
+Start a stack on accumulator planes owned by the caller (the native workspace
+arena), so repeated runs of the same geometry allocate nothing. Planes are
+column-major `height`×`width` (`UInt16` counts, `Float32` moments), are reset
+here, and must stay valid until the session is finished.
+"""
+function begin_stack(height::Integer, width::Integer, config::ProcessingConfig,
+                     n_ptr::UInt, mean_ptr::UInt, m2_ptr::UInt, m3_ptr::UInt, m4_ptr::UInt,
+                     min_ptr::UInt, max_ptr::UInt)
+    log_stack_start(height, width, config)
+
+    distributions = wrap_accumulator(height, width, n_ptr, mean_ptr, m2_ptr, m3_ptr, m4_ptr, min_ptr, max_ptr)
+    reset!(distributions)
+
+    @info "Phase 1: Accumulating statistics..."
+    return StackSession(config, distributions)
+end
+
+"""
+    accumulate_frame!(session::StackSession, frame::AbstractMatrix{<:Real}) -> StackSession
+
+Accumulate one frame into the session's per-pixel distributions. Non-Float32
+frames are converted sample by sample, without a converted copy.
+"""
+function accumulate_frame!(session::StackSession, frame::AbstractMatrix{<:Real})
+    @assert size(frame) == (session.height, session.width) "Frame size $(size(frame)) does not match stack"
+
+    if is_gpu_available() && session.config.use_gpu
+        # GPU path (when implemented)
+        # gpu_accumulate!(distributions_gpu, frame_gpu, frame_idx)
+        cpu_accumulate!(session.distributions, frame)
+    else
+        cpu_accumulate!(session.distributions, frame)
+    end
+
+    session.n_frames += 1
+    return session
+end
+
+"""
+    accumulate_frame!(session::StackSession, ptr::UInt, height, width) -> StackSession
+
+Accumulate a frame held in caller-owned memory (column-major Float32) without copying.
+The memory must stay valid for the duration of the call. When the caller reuses one
+decode buffer, its wrapper is reused too, so steady-state frames allocate nothing
+beyond thread scheduling.
+"""
+function accumulate_frame!(session::StackSession, ptr::UInt, height::Integer, width::Integer)
+    bytes_before = Base.gc_bytes()
+
+    if ptr != session.frame_ptr || size(session.frame) != (height, width)
+        session.frame = unsafe_wrap(Matrix{Float32}, Ptr{Float32}(ptr), (Int(height), Int(width)))
+        session.frame_ptr = ptr
+    end
+    accumulate_frame!(session, session.frame)
+
+    # The first frame pays for compilation and wrapper setup; later ones are steady state
+    if session.n_frames > 1
+        session.frame_alloc_bytes += Base.gc_bytes() - bytes_before
+    end
+    return session
+end
+
+"""
+    finalize_stack(session::StackSession) -> Tuple{Matrix{Float32}, Matrix{Float32}, Matrix{DistributionType}}
+
+Finalize accumulated statistics into (fused_image, confidence_map, classifications).
+"""
+function finalize_stack(session::StackSession)
+    @info "  Accumulation of $(session.n_frames) frames complete in $(round(time() - session.t_start, digits=2))s"
+
+    @info "Phase 2: Finalizing and fusing..."
+    t_start = time()
+
+    fused_image, confidence_map, dist_types = cpu_finalize!(session.distributions;
+                                                                strategy=session.config.fusion_strategy)
+
+    @info "  Finalization complete in $(round(time() - t_start, digits=2))s"
+
+    log_result_statistics(confidence_map, dist_types)
+
+    return (fused_image, confidence_map, dist_types)
+end
+
+"""
+    finish_stack(session::StackSession, output_path::String) -> NamedTuple
+
+Finalize a session, save the fused image and confidence map (and classification
+map, if configured) next to `output_path` and return a summary for the host application.
+"""
+function finish_stack(session::StackSession, output_path::String)
+    fused, confidence, dist_types = finalize_stack(session)
+    save_outputs(output_path, fused, confidence, session.n_frames, session.config;
+                 dist_types=dist_types)
+    return result_summary(confidence, dist_types)
+end
+
+"""
+    finish_stack(session::StackSession) -> NamedTuple
+
+Finalize a session without saving, for hosts that encode and write the planes
+natively. Returns the summary fields plus the `fused`, `confidence` and
+`classification` (UInt8 codes) planes and their data pointers; the pointers stay
+valid while the returned tuple is rooted.
+"""
+function finish_stack(session::StackSession)
+    fused, confidence, dist_types = finalize_stack(session)
+    classification = UInt8.(Integer.(dist_types))
+    return merge(result_summary(confidence, dist_types), (
+        fused = fused,
+        confidence = confidence,
+        classification = classification,
+        fused_ptr = UInt(pointer(fused)),
+        confidence_ptr = UInt(pointer(confidence)),
+        classification_ptr = UInt(pointer(classification))
+    ))
+end
+
+"""
+    finish_stack!(session::StackSession, fused_ptr, confidence_ptr, classification_ptr) -> NamedTuple
+
+Finalize a session into caller-owned planes (column-major `height`×`width`:
+`Float32` fused image and confidence map, `UInt8` class codes) and return the
+summary fields plus `frame_alloc_bytes`, the average bytes allocated per
+steady-state frame.
+"""
+function finish_stack!(session::StackSession, fused_ptr::UInt, confidence_ptr::UInt,
+                       classification_ptr::UInt)
+    @info "  Accumulation of $(session.n_frames) frames complete in $(round(time() - session.t_start, digits=2))s"
+    summary = finalize_into!(session, fused_ptr, confidence_ptr, classification_ptr)
+
+    steady_frames = max(session.n_frames - 1, 1)
+    return merge(summary, (frame_alloc_bytes = session.frame_alloc_bytes ÷ steady_frames,))
+end
+
+"""
+    refinalize_stack!(height, width, config, n_ptr, mean_ptr, m2_ptr, m3_ptr, m4_ptr, min_ptr, max_ptr,
+                      fused_ptr, confidence_ptr, classification_ptr) -> NamedTuple
+
+Finalize accumulator planes kept from an earlier run again, with `config`, into
+caller-owned output planes. The accumulators are only read, so a host can change
+the fusion strategy without reading the frames again. Finalization does not read
+`config.confidence_threshold`. Returns the same fields as `finish_stack!`, with
+`frame_alloc_bytes` zero.
+"""
+function refinalize_stack!(height::Integer, width::Integer, config::ProcessingConfig,
+                           n_ptr::UInt, mean_ptr::UInt, m2_ptr::UInt, m3_ptr::UInt, m4_ptr::UInt,
+                           min_ptr::UInt, max_ptr::UInt,
+                           fused_ptr::UInt, confidence_ptr::UInt, classification_ptr::UInt)
+    @info "Refinalizing kept accumulators: $(width)×$(height) pixels"
+    @info "Fusion strategy: $(config.fusion_strategy)"
+    distributions = wrap_accumulator(height, width, n_ptr, mean_ptr, m2_ptr, m3_ptr, m4_ptr, min_ptr, max_ptr)
+    summary = finalize_into!(StackSession(config, distributions), fused_ptr, confidence_ptr, classification_ptr)
+    return merge(summary, (frame_alloc_bytes = 0,))
+end
+
+# Finalize a session into caller-owned planes and summarize them
+function finalize_into!(session::StackSession, fused_ptr::UInt, confidence_ptr::UInt, classification_ptr::UInt)
+    @info "Phase 2: Finalizing and fusing..."
+    t_start = time()
+
+    dims = (session.height, session.width)
+    fused = unsafe_wrap(Matrix{Float32}, Ptr{Float32}(fused_ptr), dims)
+    confidence = unsafe_wrap(Matrix{Float32}, Ptr{Float32}(confidence_ptr), dims)
+    classification = unsafe_wrap(Matrix{UInt8}, Ptr{UInt8}(classification_ptr), dims)
+    cpu_finalize!(fused, confidence, classification, session.distributions;
+                  strategy=session.config.fusion_strategy)
+
+    @info "  Finalization complete in $(round(time() - t_start, digits=2))s"
+    log_result_statistics(confidence, classification)
+
+    return result_summary(confidence, classification)
+end
+
+"""
+    memory_counters!(ptr::UInt) -> Nothing
+
+Store the cumulative Julia allocation count (bytes) and total GC time (ns) as two
+`UInt64` at `ptr`. The host samples these around each phase of a run; writing into
+its buffer keeps the sample itself allocation-free.
+"""
+function memory_counters!(ptr::UInt)
+    counters = Ptr{UInt64}(ptr)
+    unsafe_store!(counters, UInt64(Base.gc_bytes()), 1)
+    unsafe_store!(counters, UInt64(Base.gc_num().total_time), 2)
+    return nothing
+end
 
 """
     process_stack(stack::ImageStack, config::ProcessingConfig) -> Tuple{Matrix{Float32}, Matrix{Float32}}
@@ -28,55 +287,21 @@ Process an image stack and return fused image and confidence map.
 - Tuple of (fused_image, confidence_map) as Float32 matrices
 """
 function process_stack(stack::ImageStack{T}, config::ProcessingConfig) where T
-    height, width = stack.height, stack.width
     n_frames = length(stack)
-    
-    @info "Processing stack: $(width)×$(height) pixels, $n_frames frames"
-    @info "Fusion strategy: $(config.fusion_strategy)"
-    @info "GPU available: $(is_gpu_available() && config.use_gpu)"
-    
-    # Initialize distribution array
-    distributions = [PixelDistribution() for _ in 1:height, _ in 1:width]
-    
-    # Phase 1: Accumulate statistics
-    @info "Phase 1: Accumulating statistics..."
-    t_start = time()
-    
+    session = begin_stack(stack.height, stack.width, config)
+
     for (frame_idx, frame) in enumerate(stack.frames)
-        frame_f32 = Float32.(frame)
-        
-        if is_gpu_available() && config.use_gpu
-            # GPU path (when implemented)
-            # gpu_accumulate!(distributions_gpu, frame_gpu, frame_idx)
-            cpu_accumulate!(distributions, frame_f32)
-        else
-            cpu_accumulate!(distributions, frame_f32)
-        end
-        
+        accumulate_frame!(session, frame)
+
         if frame_idx % 10 == 0 || frame_idx == n_frames
-            elapsed = time() - t_start
+            elapsed = time() - session.t_start
             fps = frame_idx / elapsed
             @info "  Frame $frame_idx/$n_frames ($(round(fps, digits=1)) fps)"
         end
     end
-    
-    @info "  Accumulation complete in $(round(time() - t_start, digits=2))s"
-    
-    # Phase 2: Finalize and fuse
-    @info "Phase 2: Finalizing and fusing..."
-    t_start = time()
-    
-    results = cpu_finalize!(distributions)
-    
-    @info "  Finalization complete in $(round(time() - t_start, digits=2))s"
-    
-    # Extract output arrays
-    fused_image = extract_values(results)
-    confidence_map = extract_confidences(results)
-    
-    # Log statistics
-    log_result_statistics(results)
-    
+
+    fused_image, confidence_map, _ = finalize_stack(session)
+
     return (fused_image, confidence_map)
 end
 
@@ -102,30 +327,56 @@ function process_directory(input_dir::String, output_path::String;
     
     @info "Found $(length(files)) FITS files"
     
-    # Load stack
-    stack = load_frame_sequence(files)
-    
-    # Process
-    fused, confidence = process_stack(stack, config)
+    # Stream frames through a session; only one frame is resident at a time
+    first_frame = load_fits(files[1])
+    session = begin_stack(size(first_frame)..., config)
+    accumulate_frame!(session, first_frame)
+    for file in files[2:end]
+        accumulate_frame!(session, load_fits(file))
+    end
     
-    # Save outputs
+    # Finalize and save outputs
+    finish_stack(session, output_path)
+
+    return nothing
+end
+
+"""
+    save_outputs(output_path, fused, confidence, n_frames, config; dist_types=nothing)
+
+Write the fused image and confidence map as `<output_path>_fused.fits` and
+`<output_path>_confidence.fits`, plus `<output_path>_classification.fits` when
+`config.save_classification` is set and `dist_types` is given. Each plane uses
+its configured encoding.
+"""
+function save_outputs(output_path::String, fused::Matrix{Float32}, confidence::Matrix{Float32},
+                      n_frames::Integer, config::ProcessingConfig;
+                      dist_types::Union{Nothing,Matrix{DistributionType}}=nothing)
     fused_path = output_path * "_fused.fits"
     conf_path = output_path * "_confidence.fits"
-    
-    save_fits(fused_path, fused; header_cards=Dict(
+
+    save_fits(fused_path, fused; header_cards=Dict{String,Any}(
         "BAYESIAN" => true,
-        "NFRAMES" => length(stack),
+        "NFRAMES" => n_frames,
         "FUSION" => string(config.fusion_strategy)
-    ))
-    
-    save_fits(conf_path, confidence; header_cards=Dict(
+    ), encoding=config.fused_encoding, compress=config.compress_output)
+
+    save_fits(conf_path, confidence; header_cards=Dict{String,Any}(
         "DATATYPE" => "CONFIDENCE",
         "RANGE" => "0.0-1.0"
-    ))
-    
+    ), encoding=config.confidence_encoding, compress=config.compress_output, range=(0.0, 1.0))
+
     @info "Saved fused image to: $fused_path"
     @info "Saved confidence map to: $conf_path"
-    
+
+    if config.save_classification && dist_types !== nothing
+        class_path = output_path * "_classification.fits"
+        save_fits(class_path, UInt8.(Integer.(dist_types)); header_cards=Dict{String,Any}(
+            "DATATYPE" => "CLASSIFICATION"
+        ), encoding=config.classification_encoding, compress=config.compress_output)
+        @info "Saved classification map to: $class_path"
+    end
+
     return nothing
 end
 
@@ -135,7 +386,20 @@ end
 Extract fused values from result matrix.
 """
 function extract_values(results::Matrix{PixelResult})::Matrix{Float32}
-    return Float32[r.value for r in results]
+    return extract_values!(Matrix{Float32}(undef, size(results)), results)
+end
+
+"""
+    extract_values!(out::AbstractMatrix{Float32}, results::Matrix{PixelResult}) -> out
+
+In-place variant of `extract_values`, for reused output planes.
+"""
+function extract_values!(out::AbstractMatrix{Float32}, results::Matrix{PixelResult})
+    @assert size(out) == size(results)
+    @inbounds for k in eachindex(out, results)
+        out[k] = results[k].value
+    end
+    return out
 end
 
 """
@@ -144,7 +408,20 @@ end
 Extract confidence values from result matrix.
 """
 function extract_confidences(results::Matrix{PixelResult})::Matrix{Float32}
-    return Float32[r.confidence for r in results]
+    return extract_confidences!(Matrix{Float32}(undef, size(results)), results)
+end
+
+"""
+    extract_confidences!(out::AbstractMatrix{Float32}, results::Matrix{PixelResult}) -> out
+
+In-place variant of `extract_confidences`, for reused output planes.
+"""
+function extract_confidences!(out::AbstractMatrix{Float32}, results::Matrix{PixelResult})
+    @assert size(out) == size(results)
+    @inbounds for k in eachindex(out, results)
+        out[k] = results[k].confidence
+    end
+    return out
 end
 
 """
@@ -191,4 +468,48 @@ function log_result_statistics(results::Matrix{PixelResult})
     end
 end
 
+# Classification planes hold either DistributionType values or their UInt8 codes
+distribution_type(t::DistributionType) = t
+distribution_type(code::UInt8) = DistributionType(code)
+
+"""
+Log statistics about finalized confidence and classification maps.
+"""
+function log_result_statistics(confidence::AbstractMatrix{Float32}, dist_types::AbstractMatrix)
+    n_pixels = length(confidence)
+
+    type_counts = Dict{DistributionType, Int}()
+    for t in dist_types
+        dtype = distribution_type(t)
+        type_counts[dtype] = get(type_counts, dtype, 0) + 1
+    end
+
+    @info "Result statistics:"
+    @info "  Total pixels: $n_pixels"
+    @info "  Mean confidence: $(round(sum(confidence) / n_pixels, digits=3))"
+    @info "  Distribution types:"
+
+    for (dtype, count) in sort(collect(type_counts), by=x->-x[2])
+        pct = round(100.0 * count / n_pixels, digits=1)
+        @info "    $dtype: $count ($pct%)"
+    end
+end
+
+"""
+    result_summary(confidence, dist_types) -> NamedTuple
+
+Summary counts reported back to the host (mirrors the C++ ProcessingResult fields).
+"""
+function result_summary(confidence::AbstractMatrix{Float32}, dist_types::AbstractMatrix)
+    count_of(t) = count(x -> distribution_type(x) == t, dist_types)
+    return (
+        total_pixels = length(confidence),
+        mean_confidence = Float32(sum(confidence) / max(length(confidence), 1)),
+        gaussian_pixels = count_of(GAUSSIAN),
+        poisson_pixels = count_of(POISSON),
+        bimodal_pixels = count_of(BIMODAL),
+        artifact_pixels = count_of(SKEWED_RIGHT) + count_of(SKEWED_LEFT) + count_of(UNIFORM)
+    )
+end
+
 end # module Pipeline
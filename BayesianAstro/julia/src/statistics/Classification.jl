@@ -6,7 +6,8 @@ of each pixel's distribution across frames.
 """
 module Classification
 
-using ..BayesianAstro: PixelDistribution, DistributionType
+using ..BayesianAstro: AbstractPixelDistribution, PixelDistribution, DistributionType,
+                       GAUSSIAN, POISSON, BIMODAL, SKEWED_RIGHT, SKEWED_LEFT, UNIFORM, UNKNOWN
 using ..Welford: variance, skewness, kurtosis
 
 export classify_distribution
@@ -19,7 +20,7 @@ const MIN_SAMPLES = 5             # Minimum samples for reliable classification
 const VARIANCE_RATIO_THRESHOLD = 0.1f0  # For detecting uniform/saturated
 
 """
-    classify_distribution(dist::PixelDistribution) -> DistributionType
+    classify_distribution(dist::AbstractPixelDistribution) -> DistributionType
 
 Classify a pixel's distribution based on its statistical moments.
 
@@ -32,7 +33,7 @@ Classify a pixel's distribution based on its statistical moments.
 - SKEWED_LEFT: High negative skewness (dark artifact)
 - BIMODAL: High kurtosis (star + background, or artifact)
 """
-function classify_distribution(dist::PixelDistribution)::DistributionType
+function classify_distribution(dist::AbstractPixelDistribution)::DistributionType
     # Insufficient data
     if dist.n < MIN_SAMPLES
         return UNKNOWN
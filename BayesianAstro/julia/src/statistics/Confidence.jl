@@ -6,7 +6,8 @@ how reliable the fused value is.
 """
 module Confidence
 
-using ..BayesianAstro: PixelDistribution, DistributionType, PixelResult
+using ..BayesianAstro: AbstractPixelDistribution, DistributionType, PixelResult,
+                       GAUSSIAN, POISSON, BIMODAL, SKEWED_RIGHT, SKEWED_LEFT, UNIFORM
 using ..Welford: variance, stddev, skewness, kurtosis
 using ..Classification: classify_distribution, is_reliable, is_artifact_candidate
 
@@ -23,7 +24,7 @@ const REF_SAMPLE_COUNT = 100   # "Good" number of samples
 const REF_VARIANCE = 100.0f0   # Reference variance for normalization
 
 """
-    compute_confidence(dist::PixelDistribution) -> Float32
+    compute_confidence(dist::AbstractPixelDistribution) -> Float32
 
 Compute confidence score (0.0 - 1.0) for a pixel based on its distribution.
 
@@ -33,7 +34,7 @@ Compute confidence score (0.0 - 1.0) for a pixel based on its distribution.
 3. Distribution type: Gaussian/Poisson = higher confidence
 4. Outlier indicators: Skewness/kurtosis affect confidence
 """
-function compute_confidence(dist::PixelDistribution)::Float32
+function compute_confidence(dist::AbstractPixelDistribution)::Float32
     if dist.n < 2
         return 0.0f0
     end
@@ -128,11 +129,11 @@ function compute_confidence(stats::NamedTuple)::Float32
 end
 
 """
-    compute_pixel_result(dist::PixelDistribution, fused_value::Float32) -> PixelResult
+    compute_pixel_result(dist::AbstractPixelDistribution, fused_value::Float32) -> PixelResult
 
 Create a complete PixelResult from distribution and fused value.
 """
-function compute_pixel_result(dist::PixelDistribution, fused_value::Float32)::PixelResult
+function compute_pixel_result(dist::AbstractPixelDistribution, fused_value::Float32)::PixelResult
     return PixelResult(
         fused_value,
         compute_confidence(dist),
@@ -142,12 +143,12 @@ function compute_pixel_result(dist::PixelDistribution, fused_value::Float32)::Pi
 end
 
 """
-    confidence_weight(dist::PixelDistribution) -> Float32
+    confidence_weight(dist::AbstractPixelDistribution) -> Float32
 
 Compute a weight suitable for weighted averaging based on confidence.
 Higher confidence = higher weight.
 """
-function confidence_weight(dist::PixelDistribution)::Float32
+function confidence_weight(dist::AbstractPixelDistribution)::Float32
     conf = compute_confidence(dist)
     var = variance(dist)
     
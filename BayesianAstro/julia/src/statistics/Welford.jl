@@ -10,11 +10,39 @@ Reference: Welford, B. P. (1962). "Note on a method for calculating corrected
 """
 module Welford
 
-using ..BayesianAstro: PixelDistribution
+using ..BayesianAstro: AbstractPixelDistribution, PixelDistribution, DistributionAccumulator
 
 export accumulate!, finalize_statistics, reset!
 export variance, stddev, skewness, kurtosis
 
+"""
+    welford_step(n, mean, m2, m3, m4, value) -> (n, mean, m2, m3, m4)
+
+One Welford update of the count and central moments. Shared by the scalar,
+structure-of-arrays and GPU paths so they agree bit for bit. Counts are
+converted to Float32 before use (`n*n` in UInt16 would wrap past 255 frames).
+"""
+@inline function welford_step(n1::UInt16, mean::Float32, m2::Float32, m3::Float32, m4::Float32,
+                              value::Float32)
+    n = n1 + UInt16(1)
+    n_f = Float32(n)
+    n1_f = Float32(n1)
+
+    delta = value - mean
+    delta_n = delta / n_f
+    delta_n2 = delta_n * delta_n
+    term1 = delta * delta_n * n1_f
+
+    # M4 before M3 before M2: each update uses the previous lower moments
+    m4 += term1 * delta_n2 * (n_f * n_f - 3.0f0 * n_f + 3.0f0) +
+          6.0f0 * delta_n2 * m2 -
+          4.0f0 * delta_n * m3
+    m3 += term1 * delta_n * (n_f - 2.0f0) - 3.0f0 * delta_n * m2
+    m2 += term1
+
+    return (n, mean + delta_n, m2, m3, m4)
+end
+
 """
     accumulate!(dist::PixelDistribution, value::Float32)
 
@@ -22,38 +50,39 @@ Update running statistics with a new observation using Welford's algorithm.
 Computes mean, variance, skewness, and kurtosis in a single pass.
 """
 function accumulate!(dist::PixelDistribution, value::Float32)
-    # Update count
-    n1 = dist.n
-    dist.n += 1
-    n = dist.n
-    
-    # Update min/max
     dist.min = min(dist.min, value)
     dist.max = max(dist.max, value)
-    
-    # Welford's algorithm for mean and higher moments
-    delta = value - dist.mean
-    delta_n = delta / n
-    delta_n2 = delta_n * delta_n
-    term1 = delta * delta_n * n1
-    
-    # Update mean
-    dist.mean += delta_n
-    
-    # Update M4 (must be done before M3 and M2)
-    dist.m4 += term1 * delta_n2 * (n*n - 3*n + 3) + 
-               6 * delta_n2 * dist.m2 - 
-               4 * delta_n * dist.m3
-    
-    # Update M3 (must be done before M2)
-    dist.m3 += term1 * delta_n * (n - 2) - 3 * delta_n * dist.m2
-    
-    # Update M2
-    dist.m2 += term1
-    
+    dist.n, dist.mean, dist.m2, dist.m3, dist.m4 =
+        welford_step(dist.n, dist.mean, dist.m2, dist.m3, dist.m4, value)
     return dist
 end
 
+"""
+    accumulate!(acc::DistributionAccumulator, frame::AbstractMatrix{<:Real})
+
+Accumulate a whole frame into a structure-of-arrays accumulator. Columns are
+split across threads; within a column the update runs over contiguous memory
+and vectorizes.
+"""
+function accumulate!(acc::DistributionAccumulator, frame::AbstractMatrix{<:Real})
+    height, width = size(frame)
+    @assert size(acc) == (height, width) "Frame size $(size(frame)) does not match accumulator $(size(acc))"
+
+    n, mean, m2, m3, m4, lo, hi = acc.n, acc.mean, acc.m2, acc.m3, acc.m4, acc.min, acc.max
+
+    Threads.@threads for j in 1:width
+        @inbounds @simd for i in 1:height
+            value = Float32(frame[i, j])
+            n[i, j], mean[i, j], m2[i, j], m3[i, j], m4[i, j] =
+                welford_step(n[i, j], mean[i, j], m2[i, j], m3[i, j], m4[i, j], value)
+            lo[i, j] = min(lo[i, j], value)
+            hi[i, j] = max(hi[i, j], value)
+        end
+    end
+
+    return acc
+end
+
 """
     accumulate!(dist::PixelDistribution, values::AbstractVector{Float32})
 
@@ -68,8 +97,9 @@ end
 
 """
     reset!(dist::PixelDistribution)
+    reset!(acc::DistributionAccumulator)
 
-Reset distribution to initial state.
+Reset distribution(s) to the initial state.
 """
 function reset!(dist::PixelDistribution)
     dist.n = 0
@@ -82,13 +112,24 @@ function reset!(dist::PixelDistribution)
     return dist
 end
 
+function reset!(acc::DistributionAccumulator)
+    fill!(acc.n, 0)
+    fill!(acc.mean, 0.0f0)
+    fill!(acc.m2, 0.0f0)
+    fill!(acc.m3, 0.0f0)
+    fill!(acc.m4, 0.0f0)
+    fill!(acc.min, Inf32)
+    fill!(acc.max, -Inf32)
+    return acc
+end
+
 """
-    variance(dist::PixelDistribution; corrected=true) -> Float32
+    variance(dist::AbstractPixelDistribution; corrected=true) -> Float32
 
 Compute variance from accumulated statistics.
 Uses Bessel's correction (n-1) by default for sample variance.
 """
-function variance(dist::PixelDistribution; corrected::Bool=true)::Float32
+function variance(dist::AbstractPixelDistribution; corrected::Bool=true)::Float32
     if dist.n < 2
         return 0.0f0
     end
@@ -101,21 +142,21 @@ function variance(dist::PixelDistribution; corrected::Bool=true)::Float32
 end
 
 """
-    stddev(dist::PixelDistribution; corrected=true) -> Float32
+    stddev(dist::AbstractPixelDistribution; corrected=true) -> Float32
 
 Compute standard deviation from accumulated statistics.
 """
-function stddev(dist::PixelDistribution; corrected::Bool=true)::Float32
+function stddev(dist::AbstractPixelDistribution; corrected::Bool=true)::Float32
     return sqrt(variance(dist; corrected=corrected))
 end
 
 """
-    skewness(dist::PixelDistribution) -> Float32
+    skewness(dist::AbstractPixelDistribution) -> Float32
 
 Compute skewness (third standardized moment) from accumulated statistics.
 Returns 0 for distributions with fewer than 3 samples.
 """
-function skewness(dist::PixelDistribution)::Float32
+function skewness(dist::AbstractPixelDistribution)::Float32
     if dist.n < 3 || dist.m2 ≈ 0.0f0
         return 0.0f0
     end
@@ -125,13 +166,13 @@ function skewness(dist::PixelDistribution)::Float32
 end
 
 """
-    kurtosis(dist::PixelDistribution; excess=true) -> Float32
+    kurtosis(dist::AbstractPixelDistribution; excess=true) -> Float32
 
 Compute kurtosis (fourth standardized moment) from accumulated statistics.
 Returns excess kurtosis by default (normal distribution = 0).
 Returns 0 for distributions with fewer than 4 samples.
 """
-function kurtosis(dist::PixelDistribution; excess::Bool=true)::Float32
+function kurtosis(dist::AbstractPixelDistribution; excess::Bool=true)::Float32
     if dist.n < 4 || dist.m2 ≈ 0.0f0
         return 0.0f0
     end
@@ -147,7 +188,7 @@ function kurtosis(dist::PixelDistribution; excess::Bool=true)::Float32
 end
 
 """
-    finalize_statistics(dist::PixelDistribution) -> NamedTuple
+    finalize_statistics(dist::AbstractPixelDistribution) -> NamedTuple
 
 Compute all final statistics from accumulated data.
 
@@ -163,7 +204,7 @@ Named tuple with fields:
 - `max`: Maximum value
 - `range`: max - min
 """
-function finalize_statistics(dist::PixelDistribution)
+function finalize_statistics(dist::AbstractPixelDistribution)
     return (
         n = Int(dist.n),
         mean = dist.mean,
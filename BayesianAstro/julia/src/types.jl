@@ -15,6 +15,15 @@ Classification of per-pixel statistical behavior across frames.
     UNKNOWN = 7           # Insufficient data to classify
 end
 
+"""
+    AbstractPixelDistribution
+
+Anything exposing the per-pixel moment fields (`n`, `mean`, `m2`, `m3`, `m4`,
+`min`, `max`); the statistics, classification and confidence functions accept
+any subtype.
+"""
+abstract type AbstractPixelDistribution end
+
 """
     PixelDistribution
 
@@ -30,7 +39,7 @@ Uses Welford's online algorithm for numerically stable single-pass computation.
 - `min::Float32`: Minimum observed value
 - `max::Float32`: Maximum observed value
 """
-mutable struct PixelDistribution
+mutable struct PixelDistribution <: AbstractPixelDistribution
     n::UInt16
     mean::Float32
     m2::Float32      # For variance: sum((x - mean)^2)
@@ -44,6 +53,80 @@ mutable struct PixelDistribution
     end
 end
 
+"""
+    PixelMoments
+
+Immutable per-pixel view of a `DistributionAccumulator`, with the same fields as
+`PixelDistribution`. Loading one is seven array reads and no allocation, so the
+statistics functions run on it entirely in registers.
+"""
+struct PixelMoments <: AbstractPixelDistribution
+    n::UInt16
+    mean::Float32
+    m2::Float32
+    m3::Float32
+    m4::Float32
+    min::Float32
+    max::Float32
+end
+
+PixelMoments(dist::AbstractPixelDistribution) =
+    PixelMoments(dist.n, dist.mean, dist.m2, dist.m3, dist.m4, dist.min, dist.max)
+
+"""
+    DistributionAccumulator(height, width)
+
+Per-pixel accumulators for a whole stack as a structure of arrays: one
+`height×width` matrix per moment, the same layout the GPU kernels use. Compared
+with a `Matrix{PixelDistribution}` there is no per-pixel heap object, the GC
+tracks seven arrays instead of one object per pixel, and the accumulation loop
+streams through contiguous columns and vectorizes.
+
+`acc[i, j]` returns the pixel's `PixelMoments`; `acc[i, j] = dist` stores one.
+"""
+struct DistributionAccumulator
+    n::Matrix{UInt16}
+    mean::Matrix{Float32}
+    m2::Matrix{Float32}
+    m3::Matrix{Float32}
+    m4::Matrix{Float32}
+    min::Matrix{Float32}
+    max::Matrix{Float32}
+end
+
+function DistributionAccumulator(height::Integer, width::Integer)
+    return DistributionAccumulator(
+        zeros(UInt16, height, width),
+        zeros(Float32, height, width),
+        zeros(Float32, height, width),
+        zeros(Float32, height, width),
+        zeros(Float32, height, width),
+        fill(Inf32, height, width),
+        fill(-Inf32, height, width)
+    )
+end
+
+Base.size(acc::DistributionAccumulator) = size(acc.n)
+Base.size(acc::DistributionAccumulator, d::Integer) = size(acc.n, d)
+Base.length(acc::DistributionAccumulator) = length(acc.n)
+
+Base.@propagate_inbounds function Base.getindex(acc::DistributionAccumulator, I::Integer...)
+    return PixelMoments(acc.n[I...], acc.mean[I...], acc.m2[I...], acc.m3[I...],
+                        acc.m4[I...], acc.min[I...], acc.max[I...])
+end
+
+Base.@propagate_inbounds function Base.setindex!(acc::DistributionAccumulator,
+                                                 dist::AbstractPixelDistribution, I::Integer...)
+    acc.n[I...] = dist.n
+    acc.mean[I...] = dist.mean
+    acc.m2[I...] = dist.m2
+    acc.m3[I...] = dist.m3
+    acc.m4[I...] = dist.m4
+    acc.min[I...] = dist.min
+    acc.max[I...] = dist.max
+    return acc
+end
+
 """
     PixelResult
 
@@ -102,6 +185,19 @@ Available pixel fusion strategies.
     MULTISCALE = 4           # Different strategies at different scales
 end
 
+"""
+    OutputEncoding
+
+Storage encoding of an output plane (values mirror the native `PlaneEncoding`).
+"""
+@enum OutputEncoding begin
+    ENCODE_FLOAT32 = 0       # Plain float32
+    ENCODE_FLOAT16 = 1       # Half-precision significand, float32 exponent; stored compressed
+    ENCODE_UINT16 = 2        # Scaled 16-bit integers (BSCALE/BZERO), NaN as BLANK
+    ENCODE_UINT8 = 3         # 8-bit class codes
+    ENCODE_PACKED4 = 4       # Two 4-bit class codes per byte along the first axis
+end
+
 """
     ProcessingConfig
 
@@ -113,6 +209,11 @@ Pipeline configuration options.
 - `outlier_sigma::Float32`: Sigma threshold for outlier rejection
 - `tile_size::Tuple{Int,Int}`: Tile dimensions for GPU memory management
 - `use_gpu::Bool`: Whether to attempt GPU acceleration
+- `fused_encoding::OutputEncoding`: Encoding of the fused image
+- `confidence_encoding::OutputEncoding`: Encoding of the confidence map
+- `classification_encoding::OutputEncoding`: Encoding of the classification map
+- `save_classification::Bool`: Whether to write the classification map
+- `compress_output::Bool`: Lossless tile compression of all output planes
 """
 struct ProcessingConfig
     fusion_strategy::FusionStrategy
@@ -120,15 +221,27 @@ struct ProcessingConfig
     outlier_sigma::Float32
     tile_size::Tuple{Int,Int}
     use_gpu::Bool
+    fused_encoding::OutputEncoding
+    confidence_encoding::OutputEncoding
+    classification_encoding::OutputEncoding
+    save_classification::Bool
+    compress_output::Bool
     
     function ProcessingConfig(;
         fusion_strategy::FusionStrategy = CONFIDENCE_WEIGHTED,
         confidence_threshold::Float32 = 0.1f0,
         outlier_sigma::Float32 = 3.0f0,
         tile_size::Tuple{Int,Int} = (1024, 1024),
-        use_gpu::Bool = true
+        use_gpu::Bool = true,
+        fused_encoding::OutputEncoding = ENCODE_FLOAT32,
+        confidence_encoding::OutputEncoding = ENCODE_FLOAT32,
+        classification_encoding::OutputEncoding = ENCODE_PACKED4,
+        save_classification::Bool = false,
+        compress_output::Bool = false
     )
-        new(fusion_strategy, confidence_threshold, outlier_sigma, tile_size, use_gpu)
+        new(fusion_strategy, confidence_threshold, outlier_sigma, tile_size, use_gpu,
+            fused_encoding, confidence_encoding, classification_encoding,
+            save_classification, compress_output)
     end
 end
 
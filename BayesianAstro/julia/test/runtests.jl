@@ -3,15 +3,17 @@ Comprehensive tests for BayesianAstro package.
 
 Tests cover:
 - Core types and constructors
-- Welford's algorithm (numerical accuracy, edge cases, merging)
+- Welford's algorithm (numerical accuracy, edge cases, merging, SoA accumulator)
 - Distribution classification (boundary conditions, all types)
 - Confidence scoring (factor contributions, edge cases)
 - Fusion strategies (MLE, confidence-weighted, lucky)
 - GPU/CPU parity (when CUDA available)
+- Parity with the native C++ kernels (checked-in fixture)
 =#
 
 using Test
 using BayesianAstro
+using Random
 using Statistics
 
 @testset "BayesianAstro.jl" begin
@@ -67,6 +69,10 @@ using Statistics
             @test config2.fusion_strategy == MLE
             @test config2.outlier_sigma == 2.5f0
             @test config2.use_gpu == false
+
+            @test config.fused_encoding == ENCODE_FLOAT32
+            @test config.classification_encoding == ENCODE_PACKED4
+            @test config.save_classification == false
         end
 
         @testset "DistributionType enum" begin
@@ -251,6 +257,55 @@ using Statistics
 
             @test kurtosis(dist) > 0  # Should be positive (leptokurtic)
         end
+
+        @testset "Structure-of-arrays accumulator" begin
+            height, width, n_frames = 7, 5, 12
+            frames = [rand(Float32, height, width) .* 1000 for _ in 1:n_frames]
+
+            acc = DistributionAccumulator(height, width)
+            @test size(acc) == (height, width)
+            @test acc[1, 1].n == 0
+            @test acc[1, 1].min == Inf32
+
+            reference = [PixelDistribution() for _ in 1:height, _ in 1:width]
+            for frame in frames
+                accumulate!(acc, frame)
+                for j in 1:width, i in 1:height
+                    accumulate!(reference[i, j], frame[i, j])
+                end
+            end
+
+            # Same update as the scalar path, so the moments agree exactly
+            for j in 1:width, i in 1:height
+                px = acc[i, j]
+                @test px isa PixelMoments
+                @test px == PixelMoments(reference[i, j])
+                @test variance(px) == variance(reference[i, j])
+                @test classify_distribution(px) == classify_distribution(reference[i, j])
+                @test compute_confidence(px) == compute_confidence(reference[i, j])
+            end
+
+            # Views can be stored back, and the accumulator reset in place
+            acc[2, 3] = PixelDistribution()
+            @test acc[2, 3].n == 0
+            reset!(acc)
+            @test all(acc.n .== 0)
+            @test all(acc.max .== -Inf32)
+        end
+
+        @testset "Counts past 255 frames" begin
+            # n*n must not be evaluated in UInt16
+            dist = PixelDistribution()
+            values = Float32.(sin.(1:400)) .* 10
+            for v in values
+                accumulate!(dist, v)
+            end
+            m = mean(values)
+            m4 = sum((values .- m) .^ 4)
+            @test dist.n == 400
+            @test dist.m4 ≈ m4 rtol=1e-3
+            @test kurtosis(dist) ≈ length(values) * m4 / sum((values .- m) .^ 2)^2 - 3 atol=1e-3
+        end
     end
 
     # ========================================================================
@@ -469,6 +524,42 @@ using Statistics
             @test fused_low ≈ 5.0f0 atol=0.01
         end
 
+        @testset "Lucky imaging from moments" begin
+            # A cosmic ray in one of ten frames: the dominant cluster is the sky
+            dist = PixelDistribution()
+            for v in Float32[100, 100, 100, 100, 100, 100, 100, 100, 100, 1000]
+                accumulate!(dist, v)
+            end
+            @test dist.mean ≈ 190.0f0
+            @test fuse_lucky(dist) ≈ 100.0f0 atol=0.5
+
+            # Symmetric values have no larger cluster and keep the mean
+            sym = PixelDistribution()
+            for v in Float32[90, 95, 100, 105, 110]
+                accumulate!(sym, v)
+            end
+            @test fuse_lucky(sym) == sym.mean
+            @test fuse_lucky(PixelDistribution()) == 0.0f0
+        end
+
+        @testset "fuse_pixel" begin
+            dist = PixelDistribution()
+            for v in Float32[100, 100, 100, 100, 100, 100, 100, 100, 100, 1000]
+                accumulate!(dist, v)
+            end
+            @test fuse_pixel(dist, MLE) == fuse_mle(dist)
+            @test fuse_pixel(dist, CONFIDENCE_WEIGHTED) == fuse_mle(dist)
+            @test fuse_pixel(dist, MULTISCALE) == fuse_multiscale(dist, :mid)
+            @test fuse_pixel(dist, LUCKY) == fuse_lucky(dist)
+
+            acc = DistributionAccumulator(1, 1)
+            for v in Float32[100, 100, 100, 100, 100, 100, 100, 100, 100, 1000]
+                cpu_accumulate!(acc, fill(v, 1, 1))
+            end
+            @test cpu_finalize!(acc)[1][1, 1] ≈ dist.mean
+            @test cpu_finalize!(acc; strategy=LUCKY)[1][1, 1] ≈ fuse_lucky(dist)
+        end
+
         @testset "select_fusion_strategy" begin
             @test select_fusion_strategy(GAUSSIAN) == MLE
             @test select_fusion_strategy(POISSON) == MLE
@@ -548,6 +639,172 @@ using Statistics
             end
         end
 
+        @testset "Streaming stack session" begin
+            height, width, n_frames = 12, 8, 10
+            frames = [rand(Float32, height, width) for _ in 1:n_frames]
+            config = ProcessingConfig(use_gpu=false)
+
+            session = begin_stack(height, width, config)
+            for frame in frames
+                accumulate_frame!(session, frame)
+            end
+            @test session.n_frames == n_frames
+
+            # Caller-owned memory (native ingest path) must give identical results
+            session_ptr = begin_stack(height, width, config)
+            for frame in frames
+                GC.@preserve frame accumulate_frame!(session_ptr, UInt(pointer(frame)), height, width)
+            end
+
+            fused, confidence, dist_types = finalize_stack(session)
+            fused_ptr, confidence_ptr, _ = finalize_stack(session_ptr)
+
+            @test fused ≈ sum(frames) ./ n_frames atol=1e-5
+            @test fused == fused_ptr
+            @test confidence == confidence_ptr
+            @test size(dist_types) == (height, width)
+            @test all(0.0f0 .<= confidence .<= 1.0f0)
+
+            # process_stack is built on the same session API
+            stack = ImageStack(frames, [FrameMetadata("f$i.fits") for i in 1:n_frames])
+            fused_stack, confidence_stack = process_stack(stack, config)
+            @test fused_stack == fused
+            @test confidence_stack == confidence
+        end
+
+        @testset "Workspace-backed session" begin
+            height, width, n_frames = 12, 8, 10
+            frames = [rand(Float32, height, width) for _ in 1:n_frames]
+            config = ProcessingConfig(use_gpu=false)
+
+            reference = begin_stack(height, width, config)
+            for frame in frames
+                accumulate_frame!(reference, frame)
+            end
+            fused_ref, confidence_ref, types_ref = finalize_stack(reference)
+
+            # Host-owned planes start with garbage and are reused across runs
+            n = fill(UInt16(7), height, width)
+            moments = [fill(NaN32, height, width) for _ in 1:6]
+            fused = Matrix{Float32}(undef, height, width)
+            confidence = Matrix{Float32}(undef, height, width)
+            classification = Matrix{UInt8}(undef, height, width)
+            buffer = Matrix{Float32}(undef, height, width)
+
+            for run in 1:2
+                summary = GC.@preserve n moments fused confidence classification buffer begin
+                    session = begin_stack(height, width, config, UInt(pointer(n)),
+                                          (UInt(pointer(m)) for m in moments)...)
+                    for frame in frames
+                        copyto!(buffer, frame)
+                        accumulate_frame!(session, UInt(pointer(buffer)), height, width)
+                    end
+                    @test session.frame_ptr == UInt(pointer(buffer))  # one wrapper for the whole run
+                    finish_stack!(session, UInt(pointer(fused)), UInt(pointer(confidence)),
+                                  UInt(pointer(classification)))
+                end
+
+                @test fused == fused_ref
+                @test confidence == confidence_ref
+                @test classification == UInt8.(Integer.(types_ref))
+                @test summary.total_pixels == height * width
+                @test summary.frame_alloc_bytes >= 0
+            end
+        end
+
+        @testset "Refinalize kept accumulators" begin
+            Random.seed!(72)
+            height, width, n_frames = 12, 8, 10
+            frames = [100.0f0 .+ rand(Float32, height, width) for _ in 1:n_frames]
+            frames[n_frames][1:4, :] .+= 1000.0f0  # A transient in one frame skews these rows
+            config = ProcessingConfig(use_gpu=false)
+
+            n = zeros(UInt16, height, width)
+            moments = [zeros(Float32, height, width) for _ in 1:6]
+            planes() = (Matrix{Float32}(undef, height, width), Matrix{Float32}(undef, height, width),
+                        Matrix{UInt8}(undef, height, width))
+            fused, confidence, classification = planes()
+            refused, reconfidence, reclassification = planes()
+
+            GC.@preserve n moments fused confidence classification refused reconfidence reclassification begin
+                pointers = (UInt(pointer(n)), (UInt(pointer(m)) for m in moments)...)
+                session = begin_stack(height, width, config, pointers...)
+                for frame in frames
+                    accumulate_frame!(session, frame)
+                end
+                summary = finish_stack!(session, UInt(pointer(fused)), UInt(pointer(confidence)),
+                                        UInt(pointer(classification)))
+                kept = (copy(n), copy.(moments))
+
+                # Another strategy over the same planes, without the frames
+                other = ProcessingConfig(use_gpu=false, fusion_strategy=LUCKY)
+                resummary = refinalize_stack!(height, width, other, pointers...,
+                                              UInt(pointer(refused)), UInt(pointer(reconfidence)),
+                                              UInt(pointer(reclassification)))
+            end
+
+            acc = DistributionAccumulator(kept[1], kept[2]...)
+            @test refused == first(cpu_finalize!(acc; strategy=LUCKY))
+            @test refused != fused
+            @test reconfidence == confidence
+            @test reclassification == classification
+            @test resummary.total_pixels == summary.total_pixels
+            @test resummary.mean_confidence == summary.mean_confidence
+            @test resummary.frame_alloc_bytes == 0
+            @test n == kept[1] && moments == kept[2]  # Accumulators are only read
+        end
+
+        @testset "Refinalize follows the fusion strategy" begin
+            Random.seed!(73)
+            height, width, n_frames = 8, 6, 12
+            frames = [100.0f0 .+ rand(Float32, height, width) for _ in 1:n_frames]
+            frames[1][:, 1:3] .+= 2000.0f0  # A satellite trail in one frame
+
+            n = zeros(UInt16, height, width)
+            moments = [zeros(Float32, height, width) for _ in 1:6]
+            fused = Matrix{Float32}(undef, height, width)
+            confidence = Matrix{Float32}(undef, height, width)
+            classification = Matrix{UInt8}(undef, height, width)
+
+            # The preview refinalizes into the same output planes on every strategy change
+            GC.@preserve n moments fused confidence classification begin
+                pointers = (UInt(pointer(n)), (UInt(pointer(m)) for m in moments)...)
+                outputs = (UInt(pointer(fused)), UInt(pointer(confidence)), UInt(pointer(classification)))
+                session = begin_stack(height, width, ProcessingConfig(use_gpu=false, fusion_strategy=MLE), pointers...)
+                for frame in frames
+                    accumulate_frame!(session, frame)
+                end
+                finish_stack!(session, outputs...)
+                by_mle = copy(fused)
+
+                refinalize_stack!(height, width, ProcessingConfig(use_gpu=false, fusion_strategy=LUCKY),
+                                  pointers..., outputs...)
+                by_lucky = copy(fused)
+
+                refinalize_stack!(height, width, ProcessingConfig(use_gpu=false, fusion_strategy=MLE),
+                                  pointers..., outputs...)
+                back_to_mle = copy(fused)
+            end
+
+            # The trail pulls the mean up; lucky fusion keeps the sky under it
+            @test by_lucky != by_mle
+            @test all(by_mle[:, 1:3] .> 200.0f0)
+            @test all(by_lucky[:, 1:3] .< 102.0f0)
+            @test back_to_mle == by_mle
+        end
+
+        @testset "Memory counters" begin
+            counters = zeros(UInt64, 2)
+            GC.@preserve counters memory_counters!(UInt(pointer(counters)))
+            before = copy(counters)
+            garbage = [zeros(Float64, 1024) for _ in 1:64]
+            GC.gc()
+            GC.@preserve counters memory_counters!(UInt(pointer(counters)))
+            @test counters[1] - before[1] >= sizeof(Float64) * 1024 * 64
+            @test counters[2] >= before[2]
+            @test length(garbage) == 64
+        end
+
         @testset "Cosmic ray simulation" begin
             dist = PixelDistribution()
 
@@ -640,6 +897,48 @@ using Statistics
 
             @test all(0.0f0 .<= output .<= 1.0f0)
         end
+
+        @testset "Native kernel parity (fixture)" begin
+            # Frames and results of the native StackKernels (cpp/), little-endian; regenerate with
+            #   BayesianAstroSynth --kernel-fixture julia/test/fixtures/kernels_40x32x24.bin --size 40x32
+            #       --frames 24 --bitpix -32 --stars 8 --hot-pixels 0.005 --cosmic-rays 3000 --trails 0.3
+            path = joinpath(@__DIR__, "fixtures", "kernels_40x32x24.bin")
+            native = open(path) do io
+                @test String(read(io, 4)) == "BAKF"
+                @test read(io, UInt32) == 1
+                height, width, n_frames = Int(read(io, Int64)), Int(read(io, Int64)), Int(read(io, Int64))
+                load(T, dims...) = read!(io, Array{T}(undef, dims...))
+                (frames = load(Float32, height, width, n_frames),
+                 n = load(UInt16, height, width),
+                 moments = [load(Float32, height, width) for _ in 1:6],
+                 fused = load(Float32, height, width),
+                 confidence = load(Float32, height, width),
+                 classes = load(UInt8, height, width),
+                 complete = eof(io))
+            end
+            @test native.complete
+
+            height, width, n_frames = size(native.frames)
+            acc = DistributionAccumulator(height, width)
+            for f in 1:n_frames
+                cpu_accumulate!(acc, native.frames[:, :, f])
+            end
+
+            # Same Welford update in the same Float32 order: identical accumulators
+            @test acc.n == native.n
+            for (plane, expected) in zip((acc.mean, acc.m2, acc.m3, acc.m4, acc.min, acc.max), native.moments)
+                @test plane == expected
+            end
+
+            output, confidence, dist_types = cpu_finalize!(acc)
+            @test output == native.fused
+            @test UInt8.(Integer.(dist_types)) == native.classes
+            # m2^1.5 may differ in the last bit between libm and Julia
+            @test confidence ≈ native.confidence rtol=1e-5
+
+            # Stars, hot pixels, cosmic rays and trails give more than the sky's class
+            @test length(unique(native.classes)) >= 3
+        end
     end
 
     # ========================================================================
@@ -699,6 +998,35 @@ using Statistics
             end
         end
 
+        @testset "Output plane encodings" begin
+            data = Float32[1000.5 2000.25; 3.0 NaN; 65535.0 0.125]
+
+            # Float16 precision keeps the Float32 exponent range (no overflow above 65504)
+            f16, cards = encode_plane(data, ENCODE_FLOAT16)
+            @test cards["BAENCODE"] == "FLOAT16"
+            @test isnan(f16[2, 2])
+            @test all(abs.(f16[isfinite.(data)] .- data[isfinite.(data)]) .<= abs.(data[isfinite.(data)]) .* 2.0f0^-11)
+            @test round_to_float16_precision(1.0f0) == 1.0f0
+            @test round_to_float16_precision(70000.0f0) ≈ 70000.0f0 rtol=2.0^-11
+
+            # Scaled UInt16 round trip is within half a level; NaN survives as BLANK
+            confidence = Float32[0.0 0.25; 0.5 1.0]
+            u16, cards = encode_plane(confidence, ENCODE_UINT16; range=(0.0, 1.0))
+            @test eltype(u16) == Int16
+            decoded = decode_plane(u16, ENCODE_UINT16; scale=cards["BSCALE"], zero=cards["BZERO"])
+            @test maximum(abs.(decoded .- confidence)) <= 0.5 / 65534 + 1e-7
+            u16n, cards = encode_plane(data, ENCODE_UINT16)
+            @test u16n[2, 2] == -32768
+            @test isnan(decode_plane(u16n, ENCODE_UINT16; scale=cards["BSCALE"], zero=cards["BZERO"])[2, 2])
+
+            # 4-bit packing halves the first axis, including odd heights
+            codes = UInt8.(rand(1:7, 5, 3))
+            packed, cards = encode_plane(codes, ENCODE_PACKED4)
+            @test size(packed) == (3, 3)
+            @test cards["BANAXIS1"] == 5
+            @test decode_plane(packed, ENCODE_PACKED4; height=5) == codes
+        end
+
         @testset "find_fits_files" begin
             # Test with non-existent directory should return empty
             try
@@ -8,6 +8,8 @@ import { useBridge } from './hooks/useBridge';
 import { FileList } from './components/FileList';
 import { ParameterPanel } from './components/ParameterPanel';
 import { ProgressPanel } from './components/ProgressPanel';
+import { PreviewViewer } from './components/PreviewViewer';
+import { HistogramPanel } from './components/HistogramPanel';
 
 export default function App() {
   const bridge = useBridge();
@@ -25,15 +27,20 @@ export default function App() {
       </header>
 
       <div className="grid grid-cols-1 lg:grid-cols-3 gap-4">
-        {/* Left panel - File list */}
-        <div className="lg:col-span-2">
+        {/* Left panel - File list and result preview */}
+        <div className="lg:col-span-2 space-y-4">
           <FileList
             files={bridge.files}
+            frameStats={bridge.frameStats}
             onAddFiles={bridge.addFiles}
             onRemoveFile={bridge.removeFile}
             onClearFiles={bridge.clearFiles}
             disabled={bridge.processing.isProcessing}
           />
+
+          <PreviewViewer preview={bridge.preview} />
+
+          <HistogramPanel preview={bridge.preview} />
         </div>
 
         {/* Right panel - Parameters */}
@@ -56,6 +63,8 @@ export default function App() {
             isProcessing={bridge.processing.isProcessing}
             progress={bridge.processing.progress}
             status={bridge.processing.status}
+            run={bridge.processing.run}
+            stagePlan={bridge.stagePlan}
             onExecute={bridge.execute}
             canExecute={bridge.files.length > 0 && !bridge.processing.isProcessing}
           />
@@ -5,15 +5,18 @@
 
 import { useState, useCallback, useRef, useEffect } from 'react';
 import { Trash2, FolderOpen, X, FileImage, ArrowUpDown, ChevronUp, ChevronDown } from 'lucide-react';
+import type { FrameStats } from '../types/bridge';
 
 interface FileInfo {
   path: string;
   name: string;
   size?: number;
+  stats?: FrameStats;
 }
 
 interface FileListProps {
   files: string[];
+  frameStats?: FrameStats[];
   onAddFiles: (paths: string[]) => void;
   onRemoveFile: (index: number) => void;
   onClearFiles: () => void;
@@ -30,11 +33,24 @@ function formatFileSize(bytes?: number): string {
   return `${(bytes / (1024 * 1024)).toFixed(1)} MB`;
 }
 
+function formatFrameStats(stats?: FrameStats): string {
+  if (!stats) return '';
+  if (!stats.valid) return stats.error ?? 'Invalid frame';
+  const parts = [`${stats.width}\u00d7${stats.height}`];
+  if (stats.filter) parts.push(stats.filter);
+  if (stats.exposure != null) parts.push(`${stats.exposure}s`);
+  if (stats.fwhm != null) parts.push(`FWHM ${stats.fwhm.toFixed(2)}`);
+  if (stats.mean != null && stats.sigma != null) {
+    parts.push(`\u03bc ${stats.mean.toPrecision(4)} \u03c3 ${stats.sigma.toPrecision(3)}`);
+  }
+  return parts.join(' \u00b7 ');
+}
+
 function getFileName(path: string): string {
   return path.split(/[/\\]/).pop() || path;
 }
 
-export function FileList({ files, onAddFiles, onRemoveFile, onClearFiles, disabled }: FileListProps) {
+export function FileList({ files, frameStats, onAddFiles, onRemoveFile, onClearFiles, disabled }: FileListProps) {
   const [isDragOver, setIsDragOver] = useState(false);
   const [selectedIndex, setSelectedIndex] = useState<number | null>(null);
   const [sortField, setSortField] = useState<SortField>('none');
@@ -42,9 +58,11 @@ export function FileList({ files, onAddFiles, onRemoveFile, onClearFiles, disabl
   const listRef = useRef<HTMLUListElement>(null);
 
   // Convert files to FileInfo objects
-  const fileInfos: FileInfo[] = files.map(path => ({
+  const fileInfos: FileInfo[] = files.map((path, i) => ({
     path,
     name: getFileName(path),
+    size: frameStats?.[i]?.fileSize,
+    stats: frameStats?.[i],
   }));
 
   // Sort files if needed
@@ -241,9 +259,11 @@ export function FileList({ files, onAddFiles, onRemoveFile, onClearFiles, disabl
                       <span className="truncate block" title={file.path}>
                         {file.name}
                       </span>
-                      {file.size && (
-                        <span className="text-xs text-gray-500">
-                          {formatFileSize(file.size)}
+                      {(file.size || file.stats) && (
+                        <span
+                          className={`text-xs ${file.stats && !file.stats.valid ? 'text-red-400' : 'text-gray-500'}`}
+                        >
+                          {[formatFileSize(file.size), formatFrameStats(file.stats)].filter(Boolean).join(' \u00b7 ')}
                         </span>
                       )}
                     </div>
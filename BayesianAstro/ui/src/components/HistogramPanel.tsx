@@ -0,0 +1,164 @@
+/**
+ * Histograms of the last result's fused, confidence and variance planes
+ * Features: per-plane tabs, percentile markers, refetch on every new result.
+ * Histograms are binned natively and fetched as binary over the preview scheme,
+ * so the bins never go through the WebChannel.
+ */
+
+import { useState, useEffect } from 'react';
+import type { HistogramPlane, PlaneHistogram, PreviewInfo } from '../types/bridge';
+
+interface HistogramPanelProps {
+  preview: PreviewInfo;
+}
+
+const PLANE_LABELS: Record<HistogramPlane, string> = {
+  fused: 'Fused',
+  confidence: 'Confidence',
+  variance: 'Variance',
+};
+
+// Must match PlaneHistogram.h
+const MAGIC = 'BAH1';
+const PERCENTS = [0.1, 1, 5, 25, 50, 75, 95, 99, 99.9];
+const HEADER_BYTES = 56 + 4 * PERCENTS.length;
+
+// Columns drawn; bins are summed into them
+const COLUMNS = 256;
+const CHART_HEIGHT = 96;
+
+export function parseHistogram(buffer: ArrayBuffer): PlaneHistogram | null {
+  if (buffer.byteLength < HEADER_BYTES) return null;
+  const view = new DataView(buffer);
+  const magic = String.fromCharCode(...new Uint8Array(buffer, 0, 4));
+  const bins = view.getUint32(4, true);
+  if (magic !== MAGIC || buffer.byteLength < HEADER_BYTES + 4 * bins) return null;
+  return {
+    low: view.getFloat32(8, true),
+    high: view.getFloat32(12, true),
+    min: view.getFloat32(16, true),
+    max: view.getFloat32(20, true),
+    samples: Number(view.getBigUint64(24, true)),
+    below: Number(view.getBigUint64(32, true)),
+    above: Number(view.getBigUint64(40, true)),
+    nonFinite: Number(view.getBigUint64(48, true)),
+    percents: PERCENTS,
+    percentiles: PERCENTS.map((_, i) => view.getFloat32(56 + 4 * i, true)),
+    counts: new Uint32Array(buffer, HEADER_BYTES, bins),
+  };
+}
+
+function formatValue(value: number): string {
+  if (!Number.isFinite(value)) return '–';
+  const magnitude = Math.abs(value);
+  return magnitude !== 0 && (magnitude < 1e-3 || magnitude >= 1e5) ? value.toExponential(2) : value.toPrecision(4);
+}
+
+export function HistogramPanel({ preview }: HistogramPanelProps) {
+  const planes = preview.histograms ?? [];
+  const [plane, setPlane] = useState<HistogramPlane>('fused');
+  const [histograms, setHistograms] = useState<Partial<Record<HistogramPlane, PlaneHistogram>>>({});
+
+  // One fetch per plane and result; the generation in the URL changes with the result
+  const url = preview.histogramUrl;
+  const planeKey = planes.join(',');
+  useEffect(() => {
+    setHistograms({});
+    if (!url || !planeKey) return;
+    let cancelled = false;
+    for (const p of planeKey.split(',') as HistogramPlane[]) {
+      fetch(`${url}/${p}.bin`)
+        .then((response) => (response.ok ? response.arrayBuffer() : null))
+        .then((buffer) => {
+          const histogram = buffer ? parseHistogram(buffer) : null;
+          if (!cancelled && histogram) setHistograms((h) => ({ ...h, [p]: histogram }));
+        })
+        .catch(() => undefined);
+    }
+    return () => {
+      cancelled = true;
+    };
+  }, [url, planeKey]);
+
+  // A banded run has no variance histogram
+  useEffect(() => {
+    if (planes.length > 0 && !planes.includes(plane)) setPlane(planes[0]);
+  }, [planes, plane]);
+
+  if (preview.live || planes.length === 0) return null;
+
+  const histogram = histograms[plane];
+  const columns: number[] = [];
+  if (histogram) {
+    const perColumn = Math.max(1, Math.ceil(histogram.counts.length / COLUMNS));
+    for (let i = 0; i < histogram.counts.length; i += perColumn) {
+      let sum = 0;
+      for (let j = i; j < Math.min(i + perColumn, histogram.counts.length); j++) sum += histogram.counts[j];
+      columns.push(sum);
+    }
+  }
+  // Square-root scale, so the tails stay visible next to the sky peak
+  const peak = Math.sqrt(Math.max(1, ...columns));
+  const path = columns
+    .map((count, i) => `M${i + 0.5} ${CHART_HEIGHT}V${CHART_HEIGHT * (1 - Math.sqrt(count) / peak)}`)
+    .join('');
+  const position = (value: number) =>
+    histogram ? ((value - histogram.low) / (histogram.high - histogram.low)) * columns.length : 0;
+  const percentile = (percent: number) => histogram?.percentiles[PERCENTS.indexOf(percent)] ?? NaN;
+
+  return (
+    <div className="bg-gray-800 rounded-lg p-4">
+      <div className="flex items-center justify-between mb-3">
+        <h2 className="text-lg font-semibold">Histogram</h2>
+        <div className="flex items-center gap-2">
+          {planes.map((p) => (
+            <button
+              key={p}
+              onClick={() => setPlane(p)}
+              className={`px-2 py-1 text-xs rounded ${
+                p === plane ? 'bg-blue-600 text-white' : 'bg-gray-700 text-gray-300 hover:bg-gray-600'
+              }`}
+            >
+              {PLANE_LABELS[p]}
+            </button>
+          ))}
+        </div>
+      </div>
+
+      <svg
+        viewBox={`0 0 ${Math.max(columns.length, 1)} ${CHART_HEIGHT}`}
+        preserveAspectRatio="none"
+        className="w-full bg-black rounded"
+        style={{ height: CHART_HEIGHT }}
+      >
+        <path d={path} stroke="#60a5fa" strokeWidth={1} vectorEffect="non-scaling-stroke" />
+        {histogram &&
+          [1, 50, 99].map((p) => (
+            <line
+              key={p}
+              x1={position(percentile(p))}
+              x2={position(percentile(p))}
+              y1={0}
+              y2={CHART_HEIGHT}
+              stroke={p === 50 ? '#facc15' : '#6b7280'}
+              strokeDasharray="2 2"
+              vectorEffect="non-scaling-stroke"
+            />
+          ))}
+      </svg>
+
+      {histogram && (
+        <div className="grid grid-cols-3 gap-2 text-xs text-gray-400 mt-2">
+          <span>1%: {formatValue(percentile(1))}</span>
+          <span>Median: {formatValue(percentile(50))}</span>
+          <span>99%: {formatValue(percentile(99))}</span>
+          <span>Min: {formatValue(histogram.min)}</span>
+          <span>
+            Range: {formatValue(histogram.low)} – {formatValue(histogram.high)}
+          </span>
+          <span>Max: {formatValue(histogram.max)}</span>
+        </div>
+      )}
+    </div>
+  );
+}
@@ -0,0 +1,191 @@
+/**
+ * Zoomable viewer for the fused, confidence and classification planes
+ * Features: wheel zoom around the cursor, drag to pan, fit, per-plane tabs.
+ * Only the tiles in view are requested, at the level matching the zoom.
+ * While a run accumulates it shows the live snapshots, in image coordinates,
+ * so the view holds from one snapshot to the next and on to the result.
+ */
+
+import { useState, useRef, useEffect, useCallback } from 'react';
+import { Maximize } from 'lucide-react';
+import type { PreviewInfo, PreviewPlane } from '../types/bridge';
+
+interface PreviewViewerProps {
+  preview: PreviewInfo;
+}
+
+interface View {
+  scale: number; // Screen pixels per image pixel
+  x: number; // Image coordinate at the viewport's top-left corner
+  y: number;
+}
+
+const PLANE_LABELS: Record<PreviewPlane, string> = {
+  fused: 'Fused',
+  confidence: 'Confidence',
+  classification: 'Classification',
+};
+
+const VIEWPORT_HEIGHT = 480;
+const MAX_SCALE = 8;
+
+export function PreviewViewer({ preview }: PreviewViewerProps) {
+  const [plane, setPlane] = useState<PreviewPlane>('fused');
+  const [view, setView] = useState<View | null>(null);
+  const [viewportWidth, setViewportWidth] = useState(0);
+  const viewportRef = useRef<HTMLDivElement>(null);
+  const dragRef = useRef<{ x: number; y: number } | null>(null);
+
+  // Image pixels per preview pixel: 1 for a result, the snapshot's step while live
+  const pixel = preview.step ?? 1;
+  const sourceWidth = preview.width ?? 0;
+  const sourceHeight = preview.height ?? 0;
+  const width = sourceWidth * pixel;
+  const height = sourceHeight * pixel;
+  const tileSize = preview.tileSize ?? 256;
+  const levels = preview.levels ?? 0;
+  const planes = preview.planes ?? [];
+
+  const fit = useCallback(() => {
+    if (!viewportWidth || !width || !height) return;
+    const scale = Math.min(viewportWidth / width, VIEWPORT_HEIGHT / height, MAX_SCALE);
+    setView({
+      scale,
+      x: -(viewportWidth / scale - width) / 2,
+      y: -(VIEWPORT_HEIGHT / scale - height) / 2,
+    });
+  }, [viewportWidth, width, height]);
+
+  // Track the viewport width
+  useEffect(() => {
+    const element = viewportRef.current;
+    if (!element) return;
+    const observer = new ResizeObserver(() => setViewportWidth(element.clientWidth));
+    observer.observe(element);
+    setViewportWidth(element.clientWidth);
+    return () => observer.disconnect();
+  }, [preview.available]);
+
+  // Fit when the image changes size; live snapshots of one run keep the view
+  useEffect(() => {
+    fit();
+  }, [fit]);
+
+  // A snapshot has no classification plane
+  useEffect(() => {
+    if (planes.length > 0 && !planes.includes(plane)) setPlane(planes[0]);
+  }, [planes, plane]);
+
+  const onWheel = (e: React.WheelEvent<HTMLDivElement>) => {
+    if (!view || !viewportRef.current) return;
+    const rect = viewportRef.current.getBoundingClientRect();
+    const px = e.clientX - rect.left;
+    const py = e.clientY - rect.top;
+    const minScale = Math.min(viewportWidth / width, VIEWPORT_HEIGHT / height) / 2;
+    const scale = Math.min(Math.max(view.scale * Math.pow(1.0015, -e.deltaY), minScale), MAX_SCALE);
+    // Keep the image point under the cursor fixed
+    setView({
+      scale,
+      x: view.x + px / view.scale - px / scale,
+      y: view.y + py / view.scale - py / scale,
+    });
+  };
+
+  const onMouseDown = (e: React.MouseEvent<HTMLDivElement>) => {
+    dragRef.current = { x: e.clientX, y: e.clientY };
+  };
+
+  const onMouseMove = (e: React.MouseEvent<HTMLDivElement>) => {
+    if (!dragRef.current || !view) return;
+    const dx = e.clientX - dragRef.current.x;
+    const dy = e.clientY - dragRef.current.y;
+    dragRef.current = { x: e.clientX, y: e.clientY };
+    setView({ ...view, x: view.x - dx / view.scale, y: view.y - dy / view.scale });
+  };
+
+  const endDrag = () => {
+    dragRef.current = null;
+  };
+
+  if (!preview.available || !preview.baseUrl) return null;
+
+  // The coarsest level that still has at least one tile pixel per screen pixel
+  const tiles: JSX.Element[] = [];
+  if (view && viewportWidth) {
+    const level = Math.min(Math.max(Math.floor(Math.log2(1 / (view.scale * pixel))), 0), levels - 1);
+    const step = 2 ** level * pixel; // Image pixels per tile pixel
+    const span = tileSize * step; // Image pixels per tile edge
+    const levelWidth = Math.ceil(sourceWidth / 2 ** level);
+    const levelHeight = Math.ceil(sourceHeight / 2 ** level);
+    const x0 = Math.max(Math.floor(view.x / span), 0);
+    const y0 = Math.max(Math.floor(view.y / span), 0);
+    const x1 = Math.min(Math.floor((view.x + viewportWidth / view.scale) / span), Math.ceil(levelWidth / tileSize) - 1);
+    const y1 = Math.min(Math.floor((view.y + VIEWPORT_HEIGHT / view.scale) / span), Math.ceil(levelHeight / tileSize) - 1);
+    for (let ty = y0; ty <= y1; ty++) {
+      for (let tx = x0; tx <= x1; tx++) {
+        const tileWidth = Math.min(tileSize, levelWidth - tx * tileSize);
+        const tileHeight = Math.min(tileSize, levelHeight - ty * tileSize);
+        tiles.push(
+          <img
+            key={`${preview.live ? 'live' : 'result'}/${plane}/${level}/${tx}/${ty}`}
+            src={`${preview.baseUrl}/${plane}/${level}/${tx}/${ty}.png`}
+            alt=""
+            draggable={false}
+            className="absolute max-w-none"
+            style={{
+              left: (tx * span - view.x) * view.scale,
+              top: (ty * span - view.y) * view.scale,
+              width: tileWidth * step * view.scale,
+              height: tileHeight * step * view.scale,
+              imageRendering: view.scale * step > 1 ? 'pixelated' : 'auto',
+            }}
+          />
+        );
+      }
+    }
+  }
+
+  return (
+    <div className="bg-gray-800 rounded-lg p-4">
+      <div className="flex items-center justify-between mb-3">
+        <h2 className="text-lg font-semibold">Preview</h2>
+        <div className="flex items-center gap-2">
+          {planes.map((p) => (
+            <button
+              key={p}
+              onClick={() => setPlane(p)}
+              className={`px-2 py-1 text-xs rounded ${
+                p === plane ? 'bg-blue-600 text-white' : 'bg-gray-700 text-gray-300 hover:bg-gray-600'
+              }`}
+            >
+              {preview.live && p === 'fused' ? 'Mean' : PLANE_LABELS[p]}
+            </button>
+          ))}
+          <button onClick={fit} className="p-1 text-gray-400 hover:text-gray-200" title="Fit to view">
+            <Maximize size={16} />
+          </button>
+        </div>
+      </div>
+
+      <div
+        ref={viewportRef}
+        className="relative overflow-hidden bg-black rounded cursor-grab select-none"
+        style={{ height: VIEWPORT_HEIGHT }}
+        onWheel={onWheel}
+        onMouseDown={onMouseDown}
+        onMouseMove={onMouseMove}
+        onMouseUp={endDrag}
+        onMouseLeave={endDrag}
+      >
+        {tiles}
+      </div>
+
+      <p className="text-xs text-gray-500 mt-2">
+        {preview.live
+          ? `Live · ${preview.frames ?? 0} frames${(preview.bands ?? 1) > 1 ? ` · band ${preview.band}/${preview.bands}` : ''}`
+          : `${width}×${height}`}
+        {view && ` · ${(view.scale * 100).toFixed(view.scale < 0.1 ? 1 : 0)}%`}
+      </p>
+    </div>
+  );
+}
@@ -5,11 +5,14 @@
 
 import { useState, useEffect, useRef } from 'react';
 import { Play, Loader2, CheckCircle, XCircle, Clock, Zap } from 'lucide-react';
+import type { RunStatus, StagePlanEntry } from '../types/bridge';
 
 interface ProgressPanelProps {
   isProcessing: boolean;
   progress: number;
   status: string;
+  run?: RunStatus;
+  stagePlan?: StagePlanEntry[];
   onExecute: () => void;
   canExecute: boolean;
 }
@@ -38,6 +41,15 @@ function getStageFromStatus(status: string): string {
   return 'processing';
 }
 
+// Engine phases map onto stages directly; free-text status is the fallback
+const PHASE_STAGES: Record<RunStatus['phase'], string> = {
+  scan: 'loading',
+  ingest: 'accumulating',
+  accumulate: 'accumulating',
+  finalize: 'fusing',
+  write: 'saving',
+};
+
 const STAGES = [
   { id: 'loading', label: 'Load Frames' },
   { id: 'accumulating', label: 'Accumulate Statistics' },
@@ -50,6 +62,8 @@ export function ProgressPanel({
   isProcessing,
   progress,
   status,
+  run,
+  stagePlan,
   onExecute,
   canExecute,
 }: ProgressPanelProps) {
@@ -60,7 +74,9 @@ export function ProgressPanel({
   const [eta, setEta] = useState<number | null>(null);
   const intervalRef = useRef<number | null>(null);
 
-  const currentStage = getStageFromStatus(status);
+  const statusStage = getStageFromStatus(status);
+  const currentStage =
+    run?.running && statusStage !== 'error' ? PHASE_STAGES[run.phase] : statusStage;
   const isComplete = progress >= 100 && !isProcessing;
   const isError = currentStage === 'error';
 
@@ -116,6 +132,9 @@ export function ProgressPanel({
     }
   }, [progress, isProcessing, lastProgress, lastProgressTime]);
 
+  // The engine's estimate covers the whole run; the local one is the fallback
+  const displayEta = run?.running && run.etaSeconds !== null ? run.etaSeconds : eta;
+
   // Reset on completion
   useEffect(() => {
     if (!isProcessing) {
@@ -202,12 +221,22 @@ export function ProgressPanel({
             <Clock size={14} />
             <span>Elapsed: {formatTime(elapsedSeconds)}</span>
           </div>
-          {eta !== null && eta > 0 && (
-            <span>ETA: ~{formatTime(eta)}</span>
+          {displayEta !== null && displayEta > 0 && (
+            <span>ETA: ~{formatTime(displayEta)}</span>
           )}
         </div>
       )}
 
+      {/* Engine throughput and memory */}
+      {isProcessing && run?.running && (
+        <div className="flex justify-between text-xs text-gray-500 mb-4">
+          <span>
+            {run.framesPerSecond.toFixed(1)} frames/s · {run.megabytesPerSecond.toFixed(0)} MB/s
+          </span>
+          <span>{(run.rssBytes / 1048576).toFixed(0)} MB RSS</span>
+        </div>
+      )}
+
       {/* Completion message */}
       {isComplete && !isProcessing && (
         <div className="flex items-center gap-2 text-green-400 mb-4 p-2 bg-green-900/20 rounded">
@@ -246,6 +275,26 @@ export function ProgressPanel({
         )}
       </button>
 
+      {/* Stages the next Execute recomputes; the rest are reused from the last run */}
+      {stagePlan && stagePlan.length > 0 && !isProcessing && (
+        <div className="flex items-center justify-center gap-1 mt-2 text-xs">
+          <span className="text-gray-400 mr-1">
+            {stagePlan.some((s) => s.run) ? 'Will run:' : 'Up to date:'}
+          </span>
+          {stagePlan.map((s) => (
+            <span
+              key={s.stage}
+              className={`px-2 py-0.5 rounded capitalize ${
+                s.run ? 'bg-blue-900/50 text-blue-300' : 'bg-gray-700 text-gray-500 line-through'
+              }`}
+              title={s.run ? 'Recomputed' : 'Reused from the last run'}
+            >
+              {s.stage}
+            </span>
+          ))}
+        </div>
+      )}
+
       {!canExecute && !isProcessing && (
         <p className="text-xs text-gray-400 mt-2 text-center">
           Add input files to enable execution
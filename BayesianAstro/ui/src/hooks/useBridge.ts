@@ -3,7 +3,14 @@
  */
 
 import { useEffect, useState, useCallback } from 'react';
-import type { BayesianAstroBridge, ProcessingState } from '../types/bridge';
+import type {
+  BayesianAstroBridge,
+  FrameStats,
+  PreviewInfo,
+  ProcessingState,
+  RunStatus,
+  StagePlanEntry,
+} from '../types/bridge';
 
 interface BridgeState {
   connected: boolean;
@@ -14,6 +21,9 @@ interface BridgeState {
   useGPU: boolean;
   generateConfidenceMap: boolean;
   files: string[];
+  frameStats: FrameStats[];
+  preview: PreviewInfo;
+  stagePlan: StagePlanEntry[];
   processing: ProcessingState;
 }
 
@@ -27,6 +37,9 @@ export function useBridge() {
     useGPU: true,
     generateConfidenceMap: true,
     files: [],
+    frameStats: [],
+    preview: { available: false },
+    stagePlan: [],
     processing: {
       isProcessing: false,
       progress: 0,
@@ -62,13 +75,17 @@ export function useBridge() {
         });
 
         bridge.filesChanged.connect(() => {
-          setState((s) => ({ ...s, files: bridge.getFiles() }));
+          setState((s) => ({ ...s, files: bridge.getFiles(), frameStats: bridge.getFrameStats() }));
         });
 
-        bridge.progressUpdated.connect((percent: number, status: string) => {
+        bridge.previewChanged.connect(() => {
+          setState((s) => ({ ...s, preview: bridge.getPreviewInfo() }));
+        });
+
+        bridge.statusUpdated.connect((run: RunStatus) => {
           setState((s) => ({
             ...s,
-            processing: { ...s.processing, progress: percent, status },
+            processing: { ...s.processing, progress: run.percent, status: run.status, run },
           }));
         });
 
@@ -94,6 +111,8 @@ export function useBridge() {
           useGPU: bridge.useGPU,
           generateConfidenceMap: bridge.generateConfidenceMap,
           files: bridge.getFiles(),
+          frameStats: bridge.getFrameStats(),
+          preview: bridge.getPreviewInfo(),
         }));
       });
     } else {
@@ -103,6 +122,24 @@ export function useBridge() {
     }
   }, []);
 
+  // Stages Execute would rerun: re-planned whenever an input, parameter or cached result
+  // may have changed (planning stats the inputs, no pixel is read)
+  useEffect(() => {
+    if (!state.bridge || state.processing.isProcessing) return;
+    const stagePlan = state.bridge.getStagePlan();
+    setState((s) => ({ ...s, stagePlan }));
+  }, [
+    state.bridge,
+    state.processing.isProcessing,
+    state.fusionStrategy,
+    state.outlierSigma,
+    state.confidenceThreshold,
+    state.useGPU,
+    state.generateConfidenceMap,
+    state.files,
+    state.preview,
+  ]);
+
   // Actions
   const setFusionStrategy = useCallback(
     (value: number) => {
@@ -221,6 +258,9 @@ export function useBridge() {
     useGPU: state.useGPU,
     generateConfidenceMap: state.generateConfidenceMap,
     files: state.files,
+    frameStats: state.frameStats,
+    preview: state.preview,
+    stagePlan: state.stagePlan,
     processing: state.processing,
     setFusionStrategy,
     setOutlierSigma,
@@ -9,6 +9,96 @@ export enum FusionStrategy {
   MultiScale = 3,
 }
 
+// Per-frame header metadata and quality metrics from the native frame catalog.
+// Missing keywords and not-yet-measured metrics are null.
+export interface FrameStats {
+  valid: boolean;
+  error?: string;
+  width?: number;
+  height?: number;
+  bitpix?: number;
+  fileSize?: number;
+  fwhm?: number | null;
+  background?: number | null;
+  noise?: number | null;
+  exposure?: number | null;
+  gain?: number | null;
+  timestamp?: number | null;
+  filter?: string;
+  mean?: number | null;
+  sigma?: number | null;
+}
+
+export type PreviewPlane = 'fused' | 'confidence' | 'classification';
+
+// Tile grid of the last run's output planes, or while a run accumulates, of its latest
+// live snapshot (running mean as 'fused' and interim confidence, downsampled by `step`).
+// Tiles are PNGs loaded straight from `${baseUrl}/${plane}/${level}/${x}/${y}.png`,
+// outside the WebChannel; level 0 is full resolution and each level halves it, down to
+// one tile for the whole image. A result also lists the planes it has histograms of.
+export interface PreviewInfo {
+  available: boolean;
+  generation?: number;
+  width?: number;
+  height?: number;
+  tileSize?: number;
+  levels?: number;
+  planes?: PreviewPlane[];
+  baseUrl?: string;
+  histograms?: HistogramPlane[];
+  histogramUrl?: string;
+  live?: boolean;
+  step?: number;
+  frames?: number;
+  band?: number;
+  bands?: number;
+}
+
+export type HistogramPlane = 'fused' | 'confidence' | 'variance';
+
+// Histogram of one result plane, fetched as compact binary from
+// `${histogramUrl}/${plane}.bin` (layout in PlaneHistogram.h). Bins span [low, high];
+// finite samples outside it are counted in below and above. Percentiles are of the
+// finite samples, at the percents in `percents`.
+export interface PlaneHistogram {
+  low: number;
+  high: number;
+  min: number;
+  max: number;
+  samples: number;
+  below: number;
+  above: number;
+  nonFinite: number;
+  percents: number[];
+  percentiles: number[];
+  counts: Uint32Array;
+}
+
+// One stage of the run graph and whether Execute would compute it (run) or reuse the
+// output the session holds from an earlier run with the same inputs and parameters.
+export interface StagePlanEntry {
+  stage: 'accumulate' | 'finalize' | 'write';
+  run: boolean;
+}
+
+// Coalesced run status, pushed at a fixed refresh rate while a run executes.
+// etaSeconds is null until the run has made progress.
+export interface RunStatus {
+  running: boolean;
+  phase: 'scan' | 'ingest' | 'accumulate' | 'finalize' | 'write';
+  percent: number;
+  status: string;
+  framesDone: number;
+  framesTotal: number;
+  band: number;
+  bands: number;
+  elapsedSeconds: number;
+  framesPerSecond: number;
+  megabytesPerSecond: number;
+  etaSeconds: number | null;
+  rssBytes: number;
+}
+
 export interface BayesianAstroBridge {
   // Properties (reactive via Qt signals)
   fusionStrategy: number;
@@ -22,6 +112,9 @@ export interface BayesianAstroBridge {
   removeFile(index: number): void;
   clearFiles(): void;
   getFiles(): string[];
+  getFrameStats(): FrameStats[];
+  getPreviewInfo(): PreviewInfo;
+  getStagePlan(): StagePlanEntry[];
   execute(): void;
   setOutputDirectory(path: string): void;
   setOutputPrefix(prefix: string): void;
@@ -33,7 +126,8 @@ export interface BayesianAstroBridge {
   useGPUChanged: { connect: (callback: () => void) => void };
   generateConfidenceMapChanged: { connect: (callback: () => void) => void };
   filesChanged: { connect: (callback: () => void) => void };
-  progressUpdated: { connect: (callback: (percent: number, status: string) => void) => void };
+  previewChanged: { connect: (callback: () => void) => void };
+  statusUpdated: { connect: (callback: (status: RunStatus) => void) => void };
   executionComplete: { connect: (callback: (success: boolean, message: string) => void) => void };
 }
 
@@ -53,4 +147,5 @@ export interface ProcessingState {
   isProcessing: boolean;
   progress: number;
   status: string;
+  run?: RunStatus;
 }